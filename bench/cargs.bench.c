@@ -0,0 +1,1107 @@
+/* Benchmark suite: synthetic command trees at several scales, the doc and
+ * completion emitters, and the typed helpers.
+ *
+ *   cargs-bench [FILTER] [--min-ms N]
+ *
+ * Runs every scenario whose name contains FILTER and prints one JSON object
+ * per line: name, iterations, ns/op, heap allocations/op (-1 when not
+ * counted) and bytes written/op. */
+#define _POSIX_C_SOURCE 200809L
+#define CARGS_ENABLE_THREADS
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "c-args-parser.h"
+
+/* ---------- allocation counting (glibc symbol interposition) ---------- */
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) && \
+    !defined(CARGS_BENCH_NO_MALLOC_HOOK)
+#    define BENCH_COUNT_ALLOCS 1
+extern void *__libc_malloc(size_t);
+extern void *__libc_calloc(size_t, size_t);
+extern void *__libc_realloc(void *, size_t);
+static unsigned long long allocs;
+void *malloc(size_t n) {
+    allocs++;
+    return __libc_malloc(n);
+}
+void *calloc(size_t n, size_t k) {
+    allocs++;
+    return __libc_calloc(n, k);
+}
+void *realloc(void *p, size_t n) {
+    allocs++;
+    return __libc_realloc(p, n);
+}
+#else
+static unsigned long long allocs;
+#endif
+
+static double now_ns(void) {
+    struct timespec ts;
+#ifdef CLOCK_MONOTONIC
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+    timespec_get(&ts, TIME_UTC);
+#endif
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/* ---------- harness ---------- */
+typedef size_t (*bench_fn)(void *ctx); /* one op; returns bytes written */
+
+static const char *filter = "";
+static double      min_ns = 200e6;
+
+static void measure(const char *name, bench_fn fn, void *ctx) {
+    if (!strstr(name, filter)) return;
+    fn(ctx); /* warm up */
+    size_t iters = 1;
+    for (;;) {
+        unsigned long long a0    = allocs;
+        size_t             bytes = 0;
+        double             t0    = now_ns();
+        for (size_t i = 0; i < iters; i++) bytes += fn(ctx);
+        double dt = now_ns() - t0;
+        if (dt >= min_ns || iters >= ((size_t)1 << 30)) {
+#ifdef BENCH_COUNT_ALLOCS
+            double ap = (double)(allocs - a0) / (double)iters;
+#else
+            double ap = (void)a0, -1.0;
+#endif
+            printf("{\"name\":\"%s\",\"iters\":%zu,\"ns_per_op\":%.1f,"
+                   "\"allocs_per_op\":%.2f,\"bytes_per_op\":%.1f}\n",
+                   name, iters, dt / (double)iters, ap,
+                   (double)bytes / (double)iters);
+            fflush(stdout);
+            return;
+        }
+        /* aim straight for min_ns, at least doubling */
+        double want = dt > 0 ? (double)iters * min_ns * 1.1 / dt : 0;
+        iters       = want > (double)iters * 2 ? (size_t)want : iters * 2;
+    }
+}
+
+static void *xcalloc(size_t n, size_t k) {
+    void *p = calloc(n ? n : 1, k);
+    if (!p) {
+        perror("calloc");
+        exit(1);
+    }
+    return p;
+}
+
+/* Output sink that can be measured: rewound before every op */
+static FILE *sink;
+
+static size_t sink_reset(void) {
+    rewind(sink);
+    return 0;
+}
+
+static size_t sink_bytes(void) {
+    fflush(sink);
+    long n = ftell(sink);
+    return n > 0 ? (size_t)n : 0;
+}
+
+static int bench_cb(const char *v, void *u) {
+    (void)v;
+    (*(size_t *)u)++;
+    return CARGS_OK;
+}
+
+static int bench_run(int argc, char **argv, void *u) {
+    (void)argv;
+    *(size_t *)u += (size_t)argc;
+    return CARGS_OK;
+}
+
+/* ---------- synthetic trees ---------- */
+
+/* n options named opt-00000.., every 3rd takes a value; the first 52 also
+   get a short name */
+static cargs_opt *make_opts(size_t n, char **names_out) {
+    static const char shorts[] =
+        "abcdefgijklmnopqrstuwxyzABCDEFGIJKLMNOPQRSTUWXYZ0123";
+    cargs_opt *o     = (cargs_opt *)xcalloc(n, sizeof *o);
+    char      *names = (char *)xcalloc(n, 16);
+    for (size_t i = 0; i < n; i++) {
+        snprintf(names + 16 * i, 16, "opt-%05zu", i);
+        o[i].long_name  = names + 16 * i;
+        o[i].short_name = i < sizeof shorts - 1 ? shorts[i] : 0;
+        o[i].arg        = i % 3 == 0 ? CARGS_ARG_REQUIRED : CARGS_ARG_NONE;
+        o[i].metavar    = i % 3 == 0 ? "VALUE" : NULL;
+        o[i].help       = "Synthetic option used by the benchmark suite";
+        o[i].cb         = bench_cb;
+    }
+    *names_out = names;
+    return o;
+}
+
+typedef struct {
+    cargs_env        env;
+    cargs_cmd        root;
+    const cargs_cmd *dispatch_root;
+    int              argc;
+    char           **argv;
+    size_t           hits;
+} scenario;
+
+static void env_init(cargs_env *e) {
+    memset(e, 0, sizeof *e);
+    e->prog      = "bench";
+    e->version   = "1.0";
+    e->auto_help = true;
+    e->wrap_cols = 100;
+    e->out       = sink;
+    e->err       = sink;
+}
+
+/* argv: k option uses spread over n options (values attached with '=') */
+static char **make_opt_argv(const cargs_opt *o, size_t n, int k, int *argc) {
+    char **argv = (char **)xcalloc((size_t)k + 2, sizeof *argv);
+    argv[0]     = (char *)xcalloc(8, 1);
+    strcpy(argv[0], "bench");
+    for (int i = 1; i <= k; i++) {
+        const cargs_opt *p = &o[((size_t)i * 7919u) % n];
+        argv[i]            = (char *)xcalloc(32, 1);
+        snprintf(argv[i], 32, "--%s%s", p->long_name,
+                 p->arg == CARGS_ARG_REQUIRED ? "=1" : "");
+    }
+    *argc = k + 1;
+    return argv;
+}
+
+static size_t op_dispatch(void *ctx) {
+    scenario *s = (scenario *)ctx;
+    sink_reset();
+    if (cargs_dispatch(&s->env, s->dispatch_root, s->argc, s->argv, &s->hits) <
+        0) {
+        fprintf(stderr, "dispatch failed\n");
+        exit(1);
+    }
+    return sink_bytes();
+}
+
+static size_t op_multicall(void *ctx) {
+    scenario *s = (scenario *)ctx;
+    sink_reset();
+    if (cargs_dispatch_multicall(&s->env, s->dispatch_root, s->argc, s->argv,
+                                 &s->hits) < 0) {
+        fprintf(stderr, "dispatch failed\n");
+        exit(1);
+    }
+    return sink_bytes();
+}
+
+typedef struct {
+    scenario           *s;
+    const cargs_packed *pk;
+    cargs_packed_fns    fns;
+} packed_ctx;
+
+static size_t op_dispatch_packed(void *ctx) {
+    packed_ctx *p = (packed_ctx *)ctx;
+    sink_reset();
+    if (cargs_dispatch_packed(&p->s->env, p->pk, &p->fns, p->s->argc,
+                              p->s->argv, &p->s->hits) < 0) {
+        fprintf(stderr, "dispatch failed\n");
+        exit(1);
+    }
+    return sink_bytes();
+}
+
+/* A mistyped option: the error path including the "did you mean" search */
+static size_t op_unknown(void *ctx) {
+    scenario *s = (scenario *)ctx;
+    sink_reset();
+    if (cargs_dispatch(&s->env, s->dispatch_root, s->argc, s->argv, &s->hits) !=
+        CARGS_ERR_UNKNOWN) {
+        fprintf(stderr, "expected an unknown option\n");
+        exit(1);
+    }
+    return sink_bytes();
+}
+
+static void bench_opts(size_t n) {
+    char     *names;
+    scenario  s;
+    char      name[64];
+    cargs_opt *opts = make_opts(n, &names);
+    env_init(&s.env);
+    memset(&s.root, 0, sizeof s.root);
+    s.root.opts      = opts;
+    s.root.opt_count = n;
+    s.root.run       = bench_run;
+    s.dispatch_root  = &s.root;
+    s.argv           = make_opt_argv(opts, n, 16, &s.argc);
+    s.hits           = 0;
+
+    snprintf(name, sizeof name, "dispatch/opts=%zu/linear", n);
+    measure(name, op_dispatch, &s);
+
+    size_t             need = cargs_compile_size(&s.root);
+    void              *mem  = xcalloc(need, 1);
+    s.env.index             = cargs_compile(&s.root, mem, need);
+    snprintf(name, sizeof name, "dispatch/opts=%zu/indexed", n);
+    measure(name, op_dispatch, &s);
+    s.env.index = NULL;
+    free(mem);
+
+    if (n >= 1000) { /* default budget (1024 names), then every name */
+        char *keep = s.argv[1];
+        char  typo[] = "--opt-0O042";
+        s.argv[1]    = typo;
+        s.argc       = 2;
+        snprintf(name, sizeof name, "suggest/opts=%zu", n);
+        measure(name, op_unknown, &s);
+        s.env.suggest_budget = (int)n;
+        snprintf(name, sizeof name, "suggest/opts=%zu/full", n);
+        measure(name, op_unknown, &s);
+        s.env.suggest_budget = 0;
+        s.argv[1]            = keep;
+        s.argc               = 17;
+    }
+
+    if (n == 1000) {
+        snprintf(name, sizeof name, "help/opts=%zu", n);
+        s.argc = 2;
+        strcpy(s.argv[1], "--help");
+        measure(name, op_dispatch, &s);
+    }
+    for (int i = 0; i < 18 && s.argv[i]; i++) free(s.argv[i]);
+    free(s.argv);
+    free(opts);
+    free(names);
+}
+
+/* 200 subcommands, two aliases each, 4 options per subcommand */
+typedef struct {
+    cargs_cmd   root;
+    cargs_cmd   subs[200];
+    const char *aliases[200][2];
+    char        names[200][3][16];
+    cargs_opt   opts[200][4];
+} subs_tree;
+
+static void make_subs(subs_tree *t) {
+    memset(t, 0, sizeof *t);
+    for (size_t i = 0; i < 200; i++) {
+        snprintf(t->names[i][0], 16, "command-%03zu", i);
+        snprintf(t->names[i][1], 16, "c%03zu", i);
+        snprintf(t->names[i][2], 16, "cmd%03zu", i);
+        t->aliases[i][0] = t->names[i][1];
+        t->aliases[i][1] = t->names[i][2];
+        for (size_t k = 0; k < 4; k++) {
+            static const char *ln[] = {"force", "output", "depth", "quiet"};
+            t->opts[i][k].long_name  = ln[k];
+            t->opts[i][k].short_name = ln[k][0];
+            t->opts[i][k].arg = k == 1 ? CARGS_ARG_REQUIRED : CARGS_ARG_NONE;
+            t->opts[i][k].metavar = k == 1 ? "FILE" : NULL;
+            t->opts[i][k].help    = "Per-command option";
+            t->opts[i][k].cb      = bench_cb;
+        }
+        t->subs[i].name        = t->names[i][0];
+        t->subs[i].desc        = "Synthetic subcommand";
+        t->subs[i].opts        = t->opts[i];
+        t->subs[i].opt_count   = 4;
+        t->subs[i].aliases     = t->aliases[i];
+        t->subs[i].alias_count = 2;
+        t->subs[i].run         = bench_run;
+    }
+    t->root.desc      = "Benchmark tree with 200 subcommands";
+    t->root.subs      = t->subs;
+    t->root.sub_count = 200;
+}
+
+typedef struct {
+    scenario           s;
+    subs_tree          t;
+    int                kind;
+    const cargs_blobs *blobs;   /* serve prebuilt output when set */
+    bool               checked; /* blobs already matched: no tree hash */
+} emit_ctx;
+
+static size_t op_emit(void *ctx) {
+    emit_ctx *e = (emit_ctx *)ctx;
+    sink_reset();
+    if (e->blobs) {
+        if (e->checked)
+            cargs_emit_checked(
+                &e->s.env, &e->t.root, "bench", sink, e->blobs,
+                (cargs_blob_kind)e->kind
+            );
+        else
+            cargs_emit_cached(
+                &e->s.env, &e->t.root, "bench", sink, e->blobs,
+                (cargs_blob_kind)e->kind
+            );
+        return sink_bytes();
+    }
+    switch (e->kind) {
+        case 0:
+            cargs_emit_markdown(&e->s.env, &e->t.root, "bench", sink);
+            break;
+        case 1:
+            cargs_emit_man(&e->s.env, &e->t.root, "bench", sink, "1");
+            break;
+        case 2:
+            cargs_emit_completion_bash(&e->s.env, &e->t.root, "bench", sink);
+            break;
+        case 3:
+            cargs_emit_completion_zsh(&e->s.env, &e->t.root, "bench", sink);
+            break;
+        case 4:
+            cargs_emit_completion_fish(&e->s.env, &e->t.root, "bench", sink);
+            break;
+        default:
+            cargs_emit_json(&e->s.env, &e->t.root, "bench", sink);
+            break;
+    }
+    return sink_bytes();
+}
+
+static void bench_subs(void) {
+    static emit_ctx e;
+    static char     a0[] = "bench", a1[] = "cmd199", a2[] = "-f",
+                    a3[] = "--output=x", a4[] = "pos";
+    static char    *argv[] = {a0, a1, a2, a3, a4, NULL};
+    make_subs(&e.t);
+    env_init(&e.s.env);
+    e.s.dispatch_root = &e.t.root;
+    e.s.argc          = 5;
+    e.s.argv          = argv;
+    measure("dispatch/subs=200/alias", op_dispatch, &e.s);
+
+    size_t need   = cargs_compile_size(&e.t.root);
+    void  *mem    = xcalloc(need, 1);
+    e.s.env.index = cargs_compile(&e.t.root, mem, need);
+    measure("dispatch/subs=200/alias/indexed", op_dispatch, &e.s);
+
+    /* busybox style: argv[0] names the applet */
+    static char a0m[]    = "/usr/bin/command-199";
+    char       *argv_m[] = {a0m, a2, a3, a4, NULL};
+    e.s.argv             = argv_m;
+    e.s.argc             = 4;
+    measure("dispatch/subs=200/multicall", op_multicall, &e.s);
+    e.s.argv      = argv;
+    e.s.argc      = 5;
+    e.s.env.index = NULL;
+    free(mem);
+
+    /* the same tree as relocation-free tables, decoded level by level */
+    static const cargs_cb cbs[]    = {bench_cb};
+    static int (*const runs[])(int, char **, void *) = {bench_run};
+    static packed_ctx pc;
+    static uint64_t   pk_mem[16384];
+    cargs_arena       pk_arena;
+    memset(&pc.fns, 0, sizeof pc.fns);
+    pc.fns.cb        = cbs;
+    pc.fns.cb_count  = 1;
+    pc.fns.run       = runs;
+    pc.fns.run_count = 1;
+    cargs_arena_init(&pk_arena, pk_mem, sizeof pk_mem);
+    pc.pk = cargs_pack(&e.t.root, &pc.fns, &pk_arena);
+    pc.s  = &e.s;
+    if (!pc.pk) {
+        fprintf(stderr, "pack failed\n");
+        exit(1);
+    }
+    measure("dispatch/subs=200/packed", op_dispatch_packed, &pc);
+
+    static const char *const names[] = {
+        "emit/markdown/subs=200", "emit/man/subs=200",
+        "completion/bash/subs=200", "completion/zsh/subs=200",
+        "completion/fish/subs=200", "emit/json/subs=200",
+    };
+    for (int k = 0; k < 6; k++) {
+        e.kind = k;
+        measure(names[k], op_emit, &e);
+    }
+
+    /* the same outputs from blobs, as a cargs_write_blobs header holds */
+    static cargs_blobs b;
+    char              *own[CARGS_BLOB_COUNT];
+    b.tree_hash = cargs_tree_hash(&e.s.env, &e.t.root, "bench");
+    for (int k = 0; k < CARGS_BLOB_COUNT; k++) {
+        e.kind = k;
+        op_emit(&e);
+        size_t n = sink_bytes();
+        char  *p = (char *)xcalloc(n + 1, 1);
+        rewind(sink);
+        if (fread(p, 1, n, sink) != n) abort();
+        own[k]    = p;
+        b.data[k] = p;
+        b.len[k]  = n;
+    }
+    static const char *const cached[] = {
+        "emit/markdown/subs=200/blob", "emit/man/subs=200/blob",
+        "completion/bash/subs=200/blob", "completion/zsh/subs=200/blob",
+        "completion/fish/subs=200/blob",
+    };
+    e.blobs = &b;
+    for (int k = 0; k < 5; k++) {
+        e.kind = k;
+        measure(cached[k], op_emit, &e);
+    }
+    /* cargs_blobs_check once up front, then no hashing per output */
+    static const char *const checked[] = {
+        "emit/markdown/subs=200/blob/checked",
+        "emit/man/subs=200/blob/checked",
+        "completion/bash/subs=200/blob/checked",
+        "completion/zsh/subs=200/blob/checked",
+        "completion/fish/subs=200/blob/checked",
+    };
+    e.blobs   = cargs_blobs_check(&e.s.env, &e.t.root, "bench", &b);
+    e.checked = true;
+    for (int k = 0; k < 5; k++) {
+        e.kind = k;
+        measure(checked[k], op_emit, &e);
+    }
+    e.checked = false;
+    e.blobs   = NULL;
+    for (int k = 0; k < CARGS_BLOB_COUNT; k++) free(own[k]);
+}
+
+/* __complete: an enum value and a completer over 1000 candidates, both
+   under the default time budget */
+static int bench_completer(const char *prefix, const cargs_opt *opt,
+                           cargs_completion *out, void *user) {
+    char word[16];
+    (void)prefix;
+    (void)opt;
+    (void)user;
+    for (int i = 0; i < 1000; i++) {
+        snprintf(word, sizeof word, "host-%04d", i);
+        if (cargs_complete_add(out, word) == CARGS_DONE) break;
+    }
+    return CARGS_OK;
+}
+
+static void bench_complete(void) {
+    static const cargs_choice colors[] = {
+        {"auto", 0}, {"always", 1}, {"never", 2}, {NULL, 0},
+    };
+    static int       color;
+    static cargs_opt opts[] = {
+        {.long_name = "color", .arg = CARGS_ARG_REQUIRED, .metavar = "WHEN",
+         .bind = CARGS_BIND_ENUM_TO(&color, colors)},
+        {.long_name = "host", .arg = CARGS_ARG_REQUIRED, .metavar = "HOST",
+         .bind = CARGS_COMPLETE(bench_completer)},
+    };
+    static scenario  s;
+    static char      a0[] = "bench", a1[] = "__complete", a2[] = "--color",
+                     a3[] = "a", a4[] = "--host", a5[] = "host-09";
+    static char     *argv_e[] = {a0, a1, a2, a3, NULL};
+    static char     *argv_c[] = {a0, a1, a4, a5, NULL};
+    env_init(&s.env);
+    s.env.complete   = true;
+    s.root.desc      = "Completion endpoint";
+    s.root.opts      = opts;
+    s.root.opt_count = 2;
+    s.dispatch_root  = &s.root;
+    s.argc           = 4;
+    s.argv           = argv_e;
+    measure("complete/enum", op_dispatch, &s);
+    s.argv = argv_c;
+    measure("complete/callback/n=1000", op_dispatch, &s);
+}
+
+/* 4096 stored invocations over the 200-subcommand tree, one shared index */
+#define BATCH_JOBS 4096
+typedef struct {
+    subs_tree  t;
+    cargs_env  env;
+    cargs_job  jobs[BATCH_JOBS];
+    size_t     hits[BATCH_JOBS];
+    char       words[BATCH_JOBS][4][16];
+    char      *argv[BATCH_JOBS][5];
+    unsigned   threads;
+    size_t     chunk; /* jobs per call when pool is set */
+    cargs_pool pool;
+} batch_ctx;
+
+static size_t op_batch(void *ctx) {
+    batch_ctx *b = (batch_ctx *)ctx;
+    if (cargs_dispatch_batch(&b->env, &b->t.root, b->jobs, BATCH_JOBS,
+                             b->threads)) {
+        fprintf(stderr, "batch job failed\n");
+        exit(1);
+    }
+    return 0;
+}
+
+/* The same jobs as many small batches, on per-call threads or on a pool */
+static size_t op_batch_small(void *ctx) {
+    batch_ctx *b      = (batch_ctx *)ctx;
+    size_t     failed = 0;
+    for (size_t i = 0; i < BATCH_JOBS; i += b->chunk)
+        failed += b->pool.threads
+                      ? cargs_pool_dispatch(&b->pool, &b->env, &b->t.root,
+                                            b->jobs + i, b->chunk)
+                      : cargs_dispatch_batch(&b->env, &b->t.root,
+                                             b->jobs + i, b->chunk, 0);
+    if (failed) {
+        fprintf(stderr, "batch job failed\n");
+        exit(1);
+    }
+    return 0;
+}
+
+static void bench_batch(void) {
+    batch_ctx *b = (batch_ctx *)xcalloc(1, sizeof *b);
+    make_subs(&b->t);
+    env_init(&b->env);
+    size_t need  = cargs_compile_size(&b->t.root);
+    void  *mem   = xcalloc(need, 1);
+    b->env.index = cargs_compile(&b->t.root, mem, need);
+    for (size_t i = 0; i < BATCH_JOBS; i++) {
+        snprintf(b->words[i][0], 16, "bench");
+        snprintf(b->words[i][1], 16, "cmd%03zu", i % 200);
+        snprintf(b->words[i][2], 16, "--output=%zu", i);
+        snprintf(b->words[i][3], 16, "-fq");
+        for (int k = 0; k < 4; k++) b->argv[i][k] = b->words[i][k];
+        b->jobs[i].argc = 4;
+        b->jobs[i].argv = b->argv[i];
+        b->jobs[i].user = &b->hits[i];
+    }
+    b->threads = 1;
+    measure("batch/jobs=4096/threads=1", op_batch, b);
+    b->threads = 0;
+    measure("batch/jobs=4096/threads=cpus", op_batch, b);
+    b->chunk = 64;
+    measure("batch/64x64/threads=cpus/per-call", op_batch_small, b);
+    cargs_pool_start(&b->pool, 0);
+    measure("batch/64x64/threads=cpus/pool", op_batch_small, b);
+    cargs_pool_stop(&b->pool);
+    free(mem);
+    free(b);
+}
+
+/* A key=value file setting 3 options of each of the 200 subcommands, loaded
+   by parsing it and from its binary snapshot */
+typedef struct {
+    subs_tree   t;
+    cargs_env   env;
+    void       *mem;
+    size_t      cap;
+    const char *snapshot;
+} config_ctx;
+
+#define BENCH_CFG  "cargs-bench-config.ini"
+#define BENCH_SNAP "cargs-bench-config.snap"
+
+static size_t op_config(void *ctx) {
+    config_ctx  *c = (config_ctx *)ctx;
+    cargs_config cfg;
+    cargs_arena  arena;
+    cargs_arena_init(&arena, c->mem, c->cap);
+    int rc = cargs_config_load(&cfg, &c->env, &c->t.root, BENCH_CFG,
+                               c->snapshot, &arena);
+    if (rc != CARGS_OK || cfg.count != 600 ||
+        cfg.from_snapshot != (c->snapshot != NULL)) {
+        fprintf(stderr, "config load failed\n");
+        exit(1);
+    }
+    cargs_config_close(&cfg);
+    return 0;
+}
+
+static void bench_config(void) {
+    config_ctx *c = (config_ctx *)xcalloc(1, sizeof *c);
+    make_subs(&c->t);
+    env_init(&c->env);
+    FILE *f = fopen(BENCH_CFG, "w");
+    if (!f) {
+        perror(BENCH_CFG);
+        exit(1);
+    }
+    for (int i = 0; i < 200; i++)
+        fprintf(f, "# command %d\n[command-%03d]\nforce = 1\n"
+                   "output = \"/var/tmp/out-%03d.bin\"\ndepth = %d\n\n",
+                i, i, i, i % 16);
+    fclose(f);
+    c->cap = cargs_config_size(&c->t.root) + 64 * 1024;
+    c->mem = xcalloc(c->cap, 1);
+    measure("config/keys=600/parse", op_config, c);
+    size_t need  = cargs_compile_size(&c->t.root);
+    void  *ixmem = xcalloc(need, 1);
+    c->env.index = cargs_compile(&c->t.root, ixmem, need);
+    measure("config/keys=600/parse/indexed", op_config, c);
+    remove(BENCH_SNAP);
+    c->snapshot = BENCH_SNAP;
+    if (strstr("config/keys=600/snapshot", filter)) {
+        cargs_config cfg; /* first load writes it */
+        cargs_arena  arena;
+        cargs_arena_init(&arena, c->mem, c->cap);
+        if (cargs_config_load(&cfg, &c->env, &c->t.root, BENCH_CFG, c->snapshot,
+                              &arena) == CARGS_OK)
+            cargs_config_close(&cfg);
+    }
+    measure("config/keys=600/snapshot", op_config, c);
+    remove(BENCH_CFG);
+    remove(BENCH_SNAP);
+    free(ixmem);
+    free(c->mem);
+    free(c);
+}
+
+/* 8 nested levels, 4 options each; argv walks to the bottom */
+static void bench_depth(void) {
+    static cargs_cmd lv[9];
+    static cargs_opt opts[9][4];
+    static char      names[9][16];
+    static char     *argv[32];
+    static char      buf[32][24];
+    int              argc = 0;
+    memset(lv, 0, sizeof lv);
+    snprintf(buf[argc], 24, "bench");
+    argv[argc] = buf[argc];
+    argc++;
+    for (int d = 8; d >= 0; d--) {
+        static const char *ln[] = {"alpha", "beta", "gamma", "delta"};
+        for (int k = 0; k < 4; k++) {
+            opts[d][k].long_name  = ln[k];
+            opts[d][k].short_name = ln[k][0];
+            opts[d][k].cb         = bench_cb;
+            opts[d][k].help       = "Level option";
+        }
+        snprintf(names[d], 16, "level%d", d);
+        lv[d].name      = names[d];
+        lv[d].desc      = "Nested level";
+        lv[d].opts      = opts[d];
+        lv[d].opt_count = 4;
+        lv[d].run       = bench_run;
+        if (d < 8) {
+            lv[d].subs      = &lv[d + 1];
+            lv[d].sub_count = 1;
+        }
+    }
+    for (int d = 1; d <= 8; d++) {
+        snprintf(buf[argc], 24, "level%d", d);
+        argv[argc] = buf[argc];
+        argc++;
+        snprintf(buf[argc], 24, "-ab");
+        argv[argc] = buf[argc];
+        argc++;
+    }
+    static scenario s;
+    env_init(&s.env);
+    s.dispatch_root = &lv[0];
+    s.argc          = argc;
+    s.argv          = argv;
+    measure("dispatch/depth=8", op_dispatch, &s);
+}
+
+/* argv of n words: n/2 options, then n/2 positionals */
+static void bench_long_argv(int n) {
+    static const cargs_pos pos[] = {{"FILE", "Input", 0, CARGS_POS_INF}};
+    char                   *names;
+    cargs_opt              *opts = make_opts(10, &names);
+    scenario                s;
+    char                    name[64];
+    env_init(&s.env);
+    memset(&s.root, 0, sizeof s.root);
+    s.root.opts      = opts;
+    s.root.opt_count = 10;
+    s.root.pos       = pos;
+    s.root.pos_count = 1;
+    s.root.run       = bench_run;
+    s.dispatch_root  = &s.root;
+    s.argc           = n + 1;
+    s.argv           = (char **)xcalloc((size_t)n + 2, sizeof(char *));
+    char *words      = (char *)xcalloc((size_t)n + 1, 24);
+    for (int i = 0; i <= n; i++) {
+        char *w = words + 24 * (size_t)i;
+        if (i == 0)
+            snprintf(w, 24, "bench");
+        else if (i <= n / 2)
+            snprintf(w, 24, "--opt-%05d%s", i % 10, i % 10 % 3 ? "" : "=7");
+        else
+            snprintf(w, 24, "file-%d.dat", i);
+        s.argv[i] = w;
+    }
+    s.hits = 0;
+    snprintf(name, sizeof name, "dispatch/argv=%d", n);
+    measure(name, op_dispatch, &s);
+    free(words);
+    free(s.argv);
+    free(opts);
+    free(names);
+}
+
+/* Previous cargs_read_size, verbatim (double math, clamps, strtod) */
+static int legacy_read_size(
+    const char *s, uint64_t *out, bool prefer_iec
+) {
+    if (!s || !*s || !out) return -1;
+    errno      = 0;
+    char  *end = NULL;
+    double v   = strtod(s, &end);
+    if (end == s) return -1;
+    while (*end == ' ' || *end == '\t') end++;
+    double mult = 1.0;
+    if (*end) {
+        char   a   = (char)toupper((unsigned char)end[0]);
+        char   b   = (char)toupper((unsigned char)end[1]);
+        char   c   = (char)toupper((unsigned char)end[2]);
+        double k10 = 1000.0, k2 = 1024.0;
+        switch (a) {
+            case 'B': end++; break;
+            case 'K':
+                mult = (b == 'I') ? k2 : (prefer_iec ? k2 : k10);
+                end += (b == 'I' && (c == 'B' || c == '\0'))
+                           ? ((c == 'B') ? 3 : 2)
+                           : ((b == 'B') ? 2 : 1);
+                break;
+            case 'M':
+                mult =
+                    (b == 'I') ? k2 * k2 : (prefer_iec ? k2 * k2 : k10 * k10);
+                end += (b == 'I' && (c == 'B' || c == '\0'))
+                           ? ((c == 'B') ? 3 : 2)
+                           : ((b == 'B') ? 2 : 1);
+                break;
+            case 'G':
+                mult = (b == 'I')
+                           ? k2 * k2 * k2
+                           : (prefer_iec ? k2 * k2 * k2 : k10 * k10 * k10);
+                end += (b == 'I' && (c == 'B' || c == '\0'))
+                           ? ((c == 'B') ? 3 : 2)
+                           : ((b == 'B') ? 2 : 1);
+                break;
+            case 'T':
+                mult = (b == 'I') ? k2 * k2 * k2 * k2
+                                  : (prefer_iec ? k2 * k2 * k2 * k2
+                                                : k10 * k10 * k10 * k10);
+                end += (b == 'I' && (c == 'B' || c == '\0'))
+                           ? ((c == 'B') ? 3 : 2)
+                           : ((b == 'B') ? 2 : 1);
+                break;
+            case 'P':
+                mult = (b == 'I') ? k2 * k2 * k2 * k2 * k2
+                                  : (prefer_iec ? k2 * k2 * k2 * k2 * k2
+                                                : k10 * k10 * k10 * k10 * k10);
+                end += (b == 'I' && (c == 'B' || c == '\0'))
+                           ? ((c == 'B') ? 3 : 2)
+                           : ((b == 'B') ? 2 : 1);
+                break;
+            case 'E':
+                mult = (b == 'I')
+                           ? k2 * k2 * k2 * k2 * k2 * k2
+                           : (prefer_iec ? k2 * k2 * k2 * k2 * k2 * k2
+                                         : k10 * k10 * k10 * k10 * k10 * k10);
+                end += (b == 'I' && (c == 'B' || c == '\0'))
+                           ? ((c == 'B') ? 3 : 2)
+                           : ((b == 'B') ? 2 : 1);
+                break;
+            default: return -1;
+        }
+        while (*end == ' ' || *end == '\t') end++;
+        if (*end != '\0') return -1;
+    }
+    double bytes = v * mult;
+    if (bytes < 0.0 || bytes > (double)UINT64_MAX) return -1;
+    *out = (uint64_t)(bytes + 0.5);
+    return 0;
+}
+
+/* ---------- typed helpers ---------- */
+typedef int (*size_fn)(const char *, uint64_t *, bool);
+
+static const char *size_inputs[] = {
+    "4096", "12MB", "256MiB", "1.5KiB", "7 GB", "0.25TiB",
+    "18446744073709551615", "3.75G", "512k", "1EiB",
+};
+#define N_SIZES (sizeof size_inputs / sizeof size_inputs[0])
+
+static const char *int_inputs[] = {
+    "0", "7", "42", "8080", "65535", "1234567", "2147483647", "-2147483648",
+    "99999999", "-17",
+};
+#define N_INTS (sizeof int_inputs / sizeof int_inputs[0])
+
+static const char *dur_inputs[] = {
+    "250ms", "1h30m", "2m30.5s", "7ns", "1.5", "1w2d", "90s", "0.1h",
+    "1h 2m 3s 4ms", "18446744073709551615ns",
+};
+static const char *rate_inputs[] = {
+    "10MB/s", "1.5KiB/s", "512", "3600KB/h", "90B/min", "1KB/ms", "1GiB/h",
+    "2.5GB/s", "100 MiB / s", "16EiB/h",
+};
+
+static volatile uint64_t sinkv;
+
+typedef struct {
+    size_fn fn;
+    int     which;
+} helper_ctx;
+
+/* one op = one pass over the input set */
+static size_t op_helper(void *ctx) {
+    helper_ctx *h = (helper_ctx *)ctx;
+    for (size_t i = 0; i < 10; i++) {
+        uint64_t u = 0;
+        int      v = 0;
+        int32_t  w = 0;
+        switch (h->which) {
+            case 0: h->fn(size_inputs[i], &u, true); break;
+            case 1: cargs_read_int(int_inputs[i], &v); break;
+            case 2: cargs_read_i32(int_inputs[i], &w, CARGS_BASE_DEC); break;
+            case 3: cargs_read_uint64(size_inputs[6], &u); break;
+            case 5: cargs_read_duration(dur_inputs[i], &u); break;
+            case 6: cargs_read_rate(rate_inputs[i], &u); break;
+            default: cargs_read_u64(size_inputs[6], &u, CARGS_BASE_DEC); break;
+        }
+        sinkv += u + (uint64_t)(unsigned)v + (uint64_t)(uint32_t)w;
+    }
+    return 0;
+}
+
+static void bench_helpers(void) {
+    /* the two size parsers agree wherever doubles are exact */
+    for (size_t i = 0; i < N_SIZES; i++) {
+        uint64_t a = 0, b = 0;
+        int      ra = cargs_read_size(size_inputs[i], &a, true);
+        int      rb = legacy_read_size(size_inputs[i], &b, true);
+        if (ra || (!rb && a != b && a < (1ull << 53))) {
+            fprintf(stderr, "mismatch on \"%s\": %llu vs %llu\n",
+                    size_inputs[i], (unsigned long long)a,
+                    (unsigned long long)b);
+            exit(1);
+        }
+    }
+    (void)N_INTS;
+    helper_ctx h[] = {
+        {cargs_read_size, 0}, {legacy_read_size, 0}, {NULL, 1},
+        {NULL, 2},            {NULL, 3},             {NULL, 4},
+        {NULL, 5},            {NULL, 6},
+    };
+    static const char *const names[] = {
+        "read/size x10",   "read/size-strtod x10", "read/int x10",
+        "read/i32 x10",    "read/uint64 x10",      "read/u64 x10",
+        "read/duration x10", "read/rate x10",
+    };
+    for (size_t k = 0; k < sizeof h / sizeof h[0]; k++)
+        measure(names[k], op_helper, &h[k]);
+}
+
+/* ---------- human-readable formatting ---------- */
+/* Previous cargs_fmt_bytes, verbatim (double division, snprintf) */
+static char *legacy_fmt_bytes(
+    uint64_t bytes, char *buf, size_t bufsz, bool iec, int decimals
+) {
+    if (!buf || bufsz == 0) return buf;
+
+    static const char *U_SI[]  = {"B", "KB", "MB", "GB", "TB", "PB", "EB"};
+    static const char *U_IEC[] = {"B",   "KiB", "MiB", "GiB",
+                                  "TiB", "PiB", "EiB"};
+    const char       **U       = iec ? U_IEC : U_SI;
+    const double       k       = iec ? 1024.0 : 1000.0;
+    double             v       = (double)bytes;
+    size_t             i       = 0;
+    while (v >= k && i < 6) {
+        v /= k;
+        i++;
+    }
+
+    if (decimals < 0) decimals = 2;
+    if (decimals > 6) decimals = 6;
+
+    int n;
+    if (i == 0 || v >= 10.0 || decimals == 0) {
+        n = snprintf(buf, bufsz, "%.0f%s", v, U[i]);
+    } else {
+        n = snprintf(buf, bufsz, "%.*f%s", decimals, v, U[i]);
+    }
+
+    if (n < 0 || (size_t)n >= bufsz) { buf[bufsz ? bufsz - 1 : 0] = '\0'; }
+    return buf;
+}
+
+static const uint64_t fmt_inputs[] = {
+    512, 1536, 4096, 1500000, 12582912, 98765432, 3221225472ull,
+    1099511627776ull, 7340032, 123456789012ull,
+};
+#define N_FMT (sizeof fmt_inputs / sizeof fmt_inputs[0])
+
+typedef char *(*fmt_fn)(uint64_t, char *, size_t, bool, int);
+
+static size_t op_fmt(void *ctx) {
+    fmt_fn fn = *(fmt_fn *)ctx;
+    char   buf[32];
+    size_t n  = 0;
+    for (size_t i = 0; i < N_FMT; i++)
+        n += strlen(fn(fmt_inputs[i], buf, sizeof buf, (i & 1) != 0, 2));
+    sinkv += n;
+    return 0;
+}
+
+typedef struct {
+    uint64_t *vals;
+    char     *cells;
+    size_t    n, cap;
+} fmt_table_ctx;
+
+static size_t op_fmt_table(void *ctx) {
+    fmt_table_ctx *t = (fmt_table_ctx *)ctx;
+    sinkv += cargs_fmt_table(t->vals, t->n, CARGS_FMT_BYTES_IEC, 2, t->cells,
+                             t->cap);
+    return 0;
+}
+
+/* values just below 10 units that round up to "10.00" */
+static const uint64_t fmt_edges[] = {9994, 9996, 9999, 9996000, 10234, 10239};
+#define N_EDGES (sizeof fmt_edges / sizeof fmt_edges[0])
+
+static void bench_fmt(void) {
+    /* both agree except on exact ties, which printf rounds to even, and on
+       values that round up into the next unit (none below) */
+    for (size_t i = 0; i < N_FMT + N_EDGES; i++) {
+        uint64_t v = i < N_FMT ? fmt_inputs[i] : fmt_edges[i - N_FMT];
+        char     a[32], b[32];
+        for (int iec = 0; iec < 2; iec++) {
+            cargs_fmt_bytes(v, a, sizeof a, iec, 2);
+            legacy_fmt_bytes(v, b, sizeof b, iec, 2);
+            if (strcmp(a, b)) {
+                fprintf(stderr, "mismatch on %llu: %s vs %s\n",
+                        (unsigned long long)v, a, b);
+                exit(1);
+            }
+        }
+    }
+    fmt_fn fns[] = {cargs_fmt_bytes, legacy_fmt_bytes};
+    measure("fmt/bytes x10", op_fmt, &fns[0]);
+    measure("fmt/bytes-snprintf x10", op_fmt, &fns[1]);
+
+    fmt_table_ctx t;
+    t.n     = 1000;
+    t.cap   = t.n * 32;
+    t.vals  = (uint64_t *)xcalloc(t.n, sizeof *t.vals);
+    t.cells = (char *)xcalloc(t.cap, 1);
+    uint64_t x = 88172645463325252ull; /* xorshift: sizes over all units */
+    for (size_t i = 0; i < t.n; i++) {
+        x ^= x << 13, x ^= x >> 7, x ^= x << 17;
+        t.vals[i] = x >> (x & 63);
+    }
+    measure("fmt/table n=1000", op_fmt_table, &t);
+    free(t.vals);
+    free(t.cells);
+}
+
+/* ---------- help wrapping ---------- */
+/* The byte-counting wrapper the column-aware engine replaced */
+static void legacy_wrap(FILE *out, const char *p, int start_col, int width) {
+    while (*p) {
+        int         remaining = width - start_col;
+        const char *line_end = p, *last_space = NULL;
+        int         used = 0;
+        while (line_end[0] && line_end[0] != '\n' && used < remaining) {
+            if (line_end[0] == ' ') last_space = line_end;
+            line_end++;
+            used++;
+        }
+        if (!line_end[0] || line_end[0] == '\n') {
+            fwrite(p, 1, (size_t)(line_end - p), out);
+            fputc('\n', out);
+            p = line_end + (line_end[0] == '\n' ? 1 : 0);
+            if (*p) fprintf(out, "%*s", start_col, "");
+            continue;
+        }
+        if (last_space) {
+            fwrite(p, 1, (size_t)(last_space - p), out);
+            p = last_space + 1;
+        } else {
+            fwrite(p, 1, (size_t)remaining, out);
+            p += remaining;
+        }
+        fputc('\n', out);
+        fprintf(out, "%*s", start_col, "");
+    }
+}
+
+typedef struct {
+    const char *text;
+    bool        legacy;
+} wrap_ctx;
+
+static size_t op_wrap(void *ctx) {
+    wrap_ctx *c = (wrap_ctx *)ctx;
+    sink_reset();
+    if (c->legacy) legacy_wrap(sink, c->text, 32, 100);
+    else cargs_wrap_print(sink, c->text, 32, 100);
+    return sink_bytes();
+}
+
+/* 64 KiB of help text: plain English, then a translation with accented
+   Latin and CJK words */
+static char *make_text(const char *const *words, size_t nw) {
+    size_t cap = 64 * 1024, n = 0;
+    char  *t   = (char *)xcalloc(cap + 64, 1);
+    for (size_t i = 0; n < cap; i++) {
+        const char *w = words[(i * 7 + i / 5) % nw];
+        size_t      k = strlen(w);
+        memcpy(t + n, w, k);
+        n += k;
+        t[n++] = (i % 97 == 96) ? '\n' : ' ';
+    }
+    t[n] = '\0';
+    return t;
+}
+
+static void bench_wrap(void) {
+    static const char *const en[] = {
+        "write", "the", "output", "to", "FILE", "instead", "of", "standard",
+        "output,", "creating", "it", "when", "missing", "(default:", "-)",
+    };
+    static const char *const tr[] = {
+        "Ausgabe", "in", "DATEI", "schreiben", "statt", "\xc3\xbc" "ber",
+        "die", "Standardausgabe;", "fichier", "cr\xc3\xa9\xc3\xa9",
+        "\xe5\x87\xba\xe5\x8a\x9b\xe5\x85\x88", "\xe3\x83\x95\xe3\x82\xa1"
+        "\xe3\x82\xa4\xe3\x83\xab", "\xe3\x82\x92\xe4\xbd\x9c\xe6\x88\x90",
+        "\xed\x8c\x8c\xec\x9d\xbc", "\xec\x97\x90", "ausgeben.",
+    };
+    char    *a  = make_text(en, sizeof en / sizeof en[0]);
+    char    *u  = make_text(tr, sizeof tr / sizeof tr[0]);
+    wrap_ctx c[] = {{a, false}, {a, true}, {u, false}, {u, true}};
+    static const char *const names[] = {
+        "wrap/ascii-64k", "wrap/ascii-64k/bytewise", "wrap/utf8-64k",
+        "wrap/utf8-64k/bytewise",
+    };
+    for (size_t k = 0; k < 4; k++) measure(names[k], op_wrap, &c[k]);
+    free(a);
+    free(u);
+}
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--min-ms") == 0 && i + 1 < argc)
+            min_ns = strtod(argv[++i], NULL) * 1e6;
+        else
+            filter = argv[i];
+    }
+    sink = tmpfile();
+    if (!sink) {
+        perror("tmpfile");
+        return 1;
+    }
+    bench_opts(10);
+    bench_opts(1000);
+    bench_opts(10000);
+    bench_subs();
+    bench_complete();
+    bench_batch();
+    bench_config();
+    bench_depth();
+    bench_long_argv(1000);
+    bench_long_argv(100000);
+    bench_helpers();
+    bench_fmt();
+    bench_wrap();
+    fclose(sink);
+    return 0;
+}
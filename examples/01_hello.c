@@ -38,10 +38,10 @@ int main(int argc, char **argv) {
     st              S      = {.name = NULL, .repeat = 1, .quiet = 0};
 
     const cargs_opt opts[] = {
-        {"name",   'n', CARGS_ARG_REQUIRED, "NAME", "Name to greet",              cb_name,   NULL, NULL, 0, CARGS_GRP_NONE},
+        {"name",   'n', CARGS_ARG_REQUIRED, "NAME", "Name to greet",              cb_name,   NULL, NULL, 0, CARGS_GRP_NONE, {0}},
         {"repeat", 'r', CARGS_ARG_OPTIONAL, "N",    "Repeat N times (default 1)", cb_repeat, NULL, NULL, 0,
-         CARGS_GRP_NONE                                                                                                   },
-        {"quiet",  'q', CARGS_ARG_NONE,     NULL,   "No output",                  cb_quiet,  NULL, NULL, 0, CARGS_GRP_NONE},
+         CARGS_GRP_NONE,                                                                                                    {0}},
+        {"quiet",  'q', CARGS_ARG_NONE,     NULL,   "No output",                  cb_quiet,  NULL, NULL, 0, CARGS_GRP_NONE, {0}},
     };
 
     const cargs_cmd root = {
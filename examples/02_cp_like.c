@@ -1,10 +1,14 @@
+#include <fcntl.h>
 #include <stdio.h>
+#include <unistd.h>
 
 #include "c-args-parser.h"
 
 typedef struct {
-    int dry;
-    int verbose;
+    int          dry;
+    int          verbose;
+    cargs_stream files; /* --files-from source */
+    const char  *dst;
 } st;
 
 static int cb_dry(const char *v, void *u) {
@@ -19,6 +23,43 @@ static int cb_v(const char *v, void *u) {
     return CARGS_OK;
 }
 
+/* --files-from FILE|-: stream SRC paths (one per line, or NUL with -0) */
+static int cb_files_from(const char *v, void *u) {
+    st *S       = (st *)u;
+    S->files.fd = (v[0] == '-' && !v[1]) ? 0 : open(v, O_RDONLY);
+    if (S->files.fd < 0) {
+        perror(v);
+        return CARGS_ERR_BAD_FORMAT;
+    }
+    return CARGS_OK;
+}
+
+static int cb_null(const char *v, void *u) {
+    (void)v;
+    ((st *)u)->files.delim = '\0';
+    return CARGS_OK;
+}
+
+/* Streaming mode: argv's positionals come first, DST last as in run_cp,
+   then the streamed SRC paths while input is still being read. Streamed
+   batches point into S->files.items. */
+static int batch_cp(size_t first, size_t n, char **items, void *user) {
+    st *S = (st *)user;
+    (void)first;
+    if (items != S->files.items) {
+        S->dst = items[n - 1];
+        printf("Copy to %s (%s%s)\n", S->dst, S->dry ? "DRY-RUN" : "LIVE", S->verbose ? ", verbose" : "");
+        for (size_t k = 0; k + 1 < n; k++) printf("  - %s\n", items[k]);
+        return CARGS_OK;
+    }
+    if (!S->dst) {
+        fprintf(stderr, "need DST on the command line\n");
+        return CARGS_ERR_POSITIONAL;
+    }
+    for (size_t k = 0; k < n; k++) printf("  - %s\n", items[k]);
+    return CARGS_OK;
+}
+
 /* Schema: SRC{1..inf} DST{1} */
 static const cargs_pos pos_schema[] = {
     {"SRC", NULL, 1, CARGS_POS_INF},
@@ -27,6 +68,7 @@ static const cargs_pos pos_schema[] = {
 
 static int run_cp(int argc, char **argv, void *user) {
     st *S = (st *)user;
+    if (S->dst) return CARGS_OK; /* already streamed */
     if (argc < 2) {
         fprintf(stderr, "need SRC... DST\n");
         return 1;
@@ -38,10 +80,14 @@ static int run_cp(int argc, char **argv, void *user) {
 }
 
 int main(int argc, char **argv) {
-    st              S      = {0};
+    static char     buf[64 * 1024];
+    static char    *items[256];
+    st              S      = {.files = {-1, '\n', buf, sizeof buf, items, 256}};
     const cargs_opt opts[] = {
-        {"dry-run", 'n', CARGS_ARG_NONE, NULL, "Do not actually copy (dry run)", cb_dry, NULL, NULL, 0, CARGS_GRP_NONE},
-        {"verbose", 'V', CARGS_ARG_NONE, NULL, "Verbose output",                 cb_v,   NULL, NULL, 0, CARGS_GRP_NONE},
+        {"dry-run",    'n', CARGS_ARG_NONE,     NULL,   "Do not actually copy (dry run)",       cb_dry,        NULL, NULL, 0, CARGS_GRP_NONE, {0}},
+        {"verbose",    'V', CARGS_ARG_NONE,     NULL,   "Verbose output",                       cb_v,          NULL, NULL, 0, CARGS_GRP_NONE, {0}},
+        {"files-from", 0,   CARGS_ARG_REQUIRED, "FILE", "Read SRC paths from FILE (- = stdin)", cb_files_from, NULL, NULL, 0, CARGS_GRP_NONE, {0}},
+        {"null",       '0', CARGS_ARG_NONE,     NULL,   "--files-from items are NUL-separated", cb_null,       NULL, NULL, 0, CARGS_GRP_NONE, {0}},
     };
     const cargs_cmd root = {
         .name        = NULL,
@@ -54,7 +100,8 @@ int main(int argc, char **argv) {
         .alias_count = 0,
         .pos         = pos_schema,
         .pos_count   = 2,
-        .run         = run_cp
+        .run         = run_cp,
+        .pos_batch   = batch_cp
     };
 
     cargs_env env = {
@@ -67,8 +114,11 @@ int main(int argc, char **argv) {
         .wrap_cols    = 90,
         .color        = true,
         .out          = stdout,
-        .err          = stderr
+        .err          = stderr,
+        .stream       = &S.files
     };
 
-    return cargs_dispatch(&env, &root, argc, argv, &S) < 0 ? 1 : 0;
+    int rc = cargs_dispatch(&env, &root, argc, argv, &S);
+    if (S.files.fd > 0) close(S.files.fd);
+    return rc < 0 ? 1 : 0;
 }
@@ -44,10 +44,10 @@ int main(int argc, char **argv) {
 
     /* group 1: XOR (choose at most one), group 2: REQ_ONE (exactly one) */
     const cargs_opt opts[] = {
-        {"json",  0, CARGS_ARG_NONE, NULL, "Output JSON", cb_json,  NULL, NULL, 1, CARGS_GRP_XOR    },
-        {"yaml",  0, CARGS_ARG_NONE, NULL, "Output YAML", cb_yaml,  NULL, NULL, 1, CARGS_GRP_XOR    },
-        {"light", 0, CARGS_ARG_NONE, NULL, "Light theme", cb_light, NULL, NULL, 2, CARGS_GRP_REQ_ONE},
-        {"dark",  0, CARGS_ARG_NONE, NULL, "Dark theme",  cb_dark,  NULL, NULL, 2, CARGS_GRP_REQ_ONE},
+        {"json",  0, CARGS_ARG_NONE, NULL, "Output JSON", cb_json,  NULL, NULL, 1, CARGS_GRP_XOR,     {0}},
+        {"yaml",  0, CARGS_ARG_NONE, NULL, "Output YAML", cb_yaml,  NULL, NULL, 1, CARGS_GRP_XOR,     {0}},
+        {"light", 0, CARGS_ARG_NONE, NULL, "Light theme", cb_light, NULL, NULL, 2, CARGS_GRP_REQ_ONE, {0}},
+        {"dark",  0, CARGS_ARG_NONE, NULL, "Dark theme",  cb_dark,  NULL, NULL, 2, CARGS_GRP_REQ_ONE, {0}},
     };
 
     const cargs_cmd root = {
@@ -1,15 +1,36 @@
-// Demonstrates: --md [FILE], --man [SEC:FILE], --completion [SHELL[:FILE]]
+// Demonstrates: --md [FILE], --man [SEC:FILE], --json [FILE],
+// --completion [SHELL[:FILE]] and --blobs FILE, the build-time generator.
+// Built with -DEX_DOCS_BLOBS and the header it wrote, outputs are served from
+// the prebuilt blobs.
 #include <stdio.h>
 #include <string.h>
 
 #include "c-args-parser.h"
 
+#ifdef EX_DOCS_BLOBS
+#    include "ex_docs_blobs.h"
+#    define BLOBS (&ex_docs_blobs)
+#else
+#    define BLOBS NULL
+#endif
+
 typedef struct {
     int                     did;
     const cargs_env        *envp;
     const struct cargs_cmd *rootp;
+    const cargs_blobs      *blobs; /* BLOBS if still current */
+    int                     checked;
 } st;
 
+/* Compare BLOBS with the tree on first use only: one hash per run */
+static const cargs_blobs *blobs_of(st *S) {
+    if (!S->checked) {
+        S->blobs   = cargs_blobs_check(S->envp, S->rootp, S->envp->prog ? S->envp->prog : "prog", BLOBS);
+        S->checked = 1;
+    }
+    return S->blobs;
+}
+
 /* --md [FILE] */
 static int cb_md(const char *v, void *u) {
     st   *S = (st *)u;
@@ -18,7 +39,7 @@ static int cb_md(const char *v, void *u) {
         perror("fopen");
         return -1;
     }
-    cargs_emit_markdown(S->envp, S->rootp, S->envp->prog ? S->envp->prog : "prog", f);
+    cargs_emit_checked(S->envp, S->rootp, S->envp->prog ? S->envp->prog : "prog", f, blobs_of(S), CARGS_BLOB_MARKDOWN);
     if (f != stdout) fclose(f);
     S->did = 1;
     return CARGS_OK;
@@ -50,7 +71,23 @@ static int cb_man(const char *v, void *u) {
         perror("fopen");
         return -1;
     }
-    cargs_emit_man(S->envp, S->rootp, S->envp->prog ? S->envp->prog : "prog", f, sec);
+    const char *prog = S->envp->prog ? S->envp->prog : "prog";
+    if (strcmp(sec, "1") == 0) cargs_emit_checked(S->envp, S->rootp, prog, f, blobs_of(S), CARGS_BLOB_MAN);
+    else cargs_emit_man(S->envp, S->rootp, prog, f, sec);
+    if (f != stdout) fclose(f);
+    S->did = 1;
+    return CARGS_OK;
+}
+
+/* --json [FILE]: the tree for tools that check command lines offline */
+static int cb_json(const char *v, void *u) {
+    st   *S = (st *)u;
+    FILE *f = v && *v ? fopen(v, "w") : stdout;
+    if (!f) {
+        perror("fopen");
+        return -1;
+    }
+    cargs_emit_json(S->envp, S->rootp, S->envp->prog ? S->envp->prog : "prog", f);
     if (f != stdout) fclose(f);
     S->did = 1;
     return CARGS_OK;
@@ -84,9 +121,9 @@ static int cb_completion(const char *v, void *u) {
     }
 
     const char *prog = S->envp->prog ? S->envp->prog : "prog";
-    if (strcmp(shell, "bash") == 0) cargs_emit_completion_bash(S->envp, S->rootp, prog, f);
-    else if (strcmp(shell, "zsh") == 0) cargs_emit_completion_zsh(S->envp, S->rootp, prog, f);
-    else if (strcmp(shell, "fish") == 0) cargs_emit_completion_fish(S->envp, S->rootp, prog, f);
+    if (strcmp(shell, "bash") == 0) cargs_emit_checked(S->envp, S->rootp, prog, f, blobs_of(S), CARGS_BLOB_BASH);
+    else if (strcmp(shell, "zsh") == 0) cargs_emit_checked(S->envp, S->rootp, prog, f, blobs_of(S), CARGS_BLOB_ZSH);
+    else if (strcmp(shell, "fish") == 0) cargs_emit_checked(S->envp, S->rootp, prog, f, blobs_of(S), CARGS_BLOB_FISH);
     else {
         fprintf(stderr, "unknown shell: %s\n", shell);
         if (f != stdout) fclose(f);
@@ -98,6 +135,18 @@ static int cb_completion(const char *v, void *u) {
     return CARGS_OK;
 }
 
+/* --blobs FILE: write every output above as a C header (build step) */
+static int cb_blobs(const char *v, void *u) {
+    st *S  = (st *)u;
+    int rc = cargs_write_blobs(S->envp, S->rootp, S->envp->prog ? S->envp->prog : "prog", v, "ex_docs_blobs");
+    if (rc < 0) {
+        perror(v);
+        return -1;
+    }
+    S->did = 1;
+    return CARGS_OK;
+}
+
 /* If nothing chosen, show help */
 static int run_root(int argc, char **argv, void *user) {
     st *S = (st *)user;
@@ -112,11 +161,15 @@ int main(int argc, char **argv) {
 
     const cargs_opt opts[] = {
         {"md",         0, CARGS_ARG_OPTIONAL, "[FILE]",         "Emit Markdown to FILE or stdout",     cb_md,         NULL, NULL, 0,
-         CARGS_GRP_NONE                                                                                                                            },
+         CARGS_GRP_NONE,                                                                                                                             {0}},
         {"man",        0, CARGS_ARG_OPTIONAL, "[SEC:FILE]",     "Emit man(7) to FILE (default sec=1)", cb_man,        NULL, NULL, 0,
-         CARGS_GRP_NONE                                                                                                                            },
+         CARGS_GRP_NONE,                                                                                                                             {0}},
+        {"json",       0, CARGS_ARG_OPTIONAL, "[FILE]",         "Emit the command tree as JSON",       cb_json,       NULL, NULL, 0,
+         CARGS_GRP_NONE,                                                                                                                             {0}},
         {"completion", 0, CARGS_ARG_OPTIONAL, "[SHELL[:FILE]]", "Emit completion for bash/zsh/fish",   cb_completion,
-         NULL,                                                                                                              NULL, 0, CARGS_GRP_NONE},
+         NULL,                                                                                                              NULL, 0, CARGS_GRP_NONE, {0}},
+        {"blobs",      0, CARGS_ARG_REQUIRED, "FILE",           "Write prebuilt docs/completions header", cb_blobs,   NULL, NULL, 0,
+         CARGS_GRP_NONE,                                                                                                                             {0}},
     };
 
     const cargs_cmd root = {
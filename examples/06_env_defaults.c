@@ -1,5 +1,6 @@
 // Demonstrates environment defaults + CLI override precedence.
 // Env first (JOBS, OUT, FMT, LEVEL), CLI can override.
+// `ex-env __complete --format ""` lists the formats for shell completion.
 
 #include <stdio.h>
 #include <string.h>
@@ -58,6 +59,15 @@ static int cb_format(const char *v, void *u) {
     return CARGS_OK;
 }
 
+/* values offered by "ex-env __complete --format PREFIX" */
+static int complete_format(const char *prefix, const cargs_opt *o, cargs_completion *c, void *u) {
+    (void)prefix;
+    (void)o;
+    (void)u;
+    if (cargs_complete_add(c, "json") == CARGS_OK) cargs_complete_add(c, "yaml");
+    return CARGS_OK;
+}
+
 static int run_root(int argc, char **argv, void *user) {
     (void)argc;
     (void)argv;
@@ -76,15 +86,15 @@ int main(int argc, char **argv) {
     const cargs_opt opts[] = {
         // REQUIRED with env/defaults:
         {"jobs",   'j', CARGS_ARG_REQUIRED, "N",    "Worker count (env JOBS, default 4)",        cb_jobs,   "JOBS",  "4",       0,
-         CARGS_GRP_NONE                                                                                                                          },
+         CARGS_GRP_NONE,                                                                                                                           {0}},
         {"output", 'o', CARGS_ARG_REQUIRED, "FILE", "Output file (env OUT, default out.bin)",    cb_out,    "OUT",   "out.bin",
-         0,                                                                                                                        CARGS_GRP_NONE},
+         0,                                                                                                                        CARGS_GRP_NONE, {0}},
         {"format", 0,   CARGS_ARG_REQUIRED, "KIND", "Format: json|yaml (env FMT, default json)", cb_format, "FMT",   "json",
-         0,                                                                                                                        CARGS_GRP_NONE},
+         0,                                                                                                                        CARGS_GRP_NONE, CARGS_COMPLETE(complete_format)},
 
         // OPTIONAL with env/default (no default given here; LEVEL=... triggers it)
         {"level",  'L', CARGS_ARG_OPTIONAL, "N",    "Verbosity level (bare -L -> 1; env LEVEL)", cb_level,  "LEVEL", NULL,      0,
-         CARGS_GRP_NONE                                                                                                                          },
+         CARGS_GRP_NONE,                                                                                                                           {0}},
     };
 
     const cargs_cmd root = {
@@ -111,7 +121,8 @@ int main(int argc, char **argv) {
         .wrap_cols    = 90,
         .color        = true,
         .out          = stdout,
-        .err          = stderr
+        .err          = stderr,
+        .complete     = true
     };
 
     return cargs_dispatch(&env, &root, argc, argv, &S) < 0 ? 1 : 0;
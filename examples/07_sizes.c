@@ -81,11 +81,11 @@ int main(int argc, char **argv) {
     st              S      = {0};
 
     const cargs_opt opts[] = {
-        {"verbose", 'V', CARGS_ARG_NONE,     NULL,   "Verbose output",                         cb_verbose, NULL,    NULL,  0, CARGS_GRP_NONE},
+        {"verbose", 'V', CARGS_ARG_NONE,     NULL,   "Verbose output",                         cb_verbose, NULL,    NULL,  0, CARGS_GRP_NONE, {0}},
         {"limit",   'l', CARGS_ARG_OPTIONAL, "SIZE", "Max size (IEC: KiB/MiB/...), env LIMIT", cb_limit,   "LIMIT",
-         "128MiB",                                                                                                         0, CARGS_GRP_NONE},
+         "128MiB",                                                                                                         0, CARGS_GRP_NONE, {0}},
         {"rate",    'r', CARGS_ARG_REQUIRED, "SIZE", "Throughput (SI: KB/MB/...),  env RATE",  cb_rate,    "RATE",  "5MB", 0,
-         CARGS_GRP_NONE                                                                                                                     },
+         CARGS_GRP_NONE,                                                                                                                      {0}},
     };
 
     const cargs_cmd root = {
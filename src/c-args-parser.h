@@ -6,17 +6,55 @@
 #include <ctype.h>
 #include <errno.h>
 #include <limits.h>
+#include <stdarg.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#    include <fcntl.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#    define CARGS__POSIX 1
+/* nanoseconds of st_mtime, where struct stat has them */
+#    if defined(__APPLE__) \
+        && (!defined(_POSIX_C_SOURCE) || defined(_DARWIN_C_SOURCE))
+#        define CARGS__MTIME_NS(st) ((st).st_mtimespec.tv_nsec)
+#    elif defined(__APPLE__) || (defined(__GLIBC__) && !defined(st_mtime))
+#        define CARGS__MTIME_NS(st) ((st).st_mtimensec)
+#    elif defined(_POSIX_VERSION) && _POSIX_VERSION >= 200809L
+#        define CARGS__MTIME_NS(st) ((st).st_mtim.tv_nsec)
+#    endif
+#    ifndef CARGS_NO_MMAP
+#        include <sys/mman.h>
+#        define CARGS__HAVE_MMAP 1
+#    endif
+#elif defined(_WIN32)
+#    include <io.h>
+#    include <process.h>
+#endif
+/* cargs_dispatch_batch runs jobs on POSIX threads when CARGS_ENABLE_THREADS
+   is defined (link with -pthread); otherwise on the calling thread */
+#if defined(CARGS_ENABLE_THREADS) && defined(CARGS__POSIX) \
+    && (defined(__GNUC__) || defined(__clang__))
+#    include <pthread.h>
+#    define CARGS__THREADS 1
+#endif
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 /* ===== Public API ===== */
+/* Library version. Before 1.0 a minor bump may break source compatibility:
+   0.2 added the trailing bind member to cargs_opt (see the README) */
+#define CARGS_VERSION_MAJOR 0
+#define CARGS_VERSION_MINOR 2
+#define CARGS_VERSION_PATCH 0
+
 typedef enum {
     CARGS_ARG_NONE = 0,
     CARGS_ARG_REQUIRED,
@@ -27,6 +65,8 @@ typedef enum {
 #define CARGS_GRP_NONE    0
 #define CARGS_GRP_XOR     1 /* at most one */
 #define CARGS_GRP_REQ_ONE 2 /* exactly one (env/default counts) */
+#define CARGS_GRP_ANY     3 /* at least one (env/default counts) */
+#define CARGS_GROUP_MAX   63 /* group ids are 1..63 */
 
 /* Return codes */
 #define CARGS_OK              0
@@ -37,12 +77,80 @@ typedef enum {
 #define CARGS_ERR_GROUP       -4
 #define CARGS_ERR_POSITIONAL  -5
 #define CARGS_ERR_TOO_MANY    -6
+#define CARGS_ERR_RESPONSE    -7 /* @file unreadable, too deep or arena full */
+#define CARGS_ERR_LIMIT       -8 /* a cargs_limits cap was exceeded */
 
 /* Option callback: value may be NULL for NONE or missing OPTIONAL. */
 typedef int (*cargs_cb)(const char *value, void *user);
 
-/* One option descriptor */
+/* Length-aware callback (see cargs_bind.call): value[0..len) as above (NULL,
+ * 0 when absent) plus the option that fired, so one handler can serve a
+ * whole table. value is still NUL-terminated. */
+struct cargs_opt;
+typedef int (*cargs_call)(
+    const char *value, size_t len, const struct cargs_opt *opt, void *user
+);
+
+/* Value completer (see cargs_bind.complete), run by the hidden
+ * "prog __complete WORDS..." endpoint (env->complete): offer candidates for
+ * opt's value with cargs_complete_add(). prefix is the part typed so far;
+ * candidates that do not start with it are dropped for you. */
+struct cargs_completion;
+typedef int (*cargs_completer)(
+    const char *prefix, const struct cargs_opt *opt,
+    struct cargs_completion *out, void *user
+);
+
+/* Typed binding: the parser decodes the value straight into target (no
+ * callback). Target types:
+ *   FLAG      bool*         no value -> true; else 1/0, true/false, yes/no, on/off
+ *   COUNT     int*          no value -> ++; else set to the integer given
+ *   INT       int*          strict, 0x/0b prefixes (cargs_read_i32)
+ *   U64       uint64_t*     strict, 0x/0b prefixes (cargs_read_u64)
+ *   SIZE_SI   uint64_t*     cargs_read_size_si   ("12MB" = 12000000)
+ *   SIZE_IEC  uint64_t*     cargs_read_size_iec  ("12M"  = 12582912)
+ *   STR       const char**  the argv string itself (NULL = no value)
+ *   ENUM      int*          value of the matching choices[] name
+ *   DURATION  uint64_t*     cargs_read_duration, ns ("1h30m", "250ms")
+ *   RATE      uint64_t*     cargs_read_rate, bytes/s ("10MB/s", "1GiB/h")
+ * A missing OPTIONAL value leaves all but FLAG, COUNT and STR untouched.
+ * cb, if also set, runs after a successful decode, then call (which may be
+ * used alone, with kind NONE: CARGS_CALL(fn)). */
+typedef enum {
+    CARGS_BIND_NONE = 0,
+    CARGS_BIND_FLAG,
+    CARGS_BIND_COUNT,
+    CARGS_BIND_INT,
+    CARGS_BIND_U64,
+    CARGS_BIND_SIZE_SI,
+    CARGS_BIND_SIZE_IEC,
+    CARGS_BIND_STR,
+    CARGS_BIND_ENUM,
+    CARGS_BIND_DURATION,
+    CARGS_BIND_RATE
+} cargs_bind_kind;
+
+/* Enum table entry; terminate the table with {NULL, 0} */
+typedef struct {
+    const char *name;
+    int         value;
+} cargs_choice;
+
 typedef struct {
+    cargs_bind_kind     kind;
+    void               *target;
+    const cargs_choice *choices;  /* CARGS_BIND_ENUM only */
+    cargs_call          call;     /* optional length-aware callback */
+    cargs_completer     complete; /* optional; ENUM completes its choices */
+} cargs_bind;
+
+#define CARGS_BIND(kind, ptr)       {(kind), (ptr), NULL, NULL, NULL}
+#define CARGS_BIND_ENUM_TO(ptr, ch) {CARGS_BIND_ENUM, (ptr), (ch), NULL, NULL}
+#define CARGS_CALL(fn)              {CARGS_BIND_NONE, NULL, NULL, (fn), NULL}
+#define CARGS_COMPLETE(fn)          {CARGS_BIND_NONE, NULL, NULL, NULL, (fn)}
+
+/* One option descriptor */
+typedef struct cargs_opt {
     const char    *long_name;  /* e.g., "output" (for --output); NULL if none */
     char           short_name; /* e.g., 'o' (for -o); 0 if none */
     cargs_arg_kind arg;        /* NONE / REQUIRED / OPTIONAL */
@@ -54,9 +162,11 @@ typedef struct {
                         before argv) */
     const char *def; /* string default if env is unset; may be NULL */
     /* Mutually-exclusive grouping */
-    uint8_t group;        /* 0 = none; 1..32 = group id */
+    uint8_t group;        /* 0 = none; 1..CARGS_GROUP_MAX = group id */
     uint8_t group_policy; /* CARGS_GRP_* policy (recommend same for all options
                              of a group) */
+    /* Optional typed binding ({0} = none); see cargs_bind_kind */
+    cargs_bind bind;
 } cargs_opt;
 
 /* Positional argument schema macros */
@@ -82,6 +192,25 @@ typedef struct {
     uint16_t    max;  /* maximum occurrences (CARGS_POS_INF for unbounded) */
 } cargs_pos;
 
+/* Diagnostic sink: receives each error message as one write */
+typedef struct cargs_sink {
+    void (*write)(void *ctx, const char *msg, size_t len);
+    void *ctx;
+} cargs_sink;
+
+/* Caps for parsing untrusted input (0 = no cap), so the cost of one
+ * cargs_dispatch has a fixed bound. argc and token length are checked before
+ * anything is parsed: on argv before @file expansion, then on each file's
+ * words as it is loaded. The rest are checked as parsing reaches them;
+ * exceeding one fails with CARGS_ERR_LIMIT. */
+typedef struct cargs_limits {
+    size_t   max_argc;      /* argv words, argv[0] included */
+    size_t   max_token;     /* bytes in one argv word */
+    unsigned max_shorts;    /* flags in one grouped token (-abc = 3) */
+    unsigned max_callbacks; /* cb, bind.call, pos_batch and run calls */
+    unsigned max_depth;     /* subcommand levels below the root */
+} cargs_limits;
+
 /* Global configuration and I/O */
 typedef struct {
     const char *prog;         /* program name */
@@ -96,8 +225,133 @@ typedef struct {
     bool  color;   /* enable ANSI colors unless NO_COLOR is set */
     FILE *out;     /* default stdout */
     FILE *err;     /* default stderr */
+    /* Optional: diagnostics go here instead of err */
+    const cargs_sink *err_sink;
+    /* Optional lookup index from cargs_compile(); ignored unless built for the
+       root passed to cargs_dispatch */
+    const struct cargs_index *index;
+    /* Optional environment snapshot from cargs_envsnap_build(); when set, all
+       env lookups (option env defaults, NO_COLOR, COLUMNS) are served from it
+       and the process environment is not consulted */
+    const struct cargs_envsnap *envsnap;
+    /* Optional help render buffer: help pages are built here and written with
+       a single fwrite (chunked flushes if it fills up). NULL = small stack
+       buffer, or env->arena when set (still a single fwrite) */
+    char  *help_buf;
+    size_t help_buf_cap;
+    /* Optional pre-resolved presentation (see cargs_pres_resolve); when set,
+       color, wrap_cols, NO_COLOR and COLUMNS are not consulted for help */
+    const struct cargs_pres *pres;
+    /* Fit the help left column to the widest row of the tree (still capped at
+       30) instead of the fixed 30 columns */
+    bool help_fit;
+    /* Response files: when set, "@path" arguments are replaced by the words
+       of that file (shell-style quoting, nested up to response_depth levels;
+       0 = 8). Files are mapped privately and tokenized in place; the new argv
+       array comes from arena (else a 2 KiB stack buffer). Expansion stops at
+       the first "--", in argv or in a file */
+    bool     response_files;
+    unsigned response_depth;
+    /* Optional scratch for whatever does not fit a fixed buffer: @files,
+       diagnostics over 512 bytes, help pages (when help_buf is NULL),
+       command paths deeper than 16 levels and lists in diagnostics over 256
+       bytes (without it those two fail with CARGS_ERR_TOO_MANY). Rewound
+       when cargs_dispatch returns */
+    struct cargs_arena *arena;
+    /* Streaming positional source for commands with pos_batch (see
+       cargs_stream); typically armed by a --files-from callback */
+    struct cargs_stream *stream;
+    /* Optional instrumentation, filled only when built with
+       CARGS_ENABLE_STATS (see cargs_stats) */
+    struct cargs_stats *stats;
+    /* Accept a unique prefix of a subcommand name or alias ("rem" for
+       "remote"); exact names always win, an ambiguous prefix is an error */
+    bool sub_prefix;
+    /* Optional: details of a failed unknown option / command (cargs_error) */
+    struct cargs_error *error;
+    /* "Did you mean" hints: at most this many names are compared per unknown
+       word (0 = 1024, < 0 = no suggestions) */
+    int suggest_budget;
+    /* Optional config-file layer from cargs_config_load(); its values apply
+       below env vars and argv (def < config < env < argv) */
+    const struct cargs_config *config;
+    /* Optional deferred mode (see cargs_events): occurrences are logged and
+       validated, and callbacks run only once the whole command line checks
+       out */
+    struct cargs_events *events;
+    /* Optional resource caps (see cargs_limits) */
+    const cargs_limits *limits;
+    /* Serve "prog __complete WORDS... CUR" (hidden; see cargs_completion):
+       the emitted completion scripts then ask it for the values of options
+       that have a completer or choices. complete_ms bounds one request
+       (0 = 100 ms) */
+    bool     complete;
+    unsigned complete_ms;
+    /* private: per-dispatch state, set on the dispatcher's own copy */
+    struct cargs__walk *walk_;
 } cargs_env;
 
+/* Structured failure details, reset by each cargs_dispatch. Filled when an
+ * option is unknown, or when a word is not a subcommand of a command that
+ * takes no positionals and a close subcommand name exists. */
+typedef struct cargs_error {
+    int         code;       /* CARGS_ERR_*; CARGS_OK if nothing failed */
+    const char *arg;        /* offending word, points into argv ("-x") */
+    const char *suggestion; /* closest name ("json", "remote") or NULL */
+    bool        command;    /* arg was taken as a subcommand name */
+} cargs_error;
+
+/* Deferred callbacks: with env->events set, cargs_dispatch logs each
+ * occurrence (option, value, source) instead of delivering it. Typed values
+ * are decoded into scratch to validate them, and groups, relations and
+ * positionals are checked for every level. Only then are the entries still
+ * live delivered in order, before run. A failed parse, --help or --version
+ * runs no callbacks at all. (With a streaming command, entries are delivered
+ * before the stream is read, as a --files-from callback may arm it.)
+ *
+ * An option given on argv drops that level's env, config and default entry
+ * for it, except for COUNT bindings, whose increments build on it. With
+ * last_wins, a repeated value-taking option keeps only its last occurrence;
+ * leave it off if a callback accumulates (-I DIR). A full log fails the
+ * parse with CARGS_ERR_TOO_MANY. */
+typedef enum {
+    CARGS_SRC_DEFAULT,
+    CARGS_SRC_CONFIG,
+    CARGS_SRC_ENV,
+    CARGS_SRC_ARGV
+} cargs_source;
+
+typedef struct {
+    const cargs_opt *opt;
+    const char      *value;  /* NULL if none was given */
+    uint8_t          source; /* cargs_source */
+    bool             live;   /* false once superseded (not delivered) */
+} cargs_event;
+
+typedef struct cargs_events {
+    cargs_event *buf;
+    size_t       cap;
+    bool         last_wins;
+    size_t       count; /* out: entries logged by the last dispatch */
+    /* private: the current level's first entry and first argv entry */
+    size_t level_, argv_;
+} cargs_events;
+
+/* Relation between two options of the same command. Options are named by
+ * long name, or by their short name as a one-letter string if they have no
+ * long name. REQUIRES: using opt on the command line needs other (env and
+ * defaults satisfy it). CONFLICTS: opt and other are never given together
+ * on the command line. At most CARGS_REL_MAX per command; a name that is no
+ * option of the command fails dispatch with CARGS_ERR_BAD_FORMAT. */
+#define CARGS_REL_REQUIRES  1
+#define CARGS_REL_CONFLICTS 2
+#define CARGS_REL_MAX       32
+typedef struct {
+    uint8_t     kind;
+    const char *opt;
+    const char *other;
+} cargs_rel;
+
 /* Subcommand node */
 typedef struct cargs_cmd cargs_cmd;
 struct cargs_cmd {
@@ -117,13 +371,384 @@ struct cargs_cmd {
      * with remaining positional arguments. Can be NULL — we'll print help.
      */
     int (*run)(int argc, char **argv, void *user);
+    /*
+     * pos_batch(first, n, items, user): streaming positionals (optional).
+     * When set and env->stream has a source, positionals are delivered in
+     * batches instead: argv's first, then items read from the stream. The
+     * schema's total min/max is checked as they arrive; items are valid only
+     * during the call. run() is still called afterwards with argv's part.
+     */
+    int (*pos_batch)(size_t first, size_t n, char **items, void *user);
+    /* Option relations checked after this level is parsed (may be NULL) */
+    const cargs_rel *rels;
+    size_t           rel_count;
 };
 
+/* Group policies of one command as bitsets (bit g = group g) */
+typedef struct {
+    uint64_t xor_mask; /* at most one */
+    uint64_t req_mask; /* exactly one */
+    uint64_t any_mask; /* at least one */
+} cargs_group_plan;
+
+/* Bump allocator over caller storage, shared by everything that needs
+ * scratch memory: response files, config files, cargs_parse_line, long
+ * diagnostics, help pages, deep command paths and the _arena builders of the
+ * index and env snapshot. Nothing is ever freed
+ * individually; rewind to a cargs_arena_save() mark. When a request does not
+ * fit and grow is set, grow(grow_ctx, n, &cap) is asked for another block of
+ * at least n bytes (cap = its size) and the arena carries on there; blocks
+ * stay the caller's to release. high is the most ever in use, in bytes, for
+ * sizing a static buffer per tool. */
+typedef void *(*cargs_arena_grow)(void *ctx, size_t min, size_t *cap);
+
+typedef struct cargs_arena {
+    unsigned char   *base;
+    size_t           cap;
+    size_t           used;
+    cargs_arena_grow grow; /* optional */
+    void            *grow_ctx;
+    size_t           spent; /* bytes used in blocks left for a new one */
+    size_t           high;  /* high-water mark of spent + used */
+} cargs_arena;
+
+typedef struct {
+    unsigned char *base;
+    size_t         cap, used, spent;
+} cargs_arena_mark;
+
+static inline void  cargs_arena_init(cargs_arena *a, void *buf, size_t cap);
+/* n bytes aligned to align (a power of two), or NULL if the arena is full
+   and cannot grow. */
+static inline void *cargs_arena_alloc(cargs_arena *a, size_t n, size_t align);
+static inline cargs_arena_mark cargs_arena_save(const cargs_arena *a);
+static inline void cargs_arena_rewind(cargs_arena *a, cargs_arena_mark m);
+
+/* Subcommand name or alias in a node's name table, which is sorted by name
+   (strcmp) and then by sub, so the first definition of a name comes first */
+typedef struct {
+    const char *name;
+    uint32_t    sub; /* index into cmd->subs */
+} cargs_index_name;
+
+/* Compiled lookup index (optional, read-only, lives in caller storage).
+ * Nodes are laid out breadth-first, so the children of a node are contiguous
+ * starting at first_sub. Built by cargs_compile(); without it the parser falls
+ * back to linear scans. Subcommands are found by binary search in names. */
+typedef struct {
+    const cargs_cmd        *cmd;    /* command this node indexes */
+    const uint16_t         *shorts; /* 256 entries: opt index + 1, 0 = none */
+    const uint32_t         *longs;  /* open addressing: tag | opt index + 1 */
+    const cargs_index_name *names;  /* subs names + aliases, sorted */
+    uint32_t                long_mask;  /* slot count - 1, 0 if none */
+    uint32_t                first_sub;  /* node index of cmd->subs[0] */
+    uint32_t                name_count; /* entries in names */
+    cargs_group_plan        groups;     /* precomputed group policies */
+} cargs_index_node;
+
+typedef struct cargs_index {
+    const cargs_cmd        *root;
+    const cargs_index_node *nodes; /* nodes[0] indexes root */
+    size_t                  node_count;
+} cargs_index;
+
+/* Bytes of storage cargs_compile() needs for this tree. */
+static inline size_t cargs_compile_size(const cargs_cmd *root);
+/* Build the index into storage; returns NULL if cap is too small or a command
+   has more than 65535 options or CARGS_REL_MAX relations. Set env->index to
+   the result. */
+static inline const cargs_index *cargs_compile(
+    const cargs_cmd *root, void *storage, size_t cap
+);
+/* cargs_compile() into cargs_compile_size(root) bytes of arena. */
+static inline const cargs_index *cargs_compile_arena(
+    const cargs_cmd *root, cargs_arena *arena
+);
+
+/* Environment snapshot (optional, lives in caller storage).
+ * Indexes only the variable names the tree references (each opt->env, plus
+ * NO_COLOR and COLUMNS) and fills them with one pass over an envp array. */
+typedef struct {
+    const char *name;  /* referenced variable name; NULL = empty slot */
+    const char *value; /* NULL if unset */
+    uint32_t    hash;
+} cargs_env_var;
+
+typedef struct cargs_envsnap {
+    const cargs_env_var *vars; /* open-addressed table */
+    uint32_t             mask; /* slot count - 1 (power of two) */
+} cargs_envsnap;
+
+/* Bytes of storage cargs_envsnap_build() needs for this tree. */
+static inline size_t cargs_envsnap_size(const cargs_cmd *root);
+/* Snapshot envp ("NAME=value" strings, NULL-terminated; NULL = the process
+   environment). Strings are referenced, not copied. NULL if cap is too small.
+ */
+static inline const cargs_envsnap *cargs_envsnap_build(
+    const cargs_cmd *root, const char *const *envp, void *storage, size_t cap
+);
+/* cargs_envsnap_build() into cargs_envsnap_size(root) bytes of arena. */
+static inline const cargs_envsnap *cargs_envsnap_build_arena(
+    const cargs_cmd *root, const char *const *envp, cargs_arena *arena
+);
+/* Value of a referenced variable, or NULL if unset or not referenced. */
+static inline const char *cargs_envsnap_get(
+    const cargs_envsnap *snap, const char *name
+);
+
+/* Config files: defaults keyed by long option name and subcommand path,
+ * applied before env vars and argv (set env->config):
+ *
+ *   # comment lines start with '#' or ';'
+ *   jobs = 8                root options first
+ *   [remote add]            a subcommand path (names or aliases); [] = root
+ *   url = "git@host:x y"    one word per value, quoted as in response files
+ *
+ * The file is mapped privately (or read into the arena) and tokenized in
+ * place, so values point into it until cargs_config_close(). With a
+ * snapshot path, the parsed entries are also cached there in binary form; a
+ * later load that finds the file's size and mtime, and the tree's option
+ * layout, unchanged reads the snapshot and does not parse at all. */
+typedef struct {
+    const cargs_opt *opt;   /* NULL = empty slot */
+    const char      *value; /* NUL-terminated */
+} cargs_config_entry;
+
+typedef struct cargs_config {
+    const cargs_config_entry *entries; /* open-addressed by opt */
+    uint32_t                  mask;    /* slot count - 1 (power of two) */
+    size_t                    count;   /* keys set */
+    bool                      from_snapshot; /* parsing was skipped */
+    void                     *map;     /* mapping to release, NULL if none */
+    size_t                    map_len;
+} cargs_config;
+
+/* Arena bytes of tables cargs_config_load() needs for this tree; a file that
+   cannot be mapped is read into the arena too (add its size + 1). */
+static inline size_t cargs_config_size(const cargs_cmd *root);
+/* Load path for root into cfg, using (or refreshing) snapshot if not NULL.
+   Returns CARGS_OK, 1 if path does not exist (cfg is then empty),
+   CARGS_ERR_UNKNOWN for an unknown key or section, CARGS_ERR_BAD_FORMAT for a
+   malformed line, or CARGS_ERR_RESPONSE if it cannot be read; errors are
+   reported through env with the file and line. Later duplicates win. On
+   failure the arena is rewound to where it was. */
+static inline int cargs_config_load(
+    cargs_config *cfg, const cargs_env *env, const cargs_cmd *root,
+    const char *path, const char *snapshot, cargs_arena *arena
+);
+/* Release the mapping behind cfg's values. */
+static inline void cargs_config_close(cargs_config *cfg);
+/* Configured value of opt, or NULL. */
+static inline const char *cargs_config_get(
+    const cargs_config *cfg, const cargs_opt *opt
+);
+
+/* Positional stream: delim-separated items read from fd with bounded memory.
+ * buf holds raw bytes (an item longer than cap - 1 is an error) and items one
+ * batch of pointers into it. Empty items are skipped. */
+typedef struct cargs_stream {
+    int     fd;    /* source; < 0 = not armed (e.g. 0 for "--files-from -") */
+    char    delim; /* '\0' (find -print0) or '\n' */
+    char   *buf;
+    size_t  cap;
+    char  **items;
+    size_t  items_cap; /* max batch size */
+} cargs_stream;
+
+/* Parse instrumentation. Compiled in only when CARGS_ENABLE_STATS is defined
+ * before including this header; otherwise env->stats is ignored and no code
+ * is generated. Counters accumulate across calls (zero the struct to reset).
+ * Time is monotonic and exclusive: a callback's time is charged to
+ * CARGS_PHASE_CALLBACKS, not to the phase that invoked it. The struct is not
+ * thread-safe, so cargs_dispatch_batch runs its jobs with env->stats = NULL
+ * and collects nothing. */
+typedef enum {
+    CARGS_PHASE_ENV,        /* env-var and default values */
+    CARGS_PHASE_OPTS,       /* option matching (includes --help output) */
+    CARGS_PHASE_DESCEND,    /* subcommand lookup */
+    CARGS_PHASE_POSITIONAL, /* positional validation / streaming */
+    CARGS_PHASE_CALLBACKS,  /* option callbacks, pos_batch and run */
+    CARGS_PHASE_COUNT
+} cargs_phase;
+
+typedef struct cargs_stats {
+    uint64_t ns[CARGS_PHASE_COUNT];
+    uint64_t callbacks;   /* cb, pos_batch and run invocations */
+    uint64_t lookups;     /* option and subcommand lookups */
+    uint64_t strcmps;     /* name comparisons made by those lookups */
+    uint64_t env_lookups; /* getenv / snapshot queries */
+    /* bytes written by help, version, author and the emitters (any stream,
+       pipes and ttys included) */
+    uint64_t bytes_out;
+    /* private */
+    unsigned active_; /* current phase + 1, 0 = idle */
+    uint64_t mark_;   /* start of the current slice */
+} cargs_stats;
+
+/* Value completion. With env->complete, cargs_dispatch answers
+ * "prog __complete WORDS... CUR" instead of running anything: WORDS are the
+ * words before the cursor and CUR the one being typed (or "--name=CUR").
+ * They are walked like a command line to find the command and the option
+ * whose value CUR is, but no callback, env var, default or run is touched.
+ * That option's completer (or its ENUM choices) then writes one candidate
+ * per line to env->out. Anything but a value position prints nothing. */
+typedef struct cargs_completion {
+    const char *prefix; /* CUR, or the part after '=' */
+    size_t      prefix_len;
+    FILE       *out;
+    size_t      count;     /* candidates written */
+    bool        expired;   /* env->complete_ms ran out; the rest is dropped */
+    uint64_t    deadline_; /* private: monotonic ns */
+} cargs_completion;
+
+/* Offer word (no newlines) as a candidate. Returns CARGS_OK, or CARGS_DONE
+   once the time budget is spent: stop producing candidates then. */
+static inline int cargs_complete_add(cargs_completion *c, const char *word);
+/* Whether the time budget is spent. The completer runs in the caller's
+   thread and is never interrupted: the budget is only checked here, in
+   cargs_complete_add and before the completer is called, so one that does
+   slow work (a directory walk, a network call) should poll this between
+   steps and return early. */
+static inline bool cargs_complete_expired(cargs_completion *c);
+
 /* Entry: consume argv, route to deepest subcommand, run it. */
 static inline int cargs_dispatch(
     const cargs_env *env, const cargs_cmd *root, int argc, char **argv,
     void *user
 );
+/* Multi-call entry (busybox style): when the basename of argv[0] (without a
+   ".exe" suffix on Windows) is the name or alias of one of root's
+   subcommands, dispatch with that subcommand as the root, so a link named
+   "ls" runs root's "ls" applet. Otherwise the same as cargs_dispatch, so
+   "box ls -l" works too. */
+static inline int cargs_dispatch_multicall(
+    const cargs_env *env, const cargs_cmd *root, int argc, char **argv,
+    void *user
+);
+
+/* Presentation resolved once per help call (or once per program): color
+ * escapes, wrap width and left column width for the help rows. */
+typedef struct cargs_pres {
+    const char *bold, *flag, *cmd, *pos, *rst; /* "" when color is off */
+    int         width; /* wrap width; 0 = no wrapping */
+    int         left;  /* width of the left (flags/names) column */
+} cargs_pres;
+
+/* Resolve presentation from env (color, NO_COLOR, wrap_cols, COLUMNS). The
+   left column is 30 wide; with env->help_fit it fits the widest row in root's
+   subtree, capped at 30 (root may then be NULL: 30). Tweak the result (e.g.
+   force width for non-tty output) and attach it as env->pres to reuse it. */
+static inline void cargs_pres_resolve(
+    const cargs_env *env, const cargs_cmd *root, cargs_pres *out
+);
+
+/* Reusable parser for long-running processes: the index, environment
+ * snapshot and presentation are built once, then each command line is
+ * tokenized into caller scratch and dispatched. A prepared parser is
+ * read-only, so threads may share it (each with its own scratch), provided
+ * the env it was made from sets none of error, events, stats, stream and
+ * help_buf, which every call would write to. env->arena is never used.
+ * Lines are not trusted: "@path" words stay literal unless response_files
+ * is set here after cargs_parser_init (env->response_files is ignored). */
+typedef struct cargs_parser {
+    cargs_env        env; /* copy of the caller's env, wired to the below */
+    const cargs_cmd *root;
+    cargs_pres       pres;
+    bool             response_files; /* expand @file words (default off) */
+} cargs_parser;
+
+/* Per-call buffers for cargs_parse_line; err (optional) receives this call's
+   diagnostics instead of env->err. With arena set, buf and argv may be NULL
+   or too small: the call then takes what it needs from arena and rewinds it
+   before returning. Dispatch runs with env->arena = arena (NULL if unset) */
+typedef struct {
+    char               *buf; /* prog name + tokenized words */
+    size_t              cap;
+    char              **argv;
+    size_t              argv_cap;
+    const cargs_sink   *err;
+    struct cargs_arena *arena; /* optional */
+} cargs_scratch;
+
+/* Bytes of storage cargs_parser_init() needs for this tree. */
+static inline size_t cargs_parser_size(const cargs_cmd *root);
+/* Prepare p from env (copied), reusing env->index / env->envsnap when set and
+   building them in storage otherwise. -1 if cap is too small. */
+static inline int cargs_parser_init(
+    cargs_parser *p, const cargs_env *env, const cargs_cmd *root,
+    void *storage, size_t cap
+);
+/* Split line[0..len) into words (whitespace, '...' literal, "..." and bare
+   words honour backslash escapes) and dispatch them as argv[1..]. Returns
+   what cargs_dispatch returns; CARGS_ERR_BAD_FORMAT on an open quote or if
+   the words do not fit scratch (or its arena). */
+static inline int cargs_parse_line(
+    const cargs_parser *p, const char *line, size_t len, cargs_scratch *scratch,
+    void *user
+);
+
+/* One invocation of a batch. argv is not modified; rc and error are filled
+ * in by cargs_dispatch_batch. */
+typedef struct cargs_job {
+    int                  argc;
+    char               **argv;
+    void                *user;   /* callbacks' and run's user pointer */
+    const cargs_sink    *err;    /* diagnostics; NULL = env's err_sink / err */
+    struct cargs_arena  *arena;  /* for @file expansion (env->response_files) */
+    struct cargs_events *events; /* deferred log; env->events is not used */
+    int                  rc;     /* out: what cargs_dispatch returned */
+    cargs_error          error;  /* out: unknown option / command details */
+} cargs_job;
+
+#define CARGS_BATCH_MAX_THREADS 64
+/* Dispatch jobs[0..n) as independent cargs_dispatch calls spread over up to
+ * nthreads threads (0 = online CPUs, at most CARGS_BATCH_MAX_THREADS). Each
+ * thread owns a slice of the jobs and, once done, takes work from the others'
+ * slices. Threads share only env, root, env->index and the presentation
+ * (resolved once unless env->pres is set); per job, error points at
+ * job->error, diagnostics go to job->err and env->arena, env->stream,
+ * env->stats and env->help_buf are replaced by job->arena, NULL, NULL and
+ * NULL. Callbacks run concurrently: they must only touch their job's user
+ * data. Returns the number of jobs with rc < 0.
+ *
+ * This is a per-call fan-out: the threads are created and joined by each
+ * call. For many small batches, keep workers in a cargs_pool instead. */
+static inline size_t cargs_dispatch_batch(
+    const cargs_env *env, const cargs_cmd *root, cargs_job *jobs, size_t n,
+    unsigned nthreads
+);
+
+/* Persistent batch workers in caller-owned storage. cargs_pool_start()
+ * starts nthreads - 1 threads (0 = online CPUs, at most
+ * CARGS_BATCH_MAX_THREADS) that sleep until cargs_pool_dispatch() hands them
+ * a batch, which then runs as in cargs_dispatch_batch on them and on the
+ * calling thread, without creating any thread. One batch at a time per
+ * pool; cargs_pool_stop() joins the workers. Without CARGS_ENABLE_THREADS,
+ * or if no worker starts, batches run on the calling thread. Every
+ * translation unit that shares a pool must agree on CARGS_ENABLE_THREADS. */
+typedef struct cargs_pool {
+    unsigned threads; /* out: threads per batch, the caller's included */
+#ifdef CARGS__THREADS
+    /* private */
+    pthread_t            tid_[CARGS_BATCH_MAX_THREADS];
+    pthread_mutex_t      mu_;
+    pthread_cond_t       go_, done_;
+    bool                 live_;  /* mu_ and the conditions exist */
+    bool                 stop_;
+    unsigned             self_;  /* worker numbering at start-up */
+    unsigned             busy_;  /* workers still on the current batch */
+    unsigned long        gen_;   /* batches handed out */
+    struct cargs__batch *batch_; /* the current one */
+#endif
+} cargs_pool;
+
+/* Returns the number of threads per batch (>= 1; 0 if p is NULL) */
+static inline unsigned cargs_pool_start(cargs_pool *p, unsigned nthreads);
+static inline size_t   cargs_pool_dispatch(
+      cargs_pool *p, const cargs_env *env, const cargs_cmd *root,
+      cargs_job *jobs, size_t n
+  );
+static inline void cargs_pool_stop(cargs_pool *p);
 
 /* Print help for a specific command (with its subcommands/options). */
 static inline void cargs_print_help(
@@ -131,6 +756,18 @@ static inline void cargs_print_help(
     const char *const *path, size_t depth
 );
 
+/* Terminal columns s[0..n) takes: ANSI escapes are zero wide, UTF-8 is
+   decoded and East Asian wide characters count two */
+static inline size_t cargs_text_width(const char *s, size_t n);
+
+/* Render help into buf (NUL-terminated, truncated to cap) without writing it
+   anywhere. Returns the full length, like snprintf, so callers can size and
+   cache the page. */
+static inline size_t cargs_render_help(
+    char *buf, size_t cap, const cargs_env *env, const cargs_cmd *cmd,
+    const char *prog, const char *const *path, size_t depth
+);
+
 /* Emit full-tree docs */
 static inline void cargs_emit_markdown(
     const cargs_env *env, const cargs_cmd *root, const char *prog, FILE *out
@@ -140,6 +777,17 @@ static inline void cargs_emit_man(
     const char *section
 );
 
+/* The whole tree as one line of JSON for tools that validate command lines
+   without running the program: every option (arg kind, metavar, env,
+   default, group, policy, binding type and choices), positional counts,
+   relations, aliases and subcommands, plus tree_hash for caching. The
+   layout is described at cargs_emit_json's definition; "version" is
+   CARGS_JSON_VERSION and only changes when the layout does. */
+#define CARGS_JSON_VERSION 1
+static inline void cargs_emit_json(
+    const cargs_env *env, const cargs_cmd *root, const char *prog, FILE *out
+);
+
 /* Completion generators */
 static inline void cargs_emit_completion_bash(
     const cargs_env *env, const cargs_cmd *root, const char *prog, FILE *out
@@ -151,9 +799,189 @@ static inline void cargs_emit_completion_fish(
     const cargs_env *env, const cargs_cmd *root, const char *prog, FILE *out
 );
 
+/* Build-time blobs: every emitter's output rendered once by a generator
+ * (cargs_write_blobs) into a C header that defines
+ *   static const cargs_blobs <ident> = {...};
+ * (include c-args-parser.h first). At runtime cargs_emit_cached() serves a
+ * blob with one fwrite when its tree hash still matches, and renders live
+ * otherwise. The man page is section 1. */
+typedef enum {
+    CARGS_BLOB_MARKDOWN,
+    CARGS_BLOB_MAN,
+    CARGS_BLOB_BASH,
+    CARGS_BLOB_ZSH,
+    CARGS_BLOB_FISH,
+    CARGS_BLOB_COUNT
+} cargs_blob_kind;
+
+typedef struct cargs_blobs {
+    uint64_t    tree_hash; /* cargs_tree_hash() at generation time */
+    const char *data[CARGS_BLOB_COUNT];
+    size_t      len[CARGS_BLOB_COUNT];
+} cargs_blobs;
+
+/* Output format of the emitters: bumped whenever one of them renders the
+   same tree differently, so blobs from an older library count as stale */
+#define CARGS_EMIT_FORMAT 2
+
+/* 64-bit FNV-1a over everything the emitters render: the tree's names,
+   help text, aliases, positionals, binding types, relations, prog, the env
+   built-ins and CARGS_EMIT_FORMAT. */
+static inline uint64_t cargs_tree_hash(
+    const cargs_env *env, const cargs_cmd *root, const char *prog
+);
+/* Write the blob header for root to out. -1 if no temporary file could be
+   created for rendering (tmpfile). */
+static inline int cargs_emit_blobs(
+    const cargs_env *env, const cargs_cmd *root, const char *prog, FILE *out,
+    const char *ident
+);
+/* Generator entry: (re)write path only if it is missing or was generated for
+   a different tree hash, so dependents are not rebuilt needlessly. The header
+   is written to "<path>.<pid>.tmp", so concurrent generators do not share a
+   temporary, and renamed into place once complete. Where rename() cannot
+   replace a file (Windows), the old header is first moved to
+   "<path>.<pid>.old" and put back if the new one cannot take its place. A
+   path longer than 485 bytes needs env->arena. Returns 0 if written, 1 if
+   already up to date, -1 on I/O errors. */
+static inline int cargs_write_blobs(
+    const cargs_env *env, const cargs_cmd *root, const char *prog,
+    const char *path, const char *ident
+);
+/* Serve one output: a single fwrite of blobs->data[kind] when blobs (may be
+   NULL) matches root's current hash, else the live emitter. Returns 0 when
+   served from blobs, 1 when rendered. */
+static inline int cargs_emit_cached(
+    const cargs_env *env, const cargs_cmd *root, const char *prog, FILE *out,
+    const cargs_blobs *blobs, cargs_blob_kind kind
+);
+/* cargs_emit_cached hashes the whole tree on every call. A program serving
+   several outputs checks once instead: cargs_blobs_check returns blobs when
+   it matches root's current hash, else NULL, and cargs_emit_checked serves
+   that result (NULL = render live) without hashing again. */
+static inline const cargs_blobs *cargs_blobs_check(
+    const cargs_env *env, const cargs_cmd *root, const char *prog,
+    const cargs_blobs *blobs
+);
+static inline int cargs_emit_checked(
+    const cargs_env *env, const cargs_cmd *root, const char *prog, FILE *out,
+    const cargs_blobs *checked, cargs_blob_kind kind
+);
+
+/* Packed command trees: the same tree as relocation-free tables for PIE
+ * builds. Strings are offsets into one pool (CARGS_PK_NONE = NULL), records
+ * refer to each other by 32-bit index, and cb, bind.call, bind.target,
+ * bind.choices, bind.complete, run and pos_batch are 1-based indexes into
+ * the tables of a cargs_packed_fns (0 = none). A generator builds them from
+ * the struct tree with cargs_pack() and writes them out as C with
+ * cargs_emit_packed(); the program then links only read-only records and a
+ * few pointers (the cargs_packed header and its cargs_packed_fns). Commands
+ * are numbered like cargs_compile(): root is 0 and subcommands are
+ * contiguous from first_sub. */
+#define CARGS_PK_NONE UINT32_MAX
+typedef struct {
+    uint32_t name, desc; /* pool offsets */
+    uint32_t first_opt, first_sub, first_alias, first_pos, first_rel;
+    uint32_t opt_count, sub_count, alias_count, pos_count, rel_count;
+    uint16_t run, pos_batch; /* cargs_packed_fns indexes + 1 */
+    uint16_t widest;         /* help's left column for this subtree */
+} cargs_packed_cmd;
+
+typedef struct {
+    uint32_t long_name, metavar, help, env, def;  /* pool offsets */
+    uint16_t cb, call, target, choices, complete; /* indexes + 1 */
+    char     short_name;
+    uint8_t  arg, group, group_policy, bind_kind; /* cargs_opt's values */
+} cargs_packed_opt;
+
+typedef struct {
+    uint32_t name, desc;
+    uint16_t min, max;
+} cargs_packed_pos;
+
+typedef struct {
+    uint8_t  kind;
+    uint32_t opt, other;
+} cargs_packed_rel;
+
+/* Layout of the records above; cargs_dispatch_packed refuses a tree
+   generated for another one */
+#define CARGS_PACKED_FORMAT 2
+#define CARGS_PK_FN_TABLES  7
+typedef struct cargs_packed {
+    uint32_t                format;    /* CARGS_PACKED_FORMAT */
+    uint64_t                tree_hash; /* cargs_tree_hash(NULL, root, NULL) */
+    /* sizes of the generator's cargs_packed_fns tables, in member order (cb,
+       call, run, pos_batch, target, choices, complete) */
+    uint32_t                fn_counts[CARGS_PK_FN_TABLES];
+    const char             *pool;
+    uint32_t                pool_len;
+    const cargs_packed_cmd *cmds;
+    uint32_t                cmd_count;
+    const cargs_packed_opt *opts;
+    uint32_t                opt_count;
+    const uint32_t         *aliases; /* pool offsets */
+    uint32_t                alias_count;
+    const cargs_packed_pos *pos;
+    uint32_t                pos_count;
+    const cargs_packed_rel *rels;
+    uint32_t                rel_count;
+} cargs_packed;
+
+/* Everything a packed tree refers to by index. The generator and the
+ * program must use the same tables in the same order; cargs_dispatch_packed
+ * refuses tables whose sizes differ from the generator's. */
+typedef struct cargs_packed_fns {
+    const cargs_cb *cb;
+    size_t          cb_count;
+    const cargs_call *call;
+    size_t            call_count;
+    int (*const *run)(int argc, char **argv, void *user);
+    size_t run_count;
+    int (*const *pos_batch)(size_t first, size_t n, char **items, void *user);
+    size_t pos_batch_count;
+    void *const *target;
+    size_t       target_count;
+    const cargs_choice *const *choices;
+    size_t                     choices_count;
+    const cargs_completer     *complete;
+    size_t                     complete_count;
+} cargs_packed_fns;
+
+/* Pack root into arena. NULL if it does not fit, a count exceeds 32 bits, or
+   one of root's handlers, targets or choice tables is not in fns. */
+static inline const cargs_packed *cargs_pack(
+    const cargs_cmd *root, const cargs_packed_fns *fns, cargs_arena *arena
+);
+/* Write pk as C source defining static const cargs_packed <ident> (include
+   c-args-parser.h first). Records are written with designated initializers,
+   so a reordered or extended record fails to compile or stays correct rather
+   than shifting fields; the format number is written as a literal. -1 on I/O
+   errors. */
+static inline int cargs_emit_packed(
+    const cargs_packed *pk, FILE *out, const char *ident
+);
+/* cargs_dispatch over a packed tree. Only the commands argv enters are
+   decoded, into env->arena (else an 8 KiB stack buffer; CARGS_ERR_TOO_MANY
+   when that is full); their subcommands' names, aliases and descriptions
+   only when help, a prefix or a suggestion needs them. env->index and
+   env->config, which are tied to a struct tree, do not apply, so this is
+   slower than cargs_dispatch on the struct tree, indexed or not.
+   CARGS_ERR_BAD_FORMAT if pk->format is not CARGS_PACKED_FORMAT or a table
+   of fns has another size than pk->fn_counts records (regenerate it).
+   tree_hash is for the generator's own staleness checks: there is no struct
+   tree here to compare it with. */
+static inline int cargs_dispatch_packed(
+    const cargs_env *env, const cargs_packed *pk, const cargs_packed_fns *fns,
+    int argc, char **argv, void *user
+);
+
 /* ===== Typed helpers (no allocation) ===== */
 static inline int cargs_read_int(const char *s, int *out);
 static inline int cargs_read_uint64(const char *s, uint64_t *out);
+/* Exact integer size parser: "<int>[.<frac>] [B|K|KB|KiB|..|E|EB|EiB]",
+ * case-insensitive. 'i' units are 1024-based; bare K..E follow prefer_iec.
+ * Rounds half up to whole bytes; -1 on bad syntax or anything > UINT64_MAX. */
 static inline int cargs_read_size(
     const char *s, uint64_t *out, bool prefer_iec
 );
@@ -163,17 +991,343 @@ static inline int cargs_read_size_si(
 static inline int cargs_read_size_iec(
     const char *s, uint64_t *out
 ); /* KiB=1024 */
-/* Format bytes into buf, returns buf; iec? uses Ki/Mi/Gi; decimals >=0 */
+/* Exact integer duration parser, to nanoseconds: one or more
+ * "<int>[.<frac>]<unit>" parts in any order ("1h30m", "2m 0.5s"), units
+ * ns us µs ms s m|min h d w; a lone bare number is seconds. Rate parser,
+ * to bytes per second: a cargs_read_size_si size plus an optional "/<unit>"
+ * using the duration units ("10MB/s", "1GiB/h"). Both round half up and return
+ * 0, -1 on bad syntax, or -2 when the value exceeds UINT64_MAX. */
+static inline int cargs_read_duration(const char *s, uint64_t *out);
+static inline int cargs_read_rate(const char *s, uint64_t *out);
+/* Strict, locale-free integer parsers (no whitespace, no errno, no octal).
+ * base: CARGS_BASE_DEC, _HEX (optional 0x), _BIN (optional 0b), or _AUTO
+ * (decimal unless prefixed 0x/0b). Signed forms accept a leading '+' or '-'.
+ * Return 0 on success, -1 on bad syntax or overflow (out left untouched). */
+#define CARGS_BASE_AUTO 0
+#define CARGS_BASE_BIN  2
+#define CARGS_BASE_DEC  10
+#define CARGS_BASE_HEX  16
+static inline int cargs_read_u64(const char *s, uint64_t *out, int base);
+static inline int cargs_read_i64(const char *s, int64_t *out, int base);
+static inline int cargs_read_u32(const char *s, uint32_t *out, int base);
+static inline int cargs_read_i32(const char *s, int32_t *out, int base);
+/* Parse argv[0..n) into out[0..n). On failure returns -1 and, if bad is not
+   NULL, stores the index of the first rejected item. */
+static inline int cargs_read_u64_batch(
+    char *const *argv, size_t n, uint64_t *out, int base, size_t *bad
+);
+static inline int cargs_read_i64_batch(
+    char *const *argv, size_t n, int64_t *out, int base, size_t *bad
+);
+/* Human-readable numbers in integer arithmetic only (no double, no printf):
+ * the value is scaled to the largest unit it reaches and rounded half up
+ * exactly. decimals (< 0 = default, at most 6) are shown only while the
+ * scaled value is below 10 before rounding: "999B", "1.50MB", "10.00MB" (for
+ * 9996000), "15MB". A value that rounds up to the next unit is shown in it
+ * ("1.00MiB", not "1024KiB"). Output is truncated to bufsz - 1 bytes; each
+ * returns buf. */
+/* Bytes: KB/MB.. (1000) or KiB/MiB.. (1024); default 2 decimals */
 static inline char *cargs_fmt_bytes(
     uint64_t bytes, char *buf, size_t bufsz, bool iec, int decimals
 );
+/* Counts: 999, 1.2k, 3.4M .. E (1000-based); default 1 decimal */
+static inline char *cargs_fmt_count(
+    uint64_t n, char *buf, size_t bufsz, int decimals
+);
+/* Throughput: cargs_fmt_bytes followed by "/s" */
+static inline char *cargs_fmt_rate(
+    uint64_t bytes_per_sec, char *buf, size_t bufsz, bool iec, int decimals
+);
+
+typedef enum {
+    CARGS_FMT_BYTES_SI,
+    CARGS_FMT_BYTES_IEC,
+    CARGS_FMT_COUNT,
+    CARGS_FMT_RATE_SI,
+    CARGS_FMT_RATE_IEC
+} cargs_fmt_kind;
+
+/* Format vals[0..n) as one table column: every cell is right-aligned to the
+   widest and NUL-terminated, cell i at buf + i * (width + 1). Returns width;
+   the cells are written only if cap >= n * (width + 1) (buf may be NULL to
+   size it first). */
+static inline size_t cargs_fmt_table(
+    const uint64_t *vals, size_t n, cargs_fmt_kind kind, int decimals,
+    char *buf, size_t cap
+);
 
 /* ===== Implementation (header-only, no globals) ===== */
 
+#if defined(__GNUC__) || defined(__clang__)
+#    define CARGS__PRINTF(f, a) __attribute__((format(printf, f, a)))
+#else
+#    define CARGS__PRINTF(f, a)
+#endif
+
+#ifdef __cplusplus
+#    define CARGS__ALIGN(n) alignas(n)
+#else
+#    define CARGS__ALIGN(n) _Alignas(n)
+#endif
+
+/* Hashing and storage helpers */
+static inline uint32_t cargs__hash(const char *s, size_t n) {
+    uint32_t h = 2166136261u; /* FNV-1a */
+    for (size_t i = 0; i < n; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static inline size_t cargs__align_up(size_t n, size_t a) {
+    return (n + a - 1) & ~(a - 1);
+}
+
+/* ===== Arena ===== */
+static inline void cargs_arena_init(cargs_arena *a, void *buf, size_t cap) {
+    memset(a, 0, sizeof *a);
+    a->base = (unsigned char *)buf;
+    a->cap  = buf ? cap : 0;
+}
+
+/* n bytes from the current block, or NULL */
+static inline void *cargs__arena_fit(cargs_arena *a, size_t n, size_t align) {
+    if (!a->base) return NULL;
+    size_t at = cargs__align_up((size_t)(uintptr_t)(a->base + a->used), align) -
+                (size_t)(uintptr_t)a->base;
+    if (at > a->cap || n > a->cap - at) return NULL;
+    a->used = at + n;
+    if (a->spent + a->used > a->high) a->high = a->spent + a->used;
+    return a->base + at;
+}
+
+static inline void *cargs_arena_alloc(cargs_arena *a, size_t n, size_t align) {
+    if (!a) return NULL;
+    void *p = cargs__arena_fit(a, n, align);
+    if (p || !a->grow || n > SIZE_MAX - align) return p;
+    /* a block with room for n at any alignment */
+    size_t cap = 0;
+    void  *blk = a->grow(a->grow_ctx, n + align, &cap);
+    if (!blk || cap < n + align) return NULL;
+    a->spent += a->used;
+    a->base = (unsigned char *)blk;
+    a->cap  = cap;
+    a->used = 0;
+    return cargs__arena_fit(a, n, align);
+}
+
+static inline cargs_arena_mark cargs_arena_save(const cargs_arena *a) {
+    cargs_arena_mark m;
+    m.base  = a ? a->base : NULL;
+    m.cap   = a ? a->cap : 0;
+    m.used  = a ? a->used : 0;
+    m.spent = a ? a->spent : 0;
+    return m;
+}
+
+static inline void cargs_arena_rewind(cargs_arena *a, cargs_arena_mark m) {
+    if (!a) return;
+    a->base  = m.base;
+    a->cap   = m.cap;
+    a->used  = m.used;
+    a->spent = m.spent;
+}
+
+/* ===== Instrumentation ===== */
+/* Monotonic ns, for stats and the completion budget. Strict -std=c11 hides
+   CLOCK_MONOTONIC on glibc: clock_gettime is then declared here with Linux's
+   fixed clock id. On Windows, clock() is the elapsed time since start (ms).
+   Only other platforms without either fall back to the wall clock */
+#if defined(CLOCK_MONOTONIC)
+#    define CARGS__CLOCK_MONO CLOCK_MONOTONIC
+#elif defined(__linux__) && !defined(TIME_MONOTONIC)
+#    define CARGS__CLOCK_MONO 1 /* CLOCK_MONOTONIC in the Linux ABI */
+int clock_gettime(int clk, struct timespec *ts);
+#endif
+
+static inline uint64_t cargs__now_ns(void) {
+    struct timespec ts;
+#if defined(CARGS__CLOCK_MONO)
+    if (clock_gettime(CARGS__CLOCK_MONO, &ts) != 0) return 0;
+#elif defined(TIME_MONOTONIC)
+    if (!timespec_get(&ts, TIME_MONOTONIC)) return 0;
+#elif defined(_WIN32)
+    return (uint64_t)clock() * (1000000000u / CLOCKS_PER_SEC);
+#else
+    timespec_get(&ts, TIME_UTC);
+#endif
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+#ifdef CARGS_ENABLE_STATS
+
+/* Close the current slice and switch to phase + 1 (0 = idle); returns the
+   previous state so the caller can restore it */
+static inline unsigned cargs__stat_enter(const cargs_env *e, unsigned active) {
+    cargs_stats *s = e ? e->stats : NULL;
+    if (!s) return 0;
+    uint64_t t    = cargs__now_ns();
+    unsigned prev = s->active_;
+    if (prev && prev <= CARGS_PHASE_COUNT && t > s->mark_)
+        s->ns[prev - 1] += t - s->mark_; /* a clock step back adds none */
+    s->active_ = active;
+    s->mark_   = t;
+    return prev;
+}
+
+#    define CARGS__STAT(e, field, n)                         \
+        do {                                                 \
+            if ((e) && (e)->stats) (e)->stats->field += (n); \
+        } while (0)
+#    define CARGS__CMP(st)             \
+        do {                           \
+            if (st) (st)->strcmps++;   \
+        } while (0)
+#    define CARGS__PHASE(e, ph)     cargs__stat_enter((e), (unsigned)(ph) + 1)
+#    define CARGS__PHASE_END(e, sv) (void)cargs__stat_enter((e), (sv))
+#    define CARGS__STATS(e)         ((e) ? (e)->stats : NULL)
+#else
+#    define CARGS__STAT(e, field, n) ((void)0)
+#    define CARGS__CMP(st)           ((void)0)
+#    define CARGS__PHASE(e, ph)      0u
+#    define CARGS__PHASE_END(e, sv)  (void)(sv)
+#    define CARGS__STATS(e)          ((struct cargs_stats *)NULL)
+#endif
+
+/* ===== Environment snapshot ===== */
+#if defined(_WIN32)
+static inline const char *const *cargs__process_environ(void) {
+    return (const char *const *)_environ;
+}
+#else
+extern char **environ;
+static inline const char *const *cargs__process_environ(void) {
+    return (const char *const *)environ;
+}
+#endif
+
+static inline size_t cargs__envsnap_count(const cargs_cmd *cmd) {
+    size_t n = 0;
+    for (size_t i = 0; i < cmd->opt_count; i++)
+        if (cmd->opts[i].env) n++;
+    for (size_t i = 0; i < cmd->sub_count; i++)
+        n += cargs__envsnap_count(&cmd->subs[i]);
+    return n;
+}
+
+static inline size_t cargs__envsnap_slots(const cargs_cmd *root) {
+    size_t n     = cargs__envsnap_count(root) + 2; /* + NO_COLOR, COLUMNS */
+    size_t slots = 4;
+    while (slots < 2 * n) slots <<= 1;
+    return slots;
+}
+
+static inline size_t cargs_envsnap_size(const cargs_cmd *root) {
+    if (!root) return 0;
+    return sizeof(cargs_envsnap) + sizeof(void *) +
+           cargs__envsnap_slots(root) * sizeof(cargs_env_var);
+}
+
+/* Slot holding name, or the empty slot where it would go */
+static inline uint32_t cargs__envsnap_slot(
+    const cargs_env_var *vars, uint32_t mask, const char *name, size_t len,
+    uint32_t h
+) {
+    for (uint32_t s = h & mask;; s = (s + 1) & mask) {
+        const cargs_env_var *v = &vars[s];
+        if (!v->name) return s;
+        if (v->hash == h && strncmp(v->name, name, len) == 0 &&
+            v->name[len] == '\0')
+            return s;
+    }
+}
+
+static inline void cargs__envsnap_add(
+    cargs_env_var *vars, uint32_t mask, const char *name
+) {
+    size_t         len = strlen(name);
+    uint32_t       h   = cargs__hash(name, len);
+    cargs_env_var *v   = &vars[cargs__envsnap_slot(vars, mask, name, len, h)];
+    v->name            = name;
+    v->hash            = h;
+}
+
+static inline void cargs__envsnap_add_tree(
+    cargs_env_var *vars, uint32_t mask, const cargs_cmd *cmd
+) {
+    for (size_t i = 0; i < cmd->opt_count; i++)
+        if (cmd->opts[i].env) cargs__envsnap_add(vars, mask, cmd->opts[i].env);
+    for (size_t i = 0; i < cmd->sub_count; i++)
+        cargs__envsnap_add_tree(vars, mask, &cmd->subs[i]);
+}
+
+static inline const cargs_envsnap *cargs_envsnap_build(
+    const cargs_cmd *root, const char *const *envp, void *storage, size_t cap
+) {
+    if (!root || !storage || cap < cargs_envsnap_size(root)) return NULL;
+    size_t slots = cargs__envsnap_slots(root);
+    char  *base  = (char *)storage;
+    base += cargs__align_up((size_t)(uintptr_t)base, sizeof(void *)) -
+            (size_t)(uintptr_t)base;
+    cargs_envsnap *snap = (cargs_envsnap *)(void *)base;
+    cargs_env_var *vars =
+        (cargs_env_var *)(void *)(base + sizeof(cargs_envsnap));
+    uint32_t mask = (uint32_t)(slots - 1);
+    memset(vars, 0, slots * sizeof(cargs_env_var));
+
+    cargs__envsnap_add(vars, mask, "NO_COLOR");
+    cargs__envsnap_add(vars, mask, "COLUMNS");
+    cargs__envsnap_add_tree(vars, mask, root);
+
+    /* One pass over the environment; the first definition wins, as getenv */
+    if (!envp) envp = cargs__process_environ();
+    for (; envp && *envp; envp++) {
+        const char *kv = *envp;
+        const char *eq = strchr(kv, '=');
+        if (!eq || eq == kv) continue;
+        size_t         len = (size_t)(eq - kv);
+        cargs_env_var *v   = &vars[cargs__envsnap_slot(
+            vars, mask, kv, len, cargs__hash(kv, len)
+        )];
+        if (v->name && !v->value) v->value = eq + 1;
+    }
+
+    snap->vars = vars;
+    snap->mask = mask;
+    return snap;
+}
+
+static inline const cargs_envsnap *cargs_envsnap_build_arena(
+    const cargs_cmd *root, const char *const *envp, cargs_arena *arena
+) {
+    size_t need = cargs_envsnap_size(root);
+    void  *mem  = root ? cargs_arena_alloc(arena, need, 1) : NULL;
+    return mem ? cargs_envsnap_build(root, envp, mem, need) : NULL;
+}
+
+static inline const char *cargs_envsnap_get(
+    const cargs_envsnap *snap, const char *name
+) {
+    if (!snap || !name) return NULL;
+    size_t               len = strlen(name);
+    const cargs_env_var *v   = &snap->vars[cargs__envsnap_slot(
+        snap->vars, snap->mask, name, len, cargs__hash(name, len)
+    )];
+    return v->name ? v->value : NULL;
+}
+
+/* Environment lookup: the snapshot if one is attached, else getenv */
+static inline const char *cargs__getenv(const cargs_env *e, const char *name) {
+    CARGS__STAT(e, env_lookups, 1);
+    if (e && e->envsnap) return cargs_envsnap_get(e->envsnap, name);
+    return getenv(name);
+}
+
 /* Styling */
 static inline bool cargs_use_color(const cargs_env *e) {
     if (!e || !e->color) return false;
-    const char *nc = getenv("NO_COLOR");
+    const char *nc = cargs__getenv(e, "NO_COLOR");
     return !(nc && *nc);
 }
 static inline const char *cargs_s_bold(const cargs_env *e) {
@@ -200,10 +1354,149 @@ static inline FILE *cargs_err(const cargs_env *e) {
     return (e && e->err) ? e->err : stderr;
 }
 
+/* One line on cargs_out() (--version, --author) */
+static inline void cargs__put_line(const cargs_env *e, const char *s) {
+    int n = fprintf(cargs_out(e), "%s\n", s);
+    (void)n;
+    CARGS__STAT(e, bytes_out, n > 0 ? (size_t)n : 0);
+}
+
+/* Diagnostics: to env->err_sink when set (one write per message, truncated
+   to 511 bytes), else to cargs_err() */
+CARGS__PRINTF(2, 3)
+static inline void cargs__errf(const cargs_env *e, const char *fmt, ...) {
+    va_list           ap;
+    const cargs_sink *k = e ? e->err_sink : NULL;
+    va_start(ap, fmt);
+    if (k && k->write) {
+        /* one write per message: longer ones are rebuilt in env->arena, or
+           cut at 511 bytes without one */
+        char    buf[512];
+        va_list again;
+        va_copy(again, ap);
+        int   n   = vsnprintf(buf, sizeof buf, fmt, ap);
+        char *msg = buf;
+        if (n >= (int)sizeof buf && e->arena) {
+            cargs_arena_mark m = cargs_arena_save(e->arena);
+            char *big = (char *)cargs_arena_alloc(e->arena, (size_t)n + 1, 1);
+            if (big && vsnprintf(big, (size_t)n + 1, fmt, again) == n) {
+                k->write(k->ctx, big, (size_t)n);
+                msg = NULL;
+            }
+            cargs_arena_rewind(e->arena, m);
+        }
+        va_end(again);
+        if (n > 0 && msg)
+            k->write(k->ctx, msg,
+                     (size_t)n < sizeof buf ? (size_t)n : sizeof buf - 1);
+    } else {
+        vfprintf(cargs_err(e), fmt, ap);
+    }
+    va_end(ap);
+}
+
+/* Render buffer: output accumulates in buf and is written to out in chunks.
+ * With out == NULL nothing is written; the content is truncated to cap - 1
+ * bytes (kept NUL-terminated) while total still counts every byte. */
+typedef struct {
+    char  *buf;
+    size_t cap;
+    size_t len;
+    FILE  *out;
+    size_t total; /* bytes produced so far */
+} cargs_wbuf;
+
+static inline void cargs__wb_init(
+    cargs_wbuf *w, char *buf, size_t cap, FILE *out
+) {
+    w->buf   = buf;
+    w->cap   = cap;
+    w->len   = 0;
+    w->out   = out;
+    w->total = 0;
+    if (cap) buf[0] = '\0';
+}
+
+static inline void cargs__wb_flush(cargs_wbuf *w) {
+    if (w->out && w->len) fwrite(w->buf, 1, w->len, w->out);
+    if (w->out) w->len = 0;
+    if (w->cap) w->buf[w->len] = '\0';
+}
+
+static inline void cargs__wb_write(cargs_wbuf *w, const char *s, size_t n) {
+    w->total += n;
+    while (n) {
+        size_t room = w->cap > w->len + 1 ? w->cap - w->len - 1 : 0;
+        if (!room) {
+            if (!w->out) return; /* render-only: truncate */
+            cargs__wb_flush(w);
+            if (w->cap < 2) {
+                fwrite(s, 1, n, w->out);
+                return;
+            }
+            continue;
+        }
+        size_t k = n < room ? n : room;
+        memcpy(w->buf + w->len, s, k);
+        w->len += k;
+        s += k;
+        n -= k;
+    }
+    if (w->cap) w->buf[w->len] = '\0';
+}
+
+static inline void cargs__wb_puts(cargs_wbuf *w, const char *s) {
+    cargs__wb_write(w, s, strlen(s));
+}
+
+static inline void cargs__wb_putc(cargs_wbuf *w, char c) {
+    cargs__wb_write(w, &c, 1);
+}
+
+static inline void cargs__wb_pad(cargs_wbuf *w, int n) {
+    static const char sp[] = "                                ";
+    while (n > 0) {
+        size_t k = (size_t)n < sizeof(sp) - 1 ? (size_t)n : sizeof(sp) - 1;
+        cargs__wb_write(w, sp, k);
+        n -= (int)k;
+    }
+}
+
+CARGS__PRINTF(2, 3)
+static inline void cargs__wb_printf(cargs_wbuf *w, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    size_t room = w->cap > w->len ? w->cap - w->len : 0;
+    int    n    = vsnprintf(room ? w->buf + w->len : NULL, room, fmt, ap);
+    va_end(ap);
+    if (n < 0) return;
+    if ((size_t)n < room) { /* fitted in place */
+        w->len += (size_t)n;
+        w->total += (size_t)n;
+        return;
+    }
+    if (!w->out) { /* render-only: keep the truncated prefix */
+        w->len = room ? w->cap - 1 : w->len;
+        w->total += (size_t)n;
+        return;
+    }
+    if (w->cap) w->buf[w->len] = '\0'; /* drop the partial write */
+    cargs__wb_flush(w);
+    va_start(ap, fmt);
+    if ((size_t)n < w->cap) {
+        vsnprintf(w->buf, w->cap, fmt, ap);
+        w->len = (size_t)n;
+    } else {
+        vfprintf(w->out, fmt, ap); /* larger than the whole buffer */
+    }
+    va_end(ap);
+    w->total += (size_t)n;
+}
+
 /* Columns (wrapping) */
 static inline int cargs_columns(const cargs_env *e) {
     if (e && e->wrap_cols > 0) return e->wrap_cols;
-    const char *col = getenv("COLUMNS");
+    const char *col = cargs__getenv(e, "COLUMNS");
     if (col && *col) {
         long v = strtol(col, NULL, 10);
         if (v > 0 && v < 10000) return (int)v;
@@ -211,16 +1504,34 @@ static inline int cargs_columns(const cargs_env *e) {
     return 0;
 }
 
-static inline const cargs_opt *cargs_find_long(
-    const cargs_opt *opts, size_t n, const char *name
+/* name[0..len) is the literal lit */
+static inline bool cargs__name_is(
+    const char *name, size_t len, const char *lit
+) {
+    return strncmp(name, lit, len) == 0 && lit[len] == '\0';
+}
+
+/* name[0..len) need not be terminated ("jobs=4" with len 4) */
+static inline const cargs_opt *cargs__find_long(
+    const cargs_opt *opts, size_t n, const char *name, size_t len,
+    cargs_stats *st
 ) {
+    (void)st;
     if (!opts || !name) return NULL;
     for (size_t i = 0; i < n; i++) {
         const cargs_opt *o = &opts[i];
-        if (o->long_name && strcmp(o->long_name, name) == 0) return o;
+        if (!o->long_name) continue;
+        CARGS__CMP(st);
+        if (strncmp(o->long_name, name, len) == 0 && o->long_name[len] == '\0')
+            return o;
     }
     return NULL;
 }
+static inline const cargs_opt *cargs_find_long(
+    const cargs_opt *opts, size_t n, const char *name
+) {
+    return cargs__find_long(opts, n, name, name ? strlen(name) : 0, NULL);
+}
 static inline const cargs_opt *cargs_find_short(
     const cargs_opt *opts, size_t n, char c
 ) {
@@ -230,136 +1541,789 @@ static inline const cargs_opt *cargs_find_short(
     return NULL;
 }
 
-/* Value-lookahead heuristic for OPTIONAL args:
-   treat next token as a value if it doesn't look like an option,
-   or if it looks like a numeric literal (e.g., -12, -0.5, +3). */
-static inline bool cargs_token_looks_numeric(const char *s) {
-    if (!s || !*s) return false;
-    if (*s == '+' || *s == '-') {
-        if (isdigit((unsigned char)s[1])) return true; /* -12, +7 */
-        if (s[1] == '.' && isdigit((unsigned char)s[2])) return true; /* -.5 */
-        if (s[1] == '0' && (s[2] == 'x' || s[2] == 'X'))
-            return true; /* -0xFF */
-        return false;
+/* ===== Compiled index ===== */
+static inline void cargs__group_plan(
+    const cargs_cmd *cmd, cargs_group_plan *p
+) {
+    p->xor_mask = p->req_mask = p->any_mask = 0;
+    for (size_t i = 0; i < cmd->opt_count; i++) {
+        const cargs_opt *o = &cmd->opts[i];
+        if (!o->group || o->group > CARGS_GROUP_MAX) continue;
+        uint64_t bit = 1ull << o->group;
+        if (o->group_policy == CARGS_GRP_XOR) p->xor_mask |= bit;
+        if (o->group_policy == CARGS_GRP_REQ_ONE) p->req_mask |= bit;
+        if (o->group_policy == CARGS_GRP_ANY) p->any_mask |= bit;
     }
-    return isdigit((unsigned char)s[0]);
 }
 
-/* Word-wrapping for help text */
-static inline void cargs_wrap_print(
-    FILE *out, const char *text, int start_col, int width
+/* Slot count for a command's long-name table: power of two, load <= 1/2 */
+static inline size_t cargs__ix_long_slots(const cargs_cmd *cmd) {
+    size_t n = 0;
+    for (size_t i = 0; i < cmd->opt_count; i++)
+        if (cmd->opts[i].long_name) n++;
+    if (!n) return 0;
+    size_t slots = 2;
+    while (slots < 2 * n) slots <<= 1;
+    return slots;
+}
+
+static inline void cargs__ix_count(
+    const cargs_cmd *cmd, size_t *nodes, size_t *slots, size_t *names
+) {
+    (*nodes)++;
+    *slots += cargs__ix_long_slots(cmd);
+    for (size_t i = 0; i < cmd->sub_count; i++) {
+        const cargs_cmd *c = &cmd->subs[i];
+        if (c->name) (*names)++;
+        for (size_t a = 0; a < c->alias_count; a++)
+            if (c->aliases[a]) (*names)++;
+        cargs__ix_count(c, nodes, slots, names);
+    }
+}
+
+static inline bool cargs__ix_name_less(
+    const cargs_index_name *a, const cargs_index_name *b
+) {
+    int c = strcmp(a->name, b->name);
+    return c < 0 || (c == 0 && a->sub < b->sub);
+}
+
+/* In-place heapsort (no allocation, O(n log n) for large applet tables) */
+static inline void cargs__ix_sift(cargs_index_name *t, size_t i, size_t n) {
+    for (size_t c; (c = 2 * i + 1) < n; i = c) {
+        if (c + 1 < n && cargs__ix_name_less(&t[c], &t[c + 1])) c++;
+        if (!cargs__ix_name_less(&t[i], &t[c])) return;
+        cargs_index_name x = t[i];
+        t[i]               = t[c];
+        t[c]               = x;
+    }
+}
+
+static inline void cargs__ix_sort_names(cargs_index_name *t, size_t n) {
+    for (size_t i = n / 2; i-- > 0;) cargs__ix_sift(t, i, n);
+    while (n > 1) {
+        cargs_index_name x = t[0];
+        t[0]               = t[--n];
+        t[n]               = x;
+        cargs__ix_sift(t, 0, n);
+    }
+}
+
+static inline size_t cargs_compile_size(const cargs_cmd *root) {
+    if (!root) return 0;
+    size_t nodes = 0, slots = 0, names = 0;
+    cargs__ix_count(root, &nodes, &slots, &names);
+    size_t n = cargs__align_up(sizeof(cargs_index), sizeof(uint64_t));
+    n += nodes * sizeof(cargs_index_node);
+    n  = cargs__align_up(n, sizeof(uint32_t));
+    n += nodes * 256 * sizeof(uint16_t);
+    n += slots * sizeof(uint32_t);
+    n  = cargs__align_up(n, sizeof(void *));
+    n += names * sizeof(cargs_index_name);
+    return n + sizeof(uint64_t); /* slack for aligning storage itself */
+}
+
+static inline const cargs_index *cargs_compile(
+    const cargs_cmd *root, void *storage, size_t cap
+) {
+    if (!root || !storage) return NULL;
+    size_t need = cargs_compile_size(root);
+    if (cap < need) return NULL;
+    size_t nodes = 0, slots = 0, names = 0;
+    cargs__ix_count(root, &nodes, &slots, &names);
+
+    /* Align the start; every table after the header stays naturally aligned
+       because the short tables are 512 bytes each. */
+    char *base = (char *)storage;
+    base += cargs__align_up((size_t)(uintptr_t)base, sizeof(uint64_t)) -
+            (size_t)(uintptr_t)base;
+    size_t       off = cargs__align_up(sizeof(cargs_index), sizeof(uint64_t));
+    cargs_index *ix  = (cargs_index *)(void *)base;
+    cargs_index_node *nd = (cargs_index_node *)(void *)(base + off);
+    off += nodes * sizeof(cargs_index_node);
+    off              = cargs__align_up(off, sizeof(uint32_t));
+    uint16_t *shorts = (uint16_t *)(void *)(base + off);
+    off += nodes * 256 * sizeof(uint16_t);
+    uint32_t *longs = (uint32_t *)(void *)(base + off);
+    off += slots * sizeof(uint32_t);
+    off                    = cargs__align_up(off, sizeof(void *));
+    cargs_index_name *ntab = (cargs_index_name *)(void *)(base + off);
+
+    memset(shorts, 0, nodes * 256 * sizeof(uint16_t));
+    if (slots) memset(longs, 0, slots * sizeof(uint32_t));
+
+    /* Breadth-first layout: the node array doubles as the work queue */
+    nd[0].cmd   = root;
+    size_t next = 1;
+    for (size_t k = 0; k < nodes; k++) {
+        const cargs_cmd *cmd = nd[k].cmd;
+        if (cmd->opt_count > 0xffff || cmd->rel_count > CARGS_REL_MAX)
+            return NULL;
+        nd[k].first_sub = (uint32_t)next;
+        cargs__group_plan(cmd, &nd[k].groups);
+        nd[k].names      = ntab;
+        nd[k].name_count = 0;
+        for (size_t j = 0; j < cmd->sub_count; j++) {
+            const cargs_cmd *c = &cmd->subs[j];
+            nd[next++].cmd     = c;
+            if (c->name) {
+                ntab[nd[k].name_count].name  = c->name;
+                ntab[nd[k].name_count++].sub = (uint32_t)j;
+            }
+            for (size_t a = 0; a < c->alias_count; a++) {
+                if (!c->aliases[a]) continue;
+                ntab[nd[k].name_count].name  = c->aliases[a];
+                ntab[nd[k].name_count++].sub = (uint32_t)j;
+            }
+        }
+        cargs__ix_sort_names(ntab, nd[k].name_count);
+        ntab += nd[k].name_count;
+
+        uint16_t *st = shorts + k * 256;
+        size_t    ns = cargs__ix_long_slots(cmd);
+        nd[k].shorts    = st;
+        nd[k].longs     = ns ? longs : NULL;
+        nd[k].long_mask = ns ? (uint32_t)(ns - 1) : 0;
+        /* First definition wins, matching the linear scans */
+        for (size_t i = 0; i < cmd->opt_count; i++) {
+            const cargs_opt *o = &cmd->opts[i];
+            if (o->short_name && !st[(unsigned char)o->short_name])
+                st[(unsigned char)o->short_name] = (uint16_t)(i + 1);
+            if (!o->long_name) continue;
+            size_t   len = strlen(o->long_name);
+            uint32_t h   = cargs__hash(o->long_name, len);
+            uint32_t s   = h & nd[k].long_mask;
+            bool     dup = false;
+            while (longs[s]) {
+                const cargs_opt *p = &cmd->opts[(longs[s] & 0xffffu) - 1];
+                if (strcmp(p->long_name, o->long_name) == 0) {
+                    dup = true;
+                    break;
+                }
+                s = (s + 1) & nd[k].long_mask;
+            }
+            if (!dup) longs[s] = (h & 0xffff0000u) | (uint32_t)(i + 1);
+        }
+        longs += ns;
+    }
+
+    ix->root       = root;
+    ix->nodes      = nd;
+    ix->node_count = nodes;
+    return ix;
+}
+
+static inline const cargs_index *cargs_compile_arena(
+    const cargs_cmd *root, cargs_arena *arena
+) {
+    if (!root) return NULL;
+    cargs_arena_mark   m    = cargs_arena_save(arena);
+    size_t             need = cargs_compile_size(root);
+    void              *mem  = cargs_arena_alloc(arena, need, 1);
+    const cargs_index *ix   = mem ? cargs_compile(root, mem, need) : NULL;
+    if (!ix) cargs_arena_rewind(arena, m);
+    return ix;
+}
+
+static inline const cargs_opt *cargs__ix_find_long(
+    const cargs_index_node *nd, const char *name, size_t len, cargs_stats *st
+) {
+    (void)st;
+    if (!nd->longs) return NULL;
+    uint32_t h   = cargs__hash(name, len);
+    uint32_t tag = h & 0xffff0000u;
+    for (uint32_t s = h & nd->long_mask;; s = (s + 1) & nd->long_mask) {
+        uint32_t e = nd->longs[s];
+        if (!e) return NULL;
+        if ((e & 0xffff0000u) != tag) continue;
+        const cargs_opt *o = &nd->cmd->opts[(e & 0xffffu) - 1];
+        CARGS__CMP(st);
+        if (strncmp(o->long_name, name, len) == 0 && o->long_name[len] == '\0')
+            return o;
+    }
+}
+
+static inline const cargs_opt *cargs__ix_find_short(
+    const cargs_index_node *nd, char c
+) {
+    uint16_t e = nd->shorts[(unsigned char)c];
+    return (c && e) ? &nd->cmd->opts[e - 1] : NULL;
+}
+
+/* Value-lookahead heuristic for OPTIONAL args:
+   treat next token as a value if it doesn't look like an option,
+   or if it looks like a numeric literal (e.g., -12, -0.5, +3). */
+static inline bool cargs_token_looks_numeric(const char *s) {
+    if (!s || !*s) return false;
+    if (*s == '+' || *s == '-') {
+        if (isdigit((unsigned char)s[1])) return true; /* -12, +7 */
+        if (s[1] == '.' && isdigit((unsigned char)s[2])) return true; /* -.5 */
+        if (s[1] == '0' && (s[2] == 'x' || s[2] == 'X'))
+            return true; /* -0xFF */
+        return false;
+    }
+    return isdigit((unsigned char)s[0]);
+}
+
+static inline unsigned cargs__ctz64(uint64_t m) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_ctzll(m);
+#else
+    unsigned n = 0;
+    for (; !(m & 1); m >>= 1) n++;
+    return n;
+#endif
+}
+
+/* ===== Packed trees ===== */
+#define CARGS__PK_LOCAL 8192 /* stack arena without env->arena */
+
+typedef struct cargs__pk_walk {
+    const cargs_packed *pk;
+    cargs_packed_fns    fns;
+    cargs_arena        *arena;
+    uint32_t            node;  /* packed index of the level being parsed */
+    cargs_cmd          *cur;   /* its decoded form */
+    bool                heads; /* cur->subs decoded */
+} cargs__pk_walk;
+
+/* What one dispatch carries in its copy of env (env->walk_) */
+typedef struct cargs__walk {
+    cargs__pk_walk *packed; /* set by cargs_dispatch_packed */
+    bool            capped; /* limits->max_callbacks applies */
+    unsigned        left;   /* callbacks left under it */
+} cargs__walk;
+
+static inline cargs__pk_walk *cargs__pw(const cargs_env *env) {
+    return env && env->walk_ ? env->walk_->packed : NULL;
+}
+
+static inline bool cargs__pk_fits(uint32_t first, uint32_t n, uint32_t total) {
+    return first <= total && n <= total - first;
+}
+
+static inline const char *cargs__pk_str(
+    const cargs_packed *pk, uint32_t off, bool *ok
+) {
+    if (off == CARGS_PK_NONE) return NULL;
+    if (off >= pk->pool_len) *ok = false;
+    return *ok ? pk->pool + off : NULL;
+}
+
+/* Name, description and aliases of packed command pc */
+static inline void cargs__pk_head(
+    const cargs_packed *pk, const cargs_packed_cmd *pc, cargs_cmd *c,
+    const char **al, bool *ok
+) {
+    memset(c, 0, sizeof *c);
+    c->name = cargs__pk_str(pk, pc->name, ok);
+    c->desc = cargs__pk_str(pk, pc->desc, ok);
+    for (uint32_t a = 0; a < pc->alias_count; a++)
+        al[a] = cargs__pk_str(pk, pk->aliases[pc->first_alias + a], ok);
+    c->aliases     = pc->alias_count ? al : NULL;
+    c->alias_count = pc->alias_count;
+}
+
+static inline void cargs__pk_opt(
+    const cargs__pk_walk *pw, const cargs_packed_opt *po, cargs_opt *o,
+    bool *ok
+) {
+    const cargs_packed     *pk = pw->pk;
+    const cargs_packed_fns *f  = &pw->fns;
+    memset(o, 0, sizeof *o);
+    if (po->cb > f->cb_count || po->call > f->call_count ||
+        po->target > f->target_count || po->choices > f->choices_count ||
+        po->complete > f->complete_count) {
+        *ok = false;
+        return;
+    }
+    o->long_name     = cargs__pk_str(pk, po->long_name, ok);
+    o->short_name    = po->short_name;
+    o->arg           = (cargs_arg_kind)po->arg;
+    o->metavar       = cargs__pk_str(pk, po->metavar, ok);
+    o->help          = cargs__pk_str(pk, po->help, ok);
+    o->cb            = po->cb ? f->cb[po->cb - 1] : NULL;
+    o->env           = cargs__pk_str(pk, po->env, ok);
+    o->def           = cargs__pk_str(pk, po->def, ok);
+    o->group         = po->group;
+    o->group_policy  = po->group_policy;
+    o->bind.kind     = (cargs_bind_kind)po->bind_kind;
+    o->bind.target   = po->target ? f->target[po->target - 1] : NULL;
+    o->bind.choices  = po->choices ? f->choices[po->choices - 1] : NULL;
+    o->bind.call     = po->call ? f->call[po->call - 1] : NULL;
+    o->bind.complete = po->complete ? f->complete[po->complete - 1] : NULL;
+}
+
+/* Decode packed command n into pw->arena as the current level: the command
+   with its options, positionals, relations and handlers. Its subcommands
+   stay packed (sub_count 0) until cargs__pk_heads(). NULL with
+   *rc = CARGS_ERR_TOO_MANY when the arena is full, or CARGS_ERR_BAD_FORMAT
+   when a record points outside the tables. */
+static inline const cargs_cmd *cargs__pk_level(
+    cargs__pk_walk *pw, uint32_t n, int *rc
+) {
+    const cargs_packed     *pk = pw->pk;
+    const cargs_packed_fns *f  = &pw->fns;
+    *rc                        = CARGS_ERR_BAD_FORMAT;
+    if (n >= pk->cmd_count) return NULL;
+    const cargs_packed_cmd *pc = &pk->cmds[n];
+    if (!cargs__pk_fits(pc->first_opt, pc->opt_count, pk->opt_count) ||
+        !cargs__pk_fits(pc->first_sub, pc->sub_count, pk->cmd_count) ||
+        !cargs__pk_fits(pc->first_alias, pc->alias_count, pk->alias_count) ||
+        !cargs__pk_fits(pc->first_pos, pc->pos_count, pk->pos_count) ||
+        !cargs__pk_fits(pc->first_rel, pc->rel_count, pk->rel_count) ||
+        pc->run > f->run_count || pc->pos_batch > f->pos_batch_count)
+        return NULL;
+
+    cargs_arena *a = pw->arena;
+    cargs_cmd   *c =
+        (cargs_cmd *)cargs_arena_alloc(a, sizeof *c, sizeof(void *));
+    cargs_opt *o = (cargs_opt *)cargs_arena_alloc(
+        a, pc->opt_count * sizeof *o, sizeof(void *)
+    );
+    cargs_pos *p = (cargs_pos *)cargs_arena_alloc(
+        a, pc->pos_count * sizeof *p, sizeof(void *)
+    );
+    cargs_rel *r = (cargs_rel *)cargs_arena_alloc(
+        a, pc->rel_count * sizeof *r, sizeof(void *)
+    );
+    const char **al = (const char **)cargs_arena_alloc(
+        a, pc->alias_count * sizeof *al, sizeof(void *)
+    );
+    *rc = CARGS_ERR_TOO_MANY;
+    if (!c || !o || !p || !r || !al) return NULL;
+
+    bool ok = true;
+    cargs__pk_head(pk, pc, c, al, &ok);
+    for (uint32_t k = 0; k < pc->opt_count; k++)
+        cargs__pk_opt(pw, &pk->opts[pc->first_opt + k], &o[k], &ok);
+    for (uint32_t k = 0; k < pc->pos_count; k++) {
+        const cargs_packed_pos *pp = &pk->pos[pc->first_pos + k];
+        p[k].name                  = cargs__pk_str(pk, pp->name, &ok);
+        p[k].desc                  = cargs__pk_str(pk, pp->desc, &ok);
+        p[k].min                   = pp->min;
+        p[k].max                   = pp->max;
+    }
+    for (uint32_t k = 0; k < pc->rel_count; k++) {
+        const cargs_packed_rel *pr = &pk->rels[pc->first_rel + k];
+        r[k].kind                  = pr->kind;
+        r[k].opt                   = cargs__pk_str(pk, pr->opt, &ok);
+        r[k].other                 = cargs__pk_str(pk, pr->other, &ok);
+    }
+    c->opts      = pc->opt_count ? o : NULL;
+    c->opt_count = pc->opt_count;
+    c->pos       = pc->pos_count ? p : NULL;
+    c->pos_count = pc->pos_count;
+    c->rels      = pc->rel_count ? r : NULL;
+    c->rel_count = pc->rel_count;
+    c->run       = pc->run ? f->run[pc->run - 1] : NULL;
+    c->pos_batch = pc->pos_batch ? f->pos_batch[pc->pos_batch - 1] : NULL;
+    *rc          = CARGS_ERR_BAD_FORMAT;
+    if (!ok) return NULL;
+    *rc       = CARGS_OK;
+    pw->node  = n;
+    pw->cur   = c;
+    pw->heads = false;
+    return c;
+}
+
+/* Decode the current level's subcommands with what prefix matching,
+   suggestions and help rows read (names, aliases, descriptions). On failure
+   the level keeps no subcommands; *rc (if given) says why. */
+static inline bool cargs__pk_heads(cargs__pk_walk *pw, int *rc) {
+    if (pw->heads) return true;
+    pw->heads                  = true;
+    const cargs_packed     *pk = pw->pk;
+    const cargs_packed_cmd *pc = &pk->cmds[pw->node];
+    size_t                  na = 0;
+    bool                    ok = true;
+    for (uint32_t k = 0; ok && k < pc->sub_count; k++) {
+        const cargs_packed_cmd *h = &pk->cmds[pc->first_sub + k];
+        ok = cargs__pk_fits(h->first_alias, h->alias_count, pk->alias_count);
+        na += h->alias_count;
+    }
+    cargs_cmd   *subs = NULL;
+    const char **al   = NULL;
+    if (ok) {
+        subs = (cargs_cmd *)cargs_arena_alloc(
+            pw->arena, pc->sub_count * sizeof *subs, sizeof(void *)
+        );
+        al = (const char **)cargs_arena_alloc(
+            pw->arena, na * sizeof *al, sizeof(void *)
+        );
+    }
+    int why = !ok ? CARGS_ERR_BAD_FORMAT
+            : (!subs || !al) ? CARGS_ERR_TOO_MANY
+                             : CARGS_OK;
+    for (uint32_t k = 0; !why && k < pc->sub_count; k++) {
+        const cargs_packed_cmd *h = &pk->cmds[pc->first_sub + k];
+        cargs__pk_head(pk, h, &subs[k], al, &ok);
+        al += h->alias_count;
+    }
+    if (!why && !ok) why = CARGS_ERR_BAD_FORMAT;
+    if (why) {
+        if (rc) *rc = why;
+        return false;
+    }
+    pw->cur->subs      = pc->sub_count ? subs : NULL;
+    pw->cur->sub_count = pc->sub_count;
+    return true;
+}
+
+static inline int cargs__pk_fail(const cargs_env *env, int rc, uint32_t n) {
+    if (rc == CARGS_ERR_TOO_MANY)
+        cargs__errf(env, "Packed tree: arena exhausted\n");
+    else
+        cargs__errf(env, "Packed tree: bad record %lu\n", (unsigned long)n);
+    return rc;
+}
+
+/* Subcommand k of the current level, decoded as the new current level */
+static inline const cargs_cmd *cargs__pk_enter(
+    const cargs_env *env, uint32_t k, int *rc
+) {
+    cargs__pk_walk  *pw = env->walk_->packed;
+    uint32_t         n  = pw->pk->cmds[pw->node].first_sub + k;
+    const cargs_cmd *c  = cargs__pk_level(pw, n, rc);
+    if (!c) *rc = cargs__pk_fail(env, *rc, n);
+    return c;
+}
+
+/* ===== Display width ===== */
+/* Columns follow the terminal, not the bytes: ANSI escapes take none, UTF-8
+ * is decoded, combining marks are zero wide and East Asian wide/fullwidth
+ * characters (CJK, Hangul, fullwidth forms, emoji) take two. The tables
+ * cover the common blocks rather than all of Unicode. Invalid UTF-8 counts
+ * one column per byte. */
+typedef struct {
+    uint32_t lo, hi;
+} cargs__urange;
+
+static inline bool cargs__in_ranges(
+    uint32_t cp, const cargs__urange *r, size_t n
+) {
+    if (cp < r[0].lo || cp > r[n - 1].hi) return false;
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (cp > r[mid].hi) lo = mid + 1;
+        else if (cp < r[mid].lo) hi = mid;
+        else return true;
+    }
+    return false;
+}
+
+static inline int cargs__cp_width(uint32_t cp) {
+    static const cargs__urange zero[] = {
+        {0x0300, 0x036F},   {0x0483, 0x0489}, {0x0591, 0x05BD},
+        {0x05BF, 0x05BF},   {0x05C1, 0x05C2}, {0x05C4, 0x05C5},
+        {0x05C7, 0x05C7},   {0x0610, 0x061A}, {0x064B, 0x065F},
+        {0x0670, 0x0670},   {0x06D6, 0x06DC}, {0x06DF, 0x06E4},
+        {0x06E7, 0x06E8},   {0x06EA, 0x06ED}, {0x0900, 0x0902},
+        {0x093A, 0x093A},   {0x093C, 0x093C}, {0x0941, 0x0948},
+        {0x094D, 0x094D},   {0x0951, 0x0957}, {0x0E31, 0x0E31},
+        {0x0E34, 0x0E3A},   {0x0E47, 0x0E4E}, {0x1160, 0x11FF},
+        {0x1AB0, 0x1AFF},   {0x1DC0, 0x1DFF}, {0x200B, 0x200F},
+        {0x202A, 0x202E},   {0x2060, 0x2064}, {0x20D0, 0x20FF},
+        {0xFE00, 0xFE0F},   {0xFE20, 0xFE2F}, {0xFEFF, 0xFEFF},
+        {0xE0100, 0xE01EF},
+    };
+    static const cargs__urange wide[] = {
+        {0x1100, 0x115F},   {0x231A, 0x231B},   {0x2329, 0x232A},
+        {0x23E9, 0x23EC},   {0x23F0, 0x23F0},   {0x23F3, 0x23F3},
+        {0x25FD, 0x25FE},   {0x2614, 0x2615},   {0x2648, 0x2653},
+        {0x267F, 0x267F},   {0x2693, 0x2693},   {0x26A1, 0x26A1},
+        {0x26AA, 0x26AB},   {0x26BD, 0x26BE},   {0x26C4, 0x26C5},
+        {0x26CE, 0x26CE},   {0x26D4, 0x26D4},   {0x26EA, 0x26EA},
+        {0x26F2, 0x26F3},   {0x26F5, 0x26F5},   {0x26FA, 0x26FA},
+        {0x26FD, 0x26FD},   {0x2705, 0x2705},   {0x270A, 0x270B},
+        {0x2728, 0x2728},   {0x274C, 0x274C},   {0x274E, 0x274E},
+        {0x2753, 0x2755},   {0x2757, 0x2757},   {0x2795, 0x2797},
+        {0x27B0, 0x27B0},   {0x27BF, 0x27BF},   {0x2B1B, 0x2B1C},
+        {0x2B50, 0x2B50},   {0x2B55, 0x2B55},   {0x2E80, 0x303E},
+        {0x3041, 0x33FF},   {0x3400, 0x4DBF},   {0x4E00, 0x9FFF},
+        {0xA000, 0xA4CF},   {0xA960, 0xA97F},   {0xAC00, 0xD7A3},
+        {0xF900, 0xFAFF},   {0xFE10, 0xFE19},   {0xFE30, 0xFE6F},
+        {0xFF00, 0xFF60},   {0xFFE0, 0xFFE6},   {0x1F300, 0x1F64F},
+        {0x1F900, 0x1F9FF}, {0x20000, 0x2FFFD}, {0x30000, 0x3FFFD},
+    };
+    if (cp < 0x300) return (cp < 0x20 || (cp >= 0x7F && cp < 0xA0)) ? 0 : 1;
+    if ((cp >= 0x4E00 && cp <= 0x9FFF) || (cp >= 0xAC00 && cp <= 0xD7A3))
+        return 2; /* CJK ideographs, Hangul syllables */
+    if (cargs__in_ranges(cp, zero, sizeof(zero) / sizeof(zero[0]))) return 0;
+    if (cp < 0x1100) return 1;
+    if (cargs__in_ranges(cp, wide, sizeof(wide) / sizeof(wide[0]))) return 2;
+    return 1;
+}
+
+/* Decode the sequence at s (< end); invalid, overlong or truncated input
+   yields one byte as U+FFFD */
+static inline size_t cargs__utf8_dec(
+    const char *s, const char *end, uint32_t *cp
+) {
+    const unsigned char *u   = (const unsigned char *)s;
+    size_t               max = (size_t)(end - s);
+    size_t               n   = u[0] >= 0xF0 ? 4 : u[0] >= 0xE0 ? 3 : 2;
+    uint32_t             c   = u[0] & (0x3Fu >> (n - 1));
+    if (u[0] < 0xC2 || u[0] > 0xF4 || n > max) goto bad;
+    for (size_t i = 1; i < n; i++) {
+        if ((u[i] & 0xC0) != 0x80) goto bad;
+        c = (c << 6) | (u[i] & 0x3Fu);
+    }
+    if ((n == 3 && (c < 0x800 || (c >= 0xD800 && c <= 0xDFFF)))
+        || (n == 4 && (c < 0x10000 || c > 0x10FFFF)))
+        goto bad;
+    *cp = c;
+    return n;
+bad:
+    *cp = 0xFFFD;
+    return 1;
+}
+
+/* Length of the escape sequence at s (s[0] == ESC): CSI ("\x1b[1;36m"),
+   OSC up to BEL or ST, or ESC plus one byte */
+static inline size_t cargs__esc_len(const char *s, const char *end) {
+    const char *p = s + 1;
+    if (p >= end) return 1;
+    if (*p == '[') {
+        for (p++; p < end; p++)
+            if ((unsigned char)*p >= 0x40 && (unsigned char)*p <= 0x7E)
+                return (size_t)(p + 1 - s);
+        return (size_t)(end - s);
+    }
+    if (*p == ']') {
+        for (p++; p < end; p++) {
+            if (*p == '\a') return (size_t)(p + 1 - s);
+            if (*p == '\x1b' && p + 1 < end && p[1] == '\\')
+                return (size_t)(p + 2 - s);
+        }
+        return (size_t)(end - s);
+    }
+    return 2;
+}
+
+/* One character (or escape) at s: its bytes, and its columns in *cols */
+static inline size_t cargs__char_width(
+    const char *s, const char *end, int *cols
+) {
+    unsigned char c = (unsigned char)*s;
+    if (c == 0x1B) {
+        *cols = 0;
+        return cargs__esc_len(s, end);
+    }
+    if (c < 0x80) {
+        *cols = 1; /* tabs and other controls: one column, as before */
+        return 1;
+    }
+    uint32_t cp;
+    size_t   n = cargs__utf8_dec(s, end, &cp);
+    *cols      = cargs__cp_width(cp);
+    return n;
+}
+
+static inline unsigned cargs__clz64(uint64_t m) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_clzll(m);
+#else
+    unsigned n = 0;
+    for (; !(m & 0x8000000000000000ull); m <<= 1) n++;
+    return n;
+#endif
+}
+
+/* Scan the 8 bytes at s as one word (byte i in bits 8i..8i+7). Returns bit
+   7 of each byte that needs a closer look (controls, ESC, UTF-8), and in
+   *spaces that of each ' '. No carries cross bytes, so both are exact. */
+static inline uint64_t cargs__swar_scan(const char *s, uint64_t *spaces) {
+    const uint64_t lo7 = 0x7F7F7F7F7F7F7F7Full, hi = ~lo7;
+    uint64_t       v;
+    memcpy(&v, s, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    uint64_t ge21 = ((v & lo7) + 0x5F5F5F5F5F5F5F5Full) & hi; /* >= '!' */
+    uint64_t sp   = v ^ 0x2020202020202020ull;
+    sp            = ~(((sp & lo7) + lo7) | sp) & hi;
+    *spaces       = sp;
+    return ((v & hi) | (~ge21 & hi)) & ~sp;
+}
+
+static inline size_t cargs_text_width(const char *s, size_t n) {
+    if (!s) return 0;
+    const char *end  = s + n;
+    size_t      cols = 0;
+    while (s < end) {
+        if (end - s >= 8) {
+            uint64_t sp, m = cargs__swar_scan(s, &sp);
+            size_t   k = m ? cargs__ctz64(m) >> 3 : 8;
+            s += k;
+            cols += k;
+            if (k == 8) continue;
+        }
+        if (s >= end) break;
+        int w;
+        s += cargs__char_width(s, end, &w);
+        cols += (size_t)w;
+    }
+    return cols;
+}
+
+/* Word-wrapping for help text: lines hold width - start_col columns, broken
+   at the last space that fits (or inside a word longer than a line, between
+   characters). ASCII runs are taken eight bytes at a time. */
+static inline void cargs__wrap_w(
+    cargs_wbuf *w, const char *text, int start_col, int width
 ) {
     if (!text || !*text) {
-        fputc('\n', out);
+        cargs__wb_putc(w, '\n');
         return;
     }
     if (width <= 0 || start_col <= 0 || start_col + 10 > width) {
-        fprintf(out, "%s\n", text);
+        cargs__wb_puts(w, text);
+        cargs__wb_putc(w, '\n');
         return;
     }
-    const char *p = text;
-    while (*p) {
-        int         remaining = width - start_col;
-        const char *line_end = p, *last_space = NULL;
-        int         used = 0;
-        while (line_end[0] && line_end[0] != '\n' && used < remaining) {
-            if (line_end[0] == ' ') last_space = line_end;
-            line_end++;
-            used++;
-        }
-        if (!line_end[0] || line_end[0] == '\n') {
-            fprintf(out, "%.*s\n", (int)(line_end - p), p);
-            p = line_end + (line_end[0] == '\n' ? 1 : 0);
-            if (*p) fprintf(out, "%*s", start_col, "");
+    const char *p = text, *end = text + strlen(text);
+    const int   room = width - start_col;
+    while (p < end) {
+        const char *q = p, *brk = NULL; /* last space that fits */
+        int         col = 0;
+        while (q < end) {
+            if (end - q >= 8) {
+                /* printable ASCII and spaces up to the next special byte */
+                uint64_t sp, m = cargs__swar_scan(q, &sp);
+                int      k = m ? (int)(cargs__ctz64(m) >> 3) : 8;
+                if (k > room - col) k = room - col;
+                if (k < 8) sp &= (1ull << (8 * k)) - 1;
+                if (sp) brk = q + ((63 - cargs__clz64(sp)) >> 3);
+                q += k;
+                col += k;
+                if (k == 8) continue;
+            }
+            if (q >= end || *q == '\n') break;
+            int    cw;
+            size_t n = cargs__char_width(q, end, &cw);
+            if (col + cw > room) break;
+            if (*q == ' ') brk = q;
+            q += n;
+            col += cw;
+        }
+        if (q >= end || *q == '\n') {
+            cargs__wb_write(w, p, (size_t)(q - p));
+            cargs__wb_putc(w, '\n');
+            p = q + (q < end ? 1 : 0);
+            if (p < end) cargs__wb_pad(w, start_col);
             continue;
         }
-        if (last_space) {
-            fprintf(out, "%.*s\n%*s", (int)(last_space - p), p, start_col, "");
-            p = last_space + 1;
+        if (*q == ' ') brk = q; /* the line ends exactly before a space */
+        if (brk) {
+            cargs__wb_write(w, p, (size_t)(brk - p));
+            p = brk + 1;
         } else {
-            fprintf(out, "%.*s\n%*s", remaining, p, start_col, "");
-            p += remaining;
+            cargs__wb_write(w, p, (size_t)(q - p));
+            p = q;
         }
+        cargs__wb_putc(w, '\n');
+        cargs__wb_pad(w, start_col);
     }
 }
 
-/* Render positional usage into buf */
-static inline void cargs_render_pos_usage(
-    char *buf, size_t bufsz, const cargs_cmd *cmd
+static inline void cargs_wrap_print(
+    FILE *out, const char *text, int start_col, int width
 ) {
-    if (!buf || bufsz == 0) return;
-    buf[0] = '\0';
-    if (!cmd || !cmd->pos || cmd->pos_count == 0) return;
-    size_t n = 0;
-
-#define APPEND(fmt, ...)                                             \
-    do {                                                             \
-        int _w = snprintf(                                           \
-            buf + n, (n < bufsz) ? (bufsz - n) : 0, fmt, __VA_ARGS__ \
-        );                                                           \
-        if (_w > 0) {                                                \
-            size_t _add = (size_t)_w;                                \
-            n           = (n + _add < bufsz) ? (n + _add) : bufsz;   \
-        }                                                            \
-    } while (0)
+    char       buf[4096];
+    cargs_wbuf w;
+    cargs__wb_init(&w, buf, sizeof(buf), out);
+    cargs__wrap_w(&w, text, start_col, width);
+    cargs__wb_flush(&w);
+}
 
+/* Positional usage (" NAME [FILE ...]") into w */
+static inline void cargs__pos_usage_w(cargs_wbuf *w, const cargs_cmd *cmd) {
+    if (!cmd || !cmd->pos) return;
     for (size_t i = 0; i < cmd->pos_count; i++) {
         const cargs_pos *p    = &cmd->pos[i];
-        const char      *name = (p && p->name && *p->name) ? p->name : "ARG";
-
-        if (p->max == CARGS_POS_INF) {
-            /* Unbounded */
-            int minreq = (p->min > 0) ? p->min : 0;
-            for (int k = 0; k < minreq; ++k) APPEND(" %s", name);
-            if (p->min <= 0) APPEND(" [%s ...]", name);
-            else
-                APPEND(
-                    " [%s ...]", name
-                ); /* 1..inf or more: tail optional list */
-        } else if (p->max <= 1) {
-            /* 0..1 or 1..1 */
-            if (p->min == 0) APPEND(" [%s]", name);
-            else APPEND(" %s", name);
-        } else {
-            /* Finite M..N with N>1 */
-            int minreq = (p->min > 0) ? p->min : 0;
-            for (int k = 0; k < minreq; ++k) APPEND(" %s", name);
-            int opt = (int)p->max - minreq;
-            for (int k = 0; k < opt; ++k) APPEND(" [%s]", name);
+        const char      *name = (p->name && *p->name) ? p->name : "ARG";
+        int              req  = p->min; /* spelled out */
+        int              opt  = -1;     /* [NAME] each; -1 = " [NAME ...]" */
+        if (p->max <= 1) {
+            req = p->min ? 1 : 0;
+            opt = 1 - req;
+        } else if (p->max != CARGS_POS_INF) {
+            opt = (int)p->max - req;
+        }
+        for (int k = 0; k < req; k++) {
+            cargs__wb_putc(w, ' ');
+            cargs__wb_puts(w, name);
+        }
+        for (int k = 0; k < opt; k++) {
+            cargs__wb_puts(w, " [");
+            cargs__wb_puts(w, name);
+            cargs__wb_putc(w, ']');
+        }
+        if (opt < 0) {
+            cargs__wb_puts(w, " [");
+            cargs__wb_puts(w, name);
+            cargs__wb_puts(w, " ...]");
         }
-        if (n >= bufsz) break;
     }
-    if (bufsz) buf[bufsz - 1] = '\0';
-#undef APPEND
+}
+
+/* Render positional usage into buf (truncated to bufsz - 1 bytes) */
+static inline void cargs_render_pos_usage(
+    char *buf, size_t bufsz, const cargs_cmd *cmd
+) {
+    if (!buf || bufsz == 0) return;
+    cargs_wbuf w;
+    cargs__wb_init(&w, buf, bufsz, NULL);
+    cargs__pos_usage_w(&w, cmd);
 }
 
 /* Validate positionals: ensure argc lies within [sum_mins, sum_maxs] (unless
  * any INF) */
+/* Total min/max over the positional schema; has_inf if any item is open */
+static inline void cargs__pos_bounds(
+    const cargs_cmd *cmd, unsigned *sum_min, unsigned *sum_max, bool *has_inf
+) {
+    *sum_min = *sum_max = 0;
+    *has_inf = false;
+    for (size_t i = 0; cmd->pos && i < cmd->pos_count; i++) {
+        *sum_min += cmd->pos[i].min;
+        if (cmd->pos[i].max == CARGS_POS_INF) *has_inf = true;
+        else *sum_max += cmd->pos[i].max;
+    }
+}
+
+/* The schema item that n positionals leave short, taking each item's min in
+   order (a positional fills the first item still below its min) */
+static inline const char *cargs__pos_missing(const cargs_cmd *cmd, size_t n) {
+    for (size_t i = 0; cmd->pos && i < cmd->pos_count; i++) {
+        const cargs_pos *p = &cmd->pos[i];
+        if (n < p->min) return p->name ? p->name : "ARG";
+        n -= p->min;
+    }
+    return "ARG";
+}
+
 static inline int cargs_validate_positional(
     const cargs_env *env, const cargs_cmd *cmd, int argc, char **argv
 ) {
     (void)argv;
     if (!cmd || !cmd->pos || !cmd->pos_count) return CARGS_OK;
-    unsigned sum_min = 0;
-    unsigned sum_max = 0;
-    bool     has_inf = false;
-    for (size_t i = 0; i < cmd->pos_count; i++) {
-        sum_min += cmd->pos[i].min;
-        if (cmd->pos[i].max == CARGS_POS_INF) has_inf = true;
-        else sum_max += cmd->pos[i].max;
-    }
+    unsigned sum_min, sum_max;
+    bool     has_inf;
+    cargs__pos_bounds(cmd, &sum_min, &sum_max, &has_inf);
     if (argc < (int)sum_min) {
-        fprintf(
-            cargs_err(env),
-            "Missing required positional(s): need at least %u, got %d\n",
-            sum_min, argc
+        cargs__errf(
+            env, "Missing required positional %s: need at least %u, got %d\n",
+            cargs__pos_missing(cmd, (size_t)argc), sum_min, argc
         );
         return CARGS_ERR_POSITIONAL;
     }
     if (!has_inf && argc > (int)sum_max) {
-        fprintf(
-            cargs_err(env),
-            "Too many positionals: at most %u allowed, got %d\n", sum_max, argc
+        cargs__errf(
+            env, "Too many positionals: at most %u allowed, got %d\n", sum_max,
+            argc
         );
         return CARGS_ERR_TOO_MANY;
     }
@@ -373,129 +2337,209 @@ static inline bool cargs__has_any_options(
            (env && (env->auto_help || env->auto_version || env->auto_author));
 }
 
-static inline void cargs_print_usage(
-    const cargs_env *env, const char *prog, const char *const *path,
-    size_t depth, const cargs_cmd *cmd
+/* Append s to buf (truncating, always NUL-terminated); returns new length */
+static inline size_t cargs__cat(
+    char *buf, size_t cap, size_t n, const char *s, size_t k
 ) {
-    FILE       *out = cargs_out(env);
-    const char *B = cargs_s_bold(env), *R = cargs_s_rst(env);
-
-    char        buf[256];
-    buf[0]   = '\0';
-    size_t n = 0;
-    if (prog) n += (size_t)snprintf(buf + n, sizeof(buf) - n, "%s", prog);
-    for (size_t i = 0; i < depth; i++) {
-        if (n + 1 < sizeof(buf)) buf[n++] = ' ';
-        n += (size_t)snprintf(buf + n, sizeof(buf) - n, "%s", path[i]);
-    }
-    buf[sizeof(buf) - 1] = '\0';
-
-    fprintf(out, "%sUsage:%s %s", B, R, buf);
-
-    if (cargs__has_any_options(env, cmd)) fputs(" [options]", out);
-    if (cmd && cmd->sub_count) fputs(" <command> [command-options]", out);
-
-    char pbuf[192];
-    cargs_render_pos_usage(pbuf, sizeof(pbuf), cmd);
-    fputs(pbuf, out);
-
-    if (!cmd || !cmd->pos || !cmd->pos_count) fputs(" [--] [args...]", out);
-    fputc('\n', out);
+    if (n + 1 >= cap) return n;
+    if (k > cap - n - 1) k = cap - n - 1;
+    memcpy(buf + n, s, k);
+    buf[n + k] = '\0';
+    return n + k;
 }
+#define CARGS__CATS(buf, cap, n, s) cargs__cat(buf, cap, n, s, strlen(s))
 
-static inline void cargs_print_opt_row(
-    const cargs_env *env, const cargs_opt *o
+/* need bytes for a message part: buf[cap] when it fits, else env->arena
+   (the caller rewinds it); NULL when neither has room */
+static inline char *cargs__scratch(
+    const cargs_env *env, char *buf, size_t cap, size_t need
 ) {
-    FILE       *out = cargs_out(env);
-    const char *F = cargs_s_flag(env), *R = cargs_s_rst(env);
-    char        lhs[160];
-    lhs[0]   = '\0';
+    if (need <= cap) return buf;
+    return env && env->arena ? (char *)cargs_arena_alloc(env->arena, need, 1)
+                             : NULL;
+}
+
+/* Left-column text of an option row (uncolored); returns its length */
+static inline size_t cargs__opt_lhs(const cargs_opt *o, char *lhs, size_t cap) {
     size_t n = 0;
+    lhs[0]   = '\0';
     if (o->short_name) {
-        n += (size_t)snprintf(lhs + n, sizeof(lhs) - n, "-%c", o->short_name);
-        if (o->long_name) n += (size_t)snprintf(lhs + n, sizeof(lhs) - n, ", ");
+        char sh[2] = {'-', o->short_name};
+        n          = cargs__cat(lhs, cap, n, sh, 2);
+        if (o->long_name) n = CARGS__CATS(lhs, cap, n, ", ");
     }
     if (o->long_name) {
-        n += (size_t)snprintf(lhs + n, sizeof(lhs) - n, "--%s", o->long_name);
+        n = CARGS__CATS(lhs, cap, n, "--");
+        n = CARGS__CATS(lhs, cap, n, o->long_name);
     }
-    if (o->arg == CARGS_ARG_REQUIRED) {
-        n += (size_t)snprintf(
-            lhs + n, sizeof(lhs) - n, " %s", o->metavar ? o->metavar : "VALUE"
-        );
-    } else if (o->arg == CARGS_ARG_OPTIONAL) {
-        n += (size_t)snprintf(
-            lhs + n, sizeof(lhs) - n, "[%s]", o->metavar ? o->metavar : "VALUE"
-        );
+    if (o->arg != CARGS_ARG_NONE) {
+        const char *mv = o->metavar ? o->metavar : "VALUE";
+        n = CARGS__CATS(lhs, cap, n, o->arg == CARGS_ARG_REQUIRED ? " " : "[");
+        n = CARGS__CATS(lhs, cap, n, mv);
+        if (o->arg == CARGS_ARG_OPTIONAL) n = CARGS__CATS(lhs, cap, n, "]");
     }
     if (o->env && o->def) {
-        n += (size_t)snprintf(lhs + n, sizeof(lhs) - n, " (env %s)", o->env);
-    }
-
-    char colored[200];
-    if (cargs_use_color(env))
-        snprintf(colored, sizeof(colored), "%s%s%s", F, lhs, R);
-    else snprintf(colored, sizeof(colored), "%s", lhs);
-
-    const int left      = 30;
-    int       width     = cargs_columns(env);
-    int       start_col = left + 2;
-    if (width <= 0) {
-        fprintf(out, "  %-30s %s\n", colored, o->help ? o->help : "");
-        return;
+        n = CARGS__CATS(lhs, cap, n, " (env ");
+        n = CARGS__CATS(lhs, cap, n, o->env);
+        n = CARGS__CATS(lhs, cap, n, ")");
     }
-    fprintf(out, "  %-30s ", colored);
-    cargs_wrap_print(out, o->help ? o->help : "", start_col + 2, width);
+    return n;
 }
 
-static inline void cargs_print_cmd_row(
-    const cargs_env *env, const cargs_cmd *c
+/* Left-column text of a command row: name + optional "(alias: ...)" */
+static inline size_t cargs__cmd_lhs(
+    const cargs_cmd *c, char *name, size_t cap
 ) {
-    FILE       *out = cargs_out(env);
-    const char *C = cargs_s_cmd(env), *R = cargs_s_rst(env);
-
-    /* build command name + optional "(alias: ...)" */
-    char   name[160];
     size_t n = 0;
     name[0]  = '\0';
-    n += (size_t)snprintf(
-        name + n, sizeof(name) - n, "%s", c->name ? c->name : ""
-    );
+    n        = CARGS__CATS(name, cap, n, c->name ? c->name : "");
     if (c->alias_count) {
-        n += (size_t)snprintf(name + n, sizeof(name) - n, " (alias: ");
+        n = CARGS__CATS(name, cap, n, " (alias: ");
         for (size_t a = 0; a < c->alias_count; a++) {
-            if (a) n += (size_t)snprintf(name + n, sizeof(name) - n, ", ");
-            n += (size_t)snprintf(
-                name + n, sizeof(name) - n, "%s", c->aliases[a]
-            );
+            if (a) n = CARGS__CATS(name, cap, n, ", ");
+            n = CARGS__CATS(name, cap, n, c->aliases[a]);
+        }
+        n = CARGS__CATS(name, cap, n, ")");
+    }
+    return n;
+}
+
+/* Widest left column among the rows help would print for cmd (and, with
+   recurse, its whole subtree) */
+static inline size_t cargs__pres_widest(
+    const cargs_env *env, const cargs_cmd *cmd, bool recurse
+) {
+    size_t wmax = 0;
+    char   buf[160];
+    if (env && env->auto_help) wmax = 10; /* "-h, --help" */
+    if (env && env->auto_version && env->version && wmax < 13) wmax = 13;
+    if (env && env->auto_author && env->author && wmax < 8) wmax = 8;
+    if (!cmd) return wmax;
+    for (size_t i = 0; i < cmd->opt_count; i++) {
+        size_t k = cargs__opt_lhs(&cmd->opts[i], buf, sizeof(buf));
+        k        = cargs_text_width(buf, k);
+        if (k > wmax) wmax = k;
+    }
+    for (size_t i = 0; i < cmd->sub_count; i++) {
+        size_t k = cargs__cmd_lhs(&cmd->subs[i], buf, sizeof(buf));
+        k        = cargs_text_width(buf, k);
+        if (k > wmax) wmax = k;
+        if (recurse) {
+            k = cargs__pres_widest(env, &cmd->subs[i], true);
+            if (k > wmax) wmax = k;
         }
-        n += (size_t)snprintf(name + n, sizeof(name) - n, ")");
+    }
+    for (size_t i = 0; i < cmd->pos_count; i++) {
+        const char *nm = cmd->pos[i].name;
+        size_t      k  = 3; /* "ARG" */
+        if (nm && *nm) k = cargs_text_width(nm, strlen(nm));
+        if (k > wmax) wmax = k;
+    }
+    return wmax;
+}
+
+static inline void cargs_pres_resolve(
+    const cargs_env *env, const cargs_cmd *root, cargs_pres *out
+) {
+    if (!out) return;
+    bool color = cargs_use_color(env);
+    out->bold  = color ? "\x1b[1m" : "";
+    out->flag  = color ? "\x1b[36m" : "";
+    out->cmd   = color ? "\x1b[35m" : "";
+    out->pos   = color ? "\x1b[33m" : "";
+    out->rst   = color ? "\x1b[0m" : "";
+    out->width = cargs_columns(env);
+    out->left  = 30;
+    if (root && env && env->help_fit) {
+        size_t wmax = cargs__pres_widest(env, root, true);
+        if (wmax && wmax < 30) out->left = (int)wmax;
+    }
+}
+
+/* env->pres if attached, else resolve into *tmp for cmd's subtree */
+static inline const cargs_pres *cargs__pres_get(
+    const cargs_env *env, const cargs_cmd *cmd, cargs_pres *tmp
+) {
+    cargs__pk_walk *pw = cmd ? cargs__pw(env) : NULL;
+    if (pw && pw->cur != cmd) pw = NULL;
+    if (pw) cargs__pk_heads(pw, NULL); /* help lists the subcommands */
+    if (env && env->pres) return env->pres;
+    cargs_pres_resolve(env, cmd, tmp);
+    if (pw && env->help_fit) {
+        /* below the heads the subtree is still packed: its width was
+           measured by the generator */
+        size_t w = cargs__pres_widest(env, NULL, false);
+        if (pw->pk->cmds[pw->node].widest > w)
+            w = pw->pk->cmds[pw->node].widest;
+        tmp->left = (w && w < 30) ? (int)w : 30;
+    }
+    return tmp;
+}
+
+static inline void cargs__help_usage(
+    cargs_wbuf *w, const cargs_env *env, const cargs_pres *pp,
+    const char *prog, const char *const *path, size_t depth,
+    const cargs_cmd *cmd
+) {
+    cargs__wb_puts(w, pp->bold);
+    cargs__wb_puts(w, "Usage:");
+    cargs__wb_puts(w, pp->rst);
+    cargs__wb_putc(w, ' ');
+    if (prog) cargs__wb_puts(w, prog);
+    for (size_t i = 0; i < depth; i++) {
+        cargs__wb_putc(w, ' ');
+        cargs__wb_puts(w, path[i]);
     }
 
-    char lhs[192];
-    snprintf(lhs, sizeof(lhs), "%s%s%s", C, name, R);
+    if (cargs__has_any_options(env, cmd)) cargs__wb_puts(w, " [options]");
+    if (cmd && cmd->sub_count)
+        cargs__wb_puts(w, " <command> [command-options]");
+    cargs__pos_usage_w(w, cmd);
 
-    const int left      = 30;
-    int       width     = cargs_columns(env);
-    int       start_col = left + 2;
+    if (!cmd || !cmd->pos || !cmd->pos_count)
+        cargs__wb_puts(w, " [--] [args...]");
+    cargs__wb_putc(w, '\n');
+}
 
-    if (width <= 0) {
-        fprintf(out, "  %-30s %s\n", lhs, c->desc ? c->desc : "");
+/* One help row: "  " + colored lhs padded to the left column + text */
+static inline void cargs__help_row(
+    cargs_wbuf *w, const cargs_pres *pp, const char *style, const char *lhs,
+    size_t lhs_len, const char *text
+) {
+    cargs__wb_puts(w, "  ");
+    cargs__wb_puts(w, style);
+    cargs__wb_write(w, lhs, lhs_len);
+    cargs__wb_puts(w, pp->rst);
+    cargs__wb_pad(w, pp->left - (int)cargs_text_width(lhs, lhs_len));
+    cargs__wb_putc(w, ' ');
+    if (pp->width <= 0) {
+        cargs__wb_puts(w, text);
+        cargs__wb_putc(w, '\n');
         return;
     }
-    fprintf(out, "  %-30s ", lhs);
-    cargs_wrap_print(out, c->desc ? c->desc : "", start_col + 2, width);
+    cargs__wrap_w(w, text, pp->left + 3, pp->width);
 }
 
-static inline void cargs_print_pos_row(
-    const cargs_env *env, const cargs_pos *p
+static inline void cargs__help_opt_row(
+    cargs_wbuf *w, const cargs_pres *pp, const cargs_opt *o
 ) {
-    FILE       *out = cargs_out(env);
-    const char *P = cargs_s_pos(env), *R = cargs_s_rst(env);
-    const char *name = (p && p->name && *p->name) ? p->name : "ARG";
+    char   lhs[160];
+    size_t n = cargs__opt_lhs(o, lhs, sizeof(lhs));
+    cargs__help_row(w, pp, pp->flag, lhs, n, o->help ? o->help : "");
+}
+
+static inline void cargs__help_cmd_row(
+    cargs_wbuf *w, const cargs_pres *pp, const cargs_cmd *c
+) {
+    char   name[160];
+    size_t n = cargs__cmd_lhs(c, name, sizeof(name));
+    cargs__help_row(w, pp, pp->cmd, name, n, c->desc ? c->desc : "");
+}
 
-    /* Left column (colored metavar) */
-    char lhs[160];
-    (void)snprintf(lhs, sizeof(lhs), "%s%s%s", P, name, R);
+static inline void cargs__help_pos_row(
+    cargs_wbuf *w, const cargs_pres *pp, const cargs_pos *p
+) {
+    const char *name = (p && p->name && *p->name) ? p->name : "ARG";
 
     /* Right column: prefer help; add (min..max) only when not 1..1 */
     char   rhs[256];
@@ -544,23 +2588,50 @@ static inline void cargs_print_pos_row(
         (void)snprintf(rhs, sizeof(rhs), "%s", "");
     }
 
-    const int left      = 30;
-    int       width     = cargs_columns(env);
-    int       start_col = left + 2;
-
-    if (width <= 0) {
-        fprintf(out, "  %-30s %s\n", lhs, rhs);
-        return;
-    }
-    fprintf(out, "  %-30s ", lhs);
-    cargs_wrap_print(out, rhs, start_col + 2, width);
+    cargs__help_row(w, pp, pp->pos, name, strlen(name), rhs);
 }
 
-static inline void cargs_build_usage_pos(
-    char *dst, size_t cap, const cargs_pos *pos, size_t npos
-) {
-    size_t off = 0;
-#define APPEND(fmt, ...)                                                       \
+/* Unbuffered-API wrappers: render one piece and write it to env->out */
+#define CARGS__WB_ONESHOT(env, call)                             \
+    do {                                                         \
+        char       _buf[512];                                    \
+        cargs_wbuf _w;                                           \
+        cargs_pres _tmp;                                         \
+        const cargs_pres *_pp = cargs__pres_get(env, NULL, &_tmp); \
+        cargs__wb_init(&_w, _buf, sizeof(_buf), cargs_out(env)); \
+        call;                                                    \
+        cargs__wb_flush(&_w);                                    \
+    } while (0)
+
+static inline void cargs_print_usage(
+    const cargs_env *env, const char *prog, const char *const *path,
+    size_t depth, const cargs_cmd *cmd
+) {
+    CARGS__WB_ONESHOT(
+        env, cargs__help_usage(&_w, env, _pp, prog, path, depth, cmd)
+    );
+}
+static inline void cargs_print_opt_row(
+    const cargs_env *env, const cargs_opt *o
+) {
+    CARGS__WB_ONESHOT(env, cargs__help_opt_row(&_w, _pp, o));
+}
+static inline void cargs_print_cmd_row(
+    const cargs_env *env, const cargs_cmd *c
+) {
+    CARGS__WB_ONESHOT(env, cargs__help_cmd_row(&_w, _pp, c));
+}
+static inline void cargs_print_pos_row(
+    const cargs_env *env, const cargs_pos *p
+) {
+    CARGS__WB_ONESHOT(env, cargs__help_pos_row(&_w, _pp, p));
+}
+
+static inline void cargs_build_usage_pos(
+    char *dst, size_t cap, const cargs_pos *pos, size_t npos
+) {
+    size_t off = 0;
+#define APPEND(fmt, ...)                                                       \
     do {                                                                       \
         int _n = snprintf(                                                     \
             dst + off, (cap > off ? cap - off : 0), fmt, __VA_ARGS__           \
@@ -623,139 +2694,857 @@ static inline size_t cargs_join_aliases(
     return n;
 }
 
-static inline void cargs_print_help(
-    const cargs_env *env, const cargs_cmd *cmd, const char *prog,
-    const char *const *path, size_t depth
+static inline void cargs__help(
+    cargs_wbuf *w, const cargs_env *env, const cargs_pres *pp,
+    const cargs_cmd *cmd, const char *prog, const char *const *path,
+    size_t depth
 ) {
-    FILE       *out = cargs_out(env);
-    const char *B = cargs_s_bold(env), *R = cargs_s_rst(env);
-    cargs_print_usage(env, prog, path, depth, cmd);
-    fputc('\n', out);
+    const char *B = pp->bold, *R = pp->rst;
+    cargs__help_usage(w, env, pp, prog, path, depth, cmd);
+    cargs__wb_putc(w, '\n');
 
     /* Options header + auto options */
     bool printed_opts_header = false;
     if (env && env->auto_help) {
         if (!printed_opts_header) {
-            fprintf(out, "%sOptions:%s\n", B, R);
+            cargs__wb_printf(w, "%sOptions:%s\n", B, R);
             printed_opts_header = true;
         }
         cargs_opt a = {
             "help", 'h',  CARGS_ARG_NONE, NULL, "Show this help and exit",
-            NULL,   NULL, NULL,           0,    0
+            NULL,   NULL, NULL,           0,    0,
+            {CARGS_BIND_NONE, NULL, NULL, NULL, NULL}
         };
-        cargs_print_opt_row(env, &a);
+        cargs__help_opt_row(w, pp, &a);
     }
     if (env && depth == 0 && env->auto_version && env->version) {
         if (!printed_opts_header) {
-            fprintf(out, "%sOptions:%s\n", B, R);
+            cargs__wb_printf(w, "%sOptions:%s\n", B, R);
             printed_opts_header = true;
         }
         cargs_opt a = {
             "version", 'v',  CARGS_ARG_NONE, NULL, "Show version and exit",
-            NULL,      NULL, NULL,           0,    0
+            NULL,      NULL, NULL,           0,    0,
+            {CARGS_BIND_NONE, NULL, NULL, NULL, NULL}
         };
-        cargs_print_opt_row(env, &a);
+        cargs__help_opt_row(w, pp, &a);
     }
     if (env && depth == 0 && env->auto_author && env->author) {
         if (!printed_opts_header) {
-            fprintf(out, "%sOptions:%s\n", B, R);
+            cargs__wb_printf(w, "%sOptions:%s\n", B, R);
             printed_opts_header = true;
         }
         cargs_opt a = {
             "author", 0,    CARGS_ARG_NONE, NULL, "Show author and exit",
-            NULL,     NULL, NULL,           0,    0
+            NULL,     NULL, NULL,           0,    0,
+            {CARGS_BIND_NONE, NULL, NULL, NULL, NULL}
         };
-        cargs_print_opt_row(env, &a);
+        cargs__help_opt_row(w, pp, &a);
     }
 
     if (cmd && cmd->opt_count) {
         if (!printed_opts_header) {
-            fprintf(out, "%sOptions:%s\n", B, R);
+            cargs__wb_printf(w, "%sOptions:%s\n", B, R);
             printed_opts_header = true;
         }
         for (size_t i = 0; i < cmd->opt_count; i++)
-            cargs_print_opt_row(env, &cmd->opts[i]);
-        fputc('\n', out);
+            cargs__help_opt_row(w, pp, &cmd->opts[i]);
+        cargs__wb_putc(w, '\n');
     } else if (printed_opts_header) {
-        fputc('\n', out);
+        cargs__wb_putc(w, '\n');
     }
 
     /* Subcommands */
     if (cmd && cmd->sub_count) {
-        fprintf(out, "%sCommands:%s\n", B, R);
+        cargs__wb_printf(w, "%sCommands:%s\n", B, R);
         for (size_t i = 0; i < cmd->sub_count; i++) {
-            cargs_print_cmd_row(env, &cmd->subs[i]);
+            cargs__help_cmd_row(w, pp, &cmd->subs[i]);
         }
 
-        if (cmd->pos_count) fputc('\n', out);
+        if (cmd->pos_count) cargs__wb_putc(w, '\n');
     }
 
     /* Positionals */
     if (cmd && cmd->pos_count) {
-        fprintf(out, "%sPositionals:%s\n", B, R);
+        cargs__wb_printf(w, "%sPositionals:%s\n", B, R);
         for (size_t i = 0; i < cmd->pos_count; ++i)
-            cargs_print_pos_row(env, &cmd->pos[i]);
+            cargs__help_pos_row(w, pp, &cmd->pos[i]);
     }
 }
 
-/* Apply env-var/defaults for a command level (before parsing argv at that
- * level). */
-static inline void cargs_apply_env_defaults_level(
-    const cargs_cmd *cmd, void *user, uint8_t *group_counts,
-    size_t group_counts_len
+static inline void cargs_print_help(
+    const cargs_env *env, const cargs_cmd *cmd, const char *prog,
+    const char *const *path, size_t depth
 ) {
-    if (!cmd || !cmd->opts) return;
-    for (size_t i = 0; i < cmd->opt_count; i++) {
-        const cargs_opt *o   = &cmd->opts[i];
-        const char      *val = NULL;
-        if (o->env) { val = getenv(o->env); }
-        if (!val && o->def) { val = o->def; }
-        if (val && o->cb) {
-            o->cb(val, user);
-            if (o->group && o->group < group_counts_len)
-                group_counts[o->group]++;
+    char              local[1024];
+    cargs_wbuf        w;
+    cargs_pres        tmp;
+    const cargs_pres *pp = cargs__pres_get(env, cmd, &tmp);
+    if (env && env->help_buf && env->help_buf_cap) {
+        cargs__wb_init(&w, env->help_buf, env->help_buf_cap, cargs_out(env));
+    } else if (env && env->arena) {
+        /* one fwrite: the page is rendered in local, or again in the arena
+           when it is longer */
+        cargs_arena_mark m = cargs_arena_save(env->arena);
+        cargs__wb_init(&w, local, sizeof(local), NULL);
+        cargs__help(&w, env, pp, cmd, prog, path, depth);
+        char *page = local;
+        if (w.total >= sizeof(local)) {
+            size_t n = w.total;
+            page     = (char *)cargs_arena_alloc(env->arena, n + 1, 1);
+            if (page) {
+                cargs__wb_init(&w, page, n + 1, NULL);
+                cargs__help(&w, env, pp, cmd, prog, path, depth);
+            }
+        }
+        if (page) {
+            fwrite(page, 1, w.len, cargs_out(env));
+            cargs_arena_rewind(env->arena, m);
+            CARGS__STAT(env, bytes_out, w.total);
+            return;
         }
+        cargs__wb_init(&w, local, sizeof(local), cargs_out(env));
+    } else {
+        cargs__wb_init(&w, local, sizeof(local), cargs_out(env));
     }
+    cargs__help(&w, env, pp, cmd, prog, path, depth);
+    cargs__wb_flush(&w);
+    CARGS__STAT(env, bytes_out, w.total);
 }
 
-static inline const cargs_cmd *cargs_find_sub(
-    const cargs_cmd *cmd, const char *name
+static inline size_t cargs_render_help(
+    char *buf, size_t cap, const cargs_env *env, const cargs_cmd *cmd,
+    const char *prog, const char *const *path, size_t depth
+) {
+    cargs_wbuf w;
+    cargs_pres tmp;
+    cargs__wb_init(&w, buf, buf ? cap : 0, NULL);
+    const cargs_pres *pp = cargs__pres_get(env, cmd, &tmp);
+    cargs__help(&w, env, pp, cmd, prog, path, depth);
+    return w.total;
+}
+
+static inline bool cargs__ieq(const char *a, const char *b) {
+    while (*a && tolower((unsigned char)*a) == *b) a++, b++;
+    return !*a && !*b;
+}
+
+/* Decode val into o->bind.target; -1 if val does not parse, -2 if it is
+   out of range for a kind that tells the two apart */
+static inline int cargs__bind_store(const cargs_opt *o, const char *val) {
+    void *t = o->bind.target;
+    switch (o->bind.kind) {
+        case CARGS_BIND_NONE: return 0;
+        case CARGS_BIND_FLAG: {
+            bool b = true;
+            if (val) {
+                if (cargs__ieq(val, "1") || cargs__ieq(val, "true") ||
+                    cargs__ieq(val, "yes") || cargs__ieq(val, "on"))
+                    b = true;
+                else if (cargs__ieq(val, "0") || cargs__ieq(val, "false") ||
+                         cargs__ieq(val, "no") || cargs__ieq(val, "off"))
+                    b = false;
+                else
+                    return -1;
+            }
+            *(bool *)t = b;
+            return 0;
+        }
+        case CARGS_BIND_COUNT: {
+            int32_t v;
+            if (!val) {
+                if (*(int *)t < INT_MAX) (*(int *)t)++;
+                return 0;
+            }
+            if (cargs_read_i32(val, &v, CARGS_BASE_DEC)) return -1;
+            *(int *)t = (int)v;
+            return 0;
+        }
+        case CARGS_BIND_INT: {
+            int32_t v;
+            if (!val) return 0;
+            if (cargs_read_i32(val, &v, CARGS_BASE_AUTO)) return -1;
+            *(int *)t = (int)v;
+            return 0;
+        }
+        case CARGS_BIND_U64:
+            if (!val) return 0;
+            return cargs_read_u64(val, (uint64_t *)t, CARGS_BASE_AUTO);
+        case CARGS_BIND_SIZE_SI:
+            return val ? cargs_read_size_si(val, (uint64_t *)t) : 0;
+        case CARGS_BIND_SIZE_IEC:
+            return val ? cargs_read_size_iec(val, (uint64_t *)t) : 0;
+        case CARGS_BIND_STR: *(const char **)t = val; return 0;
+        case CARGS_BIND_ENUM:
+            if (!val) return 0;
+            for (const cargs_choice *c = o->bind.choices; c && c->name; c++) {
+                if (strcmp(c->name, val) == 0) {
+                    *(int *)t = c->value;
+                    return 0;
+                }
+            }
+            return -1;
+        case CARGS_BIND_DURATION:
+            return val ? cargs_read_duration(val, (uint64_t *)t) : 0;
+        case CARGS_BIND_RATE:
+            return val ? cargs_read_rate(val, (uint64_t *)t) : 0;
+        default: return -1;
+    }
+}
+
+/* rc is cargs__bind_store's: -2 says "out of range" instead of "invalid" */
+static inline int cargs__bad_value(
+    const cargs_env *env, const cargs_opt *o, const char *val, int rc
+) {
+    const char *what = rc == -2 ? "Out-of-range" : "Invalid";
+    if (o->long_name)
+        cargs__errf(env, "%s value for '--%s': '%s'\n", what, o->long_name,
+                    val);
+    else
+        cargs__errf(env, "%s value for '-%c': '%s'\n", what, o->short_name,
+                    val);
+    return CARGS_ERR_BAD_FORMAT;
+}
+
+/* Take n calls from this dispatch's callback budget */
+static inline int cargs__spend(const cargs_env *env, unsigned n) {
+    cargs__walk *w = env ? env->walk_ : NULL;
+    if (!w || !w->capped) return CARGS_OK;
+    if (w->left < n) {
+        cargs__errf(env, "Too many callbacks (limit %u)\n",
+                    env->limits->max_callbacks);
+        return CARGS_ERR_LIMIT;
+    }
+    w->left -= n;
+    return CARGS_OK;
+}
+
+/* Deliver one occurrence of o: typed binding, then cb, then bind.call.
+   len is val's length when the caller knows it, else SIZE_MAX */
+static inline int cargs__apply_opt(
+    const cargs_env *env, const cargs_opt *o, const char *val, size_t len,
+    void *user
+) {
+    int bad = o->bind.kind && o->bind.target ? cargs__bind_store(o, val) : 0;
+    if (bad) return cargs__bad_value(env, o, val, bad);
+    if (!o->cb && !o->bind.call) return CARGS_OK;
+    int lim = cargs__spend(env, (o->cb ? 1u : 0u) + (o->bind.call ? 1u : 0u));
+    if (lim < 0) return lim;
+    unsigned sv = CARGS__PHASE(env, CARGS_PHASE_CALLBACKS);
+    int      rc = CARGS_OK;
+    if (o->cb) {
+        CARGS__STAT(env, callbacks, 1);
+        rc = o->cb(val, user);
+    }
+    if (rc >= 0 && o->bind.call) {
+        if (!val) len = 0;
+        else if (len == SIZE_MAX) len = strlen(val);
+        CARGS__STAT(env, callbacks, 1);
+        rc = o->bind.call(val, len, o, user);
+    }
+    CARGS__PHASE_END(env, sv);
+    return rc;
+}
+
+/* Decode val for o's typed binding into scratch; the target is untouched */
+static inline int cargs__bind_check(const cargs_opt *o, const char *val) {
+    if (!o->bind.kind || !o->bind.target) return 0;
+    union {
+        bool        b;
+        int         i;
+        uint64_t    u;
+        const char *s;
+    } tmp;
+    memset(&tmp, 0, sizeof tmp);
+    cargs_opt t   = *o;
+    t.bind.target = &tmp;
+    return cargs__bind_store(&t, val);
+}
+
+/* Deferred mode: validate and log one occurrence. An argv entry retires
+   this level's pre-argv entry for o and, with last_wins, o's previous argv
+   entry (each option has at most one live entry of either kind) */
+static inline int cargs__event_add(
+    const cargs_env *env, cargs_events *ev, const cargs_opt *o,
+    const char *val, cargs_source src
+) {
+    int bad = cargs__bind_check(o, val);
+    if (bad) return cargs__bad_value(env, o, val, bad);
+    if (ev->count >= ev->cap) {
+        cargs__errf(env, "Too many options (event log holds %zu)\n", ev->cap);
+        return CARGS_ERR_TOO_MANY;
+    }
+    bool counts = o->bind.kind == CARGS_BIND_COUNT;
+    if (src == CARGS_SRC_ARGV && !counts) {
+        for (size_t k = ev->level_; k < ev->argv_; k++)
+            if (ev->buf[k].opt == o) ev->buf[k].live = false;
+        if (ev->last_wins && o->arg != CARGS_ARG_NONE) {
+            for (size_t k = ev->count; k-- > ev->argv_;) {
+                if (ev->buf[k].opt != o || !ev->buf[k].live) continue;
+                ev->buf[k].live = false;
+                break;
+            }
+        }
+    }
+    cargs_event *e = &ev->buf[ev->count++];
+    e->opt         = o;
+    e->value       = val;
+    e->source      = (uint8_t)src;
+    e->live        = true;
+    return CARGS_OK;
+}
+
+/* An argv occurrence: delivered now, or logged when env->events is set */
+static inline int cargs__occur(
+    const cargs_env *env, const cargs_opt *o, const char *val, size_t len,
+    void *user
+) {
+    cargs_events *ev = env ? env->events : NULL;
+    if (!ev) return cargs__apply_opt(env, o, val, len, user);
+    if (!o->cb && !o->bind.kind && !o->bind.call) return CARGS_OK;
+    return cargs__event_add(env, ev, o, val, CARGS_SRC_ARGV);
+}
+
+/* Deliver the live entries in order. As when they are applied at once, the
+   first failure stops the parse, whichever source the value came from */
+static inline int cargs__events_run(const cargs_env *env, void *user) {
+    cargs_events *ev = env ? env->events : NULL;
+    if (!ev) return CARGS_OK;
+    for (size_t k = 0; k < ev->count; k++) {
+        const cargs_event *e = &ev->buf[k];
+        if (!e->live) continue;
+        int rc = cargs__apply_opt(env, e->opt, e->value, SIZE_MAX, user);
+        if (rc < 0) return rc;
+    }
+    return CARGS_OK;
+}
+
+/* ===== Suggestions ===== */
+/* Closest-name search for an unknown word: Myers' bit-parallel edit distance
+ * (words up to 64 bytes) after a length prefilter, over at most budget
+ * candidates. Only distances up to max (about a third of the word) count. */
+typedef struct {
+    uint64_t    peq[256]; /* bit i set where word[i] == c */
+    const char *word;
+    size_t      len;
+    unsigned    max, best;
+    long        budget;
+    const char *hit;
+} cargs__suggest;
+
+static inline void cargs__suggest_init(
+    cargs__suggest *s, const cargs_env *env, const char *word, size_t len
+) {
+    int b     = env ? env->suggest_budget : 0;
+    s->word   = word;
+    s->len    = len;
+    s->max    = len < 7 ? (unsigned)(len + 2) / 3 : 3u;
+    s->best   = s->max + 1;
+    s->budget = b < 0 || !len || len > 64 ? 0 : b ? b : 1024;
+    s->hit    = NULL;
+    if (!s->budget) return;
+    memset(s->peq, 0, sizeof s->peq);
+    for (size_t i = 0; i < len; i++)
+        s->peq[(unsigned char)word[i]] |= 1ull << i;
+}
+
+/* Levenshtein distance of s->word and t[0..n), or best + 1 once it cannot
+   beat s->best */
+static inline unsigned cargs__suggest_dist(
+    const cargs__suggest *s, const char *t, size_t n
+) {
+    uint64_t pv = ~0ull, mv = 0, last = 1ull << (s->len - 1);
+    unsigned score = (unsigned)s->len;
+    for (size_t j = 0; j < n; j++) {
+        uint64_t eq = s->peq[(unsigned char)t[j]];
+        uint64_t xv = eq | mv;
+        uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        uint64_t ph = mv | ~(xh | pv);
+        uint64_t mh = pv & xh;
+        if (ph & last) score++;
+        else if (mh & last) score--;
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+        /* each remaining byte lowers the score by at most one */
+        if (score >= s->best + (n - j - 1)) return s->best + 1;
+    }
+    return score;
+}
+
+static inline void cargs__suggest_try(cargs__suggest *s, const char *name) {
+    if (!name || s->budget <= 0 || s->best == 0) return;
+    s->budget--;
+    size_t n = strlen(name);
+    if ((n > s->len ? n - s->len : s->len - n) >= s->best) return;
+    unsigned d = cargs__suggest_dist(s, name, n);
+    if (d < s->best) {
+        s->best = d;
+        s->hit  = name;
+    }
+}
+
+/* Closest long option of cmd (or enabled built-in) to name[0..len) */
+static inline const char *cargs__suggest_opt(
+    const cargs_env *env, const cargs_cmd *cmd, const char *name, size_t len,
+    bool allow_version, bool allow_author
+) {
+    cargs__suggest s;
+    cargs__suggest_init(&s, env, name, len);
+    if (!s.budget) return NULL;
+    for (size_t i = 0; cmd && i < cmd->opt_count; i++)
+        cargs__suggest_try(&s, cmd->opts[i].long_name);
+    if (!env) return s.hit;
+    if (env->auto_help) cargs__suggest_try(&s, "help");
+    if (allow_version && env->auto_version && env->version)
+        cargs__suggest_try(&s, "version");
+    if (allow_author && env->auto_author && env->author)
+        cargs__suggest_try(&s, "author");
+    return s.hit;
+}
+
+/* Closest subcommand name or alias of cmd to word */
+static inline const char *cargs__suggest_sub(
+    const cargs_env *env, const cargs_cmd *cmd, const char *word
+) {
+    cargs__suggest s;
+    cargs__suggest_init(&s, env, word, strlen(word));
+    for (size_t i = 0; s.budget && i < cmd->sub_count; i++) {
+        const cargs_cmd *c = &cmd->subs[i];
+        cargs__suggest_try(&s, c->name);
+        for (size_t a = 0; a < c->alias_count; a++)
+            cargs__suggest_try(&s, c->aliases[a]);
+    }
+    return s.hit;
+}
+
+/* Record a failure in env->error (if attached) */
+static inline void cargs__set_error(
+    const cargs_env *env, int code, const char *arg, const char *suggestion,
+    bool command
+) {
+    if (!env || !env->error) return;
+    env->error->code       = code;
+    env->error->arg        = arg;
+    env->error->suggestion = suggestion;
+    env->error->command    = command;
+}
+
+static inline const cargs_cmd *cargs__find_sub(
+    const cargs_cmd *cmd, const char *name, cargs_stats *st
 ) {
+    (void)st;
     if (!cmd || !name) return NULL;
     for (size_t i = 0; i < cmd->sub_count; i++) {
         const cargs_cmd *c = &cmd->subs[i];
-        if (c->name && strcmp(c->name, name) == 0) return c;
+        if (c->name) {
+            CARGS__CMP(st);
+            if (strcmp(c->name, name) == 0) return c;
+        }
         for (size_t a = 0; a < c->alias_count; a++) {
-            if (c->aliases[a] && strcmp(c->aliases[a], name) == 0) return c;
+            if (!c->aliases[a]) continue;
+            CARGS__CMP(st);
+            if (strcmp(c->aliases[a], name) == 0) return c;
         }
     }
     return NULL;
 }
+static inline const cargs_cmd *cargs_find_sub(
+    const cargs_cmd *cmd, const char *name
+) {
+    return cargs__find_sub(cmd, name, NULL);
+}
 
-/* Parse options for a given command level. Updates *idx to first non-option. */
-static inline int cargs_parse_opts_level(
-    const cargs_env *env, const cargs_cmd *cmd, int argc, char **argv, int *idx,
-    void *user, bool allow_version, bool allow_author, const char *prog,
-    const char *const *path, size_t depth
+/* Unique subcommand whose name or alias starts with name[0..len); sets
+   *ambiguous when prefixes of two different subcommands match */
+static inline const cargs_cmd *cargs__find_sub_prefix(
+    const cargs_cmd *cmd, const char *name, size_t len, bool *ambiguous,
+    cargs_stats *st
 ) {
-    enum { MAXG = 33 }; /* groups 1..32 */
-    uint8_t counts[MAXG];
-    for (size_t z = 0; z < MAXG; z++) counts[z] = 0;
-    uint32_t xor_mask = 0, req_mask = 0;
-    if (cmd) {
+    (void)st;
+    const cargs_cmd *hit = NULL;
+    for (size_t i = 0; i < cmd->sub_count; i++) {
+        const cargs_cmd *c  = &cmd->subs[i];
+        bool             ok = false;
+        if (c->name) {
+            CARGS__CMP(st);
+            ok = strncmp(c->name, name, len) == 0;
+        }
+        for (size_t a = 0; !ok && a < c->alias_count; a++) {
+            if (!c->aliases[a]) continue;
+            CARGS__CMP(st);
+            ok = strncmp(c->aliases[a], name, len) == 0;
+        }
+        if (!ok) continue;
+        if (hit) {
+            *ambiguous = true;
+            return NULL;
+        }
+        hit = c;
+    }
+    return hit;
+}
+
+/* Binary search in the node's name table: exact match, else (prefix) the
+   run of entries starting with name, which must all be one subcommand */
+static inline const cargs_cmd *cargs__ix_find_sub(
+    const cargs_index_node *nd, const char *name, bool prefix,
+    bool *ambiguous, cargs_stats *st
+) {
+    (void)st;
+    const cargs_index_name *t  = nd->names;
+    size_t                  lo = 0, hi = nd->name_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        CARGS__CMP(st);
+        if (strcmp(t[mid].name, name) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == nd->name_count) return NULL;
+    CARGS__CMP(st);
+    if (strcmp(t[lo].name, name) == 0) return &nd->cmd->subs[t[lo].sub];
+    if (!prefix) return NULL;
+    size_t   len = strlen(name);
+    uint32_t sub = t[lo].sub;
+    if (strncmp(t[lo].name, name, len) != 0) return NULL;
+    for (size_t k = lo + 1; k < nd->name_count; k++) {
+        CARGS__CMP(st);
+        if (strncmp(t[k].name, name, len) != 0) break;
+        if (t[k].sub != sub) {
+            *ambiguous = true;
+            return NULL;
+        }
+    }
+    return &nd->cmd->subs[sub];
+}
+
+/* Subcommand named by word at cmd (index when nd is set); NULL if none. An
+   ambiguous prefix is reported and leaves *rc = CARGS_ERR_UNKNOWN. */
+static inline const cargs_cmd *cargs__lookup_sub(
+    const cargs_env *env, const cargs_cmd *cmd, const cargs_index_node *nd,
+    const char *word, int *rc
+) {
+    bool             prefix = env && env->sub_prefix && *word;
+    bool             amb    = false;
+    const cargs_cmd *sub    = NULL;
+    CARGS__STAT(env, lookups, 1);
+    if (nd) {
+        sub = cargs__ix_find_sub(nd, word, prefix, &amb, CARGS__STATS(env));
+    } else {
+        sub = cargs__find_sub(cmd, word, CARGS__STATS(env));
+        if (!sub && prefix)
+            sub = cargs__find_sub_prefix(
+                cmd, word, strlen(word), &amb, CARGS__STATS(env)
+            );
+    }
+    if (!amb) return sub;
+    /* two passes over the matches: size the list, then write it */
+    char   fixed[256];
+    char  *list = NULL;
+    size_t need = 1, n = 0, len = strlen(word);
+    cargs_arena_mark m = cargs_arena_save(env ? env->arena : NULL);
+    for (int pass = 0; pass < 2; pass++) {
+        for (size_t i = 0; i < cmd->sub_count; i++) {
+            const cargs_cmd *c   = &cmd->subs[i];
+            bool             hit = c->name && strncmp(c->name, word, len) == 0;
+            for (size_t a = 0; !hit && a < c->alias_count; a++)
+                hit = c->aliases[a] && strncmp(c->aliases[a], word, len) == 0;
+            if (!hit || !c->name) continue;
+            if (!list) {
+                need += 2 + strlen(c->name);
+                continue;
+            }
+            if (n) n = cargs__cat(list, need, n, ", ", 2);
+            n = CARGS__CATS(list, need, n, c->name);
+        }
+        if (pass) break;
+        list = cargs__scratch(env, fixed, sizeof fixed, need);
+        if (!list) break;
+        list[0] = '\0';
+    }
+    *rc = CARGS_ERR_UNKNOWN;
+    if (list) {
+        cargs__errf(env, "Ambiguous command '%s': %s\n", word, list);
+    } else {
+        cargs__errf(env, "Ambiguous command '%s' (the list of matches needs "
+                         "env->arena)\n", word);
+        *rc = CARGS_ERR_TOO_MANY;
+    }
+    cargs_arena_rewind(env ? env->arena : NULL, m);
+    cargs__set_error(env, *rc, word, NULL, true);
+    return NULL;
+}
+
+/* cargs__lookup_sub for a packed level: exact names and aliases are matched
+   on the records; the subcommand found comes back decoded as the new level.
+   Prefixes need the decoded heads. */
+static inline const cargs_cmd *cargs__pk_lookup(
+    const cargs_env *env, const char *word, int *rc
+) {
+    cargs__pk_walk         *pw = env->walk_->packed;
+    const cargs_packed     *pk = pw->pk;
+    const cargs_packed_cmd *pc = &pk->cmds[pw->node];
+    bool                    ok = true;
+    CARGS__STAT(env, lookups, 1);
+    for (uint32_t k = 0; k < pc->sub_count; k++) {
+        const cargs_packed_cmd *h = &pk->cmds[pc->first_sub + k];
+        const char             *s = cargs__pk_str(pk, h->name, &ok);
+        bool                    hit = s && strcmp(s, word) == 0;
+        for (uint32_t a = 0; !hit && a < h->alias_count &&
+                             h->first_alias + a < pk->alias_count;
+             a++) {
+            s   = cargs__pk_str(pk, pk->aliases[h->first_alias + a], &ok);
+            hit = s && strcmp(s, word) == 0;
+        }
+        if (hit) return cargs__pk_enter(env, k, rc);
+    }
+    if (!env->sub_prefix || !*word) return NULL;
+    if (!cargs__pk_heads(pw, rc)) {
+        *rc = cargs__pk_fail(env, *rc, pw->node);
+        return NULL;
+    }
+    const cargs_cmd *sub = cargs__lookup_sub(env, pw->cur, NULL, word, rc);
+    return sub ? cargs__pk_enter(env, (uint32_t)(sub - pw->cur->subs), rc)
+               : NULL;
+}
+
+/* Per-level group and relation bookkeeping */
+typedef struct {
+    cargs_group_plan plan;
+    uint64_t         seen;    /* groups used so far (bit g = group g) */
+    uint64_t         rel_cli; /* bit 2r / 2r+1: rels[r].opt / .other on argv */
+    uint64_t         rel_any; /* same, also counting env and defaults */
+    const cargs_opt *first[CARGS_GROUP_MAX + 1]; /* first use of a group */
+    const cargs_opt *ends[2 * CARGS_REL_MAX];    /* resolved rel endpoints */
+    size_t           nends;
+} cargs__grp_state;
+
+/* "--long" or "-c" as the arguments of a "%s%.*s" conversion, so names of
+   any length are printed whole */
+#define CARGS__OPT_ARGS(o)                                      \
+    (o)->long_name ? "--" : "-",                                \
+        (o)->long_name ? (int)strlen((o)->long_name) : 1,       \
+        (o)->long_name ? (o)->long_name : &(o)->short_name
+
+/* Length cargs__cat_opt appends for o */
+static inline size_t cargs__opt_len(const cargs_opt *o) {
+    return o->long_name ? 2 + strlen(o->long_name) : 2;
+}
+
+/* Append "--long" or "-c" to buf */
+static inline size_t cargs__cat_opt(
+    char *buf, size_t cap, size_t n, const cargs_opt *o
+) {
+    if (o->long_name) {
+        n = cargs__cat(buf, cap, n, "--", 2);
+        return CARGS__CATS(buf, cap, n, o->long_name);
+    }
+    n = cargs__cat(buf, cap, n, "-", 1);
+    return cargs__cat(buf, cap, n, &o->short_name, 1);
+}
+
+/* Option a relation names: long name first, then a one-letter short name */
+static inline const cargs_opt *cargs__rel_opt(
+    const cargs_cmd *cmd, const cargs_index_node *nd, const char *name
+) {
+    if (!name) return NULL;
+    const cargs_opt *o =
+        nd ? cargs__ix_find_long(nd, name, strlen(name), NULL)
+           : cargs_find_long(cmd->opts, cmd->opt_count, name);
+    if (!o && name[0] && !name[1])
+        o = cargs_find_short(cmd->opts, cmd->opt_count, name[0]);
+    return o;
+}
+
+static inline int cargs__grp_init(
+    const cargs_env *env, const cargs_cmd *cmd, const cargs_index_node *nd,
+    cargs__grp_state *gs
+) {
+    gs->seen = gs->rel_cli = gs->rel_any = 0;
+    gs->nends                            = 0;
+    if (!cmd) {
+        gs->plan.xor_mask = gs->plan.req_mask = gs->plan.any_mask = 0;
+        return CARGS_OK;
+    }
+    if (nd)
+        gs->plan = nd->groups;
+    else
+        cargs__group_plan(cmd, &gs->plan);
+    if (!cmd->rels) return CARGS_OK;
+    if (cmd->rel_count > CARGS_REL_MAX) {
+        cargs__errf(env, "Too many option relations\n");
+        return CARGS_ERR_GROUP;
+    }
+    for (size_t r = 0; r < cmd->rel_count; r++) {
+        const char *names[2] = {cmd->rels[r].opt, cmd->rels[r].other};
+        for (size_t k = 0; k < 2; k++) {
+            const cargs_opt *o = cargs__rel_opt(cmd, nd, names[k]);
+            if (!o) {
+                /* a broken tree, not a bad command line */
+                cargs__errf(
+                    env, "Relation '%s' %s '%s': no option '%s'\n",
+                    names[0] ? names[0] : "",
+                    cmd->rels[r].kind == CARGS_REL_CONFLICTS
+                        ? "conflicts with"
+                        : "requires",
+                    names[1] ? names[1] : "", names[k] ? names[k] : ""
+                );
+                return CARGS_ERR_BAD_FORMAT;
+            }
+            gs->ends[gs->nends++] = o;
+        }
+    }
+    return CARGS_OK;
+}
+
+/* Record one use of o; a second use in an at-most-one group fails here */
+static inline int cargs__grp_mark(
+    const cargs_env *env, cargs__grp_state *gs, const cargs_opt *o, bool cli
+) {
+    for (size_t k = 0; k < gs->nends; k++) {
+        if (gs->ends[k] != o) continue;
+        gs->rel_any |= 1ull << k;
+        if (cli) gs->rel_cli |= 1ull << k;
+    }
+    if (!o->group || o->group > CARGS_GROUP_MAX) return CARGS_OK;
+    uint64_t bit = 1ull << o->group;
+    if (gs->seen & bit & (gs->plan.xor_mask | gs->plan.req_mask)) {
+        const cargs_opt *a = gs->first[o->group];
+        if (a == o)
+            cargs__errf(env, "Option '%s%.*s' may be used only once\n",
+                        CARGS__OPT_ARGS(o));
+        else
+            cargs__errf(env,
+                        "Options '%s%.*s' and '%s%.*s' are mutually "
+                        "exclusive\n",
+                        CARGS__OPT_ARGS(a), CARGS__OPT_ARGS(o));
+        return CARGS_ERR_GROUP;
+    }
+    if (!(gs->seen & bit)) gs->first[o->group] = o;
+    gs->seen |= bit;
+    return CARGS_OK;
+}
+
+/* End of level: required groups first, then relations in declaration order */
+static inline int cargs__grp_check(
+    const cargs_env *env, const cargs_cmd *cmd, const cargs__grp_state *gs
+) {
+    uint64_t missing = (gs->plan.req_mask | gs->plan.any_mask) & ~gs->seen;
+    if (missing) {
+        unsigned    g    = cargs__ctz64(missing);
+        const char *what = (gs->plan.req_mask >> g) & 1 ? "Exactly one"
+                                                        : "At least one";
+        char        fixed[256];
+        size_t      need = 1, n = 0;
+        for (size_t i = 0; i < cmd->opt_count; i++)
+            if (cmd->opts[i].group == g)
+                need += 2 + cargs__opt_len(&cmd->opts[i]);
+        cargs_arena_mark m    = cargs_arena_save(env ? env->arena : NULL);
+        char            *list = cargs__scratch(env, fixed, sizeof fixed, need);
+        if (!list) {
+            cargs__errf(env, "%s of group %u is required (its option list "
+                             "needs env->arena)\n", what, g);
+            return CARGS_ERR_TOO_MANY;
+        }
+        list[0] = '\0';
         for (size_t i = 0; i < cmd->opt_count; i++) {
-            const cargs_opt *o = &cmd->opts[i];
-            if (o->group > 0 && o->group < MAXG) {
-                if (o->group_policy == CARGS_GRP_XOR)
-                    xor_mask |= (1ull << o->group);
-                if (o->group_policy == CARGS_GRP_REQ_ONE)
-                    req_mask |= (1ull << o->group);
+            if (cmd->opts[i].group != g) continue;
+            if (n) n = cargs__cat(list, need, n, ", ", 2);
+            n = cargs__cat_opt(list, need, n, &cmd->opts[i]);
+        }
+        cargs__errf(env, "%s of %s is required\n", what, list);
+        cargs_arena_rewind(env ? env->arena : NULL, m);
+        return CARGS_ERR_GROUP;
+    }
+    for (size_t r = 0; r < gs->nends / 2; r++) {
+        uint64_t a = 1ull << (2 * r), b = a << 1;
+        uint8_t  kind = cmd->rels[r].kind;
+        if (!(gs->rel_cli & a)) continue;
+        if (kind == CARGS_REL_REQUIRES && (gs->rel_any & b)) continue;
+        if (kind == CARGS_REL_CONFLICTS && !(gs->rel_cli & b)) continue;
+        if (kind != CARGS_REL_REQUIRES && kind != CARGS_REL_CONFLICTS)
+            continue;
+        const cargs_opt *x = gs->ends[2 * r], *y = gs->ends[2 * r + 1];
+        if (kind == CARGS_REL_REQUIRES)
+            cargs__errf(env, "Option '%s%.*s' requires '%s%.*s'\n",
+                        CARGS__OPT_ARGS(x), CARGS__OPT_ARGS(y));
+        else
+            cargs__errf(env,
+                        "Options '%s%.*s' and '%s%.*s' cannot be used "
+                        "together\n",
+                        CARGS__OPT_ARGS(x), CARGS__OPT_ARGS(y));
+        return CARGS_ERR_GROUP;
+    }
+    return CARGS_OK;
+}
+
+/* Env-var/defaults for one level; with gs, each applied value counts as a
+   use (not on the command line) */
+static inline int cargs__apply_env_defaults(
+    const cargs_env *env, const cargs_cmd *cmd, void *user,
+    cargs__grp_state *gs, uint8_t *group_counts, size_t group_counts_len
+) {
+    if (!cmd || !cmd->opts) return CARGS_OK;
+    for (size_t i = 0; i < cmd->opt_count; i++) {
+        const cargs_opt *o   = &cmd->opts[i];
+        const char      *val = NULL;
+        cargs_source     src = CARGS_SRC_ENV;
+        if (o->env) { val = cargs__getenv(env, o->env); }
+        if (!val && env && env->config) {
+            val = cargs_config_get(env->config, o);
+            src = CARGS_SRC_CONFIG;
+        }
+        if (!val && o->def) {
+            val = o->def;
+            src = CARGS_SRC_DEFAULT;
+        }
+        if (val && (o->cb || o->bind.kind || o->bind.call)) {
+            /* a bad env, config or default value fails like one on argv
+               (already reported); the option does not count as given */
+            int rc = env && env->events
+                         ? cargs__event_add(env, env->events, o, val, src)
+                         : cargs__apply_opt(env, o, val, SIZE_MAX, user);
+            if (rc < 0) return rc;
+            if (o->group && o->group < group_counts_len)
+                group_counts[o->group]++;
+            if (gs) {
+                rc = cargs__grp_mark(env, gs, o, false);
+                if (rc < 0) return rc;
             }
         }
     }
+    return CARGS_OK;
+}
+
+/* Apply env-var/defaults for a command level (before parsing argv at that
+ * level). Returns CARGS_OK, or the first error a value produced (reported
+ * through the error sink, as on argv). */
+static inline int cargs_apply_env_defaults_level(
+    const cargs_env *env, const cargs_cmd *cmd, void *user,
+    uint8_t *group_counts, size_t group_counts_len
+) {
+    return cargs__apply_env_defaults(
+        env, cmd, user, NULL, group_counts, group_counts_len
+    );
+}
+
+static inline int cargs__parse_opts_level(
+    const cargs_env *env, const cargs_cmd *cmd, const cargs_index_node *nd,
+    int argc, char **argv, int *idx, void *user, bool allow_version,
+    bool allow_author, const char *prog, const char *const *path, size_t depth
+) {
+    cargs__grp_state gs;
+    int              grc = cargs__grp_init(env, cmd, nd, &gs);
+    if (grc < 0) return grc;
 
-    /* Apply env/defaults first so CLI can override, and count groups */
-    cargs_apply_env_defaults_level(cmd, user, counts, MAXG);
+    /* Apply env/defaults first so CLI can override; they count as uses */
+    cargs_events *ev = env ? env->events : NULL;
+    if (ev) ev->level_ = ev->count;
+    grc = cargs__apply_env_defaults(env, cmd, user, &gs, NULL, 0);
+    if (grc < 0) return grc;
+    if (ev) ev->argv_ = ev->count;
+    (void)CARGS__PHASE(env, CARGS_PHASE_OPTS);
 
     int i = *idx;
     while (i < argc) {
@@ -767,43 +3556,51 @@ static inline int cargs_parse_opts_level(
         }
 
         if (arg[1] == '-') {
+            /* --name=value: name is matched as (name, len) in place */
             const char *name = arg + 2;
             const char *eq   = strchr(name, '=');
-            char        namebuf[96];
-            const char *val = NULL;
-            if (eq) {
-                size_t len = (size_t)(eq - name);
-                if (len >= sizeof(namebuf)) return CARGS_ERR_BAD_FORMAT;
-                memcpy(namebuf, name, len);
-                namebuf[len] = '\0';
-                name         = namebuf;
-                val          = eq + 1;
-            }
+            const char *val  = eq ? eq + 1 : NULL;
+            size_t      len  = eq ? (size_t)(eq - name) : strlen(name);
+            int         nl   = len > INT_MAX ? INT_MAX : (int)len;
 
             /* auto built-ins */
-            if (env && env->auto_help && strcmp(name, "help") == 0) {
+            if (env && env->auto_help && cargs__name_is(name, len, "help")) {
                 cargs_print_help(env, cmd, prog, path, depth);
                 *idx = argc;
                 return CARGS_DONE;
             }
             if (allow_version && env && env->auto_version &&
-                strcmp(name, "version") == 0 && env->version) {
-                fprintf(cargs_out(env), "%s\n", env->version);
+                cargs__name_is(name, len, "version") && env->version) {
+                cargs__put_line(env, env->version);
                 *idx = argc;
                 return CARGS_DONE;
             }
             if (allow_author && env && env->auto_author &&
-                strcmp(name, "author") == 0 && env->author) {
-                fprintf(cargs_out(env), "%s\n", env->author);
+                cargs__name_is(name, len, "author") && env->author) {
+                cargs__put_line(env, env->author);
                 *idx = argc;
                 return CARGS_DONE;
             }
 
-            const cargs_opt *o = cargs_find_long(
-                cmd ? cmd->opts : NULL, cmd ? cmd->opt_count : 0, name
-            );
+            const cargs_opt *o =
+                nd ? cargs__ix_find_long(nd, name, len, CARGS__STATS(env))
+                   : cargs__find_long(
+                         cmd ? cmd->opts : NULL, cmd ? cmd->opt_count : 0, name,
+                         len, CARGS__STATS(env)
+                     );
+            CARGS__STAT(env, lookups, 1);
             if (!o) {
-                fprintf(cargs_err(env), "Unknown option: --%s\n", name);
+                const char *hint = cargs__suggest_opt(
+                    env, cmd, name, len, allow_version, allow_author
+                );
+                if (hint)
+                    cargs__errf(
+                        env, "Unknown option: --%.*s (did you mean --%s?)\n",
+                        nl, name, hint
+                    );
+                else
+                    cargs__errf(env, "Unknown option: --%.*s\n", nl, name);
+                cargs__set_error(env, CARGS_ERR_UNKNOWN, arg, hint, false);
                 return CARGS_ERR_UNKNOWN;
             }
             if (o->arg == CARGS_ARG_REQUIRED) {
@@ -812,9 +3609,8 @@ static inline int cargs_parse_opts_level(
                         val = argv[++i]; /* accept even if it starts with '-'
                                             (e.g., negative numbers) */
                     } else {
-                        fprintf(
-                            cargs_err(env), "Option '--%s' requires a value\n",
-                            name
+                        cargs__errf(
+                            env, "Option '--%.*s' requires a value\n", nl, name
                         );
                         return CARGS_ERR_MISSING_VAL;
                     }
@@ -830,23 +3626,33 @@ static inline int cargs_parse_opts_level(
                 }
             } else {
                 if (val) {
-                    fprintf(
-                        cargs_err(env), "Option '--%s' does not take a value\n",
+                    cargs__errf(
+                        env, "Option '--%.*s' does not take a value\n", nl,
                         name
                     );
                     return CARGS_ERR_BAD_FORMAT;
                 }
             }
-            int rc = o->cb ? o->cb(val, user) : CARGS_OK;
+            int rc = cargs__occur(env, o, val, SIZE_MAX, user);
+            if (rc < 0) return rc;
+            rc = cargs__grp_mark(env, &gs, o, true);
             if (rc < 0) return rc;
-            if (o->group && o->group < MAXG) counts[o->group]++;
             i++;
             continue;
         } else {
             /* short or grouped */
-            const char *p = arg + 1;
+            const char *p   = arg + 1;
+            unsigned    cap = env && env->limits ? env->limits->max_shorts : 0;
+            unsigned    nf  = 0;
             i++;
             while (*p) {
+                if (cap && ++nf > cap) {
+                    cargs__errf(
+                        env, "Too many flags in argument %d (limit %u)\n",
+                        i - 1, cap
+                    );
+                    return CARGS_ERR_LIMIT;
+                }
                 const char c = *p++;
                 if (env && env->auto_help && c == 'h') {
                     cargs_print_help(env, cmd, prog, path, depth);
@@ -855,36 +3661,43 @@ static inline int cargs_parse_opts_level(
                 }
                 if (allow_version && env && env->auto_version && c == 'v' &&
                     env->version) {
-                    fprintf(cargs_out(env), "%s\n", env->version);
+                    cargs__put_line(env, env->version);
                     *idx = argc;
                     return CARGS_DONE;
                 }
-                const cargs_opt *o = cargs_find_short(
-                    cmd ? cmd->opts : NULL, cmd ? cmd->opt_count : 0, c
-                );
+                const cargs_opt *o =
+                    nd ? cargs__ix_find_short(nd, c)
+                       : cargs_find_short(
+                             cmd ? cmd->opts : NULL, cmd ? cmd->opt_count : 0, c
+                         );
+                CARGS__STAT(env, lookups, 1);
                 if (!o) {
-                    fprintf(cargs_err(env), "Unknown option: -%c\n", c);
+                    cargs__errf(env, "Unknown option: -%c\n", c);
+                    cargs__set_error(env, CARGS_ERR_UNKNOWN, arg, NULL, false);
                     return CARGS_ERR_UNKNOWN;
                 }
-                const char *val = NULL;
+                const char *val  = NULL;
+                size_t      vlen = SIZE_MAX;
                 if (o->arg == CARGS_ARG_REQUIRED) {
                     if (*p) {
-                        val = p;
-                        p += strlen(p);
+                        val  = p;
+                        vlen = strlen(p);
+                        p += vlen;
                     } /* attached: -j10 */
                     else if (i < argc) {
                         val = argv[i++];
                     } /* separated: -j 10  (even if starts with '-') */
                     else {
-                        fprintf(
-                            cargs_err(env), "Option '-%c' requires a value\n", c
+                        cargs__errf(
+                            env, "Option '-%c' requires a value\n", c
                         );
                         return CARGS_ERR_MISSING_VAL;
                     }
                 } else if (o->arg == CARGS_ARG_OPTIONAL) {
                     if (*p) { /* attached: -l12 */
-                        val = p;
-                        p += strlen(p);
+                        val  = p;
+                        vlen = strlen(p);
+                        p += vlen;
                     } else if (i < argc) {
                         const char *nxt = argv[i];
                         if (strcmp(nxt, "--") != 0 &&
@@ -895,707 +3708,3611 @@ static inline int cargs_parse_opts_level(
                         // it
                     }
                 }
-                int rc = o->cb ? o->cb(val, user) : CARGS_OK;
+                int rc = cargs__occur(env, o, val, vlen, user);
+                if (rc < 0) return rc;
+                rc = cargs__grp_mark(env, &gs, o, true);
                 if (rc < 0) return rc;
-                if (o->group && o->group < MAXG) counts[o->group]++;
             }
             continue;
         }
     }
 
-    /* Enforce group policies */
-    for (uint8_t g = 1; g < MAXG; g++) {
-        if ((xor_mask & (1ull << g)) && counts[g] > 1) {
-            fprintf(
-                cargs_err(env),
-                "Options in group %u are mutually exclusive (choose at most "
-                "one)\n",
-                g
-            );
-            return CARGS_ERR_GROUP;
-        }
-        if ((req_mask & (1ull << g)) && counts[g] != 1) {
-            fprintf(
-                cargs_err(env),
-                "Exactly one option from group %u is required\n", g
-            );
-            return CARGS_ERR_GROUP;
-        }
+    /* Enforce group policies and relations */
+    if (cmd) {
+        grc = cargs__grp_check(env, cmd, &gs);
+        if (grc < 0) return grc;
     }
 
     *idx = i;
     return CARGS_OK;
 }
 
-static inline int cargs_dispatch(
-    const cargs_env *env, const cargs_cmd *root, int argc, char **argv,
-    void *user
+/* Parse options for a given command level. Updates *idx to first non-option. */
+static inline int cargs_parse_opts_level(
+    const cargs_env *env, const cargs_cmd *cmd, const cargs_index_node *nd,
+    int argc, char **argv, int *idx, void *user, bool allow_version,
+    bool allow_author, const char *prog, const char *const *path, size_t depth
 ) {
-    if (!root || !argv || argc <= 0) return CARGS_ERR_BAD_FORMAT;
-    const char      *prog = argv[0];
-    const cargs_cmd *cmd  = root;
-    const char      *path[16];
-    size_t           depth = 0; /* fixed max depth to keep zero-alloc */
+    unsigned sv = CARGS__PHASE(env, CARGS_PHASE_ENV);
+    int      rc = cargs__parse_opts_level(
+        env, cmd, nd, argc, argv, idx, user, allow_version, allow_author, prog,
+        path, depth
+    );
+    CARGS__PHASE_END(env, sv);
+    return rc;
+}
 
-    int              i     = 1;
-    while (1) {
-        /* Parse this level's options */
-        int rc = cargs_parse_opts_level(
-            env, cmd, argc, argv, &i, user,
-            /*allow_version*/ depth == 0, /*allow_author*/ depth == 0, prog,
-            path, depth
-        );
-        if (rc == CARGS_DONE) return CARGS_OK; /* help/version printed */
-        if (rc < 0) return rc;
+/* ===== Streaming positionals ===== */
+static inline long cargs__read_fd(int fd, char *buf, size_t n) {
+#if defined(CARGS__POSIX)
+    ssize_t r;
+    do r = read(fd, buf, n);
+    while (r < 0 && errno == EINTR);
+    return (long)r;
+#elif defined(_WIN32)
+    return (long)_read(fd, buf, n > INT_MAX ? INT_MAX : (unsigned)n);
+#else
+    (void)fd, (void)buf, (void)n;
+    return -1;
+#endif
+}
 
-        if (i >= argc) break;                  /* nothing else */
-        if (argv[i][0] == '-') break;          /* positional at this level */
+typedef struct {
+    const cargs_env *env;
+    const cargs_cmd *cmd;
+    void            *user;
+    size_t           count; /* items delivered so far */
+    unsigned         sum_max;
+    bool             has_inf;
+} cargs__pstream;
+
+static inline int cargs__pstream_emit(
+    cargs__pstream *ps, size_t n, char **items
+) {
+    if (!n) return CARGS_OK;
+    if (!ps->has_inf && ps->count + n > ps->sum_max) {
+        cargs__errf(
+            ps->env, "Too many positionals: at most %u allowed\n", ps->sum_max
+        );
+        return CARGS_ERR_TOO_MANY;
+    }
+    int lim = cargs__spend(ps->env, 1);
+    if (lim < 0) return lim;
+    CARGS__STAT(ps->env, callbacks, 1);
+    unsigned sv = CARGS__PHASE(ps->env, CARGS_PHASE_CALLBACKS);
+    int      rc = ps->cmd->pos_batch(ps->count, n, items, ps->user);
+    CARGS__PHASE_END(ps->env, sv);
+    ps->count += n;
+    return rc < 0 ? rc : CARGS_OK;
+}
+
+/* Deliver argv's positionals, then the stream, in batches; min is checked at
+   the end, max before every batch */
+static inline int cargs__stream_positional(
+    const cargs_env *env, const cargs_cmd *cmd, int argc, char **argv,
+    void *user
+) {
+    cargs_stream  *s = env->stream;
+    cargs__pstream ps;
+    unsigned       sum_min;
+    ps.env   = env;
+    ps.cmd   = cmd;
+    ps.user  = user;
+    ps.count = 0;
+    cargs__pos_bounds(cmd, &sum_min, &ps.sum_max, &ps.has_inf);
+    if (!s->buf || s->cap < 2 || !s->items || !s->items_cap) {
+        cargs__errf(
+            env, "Positional stream needs buf (cap >= 2) and items (cap >= 1)\n"
+        );
+        return CARGS_ERR_BAD_FORMAT;
+    }
+
+    int rc = cargs__pstream_emit(&ps, (size_t)argc, argv);
+    if (rc < 0) return rc;
+
+    size_t fill = 0; /* bytes in buf; [0, fill) starts at an item boundary */
+    bool   eof  = false;
+    while (!eof) {
+        long r = cargs__read_fd(s->fd, s->buf + fill, s->cap - 1 - fill);
+        if (r < 0) {
+            cargs__errf(env, "Reading positionals: %s\n", strerror(errno));
+            return CARGS_ERR_BAD_FORMAT;
+        }
+        eof = r == 0;
+        fill += (size_t)r;
+        if (eof && fill && s->buf[fill - 1] != s->delim)
+            s->buf[fill++] = s->delim; /* last item without a terminator */
+
+        size_t start = 0, k = 0;
+        for (size_t p = 0; p < fill; p++) {
+            if (s->buf[p] != s->delim) continue;
+            s->buf[p] = '\0';
+            if (p > start) s->items[k++] = s->buf + start;
+            start = p + 1;
+            if (k == s->items_cap) {
+                rc = cargs__pstream_emit(&ps, k, s->items);
+                if (rc < 0) return rc;
+                k = 0;
+            }
+        }
+        rc = cargs__pstream_emit(&ps, k, s->items);
+        if (rc < 0) return rc;
+        if (!eof && start == 0 && fill == s->cap - 1) {
+            cargs__errf(
+                env, "Positional item longer than %zu bytes\n", s->cap - 2
+            );
+            return CARGS_ERR_BAD_FORMAT;
+        }
+        memmove(s->buf, s->buf + start, fill - start);
+        fill -= start;
+    }
+    if (ps.count < sum_min) {
+        cargs__errf(
+            env, "Missing required positional %s: need at least %u, got %zu\n",
+            cargs__pos_missing(cmd, ps.count), sum_min, ps.count
+        );
+        return CARGS_ERR_POSITIONAL;
+    }
+    return CARGS_OK;
+}
+
+/* ===== Files ===== */
+/* A whole file as a writable buffer with one spare byte past len */
+typedef struct {
+    char  *data;
+    size_t len;
+    void  *map; /* mapping to release, NULL if in the arena */
+    size_t map_len;
+} cargs__file;
+
+#ifdef CARGS__HAVE_MMAP
+#    if defined(MAP_ANONYMOUS)
+#        define CARGS__MAP_ANON MAP_ANONYMOUS
+#    elif defined(MAP_ANON)
+#        define CARGS__MAP_ANON MAP_ANON
+#    endif
+/* n zeroed private bytes (strict ISO modes hide MAP_ANONYMOUS: map
+   /dev/zero then); NULL on failure */
+static inline void *cargs__map_zero(size_t n) {
+#    ifdef CARGS__MAP_ANON
+    void *m = mmap(NULL, n, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | CARGS__MAP_ANON, -1, 0);
+#    else
+    int z = open("/dev/zero", O_RDWR);
+    if (z < 0) return NULL;
+    void *m = mmap(NULL, n, PROT_READ | PROT_WRITE, MAP_PRIVATE, z, 0);
+    close(z);
+#    endif
+    return m == MAP_FAILED ? NULL : m;
+}
+
+/* len bytes of fd into m; false on a short file or an error */
+static inline bool cargs__read_all(int fd, char *m, size_t len) {
+    size_t got = 0;
+    while (got < len) {
+        ssize_t r = read(fd, m + got, len - got);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        got += (size_t)r;
+    }
+    return true;
+}
+#endif
+
+/* Map path privately. A size ending on a page boundary (or 0) would leave
+   the final NUL outside the mapping; such a file is read into a zeroed
+   mapping one byte longer instead. Without mmap it is read into arena.
+   0 on success, 1 if it does not exist, -1 with *why */
+static inline int cargs__file_load(
+    cargs__file *f, const char *path, cargs_arena *arena, const char **why
+) {
+    memset(f, 0, sizeof *f);
+#ifdef CARGS__HAVE_MMAP
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        *why = strerror(errno);
+        return errno == ENOENT ? 1 : -1;
+    }
+    struct stat st;
+    long        pg = sysconf(_SC_PAGESIZE);
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        *why = "not a regular file";
+        return -1;
+    }
+    f->len = (size_t)st.st_size;
+    if (f->len && pg > 0 && f->len % (size_t)pg) {
+        void *m =
+            mmap(NULL, f->len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (m == MAP_FAILED) {
+            *why = strerror(errno);
+            return -1;
+        }
+        f->map     = m;
+        f->map_len = f->len;
+        f->data    = (char *)m;
+        return 0;
+    }
+    if (pg > 0) {
+        char *m = (char *)cargs__map_zero(f->len + 1);
+        if (m && cargs__read_all(fd, m, f->len)) {
+            close(fd);
+            f->map     = m;
+            f->map_len = f->len + 1;
+            f->data    = m;
+            return 0;
+        }
+        if (m) munmap(m, f->len + 1);
+    }
+    close(fd);
+#endif
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        *why = strerror(errno);
+        return errno == ENOENT ? 1 : -1;
+    }
+    long size = fseek(fp, 0, SEEK_END) == 0 ? ftell(fp) : -1;
+    if (size < 0 || fseek(fp, 0, SEEK_SET) != 0) {
+        fclose(fp);
+        *why = "cannot size the file";
+        return -1;
+    }
+    f->len  = (size_t)size;
+    f->data = (char *)cargs_arena_alloc(arena, f->len + 1, 1);
+    bool ok = f->data && fread(f->data, 1, f->len, fp) == f->len;
+    *why    = f->data ? "read error" : "arena exhausted";
+    fclose(fp);
+    if (!ok) return -1;
+    f->data[f->len] = '\0';
+    return 0;
+}
+
+static inline void cargs__file_release(cargs__file *f) {
+#ifdef CARGS__HAVE_MMAP
+    if (f->map) munmap(f->map, f->map_len);
+#endif
+    f->map = NULL;
+}
+
+/* ===== Response files ===== */
+#define CARGS__RSP_DEPTH 8
+#define CARGS__RSP_LOCAL 2048 /* stack scratch when env->arena is NULL */
+
+/* One loaded @file: ntok NUL-terminated words packed from tok */
+typedef struct cargs__rsp_file {
+    char                   *tok;
+    size_t                  ntok;
+    void                   *map; /* mapping to release, NULL if in arena */
+    size_t                  map_len;
+    struct cargs__rsp_file *next;
+} cargs__rsp_file;
+
+typedef struct {
+    const cargs_env *env;
+    cargs_arena     *arena;
+    cargs__rsp_file *head, **tail;
+    unsigned         max_depth;
+    bool             ended; /* a "--" was seen: later @words are literal */
+} cargs__rsp;
+
+/* Whether word a (argv's or a file's) names a response file; a "--" ends
+   expansion, in argv or in a file, for the rest of the command line */
+static inline bool cargs__rsp_word(bool *ended, const char *a) {
+    if (!a || *ended) return false;
+    if (a[0] == '-' && a[1] == '-' && !a[2]) *ended = true;
+    return a[0] == '@' && a[1];
+}
+
+/* Tokenize buf[0..n) in place: words split on whitespace or NUL, '...'
+   literal, "..." and bare text honour backslash escapes. Words are packed from
+   buf[0], each NUL-terminated; buf[n] must be writable. -1 on an open quote.
+   Shared by response files and cargs_parse_line. */
+static inline int cargs__split_words(char *buf, size_t n, size_t *count) {
+    size_t r = 0, w = 0, k = 0;
+    while (r < n) {
+        char c = buf[r];
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' ||
+            c == '\v' || c == '\0') {
+            r++;
+            continue;
+        }
+        char q = 0;
+        while (r < n) {
+            c = buf[r];
+            if (!q && (c == ' ' || c == '\t' || c == '\n' || c == '\r' ||
+                       c == '\f' || c == '\v' || c == '\0'))
+                break;
+            r++;
+            if (!c) continue; /* NUL bytes never enter a word */
+            if (q == '\'') {
+                if (c == '\'') q = 0;
+                else buf[w++] = c;
+            } else if (c == '\\' && r < n) {
+                if (buf[r]) buf[w++] = buf[r];
+                r++;
+            } else if (c == q) {
+                q = 0;
+            } else if (!q && (c == '\'' || c == '"')) {
+                q = c;
+            } else {
+                buf[w++] = c;
+            }
+        }
+        if (q) return -1;
+        buf[w++] = '\0';
+        k++;
+    }
+    *count = k;
+    return 0;
+}
+
+static inline int cargs__rsp_err(
+    const cargs__rsp *rs, const char *what, const char *path
+) {
+    cargs__errf(rs->env, "Response file '%s': %s\n", path, what);
+    return CARGS_ERR_RESPONSE;
+}
+
+/* Map (or read) path into a writable buffer with one spare byte */
+static inline int cargs__rsp_read(
+    cargs__rsp *rs, const char *path, cargs__rsp_file *f, size_t *len
+) {
+    cargs__file file;
+    const char *why = NULL;
+    if (cargs__file_load(&file, path, rs->arena, &why))
+        return cargs__rsp_err(rs, why, path);
+    f->tok     = file.data;
+    f->map     = file.map;
+    f->map_len = file.map_len;
+    *len       = file.len;
+    return CARGS_OK;
+}
+
+/* Load path and, depth-first, every @file it names; adds its leaf words to
+   *words */
+/* env->limits on the words of one file as it is loaded, so a large @file
+   stops the expansion instead of ending up in the new argv */
+static inline int cargs__rsp_cap(
+    const cargs__rsp *rs, const char *path, size_t words, size_t len
+) {
+    const cargs_limits *l = rs->env->limits;
+    if (!l) return CARGS_OK;
+    if (l->max_argc && words > l->max_argc) {
+        cargs__errf(rs->env, "Too many arguments with '%s' (limit %zu)\n",
+                    path, l->max_argc);
+        return CARGS_ERR_LIMIT;
+    }
+    if (l->max_token && len > l->max_token) {
+        cargs__errf(rs->env, "Argument in '%s' too long (limit %zu bytes)\n",
+                    path, l->max_token);
+        return CARGS_ERR_LIMIT;
+    }
+    return CARGS_OK;
+}
+
+static inline int cargs__rsp_load(
+    cargs__rsp *rs, const char *path, unsigned depth, size_t *words
+) {
+    if (depth > rs->max_depth)
+        return cargs__rsp_err(rs, "nested too deep", path);
+    cargs__rsp_file *f = (cargs__rsp_file *)cargs_arena_alloc(
+        rs->arena, sizeof *f, sizeof(void *)
+    );
+    if (!f) return cargs__rsp_err(rs, "arena exhausted", path);
+    size_t len = 0;
+    int    rc  = cargs__rsp_read(rs, path, f, &len);
+    if (rc) return rc;
+    f->next   = NULL;
+    *rs->tail = f;
+    rs->tail  = &f->next;
+    if (cargs__split_words(f->tok, len, &f->ntok))
+        return cargs__rsp_err(rs, "unterminated quote", path);
+    const char *t = f->tok;
+    for (size_t k = 0; k < f->ntok; k++) {
+        size_t n = strlen(t);
+        if (cargs__rsp_word(&rs->ended, t))
+            rc = cargs__rsp_load(rs, t + 1, depth + 1, words);
+        else rc = cargs__rsp_cap(rs, path, ++*words, n);
+        if (rc) return rc;
+        t += n + 1;
+    }
+    return CARGS_OK;
+}
+
+/* Second pass: same traversal order as cargs__rsp_load */
+static inline void cargs__rsp_emit(
+    cargs__rsp_file **cur, bool *ended, char **out, size_t *n
+) {
+    cargs__rsp_file *f = *cur;
+    *cur               = f->next;
+    char *t            = f->tok;
+    for (size_t k = 0; k < f->ntok; k++, t += strlen(t) + 1) {
+        if (cargs__rsp_word(ended, t)) cargs__rsp_emit(cur, ended, out, n);
+        else out[(*n)++] = t;
+    }
+}
+
+static inline void cargs__rsp_release(cargs__rsp *rs) {
+#ifdef CARGS__HAVE_MMAP
+    for (cargs__rsp_file *f = rs->head; f; f = f->next)
+        if (f->map) munmap(f->map, f->map_len);
+#endif
+    rs->head = NULL;
+}
+
+/* Expand @file arguments of argv[1..argc) into a new argv in the arena */
+static inline int cargs__rsp_expand(
+    cargs__rsp *rs, int argc, char **argv, int *out_argc, char ***out_argv
+) {
+    size_t words = 1;
+    rs->ended    = false;
+    for (int i = 1; i < argc; i++) {
+        if (cargs__rsp_word(&rs->ended, argv[i])) {
+            int rc = cargs__rsp_load(rs, argv[i] + 1, 1, &words);
+            if (rc) return rc;
+        } else {
+            words++;
+        }
+    }
+    if (words > (size_t)INT_MAX)
+        return cargs__rsp_err(rs, "too many arguments", argv[0]);
+    char **out = (char **)cargs_arena_alloc(
+        rs->arena, (words + 1) * sizeof(char *), sizeof(char *)
+    );
+    if (!out) return cargs__rsp_err(rs, "arena exhausted", argv[0]);
+    cargs__rsp_file *cur   = rs->head;
+    size_t           n     = 0;
+    bool             ended = false;
+    out[n++]               = argv[0];
+    for (int i = 1; i < argc; i++) {
+        if (cargs__rsp_word(&ended, argv[i]))
+            cargs__rsp_emit(&cur, &ended, out, &n);
+        else out[n++] = argv[i];
+    }
+    out[n]    = NULL;
+    *out_argc = (int)n;
+    *out_argv = out;
+    return CARGS_OK;
+}
+
+/* argc and token lengths against env->limits, before any parsing */
+static inline int cargs__limits_check(
+    const cargs_env *env, int argc, char **argv
+) {
+    const cargs_limits *l = env->limits;
+    if (l->max_argc && (size_t)argc > l->max_argc) {
+        cargs__errf(env, "Too many arguments: %d (limit %zu)\n", argc,
+                    l->max_argc);
+        return CARGS_ERR_LIMIT;
+    }
+    if (!l->max_token || l->max_token == SIZE_MAX) return CARGS_OK;
+    for (int k = 0; k < argc; k++) {
+        if (argv[k] && !memchr(argv[k], '\0', l->max_token + 1)) {
+            cargs__errf(env, "Argument %d too long (limit %zu bytes)\n", k,
+                        l->max_token);
+            return CARGS_ERR_LIMIT;
+        }
+    }
+    return CARGS_OK;
+}
+
+/* nd: compiled index node for root, or NULL */
+static inline int cargs__dispatch_walk(
+    const cargs_env *env, const cargs_cmd *root, const cargs_index_node *nd,
+    int argc, char **argv, void *user
+) {
+    if (!root || !argv || argc <= 0) return CARGS_ERR_BAD_FORMAT;
+    const char      *prog = argv[0];
+    const cargs_cmd *cmd  = root;
+    const char      *fixed[16];
+    const char     **path  = fixed; /* deeper ones move to env->arena */
+    size_t           cap   = sizeof fixed / sizeof fixed[0];
+    size_t           depth = 0;
+    int              i     = 1;
+    unsigned         level = 0; /* subcommands entered */
+    if (env && env->events) env->events->count = 0;
+    while (1) {
+        /* Parse this level's options */
+        int rc = cargs_parse_opts_level(
+            env, cmd, nd, argc, argv, &i, user,
+            /*allow_version*/ depth == 0, /*allow_author*/ depth == 0, prog,
+            path, depth
+        );
+        if (rc == CARGS_DONE) return CARGS_OK; /* help/version printed */
+        if (rc < 0) return rc;
+
+        if (i >= argc) break;                  /* nothing else */
+        if (argv[i][0] == '-') break;          /* positional at this level */
 
         /* Try to descend into a subcommand */
-        const cargs_cmd *sub = cargs_find_sub(cmd, argv[i]);
+        unsigned         sv  = CARGS__PHASE(env, CARGS_PHASE_DESCEND);
+        const cargs_cmd *sub =
+            cargs__pw(env) ? cargs__pk_lookup(env, argv[i], &rc)
+                           : cargs__lookup_sub(env, cmd, nd, argv[i], &rc);
+        CARGS__PHASE_END(env, sv);
+        if (rc < 0) return rc;
+        if (!sub && cargs__pw(env) && !cmd->pos_count && !cmd->pos_batch)
+            cargs__pk_heads(cargs__pw(env), NULL); /* for the suggestion */
+        if (!sub && cmd->sub_count && !cmd->pos_count && !cmd->pos_batch) {
+            /* no positionals here, so a near miss is a mistyped command */
+            const char *hint = cargs__suggest_sub(env, cmd, argv[i]);
+            if (hint) {
+                cargs__errf(
+                    env, "Unknown command: %s (did you mean %s?)\n", argv[i],
+                    hint
+                );
+                cargs__set_error(env, CARGS_ERR_UNKNOWN, argv[i], hint, true);
+                return CARGS_ERR_UNKNOWN;
+            }
+        }
         if (!sub)
             break; /* not a subcommand — treat as positional for current cmd */
-        if (depth < (sizeof(path) / sizeof(path[0]))) {
-            path[depth++] = argv[i];
+        if (env && env->limits && env->limits->max_depth &&
+            ++level > env->limits->max_depth) {
+            cargs__errf(env, "Commands nested too deeply (limit %u)\n",
+                        env->limits->max_depth);
+            return CARGS_ERR_LIMIT;
         }
+        if (depth == cap) {
+            const char **more =
+                env && env->arena
+                    ? (const char **)cargs_arena_alloc(
+                          env->arena, 2 * cap * sizeof *path, sizeof *path
+                      )
+                    : NULL;
+            if (!more) {
+                cargs__errf(env, "Commands nested deeper than %zu need "
+                                 "env->arena\n", cap);
+                return CARGS_ERR_TOO_MANY;
+            }
+            memcpy(more, path, depth * sizeof *path);
+            path = more;
+            cap *= 2;
+        }
+        path[depth++] = argv[i];
         i++;
+        if (nd)
+            nd = &env->index->nodes[nd->first_sub + (size_t)(sub - cmd->subs)];
         cmd = sub; /* next iteration: parse subcommand level */
     }
 
+    /* Deferred callbacks run once everything checked out; a streaming
+       command gets them first, as one may arm env->stream */
+    int ev_rc = cmd->pos_batch ? cargs__events_run(env, user) : CARGS_OK;
+    if (ev_rc < 0) return ev_rc;
+
     /* We are at the deepest matched command; validate positionals */
-    int pos_rc = cargs_validate_positional(env, cmd, argc - i, &argv[i]);
+    unsigned sv = CARGS__PHASE(env, CARGS_PHASE_POSITIONAL);
+    int      pos_rc =
+        (cmd->pos_batch && env && env->stream && env->stream->fd >= 0)
+            ? cargs__stream_positional(env, cmd, argc - i, &argv[i], user)
+            : cargs_validate_positional(env, cmd, argc - i, &argv[i]);
+    CARGS__PHASE_END(env, sv);
     if (pos_rc < 0) return pos_rc;
+    if (!cmd->pos_batch) {
+        ev_rc = cargs__events_run(env, user);
+        if (ev_rc < 0) return ev_rc;
+    }
 
     /* Run */
-    if (cmd->run) { return cmd->run(argc - i, &argv[i], user); }
+    if (cmd->run) {
+        int lim = cargs__spend(env, 1);
+        if (lim < 0) return lim;
+        CARGS__STAT(env, callbacks, 1);
+        sv     = CARGS__PHASE(env, CARGS_PHASE_CALLBACKS);
+        int rc = cmd->run(argc - i, &argv[i], user);
+        CARGS__PHASE_END(env, sv);
+        return rc;
+    }
 
     /* No runner: show help for this command. */
     cargs_print_help(env, cmd, prog, path, depth);
     return CARGS_OK;
 }
 
-/* ===== Typed helpers ===== */
-static inline int cargs_read_int(const char *s, int *out) {
-    if (!s || !*s || !out) return -1;
-    errno     = 0;
-    char *end = NULL;
-    long  v   = strtol(s, &end, 0);
-    if (errno || end == s || *end != '\0') return -1;
-    if (v < INT_MIN || v > INT_MAX) return -1;
-    *out = (int)v;
-    return 0;
+/* cargs__dispatch_walk under env->limits (a copy of env carries the
+   callback budget in its walk_), handing back what it took from env->arena */
+static inline int cargs__dispatch(
+    const cargs_env *env, const cargs_cmd *root, const cargs_index_node *nd,
+    int argc, char **argv, void *user
+) {
+    cargs_env   lim;
+    cargs__walk walk;
+    if (env && env->limits) {
+        int rc = cargs__limits_check(env, argc, argv);
+        if (rc < 0) return rc;
+        if (env->limits->max_callbacks) {
+            if (env->walk_) walk = *env->walk_;
+            else memset(&walk, 0, sizeof walk);
+            walk.capped = true;
+            walk.left   = env->limits->max_callbacks;
+            lim         = *env;
+            lim.walk_   = &walk;
+            env         = &lim;
+        }
+    }
+    cargs_arena     *a  = env ? env->arena : NULL;
+    cargs_arena_mark m  = cargs_arena_save(a);
+    int              rc = cargs__dispatch_walk(env, root, nd, argc, argv, user);
+    cargs_arena_rewind(a, m);
+    return rc;
 }
-static inline int cargs_read_uint64(const char *s, uint64_t *out) {
-    if (!s || !*s || !out) return -1;
-    errno                  = 0;
-    char              *end = NULL;
-    unsigned long long v   = strtoull(s, &end, 0);
-    if (errno || end == s || *end != '\0') return -1;
-    *out = (uint64_t)v;
-    return 0;
+
+/* ===== Completion endpoint ===== */
+#define CARGS__COMPLETE_MS 100 /* default env->complete_ms */
+
+static inline void cargs__sink_drop(void *ctx, const char *msg, size_t len) {
+    (void)ctx;
+    (void)msg;
+    (void)len;
 }
-static inline int cargs_read_size(
-    const char *s, uint64_t *out, bool prefer_iec
+
+/* Options whose values the endpoint can complete */
+static inline bool cargs__opt_completes(const cargs_opt *o) {
+    return o->bind.complete ||
+           (o->bind.kind == CARGS_BIND_ENUM && o->bind.choices);
+}
+
+static inline bool cargs_complete_expired(cargs_completion *c) {
+    if (!c) return true;
+    if (!c->expired && cargs__now_ns() > c->deadline_) c->expired = true;
+    return c->expired;
+}
+
+static inline int cargs_complete_add(cargs_completion *c, const char *word) {
+    if (!c || cargs_complete_expired(c)) return CARGS_DONE;
+    if (!word || strncmp(word, c->prefix, c->prefix_len) != 0 ||
+        strchr(word, '\n'))
+        return CARGS_OK;
+    fputs(word, c->out);
+    fputc('\n', c->out);
+    c->count++;
+    return CARGS_OK;
+}
+
+static inline const cargs_opt *cargs__complete_long(
+    const cargs_cmd *cmd, const cargs_index_node *nd, const char *name,
+    size_t len
 ) {
-    if (!s || !*s || !out) return -1;
-    errno      = 0;
-    char  *end = NULL;
-    double v   = strtod(s, &end);
-    if (end == s) return -1;
-    while (*end == ' ' || *end == '\t') end++;
-    double mult = 1.0;
-    if (*end) {
-        char   a   = (char)toupper((unsigned char)end[0]);
-        char   b   = (char)toupper((unsigned char)end[1]);
-        char   c   = (char)toupper((unsigned char)end[2]);
-        double k10 = 1000.0, k2 = 1024.0;
-        switch (a) {
-            case 'B': end++; break;
-            case 'K':
-                mult = (b == 'I') ? k2 : (prefer_iec ? k2 : k10);
-                end += (b == 'I' && (c == 'B' || c == '\0'))
-                           ? ((c == 'B') ? 3 : 2)
-                           : ((b == 'B') ? 2 : 1);
-                break;
-            case 'M':
-                mult =
-                    (b == 'I') ? k2 * k2 : (prefer_iec ? k2 * k2 : k10 * k10);
-                end += (b == 'I' && (c == 'B' || c == '\0'))
-                           ? ((c == 'B') ? 3 : 2)
-                           : ((b == 'B') ? 2 : 1);
-                break;
-            case 'G':
-                mult = (b == 'I')
-                           ? k2 * k2 * k2
-                           : (prefer_iec ? k2 * k2 * k2 : k10 * k10 * k10);
-                end += (b == 'I' && (c == 'B' || c == '\0'))
-                           ? ((c == 'B') ? 3 : 2)
-                           : ((b == 'B') ? 2 : 1);
-                break;
-            case 'T':
-                mult = (b == 'I') ? k2 * k2 * k2 * k2
-                                  : (prefer_iec ? k2 * k2 * k2 * k2
-                                                : k10 * k10 * k10 * k10);
-                end += (b == 'I' && (c == 'B' || c == '\0'))
-                           ? ((c == 'B') ? 3 : 2)
-                           : ((b == 'B') ? 2 : 1);
-                break;
-            case 'P':
-                mult = (b == 'I') ? k2 * k2 * k2 * k2 * k2
-                                  : (prefer_iec ? k2 * k2 * k2 * k2 * k2
-                                                : k10 * k10 * k10 * k10 * k10);
-                end += (b == 'I' && (c == 'B' || c == '\0'))
-                           ? ((c == 'B') ? 3 : 2)
-                           : ((b == 'B') ? 2 : 1);
-                break;
-            case 'E':
-                mult = (b == 'I')
-                           ? k2 * k2 * k2 * k2 * k2 * k2
-                           : (prefer_iec ? k2 * k2 * k2 * k2 * k2 * k2
-                                         : k10 * k10 * k10 * k10 * k10 * k10);
-                end += (b == 'I' && (c == 'B' || c == '\0'))
-                           ? ((c == 'B') ? 3 : 2)
-                           : ((b == 'B') ? 2 : 1);
-                break;
-            default: return -1;
+    return nd ? cargs__ix_find_long(nd, name, len, NULL)
+              : cargs__find_long(cmd->opts, cmd->opt_count, name, len, NULL);
+}
+
+/* Whether an OPTIONAL option takes nxt as its value, as the parser does */
+static inline bool cargs__complete_optval(const char *nxt) {
+    return strcmp(nxt, "--") != 0 &&
+           (nxt[0] != '-' || cargs_token_looks_numeric(nxt));
+}
+
+/* Walk words[0..n-1) as cargs__dispatch_walk would, delivering nothing, and
+   return the option whose value words[n - 1] is (*prefix = the value typed
+   so far), or NULL when it is not a value */
+static inline const cargs_opt *cargs__complete_find(
+    const cargs_env *env, const cargs_cmd *cmd, const cargs_index_node *nd,
+    int n, char **words, const char **prefix
+) {
+    int rc = CARGS_OK;
+    for (int i = 0; i < n - 1; i++) {
+        const char      *w = words[i];
+        const cargs_opt *o = NULL;
+        if (strcmp(w, "--") == 0) return NULL; /* positionals only */
+        if (w[0] == '-' && w[1] == '-') {
+            if (!strchr(w + 2, '='))
+                o = cargs__complete_long(cmd, nd, w + 2, strlen(w + 2));
+        } else if (w[0] == '-') {
+            /* grouped shorts: the first one taking a value ends the word */
+            for (const char *p = w + 1; *p; p++) {
+                const cargs_opt *f =
+                    nd ? cargs__ix_find_short(nd, *p)
+                       : cargs_find_short(cmd->opts, cmd->opt_count, *p);
+                if (f && f->arg != CARGS_ARG_NONE) {
+                    o = p[1] ? NULL : f; /* attached value: -j8 */
+                    break;
+                }
+            }
+        } else {
+            const cargs_cmd *sub =
+                cargs__pw(env) ? cargs__pk_lookup(env, w, &rc)
+                               : cargs__lookup_sub(env, cmd, nd, w, &rc);
+            if (!sub) return NULL; /* a positional: the rest are too */
+            if (nd)
+                nd = &env->index
+                          ->nodes[nd->first_sub + (size_t)(sub - cmd->subs)];
+            cmd = sub;
+            continue;
+        }
+        if (!o || o->arg == CARGS_ARG_NONE) continue;
+        if (o->arg == CARGS_ARG_OPTIONAL) {
+            if (i + 1 < n - 1 && cargs__complete_optval(words[i + 1])) i++;
+            continue;
+        }
+        if (++i == n - 1) {
+            *prefix = words[i];
+            return o;
         }
-        while (*end == ' ' || *end == '\t') end++;
-        if (*end != '\0') return -1;
     }
-    double bytes = v * mult;
-    if (bytes < 0.0 || bytes > (double)UINT64_MAX) return -1;
-    *out = (uint64_t)(bytes + 0.5);
-    return 0;
+    const char *cur = words[n - 1];
+    const char *eq =
+        cur[0] == '-' && cur[1] == '-' ? strchr(cur + 2, '=') : NULL;
+    if (!eq) return NULL;
+    const cargs_opt *o =
+        cargs__complete_long(cmd, nd, cur + 2, (size_t)(eq - cur - 2));
+    *prefix = eq + 1;
+    return o && o->arg != CARGS_ARG_NONE ? o : NULL;
 }
-static inline int cargs_read_size_si(const char *s, uint64_t *out) {
-    return cargs_read_size(s, out, false);
+
+/* "prog __complete WORDS... CUR": candidates for CUR, one per line */
+static inline int cargs__complete(
+    const cargs_env *env, const cargs_cmd *root, const cargs_index_node *nd,
+    int n, char **words, void *user
+) {
+    cargs_sink       none = {cargs__sink_drop, NULL};
+    cargs_env        e    = *env;
+    unsigned         ms   = env->complete_ms ? env->complete_ms
+                                             : CARGS__COMPLETE_MS;
+    cargs_completion c;
+    memset(&c, 0, sizeof c);
+    c.out       = env->out ? env->out : stdout;
+    c.deadline_ = cargs__now_ns() + (uint64_t)ms * 1000000u;
+    e.err_sink  = &none; /* ambiguous prefixes and the like stay quiet */
+    e.error     = NULL;
+    const cargs_opt *o =
+        n > 0 ? cargs__complete_find(&e, root, nd, n, words, &c.prefix)
+              : NULL;
+    if (!o || cargs_complete_expired(&c)) return CARGS_OK;
+    c.prefix_len = strlen(c.prefix);
+    int rc       = CARGS_OK;
+    if (o->bind.complete) rc = o->bind.complete(c.prefix, o, &c, user);
+    else if (o->bind.kind == CARGS_BIND_ENUM)
+        for (const cargs_choice *ch = o->bind.choices; ch && ch->name; ch++)
+            if (cargs_complete_add(&c, ch->name)) break;
+    fflush(c.out);
+    return rc < 0 ? rc : CARGS_OK;
 }
-static inline int cargs_read_size_iec(const char *s, uint64_t *out) {
-    return cargs_read_size(s, out, true);
+
+/* Response-file expansion around cargs__dispatch */
+static inline int cargs__dispatch_at(
+    const cargs_env *env, const cargs_cmd *root, const cargs_index_node *nd,
+    int argc, char **argv, void *user
+) {
+    cargs__set_error(env, CARGS_OK, NULL, NULL, false);
+    for (int k = 1; k < argc; k++) /* a NULL word ends argv, as argv[argc] */
+        if (!argv[k]) argc = k;
+    if (env && env->complete && argc > 1 && argv[1] &&
+        strcmp(argv[1], "__complete") == 0)
+        return cargs__complete(env, root, nd, argc - 2, argv + 2, user);
+    if (!env || !env->response_files) {
+        return cargs__dispatch(env, root, nd, argc, argv, user);
+    }
+    int  i     = 1;
+    bool ended = false;
+    while (i < argc && !cargs__rsp_word(&ended, argv[i])) i++;
+    if (i == argc) return cargs__dispatch(env, root, nd, argc, argv, user);
+    if (env->limits) { /* argv itself before any file is read */
+        int rc = cargs__limits_check(env, argc, argv);
+        if (rc < 0) return rc;
+    }
+
+    cargs_arena own;
+    cargs__rsp  rs;
+    uint64_t    local[CARGS__RSP_LOCAL / sizeof(uint64_t)];
+    cargs_arena_init(&own, local, sizeof local);
+    rs.env       = env;
+    rs.arena     = env->arena ? env->arena : &own;
+    rs.head      = NULL;
+    rs.tail      = &rs.head;
+    rs.max_depth = env->response_depth ? env->response_depth
+                                       : CARGS__RSP_DEPTH;
+    cargs_arena_mark mark  = cargs_arena_save(rs.arena);
+    int              argc2 = 0;
+    char           **argv2 = NULL;
+    int rc = cargs__rsp_expand(&rs, argc, argv, &argc2, &argv2);
+    if (rc == CARGS_OK)
+        rc = cargs__dispatch(env, root, nd, argc2, argv2, user);
+    cargs__rsp_release(&rs);
+    cargs_arena_rewind(rs.arena, mark);
+    return rc;
 }
-static inline char *cargs_fmt_bytes(
-    uint64_t bytes, char *buf, size_t bufsz, bool iec, int decimals
+
+/* Index node for root, if env->index was built for it */
+static inline const cargs_index_node *cargs__root_node(
+    const cargs_env *env, const cargs_cmd *root
 ) {
-    if (!buf || bufsz == 0) return buf;
+    return (env && env->index && env->index->root == root) ? env->index->nodes
+                                                           : NULL;
+}
 
-    static const char *U_SI[]  = {"B", "KB", "MB", "GB", "TB", "PB", "EB"};
-    static const char *U_IEC[] = {"B",   "KiB", "MiB", "GiB",
-                                  "TiB", "PiB", "EiB"};
-    const char       **U       = iec ? U_IEC : U_SI;
-    const double       k       = iec ? 1024.0 : 1000.0;
-    double             v       = (double)bytes;
-    size_t             i       = 0;
-    while (v >= k && i < 6) {
-        v /= k;
-        i++;
+static inline int cargs_dispatch(
+    const cargs_env *env, const cargs_cmd *root, int argc, char **argv,
+    void *user
+) {
+    if (!root || !argv || argc <= 0) return CARGS_ERR_BAD_FORMAT;
+    return cargs__dispatch_at(
+        env, root, cargs__root_node(env, root), argc, argv, user
+    );
+}
+
+/* Last path component of argv[0]: a suffix of arg0 itself, or without
+   ".exe" on Windows a copy in buf[cap] (else env->arena); NULL when neither
+   has room */
+static inline const char *cargs__applet_name(
+    const cargs_env *env, const char *arg0, char *buf, size_t cap
+) {
+    const char *base = arg0;
+    for (const char *p = arg0; *p; p++) {
+        if (*p == '/') base = p + 1;
+#if defined(_WIN32)
+        if (*p == '\\' || *p == ':') base = p + 1;
+#endif
+    }
+    size_t len = strlen(base);
+#if defined(_WIN32)
+    if (len > 4 && (strcmp(base + len - 4, ".exe") == 0 ||
+                    strcmp(base + len - 4, ".EXE") == 0))
+        len -= 4;
+#endif
+    if (!base[len]) return base;
+    char *name = cargs__scratch(env, buf, cap, len + 1);
+    if (!name) return NULL;
+    memcpy(name, base, len);
+    name[len] = '\0';
+    return name;
+}
+
+static inline int cargs_dispatch_multicall(
+    const cargs_env *env, const cargs_cmd *root, int argc, char **argv,
+    void *user
+) {
+    if (!root || !argv || argc <= 0 || !argv[0]) return CARGS_ERR_BAD_FORMAT;
+    const cargs_index_node *nd = cargs__root_node(env, root);
+    char                    buf[96];
+    cargs_arena_mark        m = cargs_arena_save(env ? env->arena : NULL);
+    const char *name = cargs__applet_name(env, argv[0], buf, sizeof buf);
+    if (!name) {
+        cargs__errf(env, "Program name longer than %zu bytes needs "
+                         "env->arena\n", sizeof buf - 1);
+        return CARGS_ERR_TOO_MANY;
+    }
+    /* Applets match by exact name or alias only, never by prefix */
+    const cargs_cmd *app = NULL;
+    if (*name) {
+        bool amb = false;
+        app      = nd ? cargs__ix_find_sub(nd, name, false, &amb, NULL)
+                      : cargs__find_sub(root, name, NULL);
     }
+    cargs_arena_rewind(env ? env->arena : NULL, m);
+    if (!app) return cargs__dispatch_at(env, root, nd, argc, argv, user);
+    if (nd) nd = &env->index->nodes[nd->first_sub + (size_t)(app - root->subs)];
+    return cargs__dispatch_at(env, app, nd, argc, argv, user);
+}
+
+/* ===== Batch dispatch ===== */
+/* A slice of the jobs; the alignment keeps slices on separate cache lines */
+typedef struct {
+    CARGS__ALIGN(64) size_t next;
+    size_t end;
+} cargs__batch_slice;
 
-    if (decimals < 0) decimals = 2;
-    if (decimals > 6) decimals = 6;
+typedef struct cargs__batch {
+    const cargs_env    *env;
+    const cargs_cmd    *root;
+    cargs_job          *jobs;
+    cargs__batch_slice *slices;
+    unsigned            nslices;
+} cargs__batch;
 
-    int n;
-    if (i == 0 || v >= 10.0 || decimals == 0) {
-        n = snprintf(buf, bufsz, "%.0f%s", v, U[i]);
-    } else {
-        n = snprintf(buf, bufsz, "%.*f%s", decimals, v, U[i]);
+static inline void cargs__batch_one(
+    const cargs_env *env, const cargs_cmd *root, cargs_job *j
+) {
+    cargs_env e = *env;
+    e.error     = &j->error;
+    e.arena     = j->arena;
+    e.stream    = NULL;
+    e.stats     = NULL;
+    e.events    = j->events;
+    /* help pages render in the job's arena or on the stack, not in a
+       buffer every job would share */
+    e.help_buf     = NULL;
+    e.help_buf_cap = 0;
+    if (j->err) e.err_sink = j->err;
+    j->rc = cargs_dispatch(&e, root, j->argc, j->argv, j->user);
+}
+
+/* Claim up to want jobs from the front of s; 0 once it is drained */
+static inline size_t cargs__batch_claim(
+    cargs__batch_slice *s, size_t want, size_t *first
+) {
+#ifdef CARGS__THREADS
+    size_t i = __atomic_fetch_add(&s->next, want, __ATOMIC_RELAXED);
+#else
+    size_t i = s->next;
+    s->next += want;
+#endif
+    if (i >= s->end) return 0;
+    *first = i;
+    return s->end - i < want ? s->end - i : want;
+}
+
+/* Own slice in chunks of 8, then the others' in pairs */
+static inline void cargs__batch_work(cargs__batch *b, unsigned self) {
+    for (unsigned k = 0; k < b->nslices; k++) {
+        cargs__batch_slice *s    = &b->slices[(self + k) % b->nslices];
+        size_t              want = k ? 2 : 8, first = 0, got;
+        while ((got = cargs__batch_claim(s, want, &first)) != 0)
+            for (size_t i = first; i < first + got; i++)
+                cargs__batch_one(b->env, b->root, &b->jobs[i]);
+    }
+}
+
+/* nthreads resolved: 0 = online CPUs, at most CARGS_BATCH_MAX_THREADS */
+static inline unsigned cargs__batch_threads(unsigned nthreads) {
+#ifdef CARGS__THREADS
+    if (!nthreads) {
+        long c   = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = c > 0 ? (unsigned)c : 1;
+    }
+    return nthreads < CARGS_BATCH_MAX_THREADS ? nthreads
+                                              : CARGS_BATCH_MAX_THREADS;
+#else
+    (void)nthreads;
+    return 1;
+#endif
+}
+
+#ifdef CARGS__THREADS
+/* A worker: wait for the next batch, work it from its own slice, report */
+static inline void *cargs__pool_main(void *arg) {
+    cargs_pool *p = (cargs_pool *)arg;
+    pthread_mutex_lock(&p->mu_);
+    unsigned      self = ++p->self_;
+    unsigned long seen = 0; /* a batch handed out before we got here counts */
+    for (;;) {
+        while (!p->stop_ && p->gen_ == seen)
+            pthread_cond_wait(&p->go_, &p->mu_);
+        if (p->stop_) break;
+        seen            = p->gen_;
+        cargs__batch *b = p->batch_;
+        pthread_mutex_unlock(&p->mu_);
+        cargs__batch_work(b, self);
+        pthread_mutex_lock(&p->mu_);
+        if (--p->busy_ == 0) pthread_cond_signal(&p->done_);
+    }
+    pthread_mutex_unlock(&p->mu_);
+    return NULL;
+}
+#endif
+
+static inline unsigned cargs_pool_start(cargs_pool *p, unsigned nthreads) {
+    if (!p) return 0;
+    memset(p, 0, sizeof *p);
+    p->threads = 1;
+#ifdef CARGS__THREADS
+    nthreads = cargs__batch_threads(nthreads);
+    if (nthreads < 2) return 1;
+    if (pthread_mutex_init(&p->mu_, NULL)) return 1;
+    if (pthread_cond_init(&p->go_, NULL)) {
+        pthread_mutex_destroy(&p->mu_);
+        return 1;
+    }
+    if (pthread_cond_init(&p->done_, NULL)) {
+        pthread_cond_destroy(&p->go_);
+        pthread_mutex_destroy(&p->mu_);
+        return 1;
     }
+    p->live_ = true;
+    /* a worker that fails to start just leaves the pool smaller */
+    while (p->threads < nthreads &&
+           pthread_create(&p->tid_[p->threads], NULL, cargs__pool_main, p) ==
+               0)
+        p->threads++;
+#else
+    (void)nthreads;
+#endif
+    return p->threads;
+}
+
+static inline size_t cargs_pool_dispatch(
+    cargs_pool *p, const cargs_env *env, const cargs_cmd *root,
+    cargs_job *jobs, size_t n
+) {
+    if (!jobs || !n) return 0;
+    cargs_env  e;
+    cargs_pres pres;
+    if (env) e = *env;
+    else memset(&e, 0, sizeof e);
+    if (!e.pres) {
+        cargs_pres_resolve(&e, root, &pres);
+        e.pres = &pres;
+    }
+    unsigned nslices = p && p->threads ? p->threads : 1;
+    if (nslices > n) nslices = (unsigned)n;
+    cargs__batch_slice slices[CARGS_BATCH_MAX_THREADS];
+    for (unsigned t = 0; t < nslices; t++) {
+        slices[t].next = n * t / nslices;
+        slices[t].end  = n * (t + 1) / nslices;
+    }
+    cargs__batch b = {&e, root, jobs, slices, nslices};
+#ifdef CARGS__THREADS
+    if (p && p->live_ && p->threads > 1) {
+        /* the caller works slice 0 while the workers take the rest */
+        pthread_mutex_lock(&p->mu_);
+        p->batch_ = &b;
+        p->busy_  = p->threads - 1;
+        p->gen_++;
+        pthread_cond_broadcast(&p->go_);
+        pthread_mutex_unlock(&p->mu_);
+        cargs__batch_work(&b, 0);
+        pthread_mutex_lock(&p->mu_);
+        while (p->busy_) pthread_cond_wait(&p->done_, &p->mu_);
+        p->batch_ = NULL;
+        pthread_mutex_unlock(&p->mu_);
+    } else
+#endif
+        cargs__batch_work(&b, 0);
+    size_t failed = 0;
+    for (size_t i = 0; i < n; i++) failed += jobs[i].rc < 0;
+    return failed;
+}
+
+static inline void cargs_pool_stop(cargs_pool *p) {
+    if (!p) return;
+#ifdef CARGS__THREADS
+    if (p->live_) {
+        pthread_mutex_lock(&p->mu_);
+        p->stop_ = true;
+        pthread_cond_broadcast(&p->go_);
+        pthread_mutex_unlock(&p->mu_);
+        for (unsigned t = 1; t < p->threads; t++)
+            pthread_join(p->tid_[t], NULL);
+        pthread_cond_destroy(&p->done_);
+        pthread_cond_destroy(&p->go_);
+        pthread_mutex_destroy(&p->mu_);
+    }
+#endif
+    memset(p, 0, sizeof *p);
+}
+
+static inline size_t cargs_dispatch_batch(
+    const cargs_env *env, const cargs_cmd *root, cargs_job *jobs, size_t n,
+    unsigned nthreads
+) {
+    if (!jobs || !n) return 0;
+    nthreads = cargs__batch_threads(nthreads);
+    if (nthreads > n) nthreads = (unsigned)n;
+    cargs_pool pool;
+    cargs_pool_start(&pool, nthreads);
+    size_t failed = cargs_pool_dispatch(&pool, env, root, jobs, n);
+    cargs_pool_stop(&pool);
+    return failed;
+}
+
+/* ===== Reusable parser ===== */
+static inline size_t cargs_parser_size(const cargs_cmd *root) {
+    return cargs_compile_size(root) + cargs_envsnap_size(root);
+}
+
+static inline int cargs_parser_init(
+    cargs_parser *p, const cargs_env *env, const cargs_cmd *root,
+    void *storage, size_t cap
+) {
+    if (!p || !env || !root) return -1;
+    char  *at   = (char *)storage;
+    size_t left = storage ? cap : 0;
+    p->env            = *env;
+    p->root           = root;
+    p->response_files = false;
+    if (!env->index || env->index->root != root) {
+        size_t n     = cargs_compile_size(root);
+        p->env.index = left >= n ? cargs_compile(root, at, left) : NULL;
+        if (!p->env.index) return -1;
+        at += n;
+        left -= n;
+    }
+    if (!env->envsnap) {
+        p->env.envsnap = cargs_envsnap_build(root, NULL, at, left);
+        if (!p->env.envsnap) return -1;
+    }
+    if (!env->pres) {
+        cargs_pres_resolve(&p->env, root, &p->pres);
+        p->env.pres = &p->pres;
+    }
+    return 0;
+}
+
+static inline int cargs_parse_line(
+    const cargs_parser *p, const char *line, size_t len, cargs_scratch *scratch,
+    void *user
+) {
+    if (!p || !scratch || (len && !line)) return CARGS_ERR_BAD_FORMAT;
+    cargs_arena *arena = scratch->arena;
+    if (!arena && (!scratch->buf || !scratch->argv))
+        return CARGS_ERR_BAD_FORMAT;
+    cargs_env env = p->env;
+    if (scratch->err) env.err_sink = scratch->err;
+    /* nothing shared between calls is written: only this call's arena */
+    env.arena          = arena;
+    env.response_files = p->response_files;
+
+    /* buf = prog NUL words...; argv[0] = prog */
+    cargs_arena_mark m    = cargs_arena_save(arena);
+    const char      *prog = env.prog ? env.prog : "";
+    size_t           pl   = strlen(prog) + 1;
+    char            *buf  = scratch->buf;
+    if ((!buf || scratch->cap < pl + 1 || len > scratch->cap - pl - 1) &&
+        arena && len < SIZE_MAX - pl)
+        buf = (char *)cargs_arena_alloc(arena, pl + len + 1, 1);
+    else if (buf && (scratch->cap < pl + 1 || len > scratch->cap - pl - 1))
+        buf = NULL;
+    if (!buf) {
+        cargs__errf(&env, "Command line too long (%zu bytes)\n", len);
+        return CARGS_ERR_BAD_FORMAT;
+    }
+    memcpy(buf, prog, pl);
+    if (len) memcpy(buf + pl, line, len);
+    size_t words = 0;
+    if (cargs__split_words(buf + pl, len, &words)) {
+        cargs_arena_rewind(arena, m);
+        cargs__errf(&env, "Unterminated quote\n");
+        return CARGS_ERR_BAD_FORMAT;
+    }
+    char **argv = scratch->argv;
+    bool   fits = argv && scratch->argv_cap >= 2 &&
+                words <= scratch->argv_cap - 2;
+    if (!fits && words <= (size_t)INT_MAX - 1)
+        argv = (char **)cargs_arena_alloc(
+            arena, (words + 2) * sizeof(char *), sizeof(char *)
+        );
+    if (!argv || words > (size_t)INT_MAX - 1) {
+        cargs_arena_rewind(arena, m);
+        cargs__errf(&env, "Too many words (%zu)\n", words);
+        return CARGS_ERR_BAD_FORMAT;
+    }
+    char *t = buf + pl;
+    argv[0] = buf;
+    for (size_t k = 1; k <= words; k++, t += strlen(t) + 1) argv[k] = t;
+    argv[words + 1] = NULL;
+    int rc = cargs_dispatch(&env, p->root, (int)words + 1, argv, user);
+    cargs_arena_rewind(arena, m);
+    return rc;
+}
+
+/* ===== Typed helpers ===== */
+static inline int cargs_read_int(const char *s, int *out) {
+    if (!s || !*s || !out) return -1;
+    errno     = 0;
+    char *end = NULL;
+    long  v   = strtol(s, &end, 0);
+    if (errno || end == s || *end != '\0') return -1;
+    if (v < INT_MIN || v > INT_MAX) return -1;
+    *out = (int)v;
+    return 0;
+}
+static inline int cargs_read_uint64(const char *s, uint64_t *out) {
+    if (!s || !*s || !out) return -1;
+    errno                  = 0;
+    char              *end = NULL;
+    unsigned long long v   = strtoull(s, &end, 0);
+    if (errno || end == s || *end != '\0') return -1;
+    *out = (uint64_t)v;
+    return 0;
+}
+/* Little-endian load of 8 bytes, independent of host byte order */
+static inline uint64_t cargs__load_le64(const char *p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | (unsigned char)p[i];
+    return v;
+}
+
+/* 8 ASCII digits at once (SWAR); returns false if any byte is not a digit */
+static inline bool cargs__swar8(const char *p, uint32_t *val) {
+    uint64_t v = cargs__load_le64(p);
+    if (((v & 0xF0F0F0F0F0F0F0F0ull) |
+         (((v + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) !=
+        0x3333333333333333ull)
+        return false;
+    /* pairs, then quads, then all eight (most significant digit first) */
+    v = ((v & 0x0F0F0F0F0F0F0F0Full) * 2561) >> 8;
+    v = ((v & 0x00FF00FF00FF00FFull) * 6553601) >> 16;
+    v = ((v & 0x0000FFFF0000FFFFull) * 42949672960001ull) >> 32;
+    *val = (uint32_t)v;
+    return true;
+}
+
+static inline int cargs__hexval(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/* Unsigned magnitude of s[0..n) (no sign); -1 on bad digit or overflow */
+static inline int cargs__parse_mag(
+    const char *s, size_t n, int base, uint64_t *out
+) {
+    if (n >= 2 && s[0] == '0' && (base == CARGS_BASE_AUTO || base == 16) &&
+        (s[1] == 'x' || s[1] == 'X')) {
+        base = 16;
+        s += 2;
+        n -= 2;
+    } else if (n >= 2 && s[0] == '0' &&
+               (base == CARGS_BASE_AUTO || base == 2) &&
+               (s[1] == 'b' || s[1] == 'B')) {
+        base = 2;
+        s += 2;
+        n -= 2;
+    } else if (base == CARGS_BASE_AUTO) {
+        base = 10;
+    }
+    if (!n) return -1;
+    uint64_t v = 0;
+    if (base == 10) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            uint32_t chunk;
+            if (!cargs__swar8(s + i, &chunk)) return -1;
+            if (v > (UINT64_MAX - chunk) / 100000000u) return -1;
+            v = v * 100000000u + chunk;
+        }
+        for (; i < n; i++) {
+            unsigned d = (unsigned)(unsigned char)s[i] - '0';
+            if (d > 9) return -1;
+            if (v > (UINT64_MAX - d) / 10) return -1;
+            v = v * 10 + d;
+        }
+    } else if (base == 16) {
+        for (size_t i = 0; i < n; i++) {
+            int d = cargs__hexval(s[i]);
+            if (d < 0 || (v >> 60)) return -1;
+            v = (v << 4) | (unsigned)d;
+        }
+    } else if (base == 2) {
+        for (size_t i = 0; i < n; i++) {
+            if ((s[i] != '0' && s[i] != '1') || (v >> 63)) return -1;
+            v = (v << 1) | (unsigned)(s[i] - '0');
+        }
+    } else {
+        return -1;
+    }
+    *out = v;
+    return 0;
+}
+
+static inline int cargs_read_u64(const char *s, uint64_t *out, int base) {
+    if (!s || !out) return -1;
+    size_t n = strlen(s);
+    if (n && *s == '+') s++, n--;
+    return cargs__parse_mag(s, n, base, out);
+}
+
+static inline int cargs_read_i64(const char *s, int64_t *out, int base) {
+    if (!s || !out) return -1;
+    size_t n   = strlen(s);
+    bool   neg = n && *s == '-';
+    if (n && (*s == '-' || *s == '+')) s++, n--;
+    uint64_t m;
+    if (cargs__parse_mag(s, n, base, &m)) return -1;
+    if (m > (uint64_t)INT64_MAX + (neg ? 1u : 0u)) return -1;
+    if (neg) *out = m == (uint64_t)INT64_MAX + 1u ? INT64_MIN : -(int64_t)m;
+    else *out = (int64_t)m;
+    return 0;
+}
+
+static inline int cargs_read_u32(const char *s, uint32_t *out, int base) {
+    uint64_t v;
+    if (!out || cargs_read_u64(s, &v, base) || v > UINT32_MAX) return -1;
+    *out = (uint32_t)v;
+    return 0;
+}
+
+static inline int cargs_read_i32(const char *s, int32_t *out, int base) {
+    int64_t v;
+    if (!out || cargs_read_i64(s, &v, base) || v < INT32_MIN || v > INT32_MAX)
+        return -1;
+    *out = (int32_t)v;
+    return 0;
+}
+
+static inline int cargs_read_u64_batch(
+    char *const *argv, size_t n, uint64_t *out, int base, size_t *bad
+) {
+    if (!out || (n && !argv)) return -1;
+    for (size_t i = 0; i < n; i++) {
+        if (cargs_read_u64(argv[i], &out[i], base)) {
+            if (bad) *bad = i;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static inline int cargs_read_i64_batch(
+    char *const *argv, size_t n, int64_t *out, int base, size_t *bad
+) {
+    if (!out || (n && !argv)) return -1;
+    for (size_t i = 0; i < n; i++) {
+        if (cargs_read_i64(argv[i], &out[i], base)) {
+            if (bad) *bad = i;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* Fraction digits the decimal readers accept (trailing zeros not counted) */
+#define CARGS__SIZE_FRAC_MAX 64
+
+/* "<int>[.<frac>]" split into digit runs; shared by the size, duration and
+   rate readers. Advances *sp; -1 when there are no digits or the fraction
+   has more than CARGS__SIZE_FRAC_MAX significant digits. */
+typedef struct cargs__dec {
+    const char *ip, *fp;
+    size_t      in, fn;
+} cargs__dec;
+
+static inline int cargs__dec_take(const char **sp, cargs__dec *d) {
+    const char *s = *sp;
+    d->ip         = s;
+    while (*s >= '0' && *s <= '9') s++;
+    d->in = (size_t)(s - d->ip);
+    d->fp = s;
+    d->fn = 0;
+    if (*s == '.') {
+        d->fp = ++s;
+        while (*s >= '0' && *s <= '9') s++;
+        d->fn = (size_t)(s - d->fp);
+    }
+    if (!d->in && !d->fn) return -1;
+    while (d->fn && d->fp[d->fn - 1] == '0') d->fn--;
+    if (d->fn > CARGS__SIZE_FRAC_MAX) return -1;
+    *sp = s;
+    return 0;
+}
+
+/* round(d * m), half up, exactly: the fraction term is folded right to left
+   as t = (digit * m + t) / 10, so it never needs more than 10 * m.
+   m <= UINT64_MAX / 10. -2 when the product exceeds UINT64_MAX. */
+static inline int cargs__dec_scale(
+    const cargs__dec *d, uint64_t m, uint64_t *out
+) {
+    uint64_t v = 0, t = 0;
+    if (d->in && cargs__parse_mag(d->ip, d->in, CARGS_BASE_DEC, &v)) return -2;
+    if (v && v > UINT64_MAX / m) return -2;
+    v *= m;
+    if (d->fn) {
+        for (size_t k = d->fn; --k;)
+            t = ((uint64_t)(d->fp[k] - '0') * m + t) / 10;
+        t = (uint64_t)(d->fp[0] - '0') * m + t;
+        t = t / 10 + (t % 10 >= 5);
+        if (t > UINT64_MAX - v) return -2;
+    }
+    *out = v + t;
+    return 0;
+}
+
+/* Number plus optional B | K[i][B] .. E[i][B] unit ('i' is always
+   1024-based), left as the digits d times *m bytes; stops after the unit.
+   0, or -1 on bad syntax. */
+static inline int cargs__size_split(
+    const char **sp, cargs__dec *d, uint64_t *m, bool prefer_iec
+) {
+    const char *s = *sp;
+    while (*s == ' ' || *s == '\t') s++;
+    if (*s == '+') s++;
+    if (cargs__dec_take(&s, d)) return -1;
+    while (*s == ' ' || *s == '\t') s++;
+
+    unsigned          pw    = 0;
+    bool              bin   = prefer_iec;
+    static const char units[] = "KMGTPE";
+    char              a       = (char)toupper((unsigned char)*s);
+    const char       *u       = a ? strchr(units, a) : NULL;
+    if (a == 'B') {
+        s++;
+    } else if (u) {
+        pw = (unsigned)(u - units) + 1;
+        s++;
+        if (*s == 'i' || *s == 'I') bin = true, s++;
+        if (*s == 'b' || *s == 'B') s++;
+    }
+    *m = 1;
+    for (unsigned k = 0; k < pw; k++) *m *= bin ? 1024 : 1000;
+    *sp = s;
+    return 0;
+}
+
+/* The same, rounded to whole bytes. 0, -1 bad syntax, -2 out of range. */
+static inline int cargs__size_take(
+    const char **sp, uint64_t *out, bool prefer_iec
+) {
+    cargs__dec d;
+    uint64_t   m;
+    if (cargs__size_split(sp, &d, &m, prefer_iec)) return -1;
+    return cargs__dec_scale(&d, m, out);
+}
+
+static inline int cargs_read_size(
+    const char *s, uint64_t *out, bool prefer_iec
+) {
+    uint64_t v;
+    if (!s || !out || cargs__size_take(&s, &v, prefer_iec)) return -1;
+    while (*s == ' ' || *s == '\t') s++;
+    if (*s) return -1;
+    *out = v;
+    return 0;
+}
+static inline int cargs_read_size_si(const char *s, uint64_t *out) {
+    return cargs_read_size(s, out, false);
+}
+static inline int cargs_read_size_iec(const char *s, uint64_t *out) {
+    return cargs_read_size(s, out, true);
+}
+
+/* Time unit at *sp, in nanoseconds; 0 if none. Switches on the first byte
+   rather than scanning a name table: it runs once per duration part. */
+static inline uint64_t cargs__time_unit(const char **sp) {
+    const uint64_t us = 1000ull, ms = us * 1000, sec = ms * 1000;
+    const char    *s  = *sp;
+    uint64_t       ns = 0;
+    switch (*s++) {
+        case 'n':
+            if (*s == 's') ns = 1, s++;
+            break;
+        case 'u':
+            if (*s == 's') ns = us, s++;
+            break;
+        case '\xc2': /* µs */
+            if (s[0] == '\xb5' && s[1] == 's') ns = us, s += 2;
+            break;
+        case 'm':
+            if (*s == 's') ns = ms, s++;
+            else if (s[0] == 'i' && s[1] == 'n') ns = 60 * sec, s += 2;
+            else ns = 60 * sec;
+            break;
+        case 's': ns = sec; break;
+        case 'h': ns = 3600 * sec; break;
+        case 'd': ns = 86400 * sec; break;
+        case 'w': ns = 604800 * sec; break;
+        default: break;
+    }
+    if (!ns || (*s >= 'a' && *s <= 'z')) return 0;
+    *sp = s;
+    return ns;
+}
+
+static inline int cargs_read_duration(const char *s, uint64_t *out) {
+    if (!s || !out) return -1;
+    uint64_t total = 0;
+    unsigned parts = 0;
+    while (*s == ' ' || *s == '\t') s++;
+    if (*s == '+') s++;
+    while (*s) {
+        cargs__dec d;
+        uint64_t   v;
+        if (cargs__dec_take(&s, &d)) return -1;
+        while (*s == ' ' || *s == '\t') s++;
+        uint64_t ns = cargs__time_unit(&s);
+        if (!ns) {
+            /* only a lone number may omit its unit (seconds) */
+            if (*s || parts) return -1;
+            ns = 1000ull * 1000 * 1000;
+        }
+        int rc = cargs__dec_scale(&d, ns, &v);
+        if (rc) return rc;
+        if (v > UINT64_MAX - total) return -2;
+        total += v;
+        parts++;
+        while (*s == ' ' || *s == '\t') s++;
+    }
+    if (!parts) return -1;
+    *out = total;
+    return 0;
+}
+
+/* d * 10^j: j fraction digits move into the whole part, which is built in
+   buf (CARGS__DEC_SHIFT_MAX bytes). Leading zeros are dropped first, so -2
+   means the whole part has more digits than any uint64_t. */
+#define CARGS__DEC_SHIFT_MAX 32
+static inline int cargs__dec_shift(cargs__dec *d, unsigned j, char *buf) {
+    while (d->in && *d->ip == '0') d->ip++, d->in--;
+    if (d->in + j > CARGS__DEC_SHIFT_MAX) return -2;
+    size_t n = d->in, moved = j < d->fn ? j : d->fn;
+    memcpy(buf, d->ip, n);
+    for (unsigned k = 0; k < j; k++) buf[n++] = k < d->fn ? d->fp[k] : '0';
+    d->ip = buf;
+    d->in = n;
+    d->fp += moved;
+    d->fn -= moved;
+    return 0;
+}
+
+/* round(d * m / k), half up, exactly. The whole part goes through long
+   division a digit at a time, keeping r < k. The fraction then adds
+   T = floor(10 * frac * m) (cargs__dec_scale's fold) before the last
+   step: q + floor((10r + T + 5k) / 10k). m <= 2^60, k < 2^32. */
+static inline int cargs__dec_ratio(
+    const cargs__dec *d, uint64_t m, uint64_t k, uint64_t *out
+) {
+    uint64_t q = 0, r = 0, t = 0;
+    for (size_t i = 0; i < d->in; i++) {
+        r = r * 10 + (uint64_t)(d->ip[i] - '0') * m;
+        uint64_t qd = r / k;
+        if (q > (UINT64_MAX - qd) / 10) return -2;
+        q = q * 10 + qd;
+        r %= k;
+    }
+    if (d->fn) {
+        for (size_t i = d->fn; --i;)
+            t = ((uint64_t)(d->fp[i] - '0') * m + t) / 10;
+        t = (uint64_t)(d->fp[0] - '0') * m + t;
+    }
+    uint64_t f = (10 * r + t + 5 * k) / (10 * k);
+    if (f > UINT64_MAX - q) return -2;
+    *out = q + f;
+    return 0;
+}
+
+static inline int cargs_read_rate(const char *s, uint64_t *out) {
+    const uint64_t sec = 1000ull * 1000 * 1000;
+    cargs__dec     d;
+    uint64_t       m, v, ns = sec;
+    char           buf[CARGS__DEC_SHIFT_MAX];
+    if (!s || !out || cargs__size_split(&s, &d, &m, false)) return -1;
+    while (*s == ' ' || *s == '\t') s++;
+    if (*s == '/') {
+        s++;
+        while (*s == ' ' || *s == '\t') s++;
+        ns = cargs__time_unit(&s);
+        if (!ns) return -1;
+        while (*s == ' ' || *s == '\t') s++;
+    }
+    if (*s) return -1;
+    /* bytes per ns-long period -> per second, from the digits as typed.
+       Sub-second periods (1, 10^3, 10^6 ns) shift the decimal point; the
+       others divide by the period in seconds */
+    int rc;
+    if (ns < sec) {
+        unsigned j = 0;
+        for (uint64_t k = ns; k < sec; k *= 10) j++;
+        rc = cargs__dec_shift(&d, j, buf);
+        if (!rc) rc = cargs__dec_scale(&d, m, &v);
+    } else {
+        rc = cargs__dec_ratio(&d, m, ns / sec, &v);
+    }
+    if (rc) return rc;
+    *out = v;
+    return 0;
+}
+/* ===== Human-readable formatting ===== */
+#define CARGS__FMT_MAX 32 /* room for any cell + NUL ("18.446744EiB/s") */
+
+/* v / div rounded half up to d fraction digits: *q whole, *f fraction. The
+   remainder stays below div <= 2^60, so r * 10 cannot overflow */
+static inline void cargs__fmt_round(
+    uint64_t v, uint64_t div, unsigned d, uint64_t *q, uint64_t *f
+) {
+    uint64_t r = v % div, p = 1;
+    *q         = v / div;
+    *f         = 0;
+    for (unsigned k = 0; k < d; k++, p *= 10) {
+        r *= 10;
+        *f = *f * 10 + r / div;
+        r %= div;
+    }
+    if (r >= div - r && ++*f == p) { /* 2r >= div */
+        *f = 0;
+        ++*q;
+    }
+}
+
+/* Digits of v, most significant first; returns the count */
+static inline size_t cargs__fmt_digits(char *out, uint64_t v, unsigned min) {
+    char   tmp[20];
+    size_t n = 0;
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v || n < min);
+    for (size_t k = 0; k < n; k++) out[k] = tmp[n - 1 - k];
+    return n;
+}
+
+/* One cell into out[CARGS__FMT_MAX]; returns its length */
+static inline size_t cargs__fmt_scaled(
+    uint64_t v, uint64_t base, const char *const *units, int decimals,
+    int dflt, const char *tail, char *out
+) {
+    unsigned dec = (unsigned)(decimals < 0 ? dflt : decimals);
+    unsigned i   = 0;
+    uint64_t div = 1, q, f;
+    if (dec > 6) dec = 6;
+    while (i < 6 && v / div >= base) {
+        div *= base;
+        i++;
+    }
+    /* decimals by the value before rounding: 9.996 is "10.00", as before */
+    unsigned d = i && v / div < 10 ? dec : 0;
+    cargs__fmt_round(v, div, d, &q, &f);
+    if (q >= base && i < 6) { /* rounded up into the next unit */
+        div *= base;
+        i++;
+        cargs__fmt_round(v, div, d = dec, &q, &f);
+    }
+    size_t n = cargs__fmt_digits(out, q, 1);
+    if (d) {
+        out[n++] = '.';
+        n += cargs__fmt_digits(out + n, f, d);
+    }
+    for (const char *u = units[i]; *u;) out[n++] = *u++;
+    for (const char *t = tail; *t;) out[n++] = *t++;
+    out[n] = '\0';
+    return n;
+}
+
+static inline size_t cargs__fmt_kind(
+    uint64_t v, cargs_fmt_kind kind, int decimals, char *out
+) {
+    static const char *const si[]  = {"B", "KB", "MB", "GB", "TB", "PB", "EB"};
+    static const char *const iec[] = {"B",   "KiB", "MiB", "GiB",
+                                      "TiB", "PiB", "EiB"};
+    static const char *const cnt[] = {"", "k", "M", "G", "T", "P", "E"};
+    switch (kind) {
+        case CARGS_FMT_COUNT:
+            return cargs__fmt_scaled(v, 1000, cnt, decimals, 1, "", out);
+        case CARGS_FMT_BYTES_IEC:
+            return cargs__fmt_scaled(v, 1024, iec, decimals, 2, "", out);
+        case CARGS_FMT_RATE_SI:
+            return cargs__fmt_scaled(v, 1000, si, decimals, 2, "/s", out);
+        case CARGS_FMT_RATE_IEC:
+            return cargs__fmt_scaled(v, 1024, iec, decimals, 2, "/s", out);
+        case CARGS_FMT_BYTES_SI:
+        default: return cargs__fmt_scaled(v, 1000, si, decimals, 2, "", out);
+    }
+}
+
+static inline char *cargs__fmt_into(
+    uint64_t v, cargs_fmt_kind kind, int decimals, char *buf, size_t bufsz
+) {
+    if (!buf || bufsz == 0) return buf;
+    char   cell[CARGS__FMT_MAX];
+    size_t n = cargs__fmt_kind(v, kind, decimals, cell);
+    if (n >= bufsz) n = bufsz - 1;
+    memcpy(buf, cell, n);
+    buf[n] = '\0';
+    return buf;
+}
+
+static inline char *cargs_fmt_bytes(
+    uint64_t bytes, char *buf, size_t bufsz, bool iec, int decimals
+) {
+    return cargs__fmt_into(
+        bytes, iec ? CARGS_FMT_BYTES_IEC : CARGS_FMT_BYTES_SI, decimals, buf,
+        bufsz
+    );
+}
+
+static inline char *cargs_fmt_count(
+    uint64_t n, char *buf, size_t bufsz, int decimals
+) {
+    return cargs__fmt_into(n, CARGS_FMT_COUNT, decimals, buf, bufsz);
+}
+
+static inline char *cargs_fmt_rate(
+    uint64_t bytes_per_sec, char *buf, size_t bufsz, bool iec, int decimals
+) {
+    return cargs__fmt_into(
+        bytes_per_sec, iec ? CARGS_FMT_RATE_IEC : CARGS_FMT_RATE_SI, decimals,
+        buf, bufsz
+    );
+}
+
+static inline size_t cargs_fmt_table(
+    const uint64_t *vals, size_t n, cargs_fmt_kind kind, int decimals,
+    char *buf, size_t cap
+) {
+    if (!vals) return 0;
+    char   cell[CARGS__FMT_MAX];
+    size_t w = 0;
+    for (size_t i = 0; i < n; i++) {
+        size_t k = cargs__fmt_kind(vals[i], kind, decimals, cell);
+        if (k > w) w = k;
+    }
+    if (!buf || cap / (w + 1) < n) return w;
+    for (size_t i = 0; i < n; i++) {
+        char  *c = buf + i * (w + 1);
+        size_t k = cargs__fmt_kind(vals[i], kind, decimals, cell);
+        memset(c, ' ', w - k);
+        memcpy(c + w - k, cell, k + 1);
+    }
+    return w;
+}
+
+/* ===== Documentation Emitters ===== */
+#define CARGS__EMIT_BUF 4096 /* stack render buffer of one emitter call */
+
+/* Command path of a page, linked from the leaf up (no depth limit) */
+typedef struct cargs__trail {
+    const char                *name;
+    const struct cargs__trail *up;
+} cargs__trail;
+
+static inline void cargs__trail_put(const cargs__trail *t, cargs_wbuf *out) {
+    if (!t) return;
+    cargs__trail_put(t->up, out);
+    cargs__wb_printf(out, " %s", t->name);
+}
+
+static inline void cargs__emit_md(
+    const cargs_env *env, const cargs_cmd *cmd, const char *prog,
+    const cargs__trail *path, size_t depth, cargs_wbuf *out
+) {
+    cargs__wb_printf(out, "%s# ", depth == 0 ? "" : "\n");
+    cargs__wb_printf(out, "%s", prog);
+    cargs__trail_put(path, out);
+    cargs__wb_putc(out, '\n');
+
+    cargs__wb_printf(out, "\n**Usage:** `");
+    cargs__wb_printf(out, "%s", prog);
+    cargs__trail_put(path, out);
+    if (cargs__has_any_options(env, cmd)) cargs__wb_puts(out, " [options]");
+    if (cmd && cmd->sub_count)
+        cargs__wb_puts(out, " <command> [command-options]");
+    cargs__pos_usage_w(out, cmd);
+    cargs__wb_puts(out, "`\n\n");
+
+    if (env && env->auto_help) {
+        cargs__wb_puts(
+            out, "### Options\n- `-h, --help` — Show this help and exit\n"
+        );
+    }
+    if (depth == 0 && env && env->auto_version && env->version) {
+        cargs__wb_printf(out, "- `-v, --version` — Show version and exit\n");
+    }
+    if (depth == 0 && env && env->auto_author && env->author) {
+        cargs__wb_printf(out, "- `--author` — Show author and exit\n");
+    }
+    if (cmd && cmd->opt_count) {
+        for (size_t i = 0; i < cmd->opt_count; i++) {
+            const cargs_opt *o = &cmd->opts[i];
+            cargs__wb_printf(out, "- `");
+            if (o->short_name) {
+                cargs__wb_printf(out, "-%c", o->short_name);
+                if (o->long_name) cargs__wb_puts(out, ", ");
+            }
+            if (o->long_name) cargs__wb_printf(out, "--%s", o->long_name);
+            if (o->arg == CARGS_ARG_REQUIRED)
+                cargs__wb_printf(out, " %s", o->metavar ? o->metavar : "VALUE");
+            if (o->arg == CARGS_ARG_OPTIONAL)
+                cargs__wb_printf(
+                    out, " [%s]", o->metavar ? o->metavar : "VALUE"
+                );
+            cargs__wb_printf(out, "` — %s\n", o->help ? o->help : "");
+        }
+    }
+
+    if (cmd && cmd->pos_count) {
+        cargs__wb_printf(out, "\n### Positionals\n");
+        for (size_t i = 0; i < cmd->pos_count; i++) {
+            const cargs_pos *p = &cmd->pos[i];
+            if (!p->name) continue;
+
+            cargs__wb_printf(out, "- **%s**", p->name);
+            if (p->desc && *p->desc) cargs__wb_printf(out, " — %s", p->desc);
+
+            if (p->min != 1 || p->max != 1) {
+                if (p->min == p->max) {
+                    cargs__wb_printf(out, " (x%u)", (unsigned)p->min);
+                } else if (p->max == CARGS_POS_INF) {
+                    cargs__wb_printf(out, " (%u..inf)", (unsigned)p->min);
+                } else {
+                    cargs__wb_printf(
+                        out, " (%u..%u)", (unsigned)p->min, (unsigned)p->max
+                    );
+                }
+            }
+            cargs__wb_putc(out, '\n');
+        }
+    }
+
+    if (cmd && cmd->sub_count) {
+        cargs__wb_printf(out, "\n### Commands\n");
+        for (size_t i = 0; i < cmd->sub_count; i++) {
+            const cargs_cmd *c = &cmd->subs[i];
+            cargs__wb_printf(out, "- **%s**", c->name ? c->name : "");
+            if (c->alias_count) {
+                cargs__wb_puts(out, " (alias: ");
+                for (size_t a = 0; a < c->alias_count; a++) {
+                    if (a) cargs__wb_puts(out, ", ");
+                    cargs__wb_puts(out, c->aliases[a]);
+                }
+                cargs__wb_putc(out, ')');
+            }
+            if (c->desc) cargs__wb_printf(out, " — %s", c->desc);
+            cargs__wb_putc(out, '\n');
+        }
+        for (size_t i2 = 0; i2 < cmd->sub_count; i2++) {
+            const cargs_cmd *c    = &cmd->subs[i2];
+            cargs__trail     next = {c->name, path};
+            cargs__emit_md(env, c, prog, &next, depth + 1, out);
+        }
+    }
+}
+
+static inline void cargs_emit_markdown(
+    const cargs_env *env, const cargs_cmd *root, const char *prog, FILE *f
+) {
+    (void)env;
+    char        buf[CARGS__EMIT_BUF];
+    cargs_wbuf  w;
+    cargs_wbuf *out = &w;
+    cargs__wb_init(out, buf, sizeof buf, f ? f : stdout);
+    cargs__emit_md(env, root, prog, NULL, 0, out);
+    cargs__wb_flush(out);
+    CARGS__STAT(env, bytes_out, out->total);
+}
+
+static inline void cargs__emit_man(
+    const cargs_env *env, const cargs_cmd *cmd, const char *prog,
+    const cargs__trail *path, size_t depth, cargs_wbuf *out
+) {
+    (void)env;
+    cargs__wb_printf(out, "\n.SH NAME\n%s", prog);
+    cargs__trail_put(path, out);
+    cargs__wb_puts(out, " - ");
+    if (cmd && cmd->desc) cargs__wb_puts(out, cmd->desc);
+    cargs__wb_putc(out, '\n');
+    cargs__wb_printf(out, ".SH SYNOPSIS\n\fB%s\fR", prog);
+    cargs__trail_put(path, out);
+    cargs__wb_puts(out, " [options]");
+    if (cmd && cmd->sub_count)
+        cargs__wb_puts(out, " <command> [command-options]");
+    cargs__pos_usage_w(out, cmd);
+    cargs__wb_puts(out, "\n");
+    if (cmd && (cmd->opt_count || (depth == 0))) {
+        cargs__wb_puts(out, ".SH OPTIONS\n");
+        if (depth == 0) {
+            cargs__wb_puts(
+                out, ".TP\n\fB-h, --help\fR\nShow this help and exit\n"
+            );
+            if (env && env->version)
+                cargs__wb_puts(
+                    out, ".TP\n\fB-v, --version\fR\nShow version and exit\n"
+                );
+            if (env && env->author)
+                cargs__wb_puts(
+                    out, ".TP\n\fB--author\fR\nShow author and exit\n"
+                );
+        }
+        for (size_t i = 0; i < cmd->opt_count; i++) {
+            const cargs_opt *o = &cmd->opts[i];
+            cargs__wb_puts(out, ".TP\n\fB");
+            if (o->short_name) {
+                cargs__wb_printf(out, "-%c", o->short_name);
+                if (o->long_name) cargs__wb_puts(out, ", ");
+            }
+            if (o->long_name) { cargs__wb_printf(out, "--%s", o->long_name); }
+            if (o->arg == CARGS_ARG_REQUIRED)
+                cargs__wb_printf(out, " %s", o->metavar ? o->metavar : "VALUE");
+            if (o->arg == CARGS_ARG_OPTIONAL)
+                cargs__wb_printf(
+                    out, "[%s]", o->metavar ? o->metavar : "VALUE"
+                );
+            cargs__wb_puts(out, "\fR\n");
+            if (o->help) cargs__wb_puts(out, o->help);
+            cargs__wb_putc(out, '\n');
+        }
+    }
+    if (cmd && cmd->pos_count) {
+        cargs__wb_puts(out, ".SH POSITIONALS\n");
+        for (size_t i = 0; i < cmd->pos_count; i++) {
+            const cargs_pos *p = &cmd->pos[i];
+            cargs__wb_puts(out, ".TP\n\fB");
+            cargs__wb_puts(out, p->name ? p->name : "ARG");
+            cargs__wb_puts(out, "\fR\nOccurrences: ");
+            if (p->min == p->max)
+                cargs__wb_printf(out, "%u\n", (unsigned)p->min);
+            else if (p->max == CARGS_POS_INF)
+                cargs__wb_printf(out, "%u..inf\n", (unsigned)p->min);
+            else
+                cargs__wb_printf(
+                    out, "%u..%u\n", (unsigned)p->min, (unsigned)p->max
+                );
+        }
+    }
+    if (cmd && cmd->sub_count) {
+        cargs__wb_puts(out, ".SH COMMANDS\n");
+        for (size_t i = 0; i < cmd->sub_count; i++) {
+            const cargs_cmd *c = &cmd->subs[i];
+            cargs__wb_puts(out, ".TP\n\fB");
+            cargs__wb_puts(out, c->name ? c->name : "");
+            if (c->alias_count) {
+                cargs__wb_puts(out, "\fR (alias: ");
+                for (size_t a = 0; a < c->alias_count; a++) {
+                    if (a) cargs__wb_puts(out, ", ");
+                    cargs__wb_puts(out, c->aliases[a]);
+                }
+                cargs__wb_puts(out, ")\n");
+            } else cargs__wb_puts(out, "\n");
+            if (c->desc) cargs__wb_puts(out, c->desc);
+            cargs__wb_putc(out, '\n');
+        }
+        for (size_t j = 0; j < cmd->sub_count; j++) {
+            const cargs_cmd *c    = &cmd->subs[j];
+            cargs__trail     next = {c->name, path};
+            cargs__emit_man(env, c, prog, &next, depth + 1, out);
+        }
+    }
+}
+
+static inline void cargs_emit_man(
+    const cargs_env *env, const cargs_cmd *root, const char *prog, FILE *f,
+    const char *section
+) {
+    char        buf[CARGS__EMIT_BUF];
+    cargs_wbuf  w;
+    cargs_wbuf *out = &w;
+    cargs__wb_init(out, buf, sizeof buf, f ? f : stdout);
+    if (!section) section = "1";
+    cargs__wb_printf(out, ".TH %s %s\n", prog, section);
+    cargs__emit_man(env, root, prog, NULL, 0, out);
+    cargs__wb_flush(out);
+    CARGS__STAT(env, bytes_out, out->total);
+}
+
+/* ===== JSON Schema ===== */
+/* One line of JSON. Every key below is always present (null, [] or 0 when
+ * unset), so a reader can rely on the shape for a given version:
+ *   {"format":"cargs-tree","version":1,"prog":..,"program_version":..,
+ *    "tree_hash":"<16 hex digits>","builtins":{"help":..,"version":..,
+ *    "author":..},"root":CMD}
+ *   CMD {"name","desc","aliases":[..],"options":[OPT],"positionals":[POS],
+ *        "relations":[REL],"commands":[CMD]}
+ *   OPT {"long","short","arg","metavar","help","env","default","group",
+ *        "policy","type","choices":[..]}
+ *   POS {"name","desc","min","max"}  (max null = unbounded)
+ *   REL {"kind","opt","other"}
+ * Bump CARGS_JSON_VERSION when a key changes meaning or goes away. */
+static inline void cargs__json_str(cargs_wbuf *out, const char *s) {
+    if (!s) {
+        cargs__wb_puts(out, "null");
+        return;
+    }
+    cargs__wb_putc(out, '"');
+    const char *run = s;
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        cargs__wb_write(out, run, (size_t)(s - run));
+        run = s + 1;
+        switch (c) {
+            case '"': cargs__wb_puts(out, "\\\""); break;
+            case '\\': cargs__wb_puts(out, "\\\\"); break;
+            case '\n': cargs__wb_puts(out, "\\n"); break;
+            case '\t': cargs__wb_puts(out, "\\t"); break;
+            default: cargs__wb_printf(out, "\\u%04x", (unsigned)c); break;
+        }
+    }
+    cargs__wb_write(out, run, (size_t)(s - run));
+    cargs__wb_putc(out, '"');
+}
+
+static inline void cargs__json_key(
+    cargs_wbuf *out, const char *key, const char *s
+) {
+    cargs__wb_printf(out, ",\"%s\":", key);
+    cargs__json_str(out, s);
+}
+
+static inline const char *cargs__json_arg(cargs_arg_kind k) {
+    switch (k) {
+        case CARGS_ARG_REQUIRED: return "required";
+        case CARGS_ARG_OPTIONAL: return "optional";
+        case CARGS_ARG_NONE: break;
+    }
+    return "none";
+}
+
+static inline const char *cargs__json_policy(uint8_t p) {
+    static const char *const names[] = {"none", "xor", "req_one", "any"};
+    return p < 4 ? names[p] : "none";
+}
+
+static inline const char *cargs__json_type(cargs_bind_kind k) {
+    static const char *const names[] = {
+        "none", "flag", "count", "int",  "u64",      "size_si",
+        "size_iec", "str", "enum", "duration", "rate",
+    };
+    return (unsigned)k < sizeof names / sizeof names[0] ? names[k] : "none";
+}
+
+static inline void cargs__json_opt(cargs_wbuf *out, const cargs_opt *o) {
+    char sn[2] = {o->short_name, '\0'};
+    cargs__wb_puts(out, "{\"long\":");
+    cargs__json_str(out, o->long_name);
+    cargs__json_key(out, "short", o->short_name ? sn : NULL);
+    cargs__wb_printf(out, ",\"arg\":\"%s\"", cargs__json_arg(o->arg));
+    cargs__json_key(out, "metavar", o->metavar);
+    cargs__json_key(out, "help", o->help);
+    cargs__json_key(out, "env", o->env);
+    cargs__json_key(out, "default", o->def);
+    cargs__wb_printf(
+        out, ",\"group\":%u,\"policy\":\"%s\",\"type\":\"%s\",\"choices\":[",
+        (unsigned)o->group, cargs__json_policy(o->group_policy),
+        cargs__json_type(o->bind.kind)
+    );
+    if (o->bind.kind == CARGS_BIND_ENUM && o->bind.choices) {
+        for (const cargs_choice *c = o->bind.choices; c->name; c++) {
+            if (c != o->bind.choices) cargs__wb_putc(out, ',');
+            cargs__json_str(out, c->name);
+        }
+    }
+    cargs__wb_puts(out, "]}");
+}
+
+static inline void cargs__json_cmd(cargs_wbuf *out, const cargs_cmd *cmd) {
+    cargs__wb_puts(out, "{\"name\":");
+    cargs__json_str(out, cmd->name && *cmd->name ? cmd->name : NULL);
+    cargs__json_key(out, "desc", cmd->desc);
+    cargs__wb_puts(out, ",\"aliases\":[");
+    for (size_t i = 0; i < cmd->alias_count; i++) {
+        if (i) cargs__wb_putc(out, ',');
+        cargs__json_str(out, cmd->aliases[i]);
+    }
+    cargs__wb_puts(out, "],\"options\":[");
+    for (size_t i = 0; i < cmd->opt_count; i++) {
+        if (i) cargs__wb_putc(out, ',');
+        cargs__json_opt(out, &cmd->opts[i]);
+    }
+    cargs__wb_puts(out, "],\"positionals\":[");
+    for (size_t i = 0; i < cmd->pos_count; i++) {
+        const cargs_pos *p = &cmd->pos[i];
+        if (i) cargs__wb_putc(out, ',');
+        cargs__wb_puts(out, "{\"name\":");
+        cargs__json_str(out, p->name);
+        cargs__json_key(out, "desc", p->desc);
+        cargs__wb_printf(out, ",\"min\":%u,\"max\":", (unsigned)p->min);
+        if (p->max == CARGS_POS_INF) cargs__wb_puts(out, "null}");
+        else cargs__wb_printf(out, "%u}", (unsigned)p->max);
+    }
+    cargs__wb_puts(out, "],\"relations\":[");
+    for (size_t i = 0; i < cmd->rel_count; i++) {
+        const cargs_rel *r = &cmd->rels[i];
+        if (i) cargs__wb_putc(out, ',');
+        cargs__wb_printf(
+            out, "{\"kind\":\"%s\"",
+            r->kind == CARGS_REL_CONFLICTS ? "conflicts" : "requires"
+        );
+        cargs__json_key(out, "opt", r->opt);
+        cargs__json_key(out, "other", r->other);
+        cargs__wb_putc(out, '}');
+    }
+    cargs__wb_puts(out, "],\"commands\":[");
+    for (size_t i = 0; i < cmd->sub_count; i++) {
+        if (i) cargs__wb_putc(out, ',');
+        cargs__json_cmd(out, &cmd->subs[i]);
+    }
+    cargs__wb_puts(out, "]}");
+}
+
+static inline void cargs_emit_json(
+    const cargs_env *env, const cargs_cmd *root, const char *prog, FILE *f
+) {
+    char        buf[CARGS__EMIT_BUF];
+    cargs_wbuf  w;
+    cargs_wbuf *out = &w;
+    cargs__wb_init(out, buf, sizeof buf, f ? f : stdout);
+    cargs__wb_printf(
+        out, "{\"format\":\"cargs-tree\",\"version\":%d", CARGS_JSON_VERSION
+    );
+    cargs__json_key(out, "prog", prog);
+    cargs__json_key(out, "program_version", env ? env->version : NULL);
+    cargs__wb_printf(
+        out, ",\"tree_hash\":\"%016llx\"",
+        (unsigned long long)cargs_tree_hash(env, root, prog)
+    );
+    cargs__wb_printf(
+        out, ",\"builtins\":{\"help\":%s,\"version\":%s,\"author\":%s}",
+        env && env->auto_help ? "true" : "false",
+        env && env->auto_version && env->version ? "true" : "false",
+        env && env->auto_author && env->author ? "true" : "false"
+    );
+    cargs__wb_puts(out, ",\"root\":");
+    if (root) cargs__json_cmd(out, root);
+    else cargs__wb_puts(out, "null");
+    cargs__wb_puts(out, "}\n");
+    cargs__wb_flush(out);
+    CARGS__STAT(env, bytes_out, out->total);
+}
+
+/* ===== Completion Generators ===== */
+/* Scripts resolve the command scope with one table lookup per word instead
+ * of case chains, so TAB cost does not grow with the tree. Scopes are
+ * numbered in preorder (root = 0); the table maps "scope/word" to the child
+ * scope, or to "+" for an option that takes the next word as its value.
+ * Candidates are precomputed per scope. With env->complete, options whose
+ * values cargs__complete() can offer map to "*" instead, and only for those
+ * does the script run "prog __complete". */
+enum { CARGS__SH_BASH, CARGS__SH_ZSH, CARGS__SH_FISH };
+
+#define CARGS__NO_SCOPE  ((size_t)-1)
+#define CARGS__DYN_SCOPE ((size_t)-2) /* "*" */
+
+/* prog as a shell variable name: anything but [A-Za-z0-9_] becomes '_' */
+static inline void cargs__emit_ident(cargs_wbuf *out, const char *s) {
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        cargs__wb_putc(out, isalnum(c) || c == '_' ? (char)c : '_');
+    }
+}
+
+/* pre and s in fish single quotes (\ and ' escaped) */
+static inline void cargs__emit_fish_sq(
+    cargs_wbuf *out, const char *pre, const char *s
+) {
+    cargs__wb_putc(out, '\'');
+    cargs__wb_puts(out, pre);
+    for (; s && *s; s++) {
+        if (*s == '\'' || *s == '\\') cargs__wb_putc(out, '\\');
+        cargs__wb_putc(out, *s);
+    }
+    cargs__wb_putc(out, '\'');
+}
+
+/* One table entry: scope/pre+word -> val (CARGS__NO_SCOPE = "+",
+   CARGS__DYN_SCOPE = "*") */
+static inline void cargs__emit_key(
+    cargs_wbuf *out, int sh, const char *prog, size_t scope, const char *pre,
+    const char *word, size_t val
+) {
+    switch (sh) {
+        case CARGS__SH_BASH:
+            cargs__wb_printf(out, "  [\"%zu/%s%s\"]=", scope, pre, word);
+            break;
+        case CARGS__SH_ZSH:
+            cargs__wb_printf(out, "  '%zu/%s%s' ", scope, pre, word);
+            break;
+        default:
+            /* fish has no associative arrays: one variable per entry, named
+               by string escape --style=var */
+            cargs__wb_puts(out, "set -g __");
+            cargs__emit_ident(out, prog);
+            cargs__wb_printf(
+                out, "_n%zu_(string escape --style=var -- ", scope
+            );
+            cargs__emit_fish_sq(out, pre, word);
+            cargs__wb_puts(out, ") ");
+            break;
+    }
+    if (val == CARGS__NO_SCOPE) cargs__wb_puts(out, "+\n");
+    else if (val == CARGS__DYN_SCOPE) cargs__wb_puts(out, "'*'\n");
+    else cargs__wb_printf(out, "%zu\n", val);
+}
+
+/* Entries leading into cmd (its name and aliases under parent) and past
+   the values of its options */
+static inline void cargs__emit_scope_keys(
+    cargs_wbuf *out, int sh, const char *prog, const cargs_env *env,
+    const cargs_cmd *cmd, size_t id, size_t parent
+) {
+    if (parent != CARGS__NO_SCOPE) {
+        if (cmd->name)
+            cargs__emit_key(out, sh, prog, parent, "", cmd->name, id);
+        for (size_t a = 0; a < cmd->alias_count; a++)
+            cargs__emit_key(out, sh, prog, parent, "", cmd->aliases[a], id);
+    }
+    for (size_t i = 0; i < cmd->opt_count; i++) {
+        const cargs_opt *o     = &cmd->opts[i];
+        char             sn[2] = {o->short_name, '\0'};
+        if (o->arg != CARGS_ARG_REQUIRED) continue;
+        size_t v = env && env->complete && cargs__opt_completes(o)
+                       ? CARGS__DYN_SCOPE
+                       : CARGS__NO_SCOPE;
+        if (o->long_name)
+            cargs__emit_key(out, sh, prog, id, "--", o->long_name, v);
+        if (o->short_name) cargs__emit_key(out, sh, prog, id, "-", sn, v);
+    }
+}
+
+/* One candidate: a bare word for bash/zsh, a word/description pair (the
+   script prints them as "word\tdesc") for fish */
+static inline void cargs__emit_cand(
+    cargs_wbuf *out, int sh, bool *first, const char *pre, const char *word,
+    const char *desc
+) {
+    if (sh != CARGS__SH_FISH) {
+        cargs__wb_printf(out, "%s%s%s", *first ? "" : " ", pre, word);
+        *first = false;
+        return;
+    }
+    cargs__wb_putc(out, ' ');
+    cargs__emit_fish_sq(out, pre, word);
+    cargs__wb_putc(out, ' ');
+    cargs__emit_fish_sq(out, "", desc);
+}
+
+static inline void cargs__emit_scope_cands(
+    cargs_wbuf *out, int sh, const char *prog, const cargs_env *env,
+    const cargs_cmd *cmd, size_t id
+) {
+    if (sh == CARGS__SH_BASH) cargs__wb_printf(out, "  [%zu]=\"", id);
+    else if (sh == CARGS__SH_ZSH) cargs__wb_puts(out, "  '");
+    else {
+        cargs__wb_puts(out, "set -g __");
+        cargs__emit_ident(out, prog);
+        cargs__wb_printf(out, "_c%zu", id);
+    }
+    bool first = true;
+    for (size_t i = 0; i < cmd->opt_count; i++) {
+        const cargs_opt *o     = &cmd->opts[i];
+        char             sn[2] = {o->short_name, '\0'};
+        if (o->long_name)
+            cargs__emit_cand(out, sh, &first, "--", o->long_name, o->help);
+        if (o->short_name) cargs__emit_cand(out, sh, &first, "-", sn, o->help);
+    }
+    cargs__emit_cand(out, sh, &first, "--", "help", "Show help");
+    cargs__emit_cand(out, sh, &first, "-", "h", "Show help");
+    if (id == 0 && env && env->auto_version && env->version) {
+        cargs__emit_cand(out, sh, &first, "--", "version", "Show version");
+        cargs__emit_cand(out, sh, &first, "-", "v", "Show version");
+    }
+    if (id == 0 && env && env->auto_author && env->author)
+        cargs__emit_cand(out, sh, &first, "--", "author", "Show author");
+    for (size_t i = 0; i < cmd->sub_count; i++) {
+        const cargs_cmd *c = &cmd->subs[i];
+        if (c->name) cargs__emit_cand(out, sh, &first, "", c->name, c->desc);
+        for (size_t a = 0; a < c->alias_count; a++)
+            cargs__emit_cand(out, sh, &first, "", c->aliases[a], c->desc);
+    }
+    cargs__wb_puts(
+        out, sh == CARGS__SH_BASH ? "\"\n" : sh == CARGS__SH_ZSH ? "'\n" : "\n"
+    );
+}
+
+/* Preorder walk writing the keys (cands = false) or candidate tables;
+   returns the number of scopes in cmd's subtree */
+static inline size_t cargs__emit_scopes(
+    cargs_wbuf *out, int sh, bool cands, const char *prog, const cargs_env *env,
+    const cargs_cmd *cmd, size_t id, size_t parent
+) {
+    if (cands) cargs__emit_scope_cands(out, sh, prog, env, cmd, id);
+    else cargs__emit_scope_keys(out, sh, prog, env, cmd, id, parent);
+    size_t n = 1;
+    for (size_t i = 0; i < cmd->sub_count; i++)
+        n += cargs__emit_scopes(
+            out, sh, cands, prog, env, &cmd->subs[i], id + n, id
+        );
+    return n;
+}
+
+/* Needs bash >= 4.2 (associative arrays, declare -g) */
+static inline void cargs_emit_completion_bash(
+    const cargs_env *env, const cargs_cmd *root, const char *prog, FILE *f
+) {
+    char        buf[CARGS__EMIT_BUF];
+    cargs_wbuf  w;
+    cargs_wbuf *out = &w;
+    cargs__wb_init(out, buf, sizeof buf, f ? f : stdout);
+    if (!prog) prog = "prog";
+    cargs__wb_puts(out, "declare -gA _");
+    cargs__emit_ident(out, prog);
+    cargs__wb_puts(out, "_next=(\n");
+    cargs__emit_scopes(
+        out, CARGS__SH_BASH, false, prog, env, root, 0, CARGS__NO_SCOPE
+    );
+    cargs__wb_puts(out, ")\ndeclare -ga _");
+    cargs__emit_ident(out, prog);
+    cargs__wb_puts(out, "_cands=(\n");
+    cargs__emit_scopes(
+        out, CARGS__SH_BASH, true, prog, env, root, 0, CARGS__NO_SCOPE
+    );
+    /* COMP_WORDS splits "--opt=value" into "--opt" "=" "value" */
+    bool dyn = env && env->complete;
+    cargs__wb_printf(
+        out,
+        ")\n\n"
+        "_%s_complete() {\n"
+        "  local cur=${COMP_WORDS[COMP_CWORD]} scope=0 i w next%s\n"
+        "  for (( i = 1; i < COMP_CWORD; i++ )); do\n"
+        "    w=${COMP_WORDS[i]}\n"
+        "    [[ $w == -- ]] && break\n"
+        "    next=${_",
+        prog, dyn ? " val a" : ""
+    );
+    cargs__emit_ident(out, prog);
+    cargs__wb_puts(out, dyn ? "_next[\"$scope/$w\"]}\n"
+              "    if [[ $next == [+*] ]]; then\n"
+              "      [[ ${COMP_WORDS[i+1]} == = ]] && (( i++ ))\n"
+              "      (( ++i >= COMP_CWORD )) && val=$next\n"
+            : "_next[\"$scope/$w\"]}\n"
+              "    if [[ $next == + ]]; then\n"
+              "      [[ ${COMP_WORDS[i+1]} == = ]] && (( i++ ))\n"
+              "      (( i++ ))\n");
+    cargs__wb_puts(out, "    elif [[ -n $next ]]; then\n"
+        "      scope=$next\n"
+        "    elif [[ $w == = ]]; then\n"
+        "      (( i++ ))\n"
+        "    elif [[ $w != -* ]]; then\n"
+        "      break\n"
+        "    fi\n"
+        "  done\n");
+    if (dyn) {
+        /* the value of a "*" option: glue the split words back together
+           and let the program answer; --opt=<TAB> leaves cur at "=" */
+        cargs__wb_puts(out, "  if [[ $val == '*' ]]; then\n"
+            "    a=()\n"
+            "    for (( i = 1; i <= COMP_CWORD; i++ )); do\n"
+            "      w=${COMP_WORDS[i]}\n"
+            "      if (( i > 1 )) && [[ $w == = || ${COMP_WORDS[i-1]} == = ]]; "
+            "then\n"
+            "        a[${#a[@]}-1]+=$w\n"
+            "      else\n"
+            "        a+=(\"$w\")\n"
+            "      fi\n"
+            "    done\n"
+            "    mapfile -t COMPREPLY < <(\"${COMP_WORDS[0]}\" __complete "
+            "\"${a[@]}\" 2>/dev/null)\n"
+            "    return\n"
+            "  fi\n");
+    }
+    cargs__wb_puts(out, "  COMPREPLY=( $(compgen -W \"${_");
+    cargs__emit_ident(out, prog);
+    cargs__wb_printf(
+        out,
+        "_cands[scope]}\" -- \"$cur\") )\n"
+        "}\n"
+        "complete -F _%s_complete %s\n",
+        prog, prog
+    );
+    cargs__wb_flush(out);
+    CARGS__STAT(env, bytes_out, out->total);
+}
+
+static inline void cargs_emit_completion_zsh(
+    const cargs_env *env, const cargs_cmd *root, const char *prog, FILE *f
+) {
+    char        buf[CARGS__EMIT_BUF];
+    cargs_wbuf  w;
+    cargs_wbuf *out = &w;
+    cargs__wb_init(out, buf, sizeof buf, f ? f : stdout);
+    if (!prog) prog = "prog";
+    cargs__wb_printf(out, "#compdef %s\n\ntypeset -gA _", prog);
+    cargs__emit_ident(out, prog);
+    cargs__wb_puts(out, "_next\n_");
+    cargs__emit_ident(out, prog);
+    cargs__wb_puts(out, "_next=(\n");
+    cargs__emit_scopes(
+        out, CARGS__SH_ZSH, false, prog, env, root, 0, CARGS__NO_SCOPE
+    );
+    cargs__wb_puts(out, ")\ntypeset -ga _");
+    cargs__emit_ident(out, prog);
+    cargs__wb_puts(out, "_cands\n_");
+    cargs__emit_ident(out, prog);
+    cargs__wb_puts(out, "_cands=(\n");
+    cargs__emit_scopes(
+        out, CARGS__SH_ZSH, true, prog, env, root, 0, CARGS__NO_SCOPE
+    );
+    bool dyn = env && env->complete;
+    cargs__wb_printf(
+        out,
+        ")\n\n"
+        "_%s() {\n"
+        "  local scope=0 i w key next%s\n"
+        "  for (( i = 2; i < CURRENT; i++ )); do\n"
+        "    w=${words[i]}\n"
+        "    [[ $w == -- ]] && break\n"
+        "    key=\"$scope/$w\"\n"
+        "    next=${_",
+        prog, dyn ? " val" : ""
+    );
+    cargs__emit_ident(out, prog);
+    cargs__wb_puts(out, dyn ? "_next[$key]}\n"
+              "    if [[ $next == [+*] ]]; then\n"
+              "      (( ++i >= CURRENT )) && val=$next\n"
+            : "_next[$key]}\n"
+              "    if [[ $next == + ]]; then\n"
+              "      (( i++ ))\n");
+    cargs__wb_puts(out, "    elif [[ -n $next ]]; then\n"
+        "      scope=$next\n"
+        "    elif [[ $w != -* ]]; then\n"
+        "      break\n"
+        "    fi\n"
+        "  done\n");
+    if (dyn) {
+        cargs__wb_puts(out, "  w=${words[CURRENT]}\n"
+            "  if [[ -z $val && $w == --*=* ]]; then\n"
+            "    val=${_");
+        cargs__emit_ident(out, prog);
+        cargs__wb_puts(out, "_next[$scope/${w%%=*}]}\n"
+            "    [[ $val == '*' ]] && compset -P '*='\n"
+            "  fi\n"
+            "  if [[ $val == '*' ]]; then\n"
+            "    compadd -- ${(f)\"$(${words[1]} __complete "
+            "\"${(@)words[2,CURRENT]}\" 2>/dev/null)\"}\n"
+            "    return\n"
+            "  fi\n");
+    }
+    cargs__wb_puts(out, "  compadd -- ${=_");
+    cargs__emit_ident(out, prog);
+    cargs__wb_printf(
+        out, "_cands[scope+1]}\n}\n\ncompdef _%s %s\n", prog, prog
+    );
+    cargs__wb_flush(out);
+    CARGS__STAT(env, bytes_out, out->total);
+}
+
+/* Needs fish >= 3.0 (string escape --style=var, math) */
+static inline void cargs_emit_completion_fish(
+    const cargs_env *env, const cargs_cmd *root, const char *prog, FILE *f
+) {
+    char        buf[CARGS__EMIT_BUF];
+    cargs_wbuf  w;
+    cargs_wbuf *out = &w;
+    cargs__wb_init(out, buf, sizeof buf, f ? f : stdout);
+    if (!prog) prog = "prog";
+    cargs__emit_scopes(
+        out, CARGS__SH_FISH, false, prog, env, root, 0, CARGS__NO_SCOPE
+    );
+    cargs__emit_scopes(
+        out, CARGS__SH_FISH, true, prog, env, root, 0, CARGS__NO_SCOPE
+    );
+    /* with env->complete, __prog_scope also prints "*" when the last word
+       is an option whose value comes from "prog __complete" */
+    bool dyn = env && env->complete;
+    cargs__wb_printf(
+        out,
+        "\n"
+        "function __%s_scope\n"
+        "    set -l tok (commandline -opc)\n"
+        "    set -l scope 0\n"
+        "    set -l i 2\n"
+        "%s"
+        "    while test $i -le (count $tok)\n"
+        "        set -l w $tok[$i]\n"
+        "        test \"$w\" = --; and break\n"
+        "        set -l v __",
+        prog, dyn ? "    set -l val\n" : ""
+    );
+    cargs__emit_ident(out, prog);
+    cargs__wb_puts(out, dyn ? "_n$scope\"_\"(string escape --style=var -- $w)\n"
+              "        if test -n \"$w\"; and set -q $v\n"
+              "            if contains -- $$v + '*'\n"
+              "                test $i -eq (count $tok); and set val $$v\n"
+              "                set i (math $i + 1)\n"
+            : "_n$scope\"_\"(string escape --style=var -- $w)\n"
+              "        if test -n \"$w\"; and set -q $v\n"
+              "            if test \"$$v\" = +\n"
+              "                set i (math $i + 1)\n");
+    cargs__wb_puts(out, "            else\n"
+        "                set scope $$v\n"
+        "            end\n"
+        "        else if not string match -q -- '-*' $w\n"
+        "            break\n"
+        "        end\n"
+        "        set i (math $i + 1)\n"
+        "    end\n");
+    cargs__wb_puts(out, dyn ? "    echo $scope\n"
+              "    contains -- '*' $val; and echo '*'\n"
+              "end\n\n"
+            : "    echo $scope\n"
+              "end\n\n");
+    if (!dyn) {
+        cargs__wb_printf(out, "function __%s_complete\n    set -l v __", prog);
+        cargs__emit_ident(out, prog);
+        cargs__wb_printf(out, "_c(__%s_scope)\n", prog);
+    } else {
+        /* --opt=<TAB> is one token: look it up, and put "--opt=" back in
+           front of the candidates */
+        cargs__wb_printf(
+            out,
+            "function __%s_complete\n"
+            "    set -l val (__%s_scope)\n"
+            "    set -l scope $val[1]\n"
+            "    set -e val[1]\n"
+            "    set -l cur (commandline -ct)\n"
+            "    set -l pre\n"
+            "    if string match -q -- '--*=*' $cur\n"
+            "        set -l k __",
+            prog, prog
+        );
+        cargs__emit_ident(out, prog);
+        cargs__wb_puts(out, "_n$scope\"_\"(string escape --style=var -- "
+            "(string replace -r '=.*' '' -- $cur))\n"
+            "        if set -q $k; and test \"$$k\" = '*'\n"
+            "            set val '*'\n"
+            "            set pre (string replace -r '=.*' '=' -- $cur)\n"
+            "        end\n"
+            "    end\n"
+            "    if contains -- '*' $val\n"
+            "        set -l tok (commandline -opc)\n"
+            "        set -l cmd $tok[1]\n"
+            "        set -e tok[1]\n"
+            "        for c in ($cmd __complete $tok $cur 2>/dev/null)\n"
+            "            echo \"$pre$c\"\n"
+            "        end\n"
+            "        return\n"
+            "    end\n"
+            "    set -l v __");
+        cargs__emit_ident(out, prog);
+        cargs__wb_puts(out, "_c$scope\n");
+    }
+    cargs__wb_printf(
+        out,
+        "    printf '%%s\\t%%s\\n' $$v\n"
+        "end\n\n"
+        "complete -c %s -a '(__%s_complete)'\n",
+        prog, prog
+    );
+    cargs__wb_flush(out);
+    CARGS__STAT(env, bytes_out, out->total);
+}
+
+/* ===== Build-time Blobs ===== */
+#define CARGS__FNV_BASIS 0xcbf29ce484222325ull
+#define CARGS__FNV_PRIME 0x100000001b3ull
+
+static inline uint64_t cargs__hash_bytes(
+    uint64_t h, const void *p, size_t n
+) {
+    const unsigned char *b = (const unsigned char *)p;
+    for (size_t i = 0; i < n; i++) {
+        h ^= b[i];
+        h *= CARGS__FNV_PRIME;
+    }
+    return h;
+}
+
+/* Strings hash with their terminator; NULL as a lone 0xff so that it
+   differs from "" */
+static inline uint64_t cargs__hash_str(uint64_t h, const char *s) {
+    if (!s) {
+        unsigned char nul = 0xff;
+        return cargs__hash_bytes(h, &nul, 1);
+    }
+    return cargs__hash_bytes(h, s, strlen(s) + 1);
+}
+
+static inline uint64_t cargs__hash_u32(uint64_t h, uint32_t v) {
+    unsigned char b[4];
+    for (int i = 0; i < 4; i++) b[i] = (unsigned char)(v >> (8 * i));
+    return cargs__hash_bytes(h, b, sizeof(b));
+}
+
+static inline uint64_t cargs__hash_cmd(uint64_t h, const cargs_cmd *c) {
+    h = cargs__hash_str(h, c->name);
+    h = cargs__hash_str(h, c->desc);
+    h = cargs__hash_u32(h, (uint32_t)c->alias_count);
+    for (size_t i = 0; i < c->alias_count; i++)
+        h = cargs__hash_str(h, c->aliases[i]);
+    h = cargs__hash_u32(h, (uint32_t)c->opt_count);
+    for (size_t i = 0; i < c->opt_count; i++) {
+        const cargs_opt *o = &c->opts[i];
+        h = cargs__hash_str(h, o->long_name);
+        h = cargs__hash_u32(
+            h, (uint32_t)(unsigned char)o->short_name
+                   | ((uint32_t)o->arg | (uint32_t)cargs__opt_completes(o) << 4)
+                         << 8
+                   | (uint32_t)o->group << 16
+                   | (uint32_t)o->group_policy << 24
+        );
+        h = cargs__hash_str(h, o->metavar);
+        h = cargs__hash_str(h, o->help);
+        h = cargs__hash_str(h, o->env);
+        h = cargs__hash_str(h, o->def);
+        h = cargs__hash_u32(h, (uint32_t)o->bind.kind);
+        if (o->bind.kind == CARGS_BIND_ENUM && o->bind.choices)
+            for (const cargs_choice *ch = o->bind.choices; ch->name; ch++)
+                h = cargs__hash_str(h, ch->name);
+    }
+    h = cargs__hash_u32(h, (uint32_t)c->rel_count);
+    for (size_t i = 0; i < c->rel_count; i++) {
+        h = cargs__hash_u32(h, c->rels[i].kind);
+        h = cargs__hash_str(h, c->rels[i].opt);
+        h = cargs__hash_str(h, c->rels[i].other);
+    }
+    h = cargs__hash_u32(h, (uint32_t)c->pos_count);
+    for (size_t i = 0; i < c->pos_count; i++) {
+        const cargs_pos *p = &c->pos[i];
+        h = cargs__hash_str(h, p->name);
+        h = cargs__hash_str(h, p->desc);
+        h = cargs__hash_u32(h, (uint32_t)p->min | (uint32_t)p->max << 16);
+    }
+    h = cargs__hash_u32(h, (uint32_t)c->sub_count);
+    for (size_t i = 0; i < c->sub_count; i++)
+        h = cargs__hash_cmd(h, &c->subs[i]);
+    return h;
+}
+
+static inline uint64_t cargs_tree_hash(
+    const cargs_env *env, const cargs_cmd *root, const char *prog
+) {
+    uint64_t h = CARGS__FNV_BASIS;
+    h = cargs__hash_u32(h, CARGS_EMIT_FORMAT);
+    h = cargs__hash_str(h, prog);
+    if (env) {
+        h = cargs__hash_u32(
+            h, (uint32_t)env->auto_help | (uint32_t)env->auto_version << 1
+                   | (uint32_t)env->auto_author << 2
+                   | (uint32_t)env->complete << 3
+        );
+        h = cargs__hash_str(h, env->version);
+        h = cargs__hash_str(h, env->author);
+    } else {
+        h = cargs__hash_str(h, NULL);
+    }
+    if (root) h = cargs__hash_cmd(h, root);
+    return h;
+}
+
+static inline void cargs__blob_render(
+    const cargs_env *env, const cargs_cmd *root, const char *prog, FILE *out,
+    cargs_blob_kind kind
+) {
+    switch (kind) {
+        case CARGS_BLOB_MARKDOWN:
+            cargs_emit_markdown(env, root, prog, out);
+            break;
+        case CARGS_BLOB_MAN: cargs_emit_man(env, root, prog, out, "1"); break;
+        case CARGS_BLOB_BASH:
+            cargs_emit_completion_bash(env, root, prog, out);
+            break;
+        case CARGS_BLOB_ZSH:
+            cargs_emit_completion_zsh(env, root, prog, out);
+            break;
+        case CARGS_BLOB_FISH:
+            cargs_emit_completion_fish(env, root, prog, out);
+            break;
+        case CARGS_BLOB_COUNT: break;
+    }
+}
+
+/* Byte n of an array initializer, 16 per line */
+static inline void cargs__blob_byte(FILE *out, int ch, size_t n) {
+    fputs(n % 16 ? "" : "\n    ", out);
+    /* '\xNN' keeps high bytes valid for a signed plain char */
+    if (ch < 0x80) fprintf(out, "%d,", ch);
+    else fprintf(out, "'\\x%02x',", (unsigned)ch);
+}
+
+/* Blobs are byte-array initializers rather than string literals: pedantic
+   compilers cap literals at 4095 bytes */
+static inline int cargs_emit_blobs(
+    const cargs_env *env, const cargs_cmd *root, const char *prog, FILE *out,
+    const char *ident
+) {
+    if (!out) out = stdout;
+    if (!ident) ident = "cargs_blobs_data";
+    uint64_t h = cargs_tree_hash(env, root, prog);
+    size_t   len[CARGS_BLOB_COUNT];
+    fprintf(
+        out,
+        "/* cargs blobs: tree 0x%016llx */\n"
+        "/* Generated by cargs_emit_blobs; do not edit. */\n",
+        (unsigned long long)h
+    );
+    for (int k = 0; k < CARGS_BLOB_COUNT; k++) {
+        FILE *tmp = tmpfile();
+        if (!tmp) return -1;
+        cargs__blob_render(env, root, prog, tmp, (cargs_blob_kind)k);
+        rewind(tmp);
+        fprintf(out, "static const char %s_%d[] = {", ident, k);
+        size_t n = 0;
+        int    ch;
+        while ((ch = fgetc(tmp)) != EOF) cargs__blob_byte(out, ch, n++);
+        fclose(tmp);
+        fprintf(out, "%s0};\n", n % 16 ? "" : "\n    ");
+        len[k] = n;
+    }
+    fprintf(out, "static const cargs_blobs %s = {\n", ident);
+    fprintf(out, "    0x%016llxull,\n    {", (unsigned long long)h);
+    for (int k = 0; k < CARGS_BLOB_COUNT; k++)
+        fprintf(out, "%s%s_%d", k ? ", " : "", ident, k);
+    fputs("},\n    {", out);
+    for (int k = 0; k < CARGS_BLOB_COUNT; k++)
+        fprintf(out, "%s%zu", k ? ", " : "", len[k]);
+    fputs("}\n};\n", out);
+    return ferror(out) ? -1 : 0;
+}
+
+static inline int cargs_write_blobs(
+    const cargs_env *env, const cargs_cmd *root, const char *prog,
+    const char *path, const char *ident
+) {
+    if (!path) return -1;
+    char  want[64], line[64];
+    FILE *f = fopen(path, "r");
+    snprintf(
+        want, sizeof(want), "/* cargs blobs: tree 0x%016llx */\n",
+        (unsigned long long)cargs_tree_hash(env, root, prog)
+    );
+    if (f) {
+        bool same = fgets(line, sizeof(line), f) && strcmp(line, want) == 0;
+        fclose(f);
+        if (same) return 1;
+    }
+    /* written beside path and renamed over it only once complete: a
+       truncated header would still carry the matching first line. The pid
+       keeps concurrent generators (parallel builds) off each other's file */
+#if defined(CARGS__POSIX)
+    unsigned long pid = (unsigned long)getpid();
+#elif defined(_WIN32)
+    unsigned long pid = (unsigned long)_getpid();
+#else
+    unsigned long pid = 0;
+#endif
+    char             local[1024], *tmp = local;
+    size_t           n   = strlen(path);
+    size_t           cap = n + 27; /* ".<pid>.tmp" with a 64-bit pid */
+    cargs_arena_mark m;
+    memset(&m, 0, sizeof m);
+    if (2 * cap > sizeof local) {
+        if (!env || !env->arena) return -1;
+        m   = cargs_arena_save(env->arena);
+        tmp = (char *)cargs_arena_alloc(env->arena, 2 * cap, 1);
+        if (!tmp) return -1;
+    }
+    char *old = tmp + cap;
+    snprintf(tmp, cap, "%s.%lu.tmp", path, pid);
+    snprintf(old, cap, "%s.%lu.old", path, pid);
+    int rc = -1;
+    f      = fopen(tmp, "w");
+    if (f) {
+        rc = cargs_emit_blobs(env, root, prog, f, ident);
+        if (fclose(f) != 0) rc = -1;
+        /* rename() does not replace an existing file on Windows: move the
+           old header aside, and back if the new one cannot take its place */
+        if (!rc && rename(tmp, path) != 0) {
+            if (rename(path, old) != 0) rc = -1;
+            else if (rename(tmp, path) != 0) {
+                rename(old, path);
+                rc = -1;
+            } else remove(old);
+        }
+        if (rc) remove(tmp);
+    }
+    if (tmp != local) cargs_arena_rewind(env->arena, m);
+    return rc;
+}
+
+static inline const cargs_blobs *cargs_blobs_check(
+    const cargs_env *env, const cargs_cmd *root, const char *prog,
+    const cargs_blobs *blobs
+) {
+    return blobs && blobs->tree_hash == cargs_tree_hash(env, root, prog)
+               ? blobs
+               : NULL;
+}
 
-    if (n < 0 || (size_t)n >= bufsz) { buf[bufsz ? bufsz - 1 : 0] = '\0'; }
-    return buf;
+static inline int cargs_emit_checked(
+    const cargs_env *env, const cargs_cmd *root, const char *prog, FILE *out,
+    const cargs_blobs *checked, cargs_blob_kind kind
+) {
+    if (!out) out = stdout;
+    if ((unsigned)kind >= CARGS_BLOB_COUNT) return 1;
+    if (checked && checked->data[kind]) {
+        fwrite(checked->data[kind], 1, checked->len[kind], out);
+        CARGS__STAT(env, bytes_out, checked->len[kind]);
+        return 0;
+    }
+    cargs__blob_render(env, root, prog, out, kind);
+    return 1;
 }
 
-/* ===== Documentation Emitters ===== */
-static inline void cargs__emit_md(
-    const cargs_env *env, const cargs_cmd *cmd, const char *prog,
-    const char *const *path, size_t depth, FILE *out
+static inline int cargs_emit_cached(
+    const cargs_env *env, const cargs_cmd *root, const char *prog, FILE *out,
+    const cargs_blobs *blobs, cargs_blob_kind kind
 ) {
-    fprintf(out, "%s# ", depth == 0 ? "" : "\n");
-    fprintf(out, "%s", prog);
-    for (size_t i = 0; i < depth; i++) fprintf(out, " %s", path[i]);
-    fputc('\n', out);
+    return cargs_emit_checked(
+        env, root, prog, out, cargs_blobs_check(env, root, prog, blobs), kind
+    );
+}
 
-    char posbuf[192];
-    cargs_render_pos_usage(posbuf, sizeof(posbuf), cmd);
+/* ===== Packed tree generator ===== */
+typedef struct {
+    cargs_packed_fns  fns;
+    cargs_packed_cmd *cmds; /* tables are NULL while counting */
+    cargs_packed_opt *opts;
+    uint32_t         *aliases;
+    cargs_packed_pos *pos;
+    cargs_packed_rel *rels;
+    char             *pool;
+    size_t cmd_n, opt_n, alias_n, pos_n, rel_n, pool_n;
+    bool   bad; /* a handler, target or choice table missing from fns */
+} cargs__pk_gen;
 
-    fprintf(out, "\n**Usage:** `");
-    fprintf(out, "%s", prog);
-    for (size_t i = 0; i < depth; i++) fprintf(out, " %s", path[i]);
-    if (cargs__has_any_options(env, cmd)) fputs(" [options]", out);
-    if (cmd && cmd->sub_count) fputs(" <command> [command-options]", out);
-    fputs(posbuf, out);
-    fputs("`\n\n", out);
+/* 1-based index of the pointer at key in tab[0..n), compared bytewise so it
+   serves function and object pointers alike; 0 and *bad if it is missing */
+static inline uint16_t cargs__pk_find(
+    const void *tab, size_t n, size_t size, const void *key, bool *bad
+) {
+    const unsigned char *t = (const unsigned char *)tab;
+    for (size_t i = 0; t && i < n && i < UINT16_MAX; i++)
+        if (memcmp(t + i * size, key, size) == 0) return (uint16_t)(i + 1);
+    *bad = true;
+    return 0;
+}
 
-    if (env && env->auto_help) {
-        fprintf(out, "### Options\n- `-h, --help` — Show this help and exit\n");
-    }
-    if (depth == 0 && env && env->auto_version && env->version) {
-        fprintf(out, "- `-v, --version` — Show version and exit\n");
-    }
-    if (depth == 0 && env && env->auto_author && env->author) {
-        fprintf(out, "- `--author` — Show author and exit\n");
-    }
-    if (cmd && cmd->opt_count) {
-        for (size_t i = 0; i < cmd->opt_count; i++) {
-            const cargs_opt *o = &cmd->opts[i];
-            fprintf(out, "- `");
-            if (o->short_name) {
-                fprintf(out, "-%c", o->short_name);
-                if (o->long_name) fputs(", ", out);
-            }
-            if (o->long_name) fprintf(out, "--%s", o->long_name);
-            if (o->arg == CARGS_ARG_REQUIRED)
-                fprintf(out, " %s", o->metavar ? o->metavar : "VALUE");
-            if (o->arg == CARGS_ARG_OPTIONAL)
-                fprintf(out, " [%s]", o->metavar ? o->metavar : "VALUE");
-            fprintf(out, "` — %s\n", o->help ? o->help : "");
-        }
-    }
+static inline uint32_t cargs__pk_put(cargs__pk_gen *g, const char *s) {
+    if (!s) return CARGS_PK_NONE;
+    size_t n = strlen(s) + 1, at = g->pool_n;
+    if (g->pool) memcpy(g->pool + at, s, n);
+    g->pool_n += n;
+    return (uint32_t)at;
+}
 
-    if (cmd && cmd->pos_count) {
-        fprintf(out, "\n### Positionals\n");
-        for (size_t i = 0; i < cmd->pos_count; i++) {
-            const cargs_pos *p = &cmd->pos[i];
-            if (!p->name) continue;
+static inline void cargs__pk_put_opt(cargs__pk_gen *g, const cargs_opt *o) {
+    const cargs_packed_fns *f = &g->fns;
+    cargs_packed_opt        po;
+    memset(&po, 0, sizeof po);
+    po.long_name  = cargs__pk_put(g, o->long_name);
+    po.metavar    = cargs__pk_put(g, o->metavar);
+    po.help       = cargs__pk_put(g, o->help);
+    po.env        = cargs__pk_put(g, o->env);
+    po.def        = cargs__pk_put(g, o->def);
+    po.short_name = o->short_name;
+    po.arg        = (uint8_t)o->arg;
+    po.group      = o->group;
+    po.group_policy = o->group_policy;
+    po.bind_kind    = (uint8_t)o->bind.kind;
+    if (o->cb)
+        po.cb = cargs__pk_find(f->cb, f->cb_count, sizeof o->cb, &o->cb,
+                               &g->bad);
+    if (o->bind.call)
+        po.call = cargs__pk_find(f->call, f->call_count, sizeof o->bind.call,
+                                 &o->bind.call, &g->bad);
+    if (o->bind.target)
+        po.target = cargs__pk_find(f->target, f->target_count,
+                                   sizeof o->bind.target, &o->bind.target,
+                                   &g->bad);
+    if (o->bind.choices)
+        po.choices = cargs__pk_find(f->choices, f->choices_count,
+                                    sizeof o->bind.choices,
+                                    &o->bind.choices, &g->bad);
+    if (o->bind.complete)
+        po.complete = cargs__pk_find(f->complete, f->complete_count,
+                                     sizeof o->bind.complete,
+                                     &o->bind.complete, &g->bad);
+    if (g->opts) g->opts[g->opt_n] = po;
+    g->opt_n++;
+}
 
-            fprintf(out, "- **%s**", p->name);
-            if (p->desc && *p->desc) fprintf(out, " — %s", p->desc);
+/* Append c's record (its subcommands start at node first_sub) */
+static inline void cargs__pk_node(
+    cargs__pk_gen *g, const cargs_cmd *c, size_t first_sub
+) {
+    const cargs_packed_fns *f = &g->fns;
+    cargs_packed_cmd        pc;
+    memset(&pc, 0, sizeof pc);
+    pc.name        = cargs__pk_put(g, c->name);
+    pc.desc        = cargs__pk_put(g, c->desc);
+    pc.first_opt   = (uint32_t)g->opt_n;
+    pc.first_sub   = (uint32_t)first_sub;
+    pc.first_alias = (uint32_t)g->alias_n;
+    pc.first_pos   = (uint32_t)g->pos_n;
+    pc.first_rel   = (uint32_t)g->rel_n;
+    pc.opt_count   = (uint32_t)c->opt_count;
+    pc.sub_count   = (uint32_t)c->sub_count;
+    pc.alias_count = (uint32_t)c->alias_count;
+    pc.pos_count   = (uint32_t)c->pos_count;
+    pc.rel_count   = (uint32_t)c->rel_count;
+    if (c->run)
+        pc.run = cargs__pk_find(f->run, f->run_count, sizeof c->run, &c->run,
+                                &g->bad);
+    if (c->pos_batch)
+        pc.pos_batch = cargs__pk_find(f->pos_batch, f->pos_batch_count,
+                                      sizeof c->pos_batch, &c->pos_batch,
+                                      &g->bad);
+    size_t w  = cargs__pres_widest(NULL, c, true);
+    pc.widest = (uint16_t)(w < UINT16_MAX ? w : UINT16_MAX);
 
-            if (p->min != 1 || p->max != 1) {
-                if (p->min == p->max) {
-                    fprintf(out, " (x%u)", (unsigned)p->min);
-                } else if (p->max == CARGS_POS_INF) {
-                    fprintf(out, " (%u..inf)", (unsigned)p->min);
-                } else {
-                    fprintf(
-                        out, " (%u..%u)", (unsigned)p->min, (unsigned)p->max
-                    );
-                }
-            }
-            fputc('\n', out);
-        }
+    for (size_t a = 0; a < c->alias_count; a++) {
+        uint32_t off = cargs__pk_put(g, c->aliases[a]);
+        if (g->aliases) g->aliases[g->alias_n] = off;
+        g->alias_n++;
     }
-
-    if (cmd && cmd->sub_count) {
-        fprintf(out, "\n### Commands\n");
-        for (size_t i = 0; i < cmd->sub_count; i++) {
-            const cargs_cmd *c = &cmd->subs[i];
-            fprintf(out, "- **%s**", c->name ? c->name : "");
-            if (c->alias_count) {
-                fputs(" (alias: ", out);
-                for (size_t a = 0; a < c->alias_count; a++) {
-                    if (a) fputs(", ", out);
-                    fputs(c->aliases[a], out);
-                }
-                fputc(')', out);
-            }
-            if (c->desc) fprintf(out, " — %s", c->desc);
-            fputc('\n', out);
-        }
-        for (size_t i2 = 0; i2 < cmd->sub_count; i2++) {
-            const cargs_cmd *c = &cmd->subs[i2];
-            const char      *newpath[16];
-            for (size_t k = 0; k < depth; k++) newpath[k] = path[k];
-            newpath[depth] = c->name;
-            cargs__emit_md(env, c, prog, newpath, depth + 1, out);
-        }
+    for (size_t k = 0; k < c->opt_count; k++) cargs__pk_put_opt(g, &c->opts[k]);
+    for (size_t k = 0; k < c->pos_count; k++) {
+        cargs_packed_pos pp;
+        pp.name = cargs__pk_put(g, c->pos[k].name);
+        pp.desc = cargs__pk_put(g, c->pos[k].desc);
+        pp.min  = c->pos[k].min;
+        pp.max  = c->pos[k].max;
+        if (g->pos) g->pos[g->pos_n] = pp;
+        g->pos_n++;
+    }
+    for (size_t k = 0; k < c->rel_count; k++) {
+        cargs_packed_rel pr;
+        memset(&pr, 0, sizeof pr);
+        pr.kind  = c->rels[k].kind;
+        pr.opt   = cargs__pk_put(g, c->rels[k].opt);
+        pr.other = cargs__pk_put(g, c->rels[k].other);
+        if (g->rels) g->rels[g->rel_n] = pr;
+        g->rel_n++;
     }
+    if (g->cmds) g->cmds[g->cmd_n] = pc;
+    g->cmd_n++;
 }
 
-static inline void cargs_emit_markdown(
-    const cargs_env *env, const cargs_cmd *root, const char *prog, FILE *out
-) {
-    (void)env;
-    if (!out) out = stdout;
-    const char *empty[1] = {0};
-    cargs__emit_md(env, root, prog, empty, 0, out);
+static inline size_t cargs__pk_size(const cargs_cmd *c) {
+    size_t n = 1;
+    for (size_t i = 0; i < c->sub_count; i++) n += cargs__pk_size(&c->subs[i]);
+    return n;
 }
 
-static inline void cargs__emit_man(
-    const cargs_env *env, const cargs_cmd *cmd, const char *prog,
-    const char *const *path, size_t depth, FILE *out
+/* c's subcommands are nodes first.., then each one's descendants in turn;
+   records come out in node order */
+static inline void cargs__pk_block(
+    cargs__pk_gen *g, const cargs_cmd *c, size_t first
 ) {
-    (void)env;
-    fprintf(out, "\n.SH NAME\n%s", prog);
-    for (size_t i = 0; i < depth; i++) fprintf(out, " %s", path[i]);
-    fputs(" - ", out);
-    if (cmd && cmd->desc) fputs(cmd->desc, out);
-    fputc('\n', out);
-    fprintf(out, ".SH SYNOPSIS\n\fB%s\fR", prog);
-    for (size_t i = 0; i < depth; i++) fprintf(out, " %s", path[i]);
-    fputs(" [options]", out);
-    if (cmd && cmd->sub_count) fputs(" <command> [command-options]", out);
-    char pbuf[192];
-    cargs_render_pos_usage(pbuf, sizeof(pbuf), cmd);
-    fputs(pbuf, out);
-    fputs("\n", out);
-    if (cmd && (cmd->opt_count || (depth == 0))) {
-        fputs(".SH OPTIONS\n", out);
-        if (depth == 0) {
-            fputs(".TP\n\fB-h, --help\fR\nShow this help and exit\n", out);
-            if (env && env->version)
-                fputs(".TP\n\fB-v, --version\fR\nShow version and exit\n", out);
-            if (env && env->author)
-                fputs(".TP\n\fB--author\fR\nShow author and exit\n", out);
-        }
-        for (size_t i = 0; i < cmd->opt_count; i++) {
-            const cargs_opt *o = &cmd->opts[i];
-            fputs(".TP\n\fB", out);
-            if (o->short_name) {
-                fprintf(out, "-%c", o->short_name);
-                if (o->long_name) fputs(", ", out);
-            }
-            if (o->long_name) { fprintf(out, "--%s", o->long_name); }
-            if (o->arg == CARGS_ARG_REQUIRED)
-                fprintf(out, " %s", o->metavar ? o->metavar : "VALUE");
-            if (o->arg == CARGS_ARG_OPTIONAL)
-                fprintf(out, "[%s]", o->metavar ? o->metavar : "VALUE");
-            fputs("\fR\n", out);
-            if (o->help) fputs(o->help, out);
-            fputc('\n', out);
-        }
-    }
-    if (cmd && cmd->pos_count) {
-        fputs(".SH POSITIONALS\n", out);
-        for (size_t i = 0; i < cmd->pos_count; i++) {
-            const cargs_pos *p = &cmd->pos[i];
-            fputs(".TP\n\fB", out);
-            fputs(p->name ? p->name : "ARG", out);
-            fputs("\fR\nOccurrences: ", out);
-            if (p->min == p->max) fprintf(out, "%u\n", (unsigned)p->min);
-            else if (p->max == CARGS_POS_INF)
-                fprintf(out, "%u..inf\n", (unsigned)p->min);
-            else fprintf(out, "%u..%u\n", (unsigned)p->min, (unsigned)p->max);
-        }
+    size_t next = first + c->sub_count;
+    for (size_t i = 0; i < c->sub_count; i++) {
+        cargs__pk_node(g, &c->subs[i], next);
+        next += cargs__pk_size(&c->subs[i]) - 1;
     }
-    if (cmd && cmd->sub_count) {
-        fputs(".SH COMMANDS\n", out);
-        for (size_t i = 0; i < cmd->sub_count; i++) {
-            const cargs_cmd *c = &cmd->subs[i];
-            fputs(".TP\n\fB", out);
-            fputs(c->name ? c->name : "", out);
-            if (c->alias_count) {
-                fputs("\fR (alias: ", out);
-                for (size_t a = 0; a < c->alias_count; a++) {
-                    if (a) fputs(", ", out);
-                    fputs(c->aliases[a], out);
-                }
-                fputs(")\n", out);
-            } else fputs("\n", out);
-            if (c->desc) fputs(c->desc, out);
-            fputc('\n', out);
-        }
-        for (size_t j = 0; j < cmd->sub_count; j++) {
-            const cargs_cmd *c = &cmd->subs[j];
-            const char      *newpath[16];
-            for (size_t k = 0; k < depth; k++) newpath[k] = path[k];
-            newpath[depth] = c->name;
-            cargs__emit_man(env, c, prog, newpath, depth + 1, out);
-        }
+    next = first + c->sub_count;
+    for (size_t i = 0; i < c->sub_count; i++) {
+        cargs__pk_block(g, &c->subs[i], next);
+        next += cargs__pk_size(&c->subs[i]) - 1;
     }
 }
 
-static inline void cargs_emit_man(
-    const cargs_env *env, const cargs_cmd *root, const char *prog, FILE *out,
-    const char *section
+static inline void cargs__pk_pass(cargs__pk_gen *g, const cargs_cmd *root) {
+    g->cmd_n = g->opt_n = g->alias_n = g->pos_n = g->rel_n = g->pool_n = 0;
+    cargs__pk_node(g, root, 1);
+    cargs__pk_block(g, root, 1);
+}
+
+/* Table sizes of f in cargs_packed.fn_counts order (f may be NULL) */
+static inline void cargs__pk_fn_counts(
+    const cargs_packed_fns *f, size_t out[CARGS_PK_FN_TABLES]
 ) {
-    if (!out) out = stdout;
-    if (!section) section = "1";
-    fprintf(out, ".TH %s %s\n", prog, section);
-    const char *empty[1] = {0};
-    cargs__emit_man(env, root, prog, empty, 0, out);
+    memset(out, 0, CARGS_PK_FN_TABLES * sizeof *out);
+    if (!f) return;
+    out[0] = f->cb_count;
+    out[1] = f->call_count;
+    out[2] = f->run_count;
+    out[3] = f->pos_batch_count;
+    out[4] = f->target_count;
+    out[5] = f->choices_count;
+    out[6] = f->complete_count;
 }
 
-/* ===== Completion Generators ===== */
-static inline void cargs__emit_bash_level(
-    const cargs_env *env, const cargs_cmd *cmd, const char *pathname,
-    const char *prog, FILE *out
+static inline const cargs_packed *cargs_pack(
+    const cargs_cmd *root, const cargs_packed_fns *fns, cargs_arena *arena
 ) {
-    (void)env;
-    (void)prog;
-    fprintf(
-        out, "  case \"$scope\" in\n    %s)\n      candidates=\"", pathname
+    if (!root) return NULL;
+    size_t counts[CARGS_PK_FN_TABLES];
+    cargs__pk_fn_counts(fns, counts);
+    for (size_t t = 0; t < CARGS_PK_FN_TABLES; t++)
+        if (counts[t] >= UINT32_MAX) return NULL;
+    cargs__pk_gen g;
+    memset(&g, 0, sizeof g);
+    if (fns) g.fns = *fns;
+    cargs__pk_pass(&g, root); /* count */
+    if (g.bad || g.pool_n >= UINT32_MAX || g.cmd_n >= UINT32_MAX ||
+        g.opt_n >= UINT32_MAX || g.alias_n >= UINT32_MAX ||
+        g.pos_n >= UINT32_MAX || g.rel_n >= UINT32_MAX)
+        return NULL;
+
+    cargs_arena_mark m  = cargs_arena_save(arena);
+    cargs_packed    *pk = (cargs_packed *)cargs_arena_alloc(
+        arena, sizeof *pk, sizeof(uint64_t)
     );
-    if (cmd) {
-        for (size_t i = 0; i < cmd->opt_count; i++) {
-            const cargs_opt *o = &cmd->opts[i];
-            if (o->long_name) { fprintf(out, "--%s ", o->long_name); }
-            if (o->short_name) { fprintf(out, "-%c ", o->short_name); }
-        }
-    }
-    fputs("--help -h ", out);
-    if (cmd) {
-        for (size_t i = 0; i < cmd->sub_count; i++) {
-            const cargs_cmd *c = &cmd->subs[i];
-            if (c->name) { fprintf(out, "%s ", c->name); }
-            for (size_t a = 0; a < c->alias_count; a++) {
-                fprintf(out, "%s ", c->aliases[a]);
-            }
-        }
+    g.cmds    = (cargs_packed_cmd *)cargs_arena_alloc(
+        arena, g.cmd_n * sizeof *g.cmds, sizeof(uint64_t)
+    );
+    g.opts    = (cargs_packed_opt *)cargs_arena_alloc(
+        arena, g.opt_n * sizeof *g.opts, sizeof(uint64_t)
+    );
+    g.aliases = (uint32_t *)cargs_arena_alloc(
+        arena, g.alias_n * sizeof *g.aliases, sizeof(uint64_t)
+    );
+    g.pos     = (cargs_packed_pos *)cargs_arena_alloc(
+        arena, g.pos_n * sizeof *g.pos, sizeof(uint64_t)
+    );
+    g.rels    = (cargs_packed_rel *)cargs_arena_alloc(
+        arena, g.rel_n * sizeof *g.rels, sizeof(uint64_t)
+    );
+    g.pool    = (char *)cargs_arena_alloc(arena, g.pool_n + 1, 1);
+    if (!pk || !g.cmds || !g.opts || !g.aliases || !g.pos || !g.rels ||
+        !g.pool) {
+        cargs_arena_rewind(arena, m);
+        return NULL;
     }
-    fputs("\"\n      ;;\n  esac\n", out);
+    cargs__pk_pass(&g, root); /* fill */
+    g.pool[g.pool_n] = '\0';
+
+    pk->format      = CARGS_PACKED_FORMAT;
+    pk->tree_hash   = cargs_tree_hash(NULL, root, NULL);
+    for (size_t t = 0; t < CARGS_PK_FN_TABLES; t++)
+        pk->fn_counts[t] = (uint32_t)counts[t];
+    pk->pool        = g.pool;
+    pk->pool_len    = (uint32_t)g.pool_n;
+    pk->cmds        = g.cmds;
+    pk->cmd_count   = (uint32_t)g.cmd_n;
+    pk->opts        = g.opt_n ? g.opts : NULL;
+    pk->opt_count   = (uint32_t)g.opt_n;
+    pk->aliases     = g.alias_n ? g.aliases : NULL;
+    pk->alias_count = (uint32_t)g.alias_n;
+    pk->pos         = g.pos_n ? g.pos : NULL;
+    pk->pos_count   = (uint32_t)g.pos_n;
+    pk->rels        = g.rel_n ? g.rels : NULL;
+    pk->rel_count   = (uint32_t)g.rel_n;
+    return pk;
 }
 
-static inline void cargs__emit_bash_tree(
-    const cargs_env *env, const cargs_cmd *cmd, const char *prog,
-    const char *path_so_far, FILE *out
+/* "a, b, c" with CARGS_PK_NONE spelled out */
+/* ".field = value" for each of names[0..n) */
+static inline void cargs__pk_row(
+    FILE *out, const char *const *names, const uint32_t *v, size_t n
 ) {
-    char path[256];
-    snprintf(path, sizeof(path), "%s", path_so_far);
-    cargs__emit_bash_level(env, cmd, path[0] ? path : "root", prog, out);
-    for (size_t i = 0; i < cmd->sub_count; i++) {
-        char child[256];
-        if (path[0])
-            snprintf(
-                child, sizeof(child), "%s_%s", path,
-                cmd->subs[i].name ? cmd->subs[i].name : ""
-            );
-        else
-            snprintf(
-                child, sizeof(child), "%s",
-                cmd->subs[i].name ? cmd->subs[i].name : ""
-            );
-        cargs__emit_bash_tree(env, &cmd->subs[i], prog, child, out);
+    for (size_t i = 0; i < n; i++) {
+        fprintf(out, "%s.%s = ", i ? ", " : "", names[i]);
+        if (v[i] == CARGS_PK_NONE) fputs("CARGS_PK_NONE", out);
+        else fprintf(out, "%lu", (unsigned long)v[i]);
     }
 }
 
-static inline void cargs_emit_completion_bash(
-    const cargs_env *env, const cargs_cmd *root, const char *prog, FILE *out
+/* Opening line of table <ident>_<name>; empty tables are left out (C has
+   no zero-length arrays) */
+static inline void cargs__pk_table(
+    FILE *out, const char *type, const char *ident, const char *name,
+    uint32_t n
+) {
+    if (n) fprintf(out, "static const %s %s_%s[] = {\n", type, ident, name);
+}
+
+static inline int cargs_emit_packed(
+    const cargs_packed *pk, FILE *out, const char *ident
 ) {
+    if (!pk) return -1;
     if (!out) out = stdout;
-    if (!prog) prog = "prog";
+    if (!ident) ident = "cargs_packed_tree";
     fprintf(
         out,
-        "_%s_complete() {\n"
-        "  local cur prev words cword\n"
-        "  _init_completion -n : 2>/dev/null || {\n"
-        "    cur=\"${COMP_WORDS[COMP_CWORD]}\"\n"
-        "  }\n"
-        "  local scope=root\n"
-        "  local i=1 w\n"
-        "  while [[ $i -lt ${#COMP_WORDS[@]} ]]; do\n"
-        "    w=${COMP_WORDS[$i]}\n"
-        "    case \"$scope\" in\n"
-        "      root)\n",
-        prog
+        "/* cargs packed tree 0x%016llx */\n"
+        "/* Generated by cargs_emit_packed; do not edit. */\n",
+        (unsigned long long)pk->tree_hash
     );
+    fprintf(out, "static const char %s_pool[] = {", ident);
+    for (uint32_t i = 0; i < pk->pool_len; i++)
+        cargs__blob_byte(out, (unsigned char)pk->pool[i], i);
+    fprintf(out, "%s0};\n", pk->pool_len % 16 ? "" : "\n    ");
 
-    /* root resolver */
-    fprintf(out, "        case \"$w\" in\n");
-    for (size_t i = 0; i < root->sub_count; i++) {
-        const cargs_cmd *c = &root->subs[i];
-        if (c->name)
-            fprintf(out, "          %s) scope=%s; ;;\n", c->name, c->name);
-        for (size_t a = 0; a < c->alias_count; a++)
-            fprintf(
-                out, "          %s) scope=%s; ;;\n", c->aliases[a],
-                c->name ? c->name : ""
-            );
+    static const char *const cmd_f[] = {
+        "name",      "desc",        "first_opt", "first_sub", "first_alias",
+        "first_pos", "first_rel",   "opt_count", "sub_count", "alias_count",
+        "pos_count", "rel_count",   "run",       "pos_batch", "widest",
+    };
+    cargs__pk_table(out, "cargs_packed_cmd", ident, "cmds", pk->cmd_count);
+    for (uint32_t i = 0; i < pk->cmd_count; i++) {
+        const cargs_packed_cmd *c    = &pk->cmds[i];
+        const uint32_t          v[]  = {
+            c->name,        c->desc,        c->first_opt, c->first_sub,
+            c->first_alias, c->first_pos,   c->first_rel, c->opt_count,
+            c->sub_count,   c->alias_count, c->pos_count, c->rel_count,
+            c->run,         c->pos_batch,   c->widest,
+        };
+        fputs("    {", out);
+        cargs__pk_row(out, cmd_f, v, sizeof v / sizeof v[0]);
+        fputs("},\n", out);
     }
-    fprintf(
-        out,
-        "          --*) ;;\n          *) break ;;\n        esac\n        ;;\n"
-    );
+    if (pk->cmd_count) fputs("};\n", out);
 
-    /* nested resolvers */
-    for (size_t i = 0; i < root->sub_count; i++) {
-        const cargs_cmd *c = &root->subs[i];
-        if (!c->name) continue;
-        fprintf(out, "      %s)\n        case \"$w\" in\n", c->name);
-        for (size_t j = 0; j < c->sub_count; j++) {
-            const cargs_cmd *s = &c->subs[j];
-            if (!s->name) continue;
-            fprintf(
-                out, "          %s) scope=%s_%s; ;;\n", s->name, c->name,
-                s->name
-            );
-            for (size_t a = 0; a < s->alias_count; a++)
-                fprintf(
-                    out, "          %s) scope=%s_%s; ;;\n", s->aliases[a],
-                    c->name, s->name
-                );
-        }
-        fprintf(
-            out,
-            "          --*) ;;\n          *) break ;;\n        esac\n        "
-            ";;\n"
+    static const char *const opt_f[] = {
+        "long_name", "metavar", "help",   "env",     "def",
+        "cb",        "call",    "target", "choices", "complete",
+    };
+    static const char *const opt_g[] = {"arg", "group", "group_policy",
+                                        "bind_kind"};
+    cargs__pk_table(out, "cargs_packed_opt", ident, "opts", pk->opt_count);
+    for (uint32_t i = 0; i < pk->opt_count; i++) {
+        const cargs_packed_opt *o   = &pk->opts[i];
+        const uint32_t          v[] = {
+            o->long_name, o->metavar, o->help,   o->env,     o->def,
+            o->cb,        o->call,    o->target, o->choices, o->complete,
+        };
+        const uint32_t w[] = {o->arg, o->group, o->group_policy,
+                              o->bind_kind};
+        unsigned char  sc  = (unsigned char)o->short_name;
+        fputs("    {", out);
+        cargs__pk_row(out, opt_f, v, sizeof v / sizeof v[0]);
+        if (sc < 0x80) fprintf(out, ", .short_name = %d, ", sc);
+        else fprintf(out, ", .short_name = '\\x%02x', ", (unsigned)sc);
+        cargs__pk_row(out, opt_g, w, sizeof w / sizeof w[0]);
+        fputs("},\n", out);
+    }
+    if (pk->opt_count) fputs("};\n", out);
+
+    cargs__pk_table(out, "uint32_t", ident, "aliases", pk->alias_count);
+    for (uint32_t i = 0; i < pk->alias_count; i++) {
+        if (pk->aliases[i] == CARGS_PK_NONE) fputs("    CARGS_PK_NONE,\n", out);
+        else fprintf(out, "    %lu,\n", (unsigned long)pk->aliases[i]);
+    }
+    if (pk->alias_count) fputs("};\n", out);
+
+    static const char *const pos_f[] = {"name", "desc", "min", "max"};
+    cargs__pk_table(out, "cargs_packed_pos", ident, "pos", pk->pos_count);
+    for (uint32_t i = 0; i < pk->pos_count; i++) {
+        const cargs_packed_pos *p   = &pk->pos[i];
+        const uint32_t          v[] = {p->name, p->desc, p->min, p->max};
+        fputs("    {", out);
+        cargs__pk_row(out, pos_f, v, sizeof v / sizeof v[0]);
+        fputs("},\n", out);
+    }
+    if (pk->pos_count) fputs("};\n", out);
+
+    static const char *const rel_f[] = {"kind", "opt", "other"};
+    cargs__pk_table(out, "cargs_packed_rel", ident, "rels", pk->rel_count);
+    for (uint32_t i = 0; i < pk->rel_count; i++) {
+        const cargs_packed_rel *r   = &pk->rels[i];
+        const uint32_t          v[] = {r->kind, r->opt, r->other};
+        fputs("    {", out);
+        cargs__pk_row(out, rel_f, v, sizeof v / sizeof v[0]);
+        fputs("},\n", out);
+    }
+    if (pk->rel_count) fputs("};\n", out);
+
+    fprintf(out, "static const cargs_packed %s = {\n", ident);
+    fprintf(out, "    .format = %d,\n", CARGS_PACKED_FORMAT);
+    fprintf(out, "    .tree_hash = 0x%016llxull,\n",
+            (unsigned long long)pk->tree_hash);
+    fputs("    .fn_counts = {", out);
+    for (size_t t = 0; t < CARGS_PK_FN_TABLES; t++)
+        fprintf(out, "%s%lu", t ? ", " : "", (unsigned long)pk->fn_counts[t]);
+    fputs("},\n", out);
+    fprintf(out, "    .pool = %s_pool,\n    .pool_len = %lu,\n", ident,
+            (unsigned long)pk->pool_len);
+    static const char *const names[] = {"cmds", "opts", "aliases", "pos",
+                                        "rels"};
+    static const char *const count_f[] = {"cmd_count", "opt_count",
+                                          "alias_count", "pos_count",
+                                          "rel_count"};
+    const uint32_t counts[] = {pk->cmd_count, pk->opt_count, pk->alias_count,
+                               pk->pos_count, pk->rel_count};
+    for (size_t t = 0; t < 5; t++) {
+        if (counts[t])
+            fprintf(out, "    .%s = %s_%s,\n    .%s = %lu,\n", names[t],
+                    ident, names[t], count_f[t], (unsigned long)counts[t]);
+        else
+            fprintf(out, "    .%s = NULL,\n    .%s = 0,\n", names[t],
+                    count_f[t]);
+    }
+    fputs("};\n", out);
+    return ferror(out) ? -1 : 0;
+}
+
+static inline int cargs_dispatch_packed(
+    const cargs_env *env, const cargs_packed *pk, const cargs_packed_fns *fns,
+    int argc, char **argv, void *user
+) {
+    if (!pk || !pk->cmd_count || !argv || argc <= 0)
+        return CARGS_ERR_BAD_FORMAT;
+    if (pk->format != CARGS_PACKED_FORMAT) {
+        cargs__errf(
+            env, "Packed tree: format %lu, expected %d (regenerate it)\n",
+            (unsigned long)pk->format, CARGS_PACKED_FORMAT
         );
+        return CARGS_ERR_BAD_FORMAT;
     }
+    static const char *const tables[] = {
+        "cb", "call", "run", "pos_batch", "target", "choices", "complete",
+    };
+    size_t have[CARGS_PK_FN_TABLES];
+    cargs__pk_fn_counts(fns, have);
+    for (size_t t = 0; t < CARGS_PK_FN_TABLES; t++) {
+        if (have[t] == pk->fn_counts[t]) continue;
+        cargs__errf(env,
+                    "Packed tree: fns->%s has %zu entries, it was generated "
+                    "with %lu (regenerate it)\n",
+                    tables[t], have[t], (unsigned long)pk->fn_counts[t]);
+        return CARGS_ERR_BAD_FORMAT;
+    }
+    cargs_env      e;
+    cargs__pk_walk pw;
+    cargs__walk    walk;
+    cargs_arena    own;
+    uint64_t       local[CARGS__PK_LOCAL / sizeof(uint64_t)];
+    if (env) e = *env;
+    else memset(&e, 0, sizeof e);
+    memset(&pw, 0, sizeof pw);
+    pw.pk = pk;
+    if (fns) pw.fns = *fns;
+    pw.arena = e.arena;
+    if (!pw.arena) {
+        cargs_arena_init(&own, local, sizeof local);
+        pw.arena = &own;
+    }
+    cargs_arena_mark m  = cargs_arena_save(pw.arena);
+    int              rc = CARGS_OK;
+    const cargs_cmd *root = cargs__pk_level(&pw, 0, &rc);
+    if (root) {
+        memset(&walk, 0, sizeof walk);
+        walk.packed = &pw;
+        e.index     = NULL;
+        e.config    = NULL;
+        e.walk_     = &walk;
+        rc          = cargs__dispatch_at(&e, root, NULL, argc, argv, user);
+    } else {
+        rc = cargs__pk_fail(&e, rc, 0);
+    }
+    cargs_arena_rewind(pw.arena, m);
+    return rc;
+}
 
-    fputs("    esac\n    i=$((i+1))\n  done\n\n  local candidates=\"\"\n", out);
+/* ===== Config files ===== */
+#define CARGS__CFG_MAGIC "cargscf2"
 
-    cargs__emit_bash_tree(env, root, prog, "", out);
+/* Snapshot file (native byte order: it caches a file for one machine): the
+   header, count records sorted by ordinal, then the NUL-terminated values */
+typedef struct {
+    char     magic[8];
+    uint64_t shape; /* cargs__cfg_shape() of the tree */
+    uint64_t src_size;
+    int64_t  src_mtime;
+    int64_t  src_mtime_ns; /* 0 where stat has no nanoseconds */
+    uint64_t total;        /* snapshot size in bytes */
+    uint64_t count;
+} cargs__cfg_head;
 
-    fputs(
-        "  COMPREPLY=( $(compgen -W \"$candidates\" -- \"$cur\") )\n}\n", out
-    );
-    fprintf(out, "complete -F _%s_complete %s\n", prog, prog);
+typedef struct {
+    uint32_t ordinal; /* option number, preorder over the tree */
+    uint32_t off;     /* value offset in the string area */
+} cargs__cfg_rec;
+
+typedef struct {
+    const cargs_env    *env;
+    const char         *path;
+    cargs_config_entry *tab;
+    uint32_t            mask;
+    size_t              count;
+    size_t              line;
+    /* snapshot walks */
+    uint32_t    ordinal;
+    const char *recs, *strs;
+    size_t      nrec, k, slen;
+    FILE       *out;
+} cargs__cfg_ctx;
+
+static inline size_t cargs__cfg_opts(const cargs_cmd *cmd) {
+    size_t n = cmd->opt_count;
+    for (size_t i = 0; i < cmd->sub_count; i++)
+        n += cargs__cfg_opts(&cmd->subs[i]);
+    return n;
 }
 
-static inline void cargs_emit_completion_zsh(
-    const cargs_env *env, const cargs_cmd *root, const char *prog, FILE *out
+static inline size_t cargs__cfg_slots(const cargs_cmd *root) {
+    size_t n = 2 * cargs__cfg_opts(root), slots = 4;
+    while (slots < n) slots <<= 1;
+    return slots;
+}
+
+static inline size_t cargs_config_size(const cargs_cmd *root) {
+    if (!root) return 0;
+    return sizeof(void *) + cargs__cfg_slots(root) * sizeof(cargs_config_entry);
+}
+
+static inline uint32_t cargs__cfg_slot(
+    const cargs_config_entry *tab, uint32_t mask, const cargs_opt *opt
 ) {
-    (void)env;
-    if (!out) out = stdout;
-    if (!prog) prog = "prog";
-    fprintf(
-        out,
-        "#compdef %s\n\n_%s() {\n  local -a candidates\n  local context state "
-        "state_descr line\n  typeset -A opt_args\n  local -a "
-        "words=(${=words})\n  local cur=${words[-1]}\n  local scope=root\n  "
-        "local i=2 w\n  while (( i <= $#words )); do\n    w=${words[i]}\n    "
-        "case $scope in\n      root)\n",
-        prog, prog
+    uint32_t i = (uint32_t)((uintptr_t)opt >> 3) * 2654435761u & mask;
+    while (tab[i].opt && tab[i].opt != opt) i = (i + 1) & mask;
+    return i;
+}
+
+static inline const char *cargs_config_get(
+    const cargs_config *cfg, const cargs_opt *opt
+) {
+    if (!cfg || !cfg->entries || !opt) return NULL;
+    return cfg->entries[cargs__cfg_slot(cfg->entries, cfg->mask, opt)].value;
+}
+
+static inline void cargs__cfg_set(
+    cargs__cfg_ctx *c, const cargs_opt *opt, const char *value
+) {
+    cargs_config_entry *e = &c->tab[cargs__cfg_slot(c->tab, c->mask, opt)];
+    if (!e->opt) c->count++;
+    e->opt   = opt;
+    e->value = value;
+}
+
+/* What the snapshot's ordinals depend on: names and option counts */
+static inline uint64_t cargs__cfg_shape(uint64_t h, const cargs_cmd *cmd) {
+    h = cargs__hash_str(h, cmd->name);
+    h = cargs__hash_u32(h, (uint32_t)cmd->opt_count);
+    for (size_t i = 0; i < cmd->opt_count; i++)
+        h = cargs__hash_str(h, cmd->opts[i].long_name);
+    h = cargs__hash_u32(h, (uint32_t)cmd->sub_count);
+    for (size_t i = 0; i < cmd->sub_count; i++)
+        h = cargs__cfg_shape(h, &cmd->subs[i]);
+    return h;
+}
+
+static inline void cargs_config_close(cargs_config *cfg) {
+    if (!cfg) return;
+#ifdef CARGS__HAVE_MMAP
+    if (cfg->map) munmap(cfg->map, cfg->map_len);
+#endif
+    cfg->map     = NULL;
+    cfg->map_len = 0;
+}
+
+static inline int cargs__cfg_err(
+    const cargs__cfg_ctx *c, int rc, const char *what, const char *s, size_t n
+) {
+    cargs__errf(
+        c->env, "Config '%s' line %zu: %s '%.*s'\n", c->path, c->line, what,
+        (int)n, s
     );
+    return rc;
+}
 
-    for (size_t i = 0; i < root->sub_count; i++) {
-        const cargs_cmd *c = &root->subs[i];
-        if (c->name)
-            fprintf(
-                out, "        [[ $w == %s ]] && scope=%s\n", c->name, c->name
-            );
-        for (size_t a = 0; a < c->alias_count; a++)
-            fprintf(
-                out, "        [[ $w == %s ]] && scope=%s\n", c->aliases[a],
-                c->name ? c->name : ""
-            );
-    }
-    fputs("        ;;\n", out);
-
-    for (size_t i = 0; i < root->sub_count; i++) {
-        const cargs_cmd *c = &root->subs[i];
-        if (!c->name) continue;
-        fprintf(out, "      %s)\n", c->name);
-        for (size_t j = 0; j < c->sub_count; j++) {
-            const cargs_cmd *s = &c->subs[j];
-            if (!s->name) continue;
-            fprintf(
-                out, "        [[ $w == %s ]] && scope=%s_%s\n", s->name,
-                c->name, s->name
-            );
-            for (size_t a = 0; a < s->alias_count; a++)
-                fprintf(
-                    out, "        [[ $w == %s ]] && scope=%s_%s\n",
-                    s->aliases[a], c->name, s->name
-                );
+static inline bool cargs__cfg_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/* [a b c]: walk the path from root (names, aliases; through env->index
+   when it was built for root); words split in place */
+static inline int cargs__cfg_section(
+    cargs__cfg_ctx *c, const cargs_cmd *root, char *s, size_t n,
+    const cargs_cmd **cmd, const cargs_index_node **nd
+) {
+    size_t words = 0;
+    if (cargs__split_words(s, n, &words))
+        return cargs__cfg_err(c, CARGS_ERR_BAD_FORMAT, "unterminated quote in",
+                              s, n);
+    const cargs_cmd        *at = root;
+    const cargs_index_node *ix = cargs__root_node(c->env, root);
+    const char             *w  = s;
+    for (size_t k = 0; k < words; k++, w += strlen(w) + 1) {
+        bool             amb = false;
+        const cargs_cmd *sub = ix ? cargs__ix_find_sub(ix, w, false, &amb, NULL)
+                                  : cargs__find_sub(at, w, NULL);
+        if (!sub)
+            return cargs__cfg_err(c, CARGS_ERR_UNKNOWN, "unknown command", w,
+                                  strlen(w));
+        if (ix) {
+            size_t k2 = ix->first_sub + (size_t)(sub - at->subs);
+            ix        = &c->env->index->nodes[k2];
         }
-        fputs("        ;;\n", out);
+        at = sub;
     }
+    *cmd = at;
+    *nd  = ix;
+    return CARGS_OK;
+}
 
-    fputs("    esac\n    (( i++ ))\n  done\n\n  case $scope in\n", out);
-
-    /* root candidates */
-    fputs("  root)\n    candidates=(", out);
-    if (root) {
-        for (size_t i = 0; i < root->opt_count; i++) {
-            const cargs_opt *o = &root->opts[i];
-            if (o->long_name) { fprintf(out, "--%s ", o->long_name); }
-            if (o->short_name) { fprintf(out, "-%c ", o->short_name); }
+/* One pass over buf[0..n) (buf[n] writable): keys resolve to options of the
+   current section, values are tokenized where they lie */
+static inline int cargs__cfg_parse(
+    cargs__cfg_ctx *c, const cargs_cmd *root, char *buf, size_t n
+) {
+    const cargs_cmd        *cmd = root;
+    const cargs_index_node *nd  = cargs__root_node(c->env, root);
+    char                   *p = buf, *end = buf + n;
+    if (n >= 3 && memcmp(buf, "\xef\xbb\xbf", 3) == 0) p += 3; /* BOM */
+    while (p < end) {
+        char *eol = (char *)memchr(p, '\n', (size_t)(end - p));
+        if (!eol) eol = end;
+        char *a = p, *b = eol;
+        p = eol + 1;
+        c->line++;
+        while (a < b && cargs__cfg_blank(*a)) a++;
+        while (b > a && cargs__cfg_blank(b[-1])) b--;
+        if (a == b || *a == '#' || *a == ';') continue;
+        size_t len = (size_t)(b - a);
+        if (*a == '[') {
+            if (b[-1] != ']' || len < 2)
+                return cargs__cfg_err(c, CARGS_ERR_BAD_FORMAT,
+                                      "expected [section] in", a, len);
+            int rc = cargs__cfg_section(c, root, a + 1, len - 2, &cmd, &nd);
+            if (rc) return rc;
+            continue;
         }
+        char *eq = (char *)memchr(a, '=', len);
+        if (!eq || eq == a)
+            return cargs__cfg_err(c, CARGS_ERR_BAD_FORMAT,
+                                  "expected key = value in", a, len);
+        char *k = eq;
+        while (k > a && cargs__cfg_blank(k[-1])) k--;
+        const cargs_opt *o =
+            nd ? cargs__ix_find_long(nd, a, (size_t)(k - a), NULL)
+               : cargs__find_long(
+                     cmd->opts, cmd->opt_count, a, (size_t)(k - a), NULL
+                 );
+        if (!o)
+            return cargs__cfg_err(c, CARGS_ERR_UNKNOWN, "unknown option", a,
+                                  (size_t)(k - a));
+        char  *v     = eq + 1;
+        size_t vlen  = (size_t)(b - v), words = 0;
+        int    split = cargs__split_words(v, vlen, &words);
+        if (split || words > 1)
+            return cargs__cfg_err(
+                c, CARGS_ERR_BAD_FORMAT,
+                split ? "unterminated quote in" : "one word per value (quote "
+                                                  "it) for",
+                a, (size_t)(k - a)
+            );
+        if (!words) v[0] = '\0';
+        cargs__cfg_set(c, o, v);
     }
-    fputs("--help -h ", out);
-    for (size_t i = 0; i < root->sub_count; i++) {
-        const cargs_cmd *c = &root->subs[i];
-        if (c->name) fprintf(out, "%s ", c->name);
-        for (size_t a = 0; a < c->alias_count; a++)
-            fprintf(out, "%s ", c->aliases[a]);
+    return CARGS_OK;
+}
+
+/* Resolve snapshot records (sorted by ordinal) in one preorder walk */
+static inline bool cargs__cfg_resolve(
+    cargs__cfg_ctx *c, const cargs_cmd *cmd
+) {
+    for (size_t i = 0; i < cmd->opt_count; i++, c->ordinal++) {
+        if (c->k == c->nrec) return true;
+        cargs__cfg_rec r;
+        memcpy(&r, c->recs + c->k * sizeof r, sizeof r);
+        if (r.ordinal < c->ordinal || r.off >= c->slen) return false;
+        if (r.ordinal != c->ordinal) continue;
+        cargs__cfg_set(c, &cmd->opts[i], c->strs + r.off);
+        c->k++;
     }
-    fputs(")\n    compadd $candidates\n    ;;\n", out);
+    for (size_t i = 0; i < cmd->sub_count; i++)
+        if (!cargs__cfg_resolve(c, &cmd->subs[i])) return false;
+    return true;
+}
 
-    for (size_t i = 0; i < root->sub_count; i++) {
-        const cargs_cmd *c = &root->subs[i];
-        if (!c->name) continue;
-        fprintf(out, "  %s)\n    candidates=(", c->name);
-        for (size_t k = 0; k < c->opt_count; k++) {
-            const cargs_opt *o = &c->opts[k];
-            if (o->long_name) { fprintf(out, "--%s ", o->long_name); }
-            if (o->short_name) { fprintf(out, "-%c ", o->short_name); }
-        }
-        fputs("--help -h ", out);
-        for (size_t j = 0; j < c->sub_count; j++) {
-            const cargs_cmd *s = &c->subs[j];
-            if (s->name) fprintf(out, "%s ", s->name);
-            for (size_t a = 0; a < s->alias_count; a++)
-                fprintf(out, "%s ", s->aliases[a]);
+static inline bool cargs__cfg_snap_load(
+    cargs__cfg_ctx *c, cargs_config *cfg, const cargs_cmd *root,
+    const char *snapshot, const cargs__cfg_head *want, cargs_arena *arena
+) {
+    cargs_arena_mark m   = cargs_arena_save(arena);
+    const char      *why = NULL;
+    cargs__file      f;
+    cargs__cfg_head  h;
+    if (cargs__file_load(&f, snapshot, arena, &why)) {
+        cargs_arena_rewind(arena, m);
+        return false;
+    }
+    cfg->map     = f.map;
+    cfg->map_len = f.map_len;
+    char  *data  = f.data;
+    size_t len   = f.len;
+    if (len < sizeof h) goto stale;
+    memcpy(&h, data, sizeof h);
+    if (memcmp(h.magic, want->magic, sizeof h.magic) || h.shape != want->shape
+        || h.src_size != want->src_size || h.src_mtime != want->src_mtime
+        || h.src_mtime_ns != want->src_mtime_ns || h.total != len
+        || h.count > (len - sizeof h) / sizeof(cargs__cfg_rec))
+        goto stale;
+    c->nrec = (size_t)h.count;
+    c->recs = data + sizeof h;
+    c->strs = c->recs + c->nrec * sizeof(cargs__cfg_rec);
+    c->slen = len - sizeof h - c->nrec * sizeof(cargs__cfg_rec);
+    if (c->nrec && (!c->slen || c->strs[c->slen - 1])) goto stale;
+    if (cargs__cfg_resolve(c, root) && c->k == c->nrec) return true;
+stale:
+    cargs_config_close(cfg);
+    cargs_arena_rewind(arena, m);
+    memset(c->tab, 0, (size_t)(c->mask + 1) * sizeof *c->tab);
+    c->count = 0;
+    return false;
+}
+
+/* Snapshot writer: the records, then (values) the strings they point at */
+static inline void cargs__cfg_snap_walk(
+    cargs__cfg_ctx *c, const cargs_cmd *cmd, bool values
+) {
+    for (size_t i = 0; i < cmd->opt_count; i++, c->ordinal++) {
+        const cargs_opt *o = &cmd->opts[i];
+        const char      *v = c->tab[cargs__cfg_slot(c->tab, c->mask, o)].value;
+        if (!v) continue;
+        size_t n = strlen(v) + 1;
+        if (values) {
+            fwrite(v, 1, n, c->out);
+        } else {
+            cargs__cfg_rec r = {c->ordinal, (uint32_t)c->slen};
+            fwrite(&r, sizeof r, 1, c->out);
         }
-        fputs(")\n    compadd $candidates\n    ;;\n", out);
+        c->slen += n;
     }
+    for (size_t i = 0; i < cmd->sub_count; i++)
+        cargs__cfg_snap_walk(c, &cmd->subs[i], values);
+}
 
-    fputs("  esac\n}\n\ncompdef _", out);
-    fputs(prog, out);
-    fputs(" ", out);
-    fputs(prog, out);
-    fputc('\n', out);
+/* Best effort: a snapshot that cannot be written is simply not used. The
+   header goes out first with total 0, so a torn file never validates. */
+static inline void cargs__cfg_snap_write(
+    cargs__cfg_ctx *c, const cargs_cmd *root, const char *snapshot,
+    cargs__cfg_head h
+) {
+    FILE *f = fopen(snapshot, "wb");
+    if (!f) return;
+    c->out      = f;
+    c->ordinal  = 0;
+    c->slen     = 0;
+    h.count     = c->count;
+    bool ok     = fwrite(&h, sizeof h, 1, f) == 1;
+    cargs__cfg_snap_walk(c, root, false);
+    size_t slen = c->slen;
+    c->ordinal  = 0;
+    cargs__cfg_snap_walk(c, root, true);
+    h.total = sizeof h + c->count * sizeof(cargs__cfg_rec) + slen;
+    ok      = ok && slen <= UINT32_MAX && !ferror(f)
+         && fseek(f, 0, SEEK_SET) == 0 && fwrite(&h, sizeof h, 1, f) == 1;
+    if (fclose(f) != 0 || !ok) remove(snapshot);
 }
 
-static inline void cargs_emit_completion_fish(
-    const cargs_env *env, const cargs_cmd *root, const char *prog, FILE *out
+static inline int cargs_config_load(
+    cargs_config *cfg, const cargs_env *env, const cargs_cmd *root,
+    const char *path, const char *snapshot, cargs_arena *arena
 ) {
-    if (!out) out = stdout;
-    if (!prog) prog = "prog";
-    (void)env;
-    /* Root subcommands */
-    for (size_t i = 0; i < root->sub_count; i++) {
-        const cargs_cmd *c = &root->subs[i];
-        fprintf(
-            out, "complete -c %s -n '__fish_use_subcommand' -a '%s' -d '%s'\n",
-            prog, c->name ? c->name : "", c->desc ? c->desc : ""
-        );
-        for (size_t a = 0; a < c->alias_count; a++) {
-            fprintf(
-                out,
-                "complete -c %s -n '__fish_use_subcommand' -a '%s' -d '%s'\n",
-                prog, c->aliases[a], c->desc ? c->desc : ""
-            );
+    if (!cfg) return CARGS_ERR_RESPONSE;
+    memset(cfg, 0, sizeof *cfg);
+    if (!root || !path || !arena) return CARGS_ERR_RESPONSE;
+    cargs_arena_mark m     = cargs_arena_save(arena);
+    size_t           slots = cargs__cfg_slots(root);
+    cargs__cfg_ctx   c;
+    memset(&c, 0, sizeof c);
+    c.env  = env;
+    c.path = path;
+    c.tab  = (cargs_config_entry *)cargs_arena_alloc(
+        arena, slots * sizeof *c.tab, sizeof(void *));
+    c.mask = (uint32_t)(slots - 1);
+    if (!c.tab) {
+        cargs__errf(env, "Config '%s': arena exhausted (%zu bytes needed)\n",
+                    path, cargs_config_size(root));
+        return CARGS_ERR_RESPONSE;
+    }
+    memset(c.tab, 0, slots * sizeof *c.tab);
+    cfg->entries = c.tab;
+    cfg->mask    = c.mask;
+
+    /* The snapshot is only trusted when the source still has the size and
+       mtime (nanoseconds where stat has them) it was built from */
+    bool            stamped = false;
+    cargs__cfg_head want;
+    memset(&want, 0, sizeof want);
+#ifdef CARGS__POSIX
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        if (errno == ENOENT) {
+            cfg->entries = NULL;
+            cargs_arena_rewind(arena, m);
+            return 1;
         }
+    } else {
+        memcpy(want.magic, CARGS__CFG_MAGIC, sizeof want.magic);
+        want.shape     = cargs__cfg_shape(CARGS__FNV_BASIS, root);
+        want.src_size  = (uint64_t)st.st_size;
+        want.src_mtime = (int64_t)st.st_mtime;
+#    ifdef CARGS__MTIME_NS
+        want.src_mtime_ns = (int64_t)CARGS__MTIME_NS(st);
+#    endif
+        stamped        = snapshot != NULL;
     }
-    /* Root options */
-    for (size_t i = 0; i < root->opt_count; i++) {
-        const cargs_opt *o = &root->opts[i];
-        if (o->long_name)
-            fprintf(
-                out, "complete -c %s -l %s -d '%s'\n", prog, o->long_name,
-                o->help ? o->help : ""
-            );
-        if (o->short_name)
-            fprintf(
-                out, "complete -c %s -s %c -d '%s'\n", prog, o->short_name,
-                o->help ? o->help : ""
-            );
+#endif
+    if (stamped
+        && cargs__cfg_snap_load(&c, cfg, root, snapshot, &want, arena)) {
+        cfg->count         = c.count;
+        cfg->from_snapshot = true;
+        return CARGS_OK;
     }
-    fprintf(out, "complete -c %s -s h -l help -d 'Show help'\n", prog);
-    /* Nested subcommands */
-    for (size_t i = 0; i < root->sub_count; i++) {
-        const cargs_cmd *c = &root->subs[i];
-        for (size_t j = 0; j < c->sub_count; j++) {
-            const cargs_cmd *s = &c->subs[j];
-            fprintf(
-                out,
-                "complete -c %s -n '__fish_seen_subcommand_from %s' -a '%s' -d "
-                "'%s'\n",
-                prog, c->name ? c->name : "", s->name ? s->name : "",
-                s->desc ? s->desc : ""
-            );
-        }
-        for (size_t k = 0; k < c->opt_count; k++) {
-            const cargs_opt *o = &c->opts[k];
-            if (o->long_name)
-                fprintf(
-                    out,
-                    "complete -c %s -n '__fish_seen_subcommand_from %s' -l %s "
-                    "-d '%s'\n",
-                    prog, c->name ? c->name : "", o->long_name,
-                    o->help ? o->help : ""
-                );
-            if (o->short_name)
-                fprintf(
-                    out,
-                    "complete -c %s -n '__fish_seen_subcommand_from %s' -s %c "
-                    "-d '%s'\n",
-                    prog, c->name ? c->name : "", o->short_name,
-                    o->help ? o->help : ""
-                );
-        }
+
+    const char *why = NULL;
+    cargs__file f;
+    int         rc = cargs__file_load(&f, path, arena, &why);
+    if (!rc) {
+        cfg->map     = f.map;
+        cfg->map_len = f.map_len;
+        rc           = cargs__cfg_parse(&c, root, f.data, f.len);
+    } else if (rc < 0) {
+        cargs__errf(env, "Config '%s': %s\n", path, why);
+        rc = CARGS_ERR_RESPONSE;
     }
+    if (rc) {
+        cargs_config_close(cfg);
+        cfg->entries = NULL;
+        cargs_arena_rewind(arena, m);
+        return rc;
+    }
+    cfg->count = c.count;
+    if (stamped) cargs__cfg_snap_write(&c, root, snapshot, want);
+    return CARGS_OK;
 }
 
 #ifdef __cplusplus
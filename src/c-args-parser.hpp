@@ -0,0 +1,447 @@
+/* SPDX-License-Identifier: MIT */
+
+/*
+ * C++20 companion for c-args-parser.h: constexpr builders for cargs_opt /
+ * cargs_cmd trees, compile-time schema validation, and the compiled lookup
+ * index generated as constant data (no cargs_compile() at startup).
+ *
+ *   inline constexpr cargs_opt root_opts[] = {
+ *       cargs::opt("jobs", 'j').required("N").help("Workers").cb(on_jobs),
+ *   };
+ *   inline constexpr cargs_cmd root = cargs::cmd().opts(root_opts).run(fn);
+ *   static_assert(cargs::validate(root));
+ *   env.index = &cargs::compiled<root>::index;
+ */
+
+#ifndef CARGS_HPP
+#define CARGS_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "c-args-parser.h"
+
+namespace cargs {
+
+/* ===== Builders ===== */
+
+struct opt {
+    cargs_opt o{};
+
+    constexpr opt(const char *long_name, char short_name = 0) {
+        o.long_name  = long_name;
+        o.short_name = short_name;
+    }
+    constexpr explicit opt(char short_name) { o.short_name = short_name; }
+
+    constexpr opt required(const char *metavar = nullptr) const {
+        opt c       = *this;
+        c.o.arg     = CARGS_ARG_REQUIRED;
+        c.o.metavar = metavar;
+        return c;
+    }
+    constexpr opt optional(const char *metavar = nullptr) const {
+        opt c       = *this;
+        c.o.arg     = CARGS_ARG_OPTIONAL;
+        c.o.metavar = metavar;
+        return c;
+    }
+    constexpr opt help(const char *text) const {
+        opt c    = *this;
+        c.o.help = text;
+        return c;
+    }
+    constexpr opt cb(cargs_cb fn) const {
+        opt c  = *this;
+        c.o.cb = fn;
+        return c;
+    }
+    constexpr opt env(const char *var, const char *def = nullptr) const {
+        opt c   = *this;
+        c.o.env = var;
+        c.o.def = def;
+        return c;
+    }
+    constexpr opt def(const char *value) const {
+        opt c   = *this;
+        c.o.def = value;
+        return c;
+    }
+    constexpr opt group(uint8_t id, uint8_t policy) const {
+        opt c            = *this;
+        c.o.group        = id;
+        c.o.group_policy = policy;
+        return c;
+    }
+    constexpr opt bind(cargs_bind_kind kind, void *target) const {
+        opt c           = *this;
+        c.o.bind.kind   = kind;
+        c.o.bind.target = target;
+        return c;
+    }
+    constexpr opt bind_enum(int *target, const cargs_choice *choices) const {
+        opt c            = bind(CARGS_BIND_ENUM, target);
+        c.o.bind.choices = choices;
+        return c;
+    }
+    constexpr opt call(cargs_call fn) const {
+        opt c         = *this;
+        c.o.bind.call = fn;
+        return c;
+    }
+    constexpr opt complete(cargs_completer fn) const {
+        opt c             = *this;
+        c.o.bind.complete = fn;
+        return c;
+    }
+    constexpr operator cargs_opt() const { return o; }
+};
+
+struct cmd {
+    cargs_cmd c{};
+
+    constexpr cmd(const char *name = nullptr, const char *desc = nullptr) {
+        c.name = name;
+        c.desc = desc;
+    }
+
+    template <std::size_t N>
+    constexpr cmd opts(const cargs_opt (&a)[N]) const {
+        cmd r         = *this;
+        r.c.opts      = a;
+        r.c.opt_count = N;
+        return r;
+    }
+    template <std::size_t N>
+    constexpr cmd subs(const cargs_cmd (&a)[N]) const {
+        cmd r         = *this;
+        r.c.subs      = a;
+        r.c.sub_count = N;
+        return r;
+    }
+    template <std::size_t N>
+    constexpr cmd aliases(const char *const (&a)[N]) const {
+        cmd r           = *this;
+        r.c.aliases     = a;
+        r.c.alias_count = N;
+        return r;
+    }
+    template <std::size_t N>
+    constexpr cmd pos(const cargs_pos (&a)[N]) const {
+        cmd r         = *this;
+        r.c.pos       = a;
+        r.c.pos_count = N;
+        return r;
+    }
+    template <std::size_t N>
+    constexpr cmd rels(const cargs_rel (&a)[N]) const {
+        cmd r         = *this;
+        r.c.rels      = a;
+        r.c.rel_count = N;
+        return r;
+    }
+    constexpr cmd run(int (*fn)(int, char **, void *)) const {
+        cmd r   = *this;
+        r.c.run = fn;
+        return r;
+    }
+    constexpr operator cargs_cmd() const { return c; }
+};
+
+/* ===== Compile-time validation ===== */
+
+/* Which built-ins the runtime cargs_env enables (they reserve names). */
+struct checks {
+    bool auto_help    = true;
+    bool auto_version = true;
+    bool auto_author  = true;
+};
+
+/* Depth of the path[] buffer in cargs_dispatch. */
+inline constexpr std::size_t max_depth = 16;
+
+namespace detail {
+
+/* Not constexpr on purpose: reaching one of these during constant evaluation
+   makes validate() ill-formed, and the compiler names the failed rule. */
+inline bool error_duplicate_short_name() { return false; }
+inline bool error_duplicate_long_name() { return false; }
+inline bool error_duplicate_subcommand_name() { return false; }
+inline bool error_group_id_above_63() { return false; }
+inline bool error_conflicting_group_policy() { return false; }
+inline bool error_clashes_with_auto_help() { return false; }
+inline bool error_clashes_with_auto_version() { return false; }
+inline bool error_clashes_with_auto_author() { return false; }
+inline bool error_nesting_deeper_than_16() { return false; }
+inline bool error_too_many_options() { return false; }
+inline bool error_too_many_relations() { return false; }
+inline bool error_unknown_relation_option() { return false; }
+
+constexpr bool streq(const char *a, const char *b) {
+    if (!a || !b) return false;
+    while (*a && *a == *b) a++, b++;
+    return *a == *b;
+}
+
+constexpr std::size_t slen(const char *s) {
+    std::size_t n = 0;
+    while (s[n]) n++;
+    return n;
+}
+
+/* Mirrors cargs__rel_opt: long name, then a one-letter short name */
+constexpr bool has_rel_opt(const cargs_cmd &c, const char *name) {
+    if (!name) return false;
+    for (std::size_t i = 0; i < c.opt_count; i++) {
+        const cargs_opt &o = c.opts[i];
+        if (streq(o.long_name, name)) return true;
+        if (name[0] && !name[1] && o.short_name == name[0]) return true;
+    }
+    return false;
+}
+
+constexpr bool validate_level(
+    const cargs_cmd &c, std::size_t depth, const checks &chk
+) {
+    if (depth > max_depth) return error_nesting_deeper_than_16();
+    if (c.opt_count > 0xffff) return error_too_many_options();
+    if (c.rel_count > CARGS_REL_MAX) return error_too_many_relations();
+    for (std::size_t r = 0; r < c.rel_count; r++)
+        if (!has_rel_opt(c, c.rels[r].opt) || !has_rel_opt(c, c.rels[r].other))
+            return error_unknown_relation_option();
+    for (std::size_t i = 0; i < c.opt_count; i++) {
+        const cargs_opt &o = c.opts[i];
+        if (o.group > CARGS_GROUP_MAX) return error_group_id_above_63();
+        if (chk.auto_help) {
+            if (o.short_name == 'h' || streq(o.long_name, "help"))
+                return error_clashes_with_auto_help();
+        }
+        if (depth == 0 && chk.auto_version) {
+            if (o.short_name == 'v' || streq(o.long_name, "version"))
+                return error_clashes_with_auto_version();
+        }
+        if (depth == 0 && chk.auto_author && streq(o.long_name, "author"))
+            return error_clashes_with_auto_author();
+        for (std::size_t j = 0; j < i; j++) {
+            const cargs_opt &p = c.opts[j];
+            if (o.short_name && o.short_name == p.short_name)
+                return error_duplicate_short_name();
+            if (streq(o.long_name, p.long_name))
+                return error_duplicate_long_name();
+            if (o.group && o.group == p.group && o.group_policy &&
+                p.group_policy && o.group_policy != p.group_policy)
+                return error_conflicting_group_policy();
+        }
+    }
+    for (std::size_t i = 0; i < c.sub_count; i++) {
+        const cargs_cmd &s = c.subs[i];
+        for (std::size_t j = 0; j < c.sub_count; j++) {
+            const cargs_cmd &t = c.subs[j];
+            if (j < i && streq(s.name, t.name))
+                return error_duplicate_subcommand_name();
+            for (std::size_t a = 0; a < t.alias_count; a++) {
+                if (j != i && streq(s.name, t.aliases[a]))
+                    return error_duplicate_subcommand_name();
+                for (std::size_t b = 0; j < i && b < s.alias_count; b++)
+                    if (streq(s.aliases[b], t.aliases[a]))
+                        return error_duplicate_subcommand_name();
+            }
+        }
+        if (!validate_level(s, depth + 1, chk)) return false;
+    }
+    return true;
+}
+
+} // namespace detail
+
+/* true for a valid tree; otherwise not a constant expression, so
+   static_assert(cargs::validate(root)) fails naming the broken rule. */
+constexpr bool validate(const cargs_cmd &root, checks chk = {}) {
+    return detail::validate_level(root, 0, chk);
+}
+
+/* ===== Compile-time lookup index ===== */
+
+namespace detail {
+
+/* Mirrors cargs__hash and cargs__ix_long_slots in c-args-parser.h */
+constexpr uint32_t fnv1a(const char *s, std::size_t n) {
+    uint32_t h = 2166136261u;
+    for (std::size_t i = 0; i < n; i++) {
+        h ^= static_cast<unsigned char>(s[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+constexpr std::size_t long_slots(const cargs_cmd &c) {
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < c.opt_count; i++)
+        if (c.opts[i].long_name) n++;
+    if (!n) return 0;
+    std::size_t slots = 2;
+    while (slots < 2 * n) slots <<= 1;
+    return slots;
+}
+
+constexpr std::size_t count_nodes(const cargs_cmd &c) {
+    std::size_t n = 1;
+    for (std::size_t i = 0; i < c.sub_count; i++) n += count_nodes(c.subs[i]);
+    return n;
+}
+
+constexpr std::size_t count_slots(const cargs_cmd &c) {
+    std::size_t n = long_slots(c);
+    for (std::size_t i = 0; i < c.sub_count; i++) n += count_slots(c.subs[i]);
+    return n;
+}
+
+/* Subcommand names and aliases of c (one node's name table) */
+constexpr std::size_t sub_names(const cargs_cmd &c) {
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < c.sub_count; i++) {
+        if (c.subs[i].name) n++;
+        for (std::size_t a = 0; a < c.subs[i].alias_count; a++)
+            if (c.subs[i].aliases[a]) n++;
+    }
+    return n;
+}
+
+constexpr std::size_t count_names(const cargs_cmd &c) {
+    std::size_t n = sub_names(c);
+    for (std::size_t i = 0; i < c.sub_count; i++) n += count_names(c.subs[i]);
+    return n;
+}
+
+/* Mirrors cargs__ix_name_less: strcmp order, then sub */
+constexpr bool name_less(const cargs_index_name &a, const cargs_index_name &b) {
+    const char *x = a.name, *y = b.name;
+    while (*x && *x == *y) x++, y++;
+    auto cx = static_cast<unsigned char>(*x);
+    auto cy = static_cast<unsigned char>(*y);
+    return cx < cy || (cx == cy && a.sub < b.sub);
+}
+
+/* Mirrors cargs__group_plan */
+constexpr cargs_group_plan group_plan(const cargs_cmd &c) {
+    cargs_group_plan p{};
+    for (std::size_t i = 0; i < c.opt_count; i++) {
+        const cargs_opt &o = c.opts[i];
+        if (!o.group || o.group > CARGS_GROUP_MAX) continue;
+        uint64_t bit = uint64_t{1} << o.group;
+        if (o.group_policy == CARGS_GRP_XOR) p.xor_mask |= bit;
+        if (o.group_policy == CARGS_GRP_REQ_ONE) p.req_mask |= bit;
+        if (o.group_policy == CARGS_GRP_ANY) p.any_mask |= bit;
+    }
+    return p;
+}
+
+/* Breadth-first node order, as cargs_compile() lays it out */
+template <std::size_t N>
+constexpr std::array<const cargs_cmd *, N> bfs(const cargs_cmd &root) {
+    std::array<const cargs_cmd *, N> q{};
+    q[0]             = &root;
+    std::size_t next = 1;
+    for (std::size_t k = 0; k < N; k++)
+        for (std::size_t j = 0; j < q[k]->sub_count; j++)
+            q[next++] = &q[k]->subs[j];
+    return q;
+}
+
+} // namespace detail
+
+template <const cargs_cmd &Root>
+struct compiled {
+    static_assert(validate(Root, checks{false, false, false}));
+
+    static constexpr std::size_t node_count = detail::count_nodes(Root);
+    static constexpr std::size_t slot_count = detail::count_slots(Root);
+    static constexpr auto order = detail::bfs<node_count>(Root);
+
+    static constexpr std::array<uint16_t, 256 * node_count> shorts = [] {
+        std::array<uint16_t, 256 * node_count> t{};
+        for (std::size_t k = 0; k < node_count; k++) {
+            const cargs_cmd &c = *order[k];
+            for (std::size_t i = 0; i < c.opt_count; i++) {
+                auto ch = static_cast<unsigned char>(c.opts[i].short_name);
+                if (ch && !t[k * 256 + ch])
+                    t[k * 256 + ch] = static_cast<uint16_t>(i + 1);
+            }
+        }
+        return t;
+    }();
+
+    /* At least one slot so data() is a valid pointer even with no long names */
+    static constexpr std::array<uint32_t, slot_count ? slot_count : 1>
+        longs = [] {
+            std::array<uint32_t, slot_count ? slot_count : 1> t{};
+            std::size_t base = 0;
+            for (std::size_t k = 0; k < node_count; k++) {
+                const cargs_cmd &c    = *order[k];
+                std::size_t      ns   = detail::long_slots(c);
+                uint32_t         mask = ns ? static_cast<uint32_t>(ns - 1) : 0;
+                for (std::size_t i = 0; i < c.opt_count; i++) {
+                    const char *ln = c.opts[i].long_name;
+                    if (!ln) continue;
+                    uint32_t h = detail::fnv1a(ln, detail::slen(ln));
+                    uint32_t s = h & mask;
+                    while (t[base + s]) s = (s + 1) & mask;
+                    t[base + s] = (h & 0xffff0000u) |
+                                  static_cast<uint32_t>(i + 1);
+                }
+                base += ns;
+            }
+            return t;
+        }();
+
+    static constexpr std::size_t name_total = detail::count_names(Root);
+
+    /* Per node: names then aliases of its subcommands, sorted */
+    static constexpr std::array<cargs_index_name, name_total ? name_total : 1>
+        names = [] {
+            std::array<cargs_index_name, name_total ? name_total : 1> t{};
+            std::size_t n = 0;
+            for (std::size_t k = 0; k < node_count; k++) {
+                const cargs_cmd &c     = *order[k];
+                std::size_t      first = n;
+                for (std::size_t j = 0; j < c.sub_count; j++) {
+                    const cargs_cmd &s = c.subs[j];
+                    if (s.name) t[n++] = {s.name, static_cast<uint32_t>(j)};
+                    for (std::size_t a = 0; a < s.alias_count; a++)
+                        if (s.aliases[a])
+                            t[n++] = {s.aliases[a], static_cast<uint32_t>(j)};
+                }
+                std::sort(t.begin() + first, t.begin() + n, detail::name_less);
+            }
+            return t;
+        }();
+
+    static constexpr std::array<cargs_index_node, node_count> nodes = [] {
+        std::array<cargs_index_node, node_count> t{};
+        std::size_t next = 1, base = 0, nbase = 0;
+        for (std::size_t k = 0; k < node_count; k++) {
+            std::size_t ns = detail::long_slots(*order[k]);
+            std::size_t nn = detail::sub_names(*order[k]);
+            t[k].cmd        = order[k];
+            t[k].shorts     = shorts.data() + k * 256;
+            t[k].longs      = ns ? longs.data() + base : nullptr;
+            t[k].long_mask  = ns ? static_cast<uint32_t>(ns - 1) : 0;
+            t[k].first_sub  = static_cast<uint32_t>(next);
+            t[k].groups     = detail::group_plan(*order[k]);
+            t[k].names      = names.data() + nbase;
+            t[k].name_count = static_cast<uint32_t>(nn);
+            next += order[k]->sub_count;
+            base += ns;
+            nbase += nn;
+        }
+        return t;
+    }();
+
+    static constexpr cargs_index index = {&Root, nodes.data(), node_count};
+};
+
+} // namespace cargs
+
+#endif /* CARGS_HPP */
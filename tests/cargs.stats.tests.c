@@ -0,0 +1,6 @@
+/* The whole suite again with the instrumentation compiled in;
+   cargs.tests.c on its own covers the build without it. POSIX is requested
+   for pipe() and fdopen() in test_stats, declared under -std=c11 only then */
+#define _POSIX_C_SOURCE 200809L
+#define CARGS_ENABLE_STATS
+#include "cargs.tests.c"
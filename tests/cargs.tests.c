@@ -3,10 +3,13 @@
 #include <stdlib.h>
 #include <string.h>
 
+/* cargs.stats.tests.c runs this suite again with CARGS_ENABLE_STATS */
+#define CARGS_ENABLE_THREADS
 #include "c-args-parser.h"
 
 #ifdef _WIN32
 #    define CARGS_DEVNULL "NUL"
+#    define getpid        _getpid
 #else
 #    define CARGS_DEVNULL "/dev/null"
 #endif
@@ -187,11 +190,11 @@ static void build_root_basic(const cargs_cmd **out_root) {
     };
 
     static const cargs_opt root_opts[] = {
-        {"verbose", 'V', CARGS_ARG_NONE,     NULL, "verbose",          cb_verbose,   NULL, NULL, 0, CARGS_GRP_NONE},
-        {"jobs",    'j', CARGS_ARG_REQUIRED, "N",  "jobs",             cb_jobs,      NULL, NULL, 0, CARGS_GRP_NONE},
-        {"limit",   'l', CARGS_ARG_OPTIONAL, "N",  "limit (optional)", cb_limit_opt, NULL, NULL, 0, CARGS_GRP_NONE},
-        {"json",    0,   CARGS_ARG_NONE,     NULL, "json",             cb_json,      NULL, NULL, 1, CARGS_GRP_XOR },
-        {"yaml",    0,   CARGS_ARG_NONE,     NULL, "yaml",             cb_yaml,      NULL, NULL, 1, CARGS_GRP_XOR },
+        {"verbose", 'V', CARGS_ARG_NONE,     NULL, "verbose",          cb_verbose,   NULL, NULL, 0, CARGS_GRP_NONE, {0}},
+        {"jobs",    'j', CARGS_ARG_REQUIRED, "N",  "jobs",             cb_jobs,      NULL, NULL, 0, CARGS_GRP_NONE, {0}},
+        {"limit",   'l', CARGS_ARG_OPTIONAL, "N",  "limit (optional)", cb_limit_opt, NULL, NULL, 0, CARGS_GRP_NONE, {0}},
+        {"json",    0,   CARGS_ARG_NONE,     NULL, "json",             cb_json,      NULL, NULL, 1, CARGS_GRP_XOR,  {0}},
+        {"yaml",    0,   CARGS_ARG_NONE,     NULL, "yaml",             cb_yaml,      NULL, NULL, 1, CARGS_GRP_XOR,  {0}},
     };
 
     static const cargs_cmd remote_subs[] = {
@@ -229,8 +232,21 @@ static void build_root_basic(const cargs_cmd **out_root) {
 /* variant that requires exactly one of --light/--dark (REQ_ONE group) */
 static void build_root_req_one(const cargs_cmd **out_root) {
     static const cargs_opt opts[] = {
-        {"light", 0, CARGS_ARG_NONE, NULL, "light mode", cb_light, NULL, NULL, 2, CARGS_GRP_REQ_ONE},
-        {"dark",  0, CARGS_ARG_NONE, NULL, "dark mode",  cb_dark,  NULL, NULL, 2, CARGS_GRP_REQ_ONE},
+        {"light", 0, CARGS_ARG_NONE, NULL, "light mode", cb_light, NULL, NULL, 2, CARGS_GRP_REQ_ONE, {0}},
+        {"dark",  0, CARGS_ARG_NONE, NULL, "dark mode",  cb_dark,  NULL, NULL, 2, CARGS_GRP_REQ_ONE, {0}},
+    };
+    static const cargs_cmd root = {
+        .opts        = opts,
+        .opt_count   = sizeof(opts) / sizeof(opts[0]),
+        .run         = run_root
+    };
+    *out_root = &root;
+}
+
+/* root whose --jobs defaults from $CARGS_T_JOBS, then "1" */
+static void build_root_env(const cargs_cmd **out_root) {
+    static const cargs_opt opts[] = {
+        {"jobs", 'j', CARGS_ARG_REQUIRED, "N", "jobs", cb_jobs, "CARGS_T_JOBS", "1", 0, CARGS_GRP_NONE, {0}},
     };
     static const cargs_cmd root = {
         .opts        = opts,
@@ -242,6 +258,7 @@ static void build_root_req_one(const cargs_cmd **out_root) {
 
 /* shared env */
 static void fill_env(cargs_env *env) {
+    memset(env, 0, sizeof(*env));
     env->prog         = "t";
     env->version      = "v1";
     env->author       = "a";
@@ -277,6 +294,22 @@ static int run_vec(const cargs_cmd *root, cargs_env *env, tstate *st, int argc,
     return rc;
 }
 
+/* run_vec over a packed tree */
+static int run_packed(const cargs_packed *pk, const cargs_packed_fns *fns, cargs_env *env, tstate *st, int argc,
+                      const char **argv0) {
+    size_t n    = (size_t)argc;
+    char **argv = (char **)malloc(n * sizeof(*argv));
+    if (!argv) {
+        perror("malloc");
+        abort();
+    }
+    for (size_t i = 0; i < n; i++) argv[i] = dup_cstr(argv0[i]);
+    int rc = cargs_dispatch_packed(env, pk, fns, (int)n, argv, st);
+    for (size_t i = 0; i < n; i++) free(argv[i]);
+    free(argv);
+    return rc;
+}
+
 /* ---------- individual tests ---------- */
 
 static void test_required_forms(void) {
@@ -501,6 +534,2465 @@ static void test_grouped_shorts(void) {
     CHECK_EQI(st.jobs, 3);
 }
 
+static void test_compiled_index(void) {
+    cargs_env env;
+    fill_env(&env);
+    const cargs_cmd *root;
+    build_root_basic(&root);
+    tstate st = {0};
+
+    static uint64_t storage[2048];
+    size_t          need = cargs_compile_size(root);
+    CHECK(need > 0 && need <= sizeof(storage));
+    CHECK(cargs_compile(root, storage, need - 1) == NULL);
+    const cargs_index *ix = cargs_compile(root, storage, sizeof(storage));
+    CHECK(ix != NULL);
+    if (!ix) return;
+    CHECK_EQI(ix->node_count, 4); /* root, remote, add, remove */
+    env.index = ix;
+
+    /* long, short, grouped and --name=value go through the index */
+    const char *a1[] = {"t", "--jobs=7", "-Vl3", "--json"};
+    CHECK_EQI(run_vec(root, &env, &st, 4, a1), CARGS_OK);
+    CHECK_EQI(st.jobs, 7);
+    CHECK_EQI(st.verbose, 1);
+    CHECK_EQI(st.limit, 3);
+    CHECK_EQI(st.json, 1);
+
+    st               = (tstate){0};
+    const char *a2[] = {"t", "--jso"};
+    CHECK(run_vec(root, &env, &st, 2, a2) == CARGS_ERR_UNKNOWN);
+    const char *a3[] = {"t", "--jsonx"};
+    CHECK(run_vec(root, &env, &st, 2, a3) == CARGS_ERR_UNKNOWN);
+    const char *a4[] = {"t", "-Z"};
+    CHECK(run_vec(root, &env, &st, 2, a4) == CARGS_ERR_UNKNOWN);
+
+    /* descent follows the breadth-first node layout */
+    const char *a5[] = {"t", "remote", "rm", "origin"};
+    CHECK_EQI(run_vec(root, &env, &st, 4, a5), CARGS_OK);
+    CHECK_EQI(st.ran_remote_rm, 1);
+    tstate_clear(&st);
+
+    /* an index built for another tree is ignored */
+    const cargs_cmd *other;
+    build_root_req_one(&other);
+    st               = (tstate){0};
+    const char *a6[] = {"t", "--dark"};
+    CHECK_EQI(run_vec(other, &env, &st, 2, a6), CARGS_OK);
+    CHECK_EQI(st.mode, 2);
+}
+
+static void test_env_snapshot(void) {
+    cargs_env env;
+    fill_env(&env);
+    const cargs_cmd *root;
+    build_root_env(&root);
+    tstate st = {0};
+
+    static uint64_t storage[256];
+    const char     *envp[] = {"PATH=/bin", "CARGS_T_JOBS=9", "NO_COLOR=1", "CARGS_T_JOBS=3", NULL};
+    CHECK(cargs_envsnap_size(root) <= sizeof(storage));
+    CHECK(cargs_envsnap_build(root, envp, storage, 8) == NULL);
+    const cargs_envsnap *snap = cargs_envsnap_build(root, envp, storage, sizeof(storage));
+    CHECK(snap != NULL);
+    if (!snap) return;
+
+    /* first definition wins; unreferenced names are not indexed */
+    CHECK_STREQ(cargs_envsnap_get(snap, "CARGS_T_JOBS"), "9");
+    CHECK_STREQ(cargs_envsnap_get(snap, "NO_COLOR"), "1");
+    CHECK(cargs_envsnap_get(snap, "COLUMNS") == NULL);
+    CHECK(cargs_envsnap_get(snap, "PATH") == NULL);
+
+    env.envsnap      = snap;
+    env.color        = true;
+    const char *a1[] = {"t"};
+    CHECK_EQI(run_vec(root, &env, &st, 1, a1), CARGS_OK);
+    CHECK_EQI(st.jobs, 9);
+    CHECK(!cargs_use_color(&env)); /* NO_COLOR from the snapshot */
+    tstate_clear(&st);
+
+    /* CLI still overrides; an empty snapshot falls back to the default */
+    st               = (tstate){0};
+    const char *a2[] = {"t", "-j", "4"};
+    CHECK_EQI(run_vec(root, &env, &st, 3, a2), CARGS_OK);
+    CHECK_EQI(st.jobs, 4);
+    tstate_clear(&st);
+
+    const char *empty[] = {NULL};
+    env.envsnap   = cargs_envsnap_build(root, empty, storage, sizeof(storage));
+    st            = (tstate){0};
+    CHECK_EQI(run_vec(root, &env, &st, 1, a1), CARGS_OK);
+    CHECK_EQI(st.jobs, 1);
+    tstate_clear(&st);
+}
+
+static void test_buffered_help(void) {
+    cargs_env env;
+    fill_env(&env);
+    const cargs_cmd *root;
+    build_root_basic(&root);
+
+    static char page[4096];
+    size_t      total = cargs_render_help(page, sizeof(page), &env, root, "t", NULL, 0);
+    CHECK(total > 0 && total < sizeof(page));
+    CHECK_EQI(strlen(page), total);
+    CHECK(strncmp(page, "Usage: t [options]", 18) == 0);
+    CHECK(strstr(page, "--jobs N") != NULL);
+    CHECK(strstr(page, "remote") != NULL);
+
+    /* truncates like snprintf but still reports the full length */
+    char small[16];
+    CHECK_EQI(cargs_render_help(small, sizeof(small), &env, root, "t", NULL, 0), total);
+    CHECK_EQI(strlen(small), sizeof(small) - 1);
+    CHECK_EQI(cargs_render_help(NULL, 0, &env, root, "t", NULL, 0), total);
+
+    /* a tiny caller buffer forces chunked flushes; output must be identical */
+    FILE *f = tmpfile();
+    CHECK(f != NULL);
+    if (!f) return;
+    char chunk[24];
+    env.out          = f;
+    env.help_buf     = chunk;
+    env.help_buf_cap = sizeof(chunk);
+    cargs_print_help(&env, root, "t", NULL, 0);
+    static char back[4096];
+    rewind(f);
+    size_t got = fread(back, 1, sizeof(back) - 1, f);
+    back[got]  = '\0';
+    fclose(f);
+    CHECK_EQI(got, total);
+    CHECK_STREQ(back, page);
+}
+
+static void test_presentation(void) {
+    cargs_env env;
+    fill_env(&env);
+    const cargs_cmd *root;
+    build_root_basic(&root);
+
+    cargs_pres pres;
+    cargs_pres_resolve(&env, root, &pres);
+    CHECK_STREQ(pres.bold, ""); /* color off */
+    CHECK_EQI(pres.width, 80);
+    CHECK_EQI(pres.left, 30); /* fixed column by default */
+    env.help_fit = true;
+    cargs_pres_resolve(&env, root, &pres);
+    CHECK_EQI(pres.left, 18); /* "remove (alias: rm)" is the widest row */
+    cargs_pres_resolve(&env, NULL, &pres);
+    CHECK_EQI(pres.left, 30);
+
+    /* a pre-resolved struct overrides env: force color and a narrow width */
+    env.color = true;
+    cargs_pres_resolve(&env, root, &pres);
+    env.color  = false;
+    pres.width = 40;
+    env.pres   = &pres;
+    static char page[4096];
+    cargs_render_help(page, sizeof(page), &env, root, "t", NULL, 0);
+    CHECK(strstr(page, "\x1b[36m-j, --jobs N\x1b[0m       jobs\n") != NULL);
+    CHECK(strstr(page, "limit (optional)\n") != NULL);
+}
+
+static void test_text_width(void) {
+    CHECK_EQI((int)cargs_text_width("plain ascii text", 16), 16);
+    CHECK_EQI((int)cargs_text_width("\x1b[1;36m--jobs\x1b[0m", 17), 6);
+    CHECK_EQI((int)cargs_text_width("h\xc3\xa9llo", 6), 5);                  /* é */
+    CHECK_EQI((int)cargs_text_width("\xe6\x97\xa5\xe6\x9c\xac", 6), 4);      /* 日本 */
+    CHECK_EQI((int)cargs_text_width("e\xcc\x81", 3), 1);                     /* e + combining acute */
+    CHECK_EQI((int)cargs_text_width("\xef\xbc\xa1\xf0\x9f\x98\x80", 7), 4); /* fullwidth A, emoji */
+    CHECK_EQI((int)cargs_text_width("\xff\xc3", 2), 2);                      /* invalid, truncated */
+    CHECK_EQI((int)cargs_text_width("\x1b]8;;x\x07link", 11), 4);            /* OSC 8 hyperlink */
+
+    /* rows align and wrap by columns: "--größe" is 7 wide in 10 bytes */
+    static const cargs_opt opts[] = {
+        {"gr\xc3\xb6\xc3\x9f" "e", 0, CARGS_ARG_NONE, NULL,
+         "\xe8\xaa\xac\xe6\x98\x8e\xe6\x96\x87\xe3\x81\xaf\xe3\x81\x93\xe3\x81\x93\xe3\x81\xa7\xe6\x8a\x98\xe3\x82\x8a"
+         "\xe8\xbf\x94\xe3\x81\x97\xe3\x81\xbe\xe3\x81\x99 "
+         "\xe8\xaa\xac\xe6\x98\x8e\xe6\x96\x87\xe3\x81\xaf\xe3\x81\x93\xe3\x81\x93\xe3\x81\xa7\xe6\x8a\x98\xe3\x82\x8a",
+         NULL, NULL, NULL, 0, CARGS_GRP_NONE, {0}},
+        {"x", 0, CARGS_ARG_NONE, NULL, "caf\xc3\xa9 au lait with a long tail of words", NULL, NULL, NULL, 0,
+         CARGS_GRP_NONE, {0}},
+    };
+    cargs_cmd root = {0};
+    root.opts      = opts;
+    root.opt_count = 2;
+    root.run       = run_root;
+    cargs_env env;
+    fill_env(&env);
+    env.auto_help    = false;
+    env.auto_version = false;
+    env.auto_author  = false;
+    env.help_fit     = true;
+    cargs_pres pres;
+    cargs_pres_resolve(&env, &root, &pres);
+    CHECK_EQI(pres.left, 7);
+    pres.width = 32;
+    env.pres   = &pres;
+    static char page[1024];
+    cargs_render_help(page, sizeof(page), &env, &root, "t", NULL, 0);
+    CHECK(strstr(page, "  --gr\xc3\xb6\xc3\x9f" "e \xe8\xaa\xac") != NULL);
+    CHECK(strstr(page, "  --x     caf\xc3\xa9 au lait with a\n          long tail of words\n") != NULL);
+    int         widest = 0;
+    const char *line   = strstr(page, "Options:\n"); /* the usage line does not wrap */
+    CHECK(line != NULL);
+    if (!line) return;
+    while (*line) {
+        const char *nl = strchr(line, '\n');
+        size_t      n  = nl ? (size_t)(nl - line) : strlen(line);
+        int         k  = (int)cargs_text_width(line, n);
+        if (k > widest) widest = k;
+        line += n + (nl ? 1 : 0);
+    }
+    CHECK(widest <= 32);
+    CHECK(widest >= 30); /* the CJK text filled its lines */
+}
+
+static void test_strict_int_parsers(void) {
+    uint64_t u = 0;
+    int64_t  v = 0;
+    uint32_t u32;
+    int32_t  i32;
+
+    CHECK(cargs_read_u64("0", &u, CARGS_BASE_DEC) == 0 && u == 0);
+    CHECK(cargs_read_u64("12345678", &u, CARGS_BASE_DEC) == 0 && u == 12345678u);
+    CHECK(cargs_read_u64("1234567890123456789", &u, CARGS_BASE_DEC) == 0 && u == 1234567890123456789ull);
+    CHECK(cargs_read_u64("18446744073709551615", &u, CARGS_BASE_DEC) == 0 && u == UINT64_MAX);
+    CHECK(cargs_read_u64("000000000000000000000000042", &u, CARGS_BASE_DEC) == 0 && u == 42);
+    CHECK(cargs_read_u64("+7", &u, CARGS_BASE_DEC) == 0 && u == 7);
+
+    /* overflow and strictness: no whitespace, sign, stray bytes or octal */
+    u = 99;
+    CHECK(cargs_read_u64("18446744073709551616", &u, CARGS_BASE_DEC) == -1);
+    CHECK(cargs_read_u64("99999999999999999999", &u, CARGS_BASE_DEC) == -1);
+    CHECK(cargs_read_u64("-1", &u, CARGS_BASE_DEC) == -1);
+    CHECK(cargs_read_u64(" 1", &u, CARGS_BASE_DEC) == -1);
+    CHECK(cargs_read_u64("1 ", &u, CARGS_BASE_DEC) == -1);
+    CHECK(cargs_read_u64("1234567a", &u, CARGS_BASE_DEC) == -1);  /* bad byte in a SWAR chunk */
+    CHECK(cargs_read_u64("123456789/", &u, CARGS_BASE_DEC) == -1); /* bad byte in the tail */
+    CHECK(cargs_read_u64("", &u, CARGS_BASE_DEC) == -1);
+    CHECK(cargs_read_u64("0x10", &u, CARGS_BASE_DEC) == -1);
+    CHECK(u == 99);
+    CHECK(cargs_read_u64("010", &u, CARGS_BASE_AUTO) == 0 && u == 10); /* not octal */
+
+    /* hex / binary, with and without prefix */
+    CHECK(cargs_read_u64("0xFFffFFffFFffFFff", &u, CARGS_BASE_AUTO) == 0 && u == UINT64_MAX);
+    CHECK(cargs_read_u64("0x1ffffffffffffffff", &u, CARGS_BASE_HEX) == -1);
+    CHECK(cargs_read_u64("ff", &u, CARGS_BASE_HEX) == 0 && u == 255);
+    CHECK(cargs_read_u64("0b1011", &u, CARGS_BASE_AUTO) == 0 && u == 11);
+    CHECK(cargs_read_u64("1011", &u, CARGS_BASE_BIN) == 0 && u == 11);
+    CHECK(cargs_read_u64("102", &u, CARGS_BASE_BIN) == -1);
+    CHECK(cargs_read_u64("0x", &u, CARGS_BASE_AUTO) == -1);
+
+    /* signed limits */
+    CHECK(cargs_read_i64("-9223372036854775808", &v, CARGS_BASE_DEC) == 0 && v == INT64_MIN);
+    CHECK(cargs_read_i64("9223372036854775807", &v, CARGS_BASE_DEC) == 0 && v == INT64_MAX);
+    CHECK(cargs_read_i64("9223372036854775808", &v, CARGS_BASE_DEC) == -1);
+    CHECK(cargs_read_i64("-9223372036854775809", &v, CARGS_BASE_DEC) == -1);
+    CHECK(cargs_read_i64("-0x10", &v, CARGS_BASE_AUTO) == 0 && v == -16);
+    CHECK(cargs_read_i64("-", &v, CARGS_BASE_DEC) == -1);
+    CHECK(cargs_read_u32("4294967295", &u32, CARGS_BASE_DEC) == 0 && u32 == UINT32_MAX);
+    CHECK(cargs_read_u32("4294967296", &u32, CARGS_BASE_DEC) == -1);
+    CHECK(cargs_read_i32("-2147483648", &i32, CARGS_BASE_DEC) == 0 && i32 == INT32_MIN);
+    CHECK(cargs_read_i32("2147483648", &i32, CARGS_BASE_DEC) == -1);
+
+    /* batch: whole slice, or index of the first bad item */
+    char     n0[] = "1", n1[] = "22", n2[] = "x3", n3[] = "-4";
+    char    *ids[] = {n0, n1, n2, n3};
+    uint64_t uo[4];
+    int64_t  so[4];
+    size_t   bad = 0;
+    CHECK(cargs_read_u64_batch(ids, 2, uo, CARGS_BASE_DEC, &bad) == 0 && uo[0] == 1 && uo[1] == 22);
+    CHECK(cargs_read_u64_batch(ids, 4, uo, CARGS_BASE_DEC, &bad) == -1 && bad == 2);
+    ids[2] = n1;
+    CHECK(cargs_read_i64_batch(ids, 4, so, CARGS_BASE_DEC, &bad) == 0 && so[3] == -4);
+    CHECK(cargs_read_u64_batch(ids, 4, uo, CARGS_BASE_DEC, &bad) == -1 && bad == 3);
+}
+
+static void test_exact_sizes(void) {
+    uint64_t b = 0;
+
+    /* the old examples */
+    CHECK(cargs_read_size_si("12MB", &b) == 0 && b == 12000000u);
+    CHECK(cargs_read_size_iec("256MiB", &b) == 0 && b == 268435456u);
+    CHECK(cargs_read_size_iec("1K", &b) == 0 && b == 1024);
+    CHECK(cargs_read_size_si("1K", &b) == 0 && b == 1000);
+    CHECK(cargs_read_size_si("1KiB", &b) == 0 && b == 1024);
+    CHECK(cargs_read_size_si("42", &b) == 0 && b == 42);
+    CHECK(cargs_read_size_si(" 7 gb ", &b) == 0 && b == 7000000000ull);
+    CHECK(cargs_read_size_si("3B", &b) == 0 && b == 3);
+
+    /* exact above 2^53 */
+    CHECK(cargs_read_size_si("18446744073709551615", &b) == 0 && b == UINT64_MAX);
+    CHECK(cargs_read_size_si("9007199254740993", &b) == 0 && b == 9007199254740993ull);
+    CHECK(cargs_read_size_iec("15.9999999999999999995EiB", &b) == 0 && b == UINT64_MAX);
+    CHECK(cargs_read_size_si("18.446744073709551615EB", &b) == 0 && b == UINT64_MAX);
+
+    /* fractions, rounding half up on the exact remainder */
+    CHECK(cargs_read_size_iec("1.5KiB", &b) == 0 && b == 1536);
+    CHECK(cargs_read_size_si("1.5KB", &b) == 0 && b == 1500);
+    CHECK(cargs_read_size_si("0.0005K", &b) == 0 && b == 1);
+    CHECK(cargs_read_size_si("0.00049K", &b) == 0 && b == 0);
+    CHECK(cargs_read_size_iec(".5K", &b) == 0 && b == 512);
+    CHECK(cargs_read_size_iec("0.00048828125K", &b) == 0 && b == 1); /* exactly 0.5 B */
+    CHECK(cargs_read_size_iec("0.00048828124K", &b) == 0 && b == 0);
+    CHECK(cargs_read_size_iec("1.50000000000000000001KiB", &b) == 0 && b == 1536); /* long-fraction path */
+    CHECK(cargs_read_size_si("2.", &b) == 0 && b == 2);
+    CHECK(cargs_read_size_si("2.4", &b) == 0 && b == 2);
+
+    /* overflow is an error, never clamped */
+    b = 99;
+    CHECK(cargs_read_size_si("18446744073709551616", &b) == -1);
+    CHECK(cargs_read_size_iec("16EiB", &b) == -1);
+    CHECK(cargs_read_size_si("18.446744073709551616EB", &b) == -1);
+    CHECK(cargs_read_size_iec("15.99999999999999999999EiB", &b) == -1); /* rounds to 2^64 */
+    CHECK(cargs_read_size_si("18446744073709551615.5", &b) == -1);
+    CHECK(b == 99);
+
+    /* syntax */
+    CHECK(cargs_read_size_si("", &b) == -1);
+    CHECK(cargs_read_size_si(".", &b) == -1);
+    CHECK(cargs_read_size_si("-1", &b) == -1);
+    CHECK(cargs_read_size_si("1X", &b) == -1);
+    CHECK(cargs_read_size_si("1KBB", &b) == -1);
+    CHECK(cargs_read_size_si("1 K i", &b) == -1);
+    CHECK(cargs_read_size_si("K", &b) == -1);
+    CHECK(b == 99);
+}
+
+static void test_durations_rates(void) {
+    uint64_t       v   = 0;
+    const uint64_t sec = 1000000000ull;
+
+    CHECK(cargs_read_duration("250ms", &v) == 0 && v == 250000000u);
+    CHECK(cargs_read_duration("1h30m", &v) == 0 && v == 5400 * sec);
+    CHECK(cargs_read_duration("30m1h", &v) == 0 && v == 5400 * sec); /* any order */
+    CHECK(cargs_read_duration("2m 30.5s", &v) == 0 && v == 150 * sec + sec / 2);
+    CHECK(cargs_read_duration(" 1min ", &v) == 0 && v == 60 * sec);
+    CHECK(cargs_read_duration("1w2d", &v) == 0 && v == 9 * 86400 * sec);
+    CHECK(cargs_read_duration("1.5us", &v) == 0 && v == 1500);
+    CHECK(cargs_read_duration("1.5\xc2\xb5s", &v) == 0 && v == 1500);
+    CHECK(cargs_read_duration("7ns", &v) == 0 && v == 7);
+    CHECK(cargs_read_duration("1.5", &v) == 0 && v == 3 * sec / 2); /* bare = seconds */
+    CHECK(cargs_read_duration("0.0000000005s", &v) == 0 && v == 1); /* exact tie rounds up */
+    CHECK(cargs_read_duration("0.00000000049999999999999999999s", &v) == 0 && v == 0);
+    CHECK(cargs_read_duration("0.1h", &v) == 0 && v == 360 * sec);
+
+    /* overflow is its own error */
+    CHECK(cargs_read_duration("18446744073709551615ns", &v) == 0 && v == UINT64_MAX);
+    v = 99;
+    CHECK(cargs_read_duration("18446744073709551616ns", &v) == -2);
+    CHECK(cargs_read_duration("18446744074s", &v) == -2);
+    CHECK(cargs_read_duration("30502w", &v) == -2);
+    CHECK(cargs_read_duration("18446744073s1s", &v) == -2); /* the sum */
+    CHECK(cargs_read_duration("", &v) == -1);
+    CHECK(cargs_read_duration("s", &v) == -1);
+    CHECK(cargs_read_duration("1h30", &v) == -1); /* only a lone number is bare */
+    CHECK(cargs_read_duration("1mo", &v) == -1);
+    CHECK(cargs_read_duration("1H", &v) == -1);
+    CHECK(cargs_read_duration("-1s", &v) == -1);
+    CHECK(v == 99);
+
+    CHECK(cargs_read_rate("10MB/s", &v) == 0 && v == 10000000u);
+    CHECK(cargs_read_rate("1.5 KiB / s", &v) == 0 && v == 1536);
+    CHECK(cargs_read_rate("512", &v) == 0 && v == 512); /* per second */
+    CHECK(cargs_read_rate("3600KB/h", &v) == 0 && v == 1000);
+    CHECK(cargs_read_rate("90B/min", &v) == 0 && v == 2); /* 1.5 rounds up */
+    CHECK(cargs_read_rate("89B/min", &v) == 0 && v == 1);
+    CHECK(cargs_read_rate("1KB/ms", &v) == 0 && v == 1000000u);
+    /* fractional sizes stay exact over sub-second periods */
+    CHECK(cargs_read_rate("1.5B/ms", &v) == 0 && v == 1500);
+    CHECK(cargs_read_rate("0.5B/us", &v) == 0 && v == 500000u);
+    CHECK(cargs_read_rate("1.4B/ns", &v) == 0 && v == 1400000000u);
+    CHECK(cargs_read_rate("0.0000000015KB/ns", &v) == 0 && v == 1500);
+    CHECK(cargs_read_rate("0.0000000005B/ns", &v) == 0 && v == 1); /* 0.5 */
+    CHECK(cargs_read_rate("0.0000000004B/ns", &v) == 0 && v == 0);
+    CHECK(cargs_read_rate("18446744073.709551615B/ns", &v) == 0 && v == UINT64_MAX);
+    /* and over longer ones: round(size / period) */
+    CHECK(cargs_read_rate("30B/min", &v) == 0 && v == 1);
+    CHECK(cargs_read_rate("29.99B/min", &v) == 0 && v == 0);
+    CHECK(cargs_read_rate("9000.5B/h", &v) == 0 && v == 3);
+    CHECK(cargs_read_rate("8999.9B/h", &v) == 0 && v == 2);
+    CHECK(cargs_read_rate("0.5KB/min", &v) == 0 && v == 8);
+    CHECK(cargs_read_rate("1.5GiB/w", &v) == 0 && v == 2663);
+    v = 99;
+    CHECK(cargs_read_rate("18446744073.709551616B/ns", &v) == -2);
+    CHECK(cargs_read_rate("1EiB/ns", &v) == -2);
+    CHECK(cargs_read_rate("16EiB/s", &v) == -2);
+    CHECK(cargs_read_rate("20EB/ms", &v) == -2);
+    CHECK(cargs_read_rate("10MB/", &v) == -1);
+    CHECK(cargs_read_rate("10MB/yr", &v) == -1);
+    CHECK(cargs_read_rate("10Mbit/s", &v) == -1);
+    CHECK(v == 99);
+}
+
+static void test_fmt_numbers(void) {
+    char b[32];
+    CHECK_STREQ(cargs_fmt_bytes(999, b, sizeof b, false, 2), "999B");
+    CHECK_STREQ(cargs_fmt_bytes(1500000, b, sizeof b, false, 2), "1.50MB");
+    CHECK_STREQ(cargs_fmt_bytes(15000000, b, sizeof b, false, 2), "15MB");
+    CHECK_STREQ(cargs_fmt_bytes(1536, b, sizeof b, true, -1), "1.50KiB");
+    CHECK_STREQ(cargs_fmt_bytes(1536, b, sizeof b, true, 0), "2KiB");
+    CHECK_STREQ(cargs_fmt_bytes(UINT64_MAX, b, sizeof b, true, 2), "16EiB");
+    CHECK_STREQ(cargs_fmt_bytes(UINT64_MAX, b, sizeof b, false, 9), "18EB");
+    CHECK_STREQ(cargs_fmt_bytes(1844674407370955161u, b, sizeof b, false, 9), "1.844674EB");
+
+    /* exact ties round up; carries move to the next unit */
+    CHECK_STREQ(cargs_fmt_bytes(1152, b, sizeof b, true, 2), "1.13KiB"); /* 1.125 */
+    CHECK_STREQ(cargs_fmt_bytes(1151, b, sizeof b, true, 2), "1.12KiB");
+    CHECK_STREQ(cargs_fmt_bytes(1048575, b, sizeof b, true, 2), "1.00MiB");
+    CHECK_STREQ(cargs_fmt_bytes(999999, b, sizeof b, false, 2), "1.00MB");
+    /* 9.995..9.999 rounds to 10 but keeps its decimals, as snprintf did */
+    CHECK_STREQ(cargs_fmt_bytes(9994, b, sizeof b, false, 2), "9.99KB");
+    CHECK_STREQ(cargs_fmt_bytes(9995, b, sizeof b, false, 2), "10.00KB");
+    CHECK_STREQ(cargs_fmt_bytes(9999, b, sizeof b, false, 2), "10.00KB");
+    CHECK_STREQ(cargs_fmt_bytes(9996000, b, sizeof b, false, 2), "10.00MB");
+    CHECK_STREQ(cargs_fmt_bytes(10000, b, sizeof b, false, 2), "10KB");
+    CHECK_STREQ(cargs_fmt_bytes(10239, b, sizeof b, true, 2), "10.00KiB");
+    CHECK_STREQ(cargs_fmt_count(9999, b, sizeof b, -1), "10.0k");
+
+    CHECK_STREQ(cargs_fmt_count(999, b, sizeof b, -1), "999");
+    CHECK_STREQ(cargs_fmt_count(1234, b, sizeof b, -1), "1.2k");
+    CHECK_STREQ(cargs_fmt_count(3400000, b, sizeof b, -1), "3.4M");
+    CHECK_STREQ(cargs_fmt_rate(12000000, b, sizeof b, false, -1), "12MB/s");
+    CHECK_STREQ(cargs_fmt_rate(1536, b, sizeof b, true, 1), "1.5KiB/s");
+    CHECK_STREQ(cargs_fmt_bytes(1500000, b, 4, false, 2), "1.5");
+
+    /* a column: right-aligned cells of the widest width */
+    static const uint64_t vals[] = {5, 1536, 12582912, 1073741824};
+    char                  cells[4 * 8];
+    CHECK_EQI((int)cargs_fmt_table(vals, 4, CARGS_FMT_BYTES_IEC, 2, NULL, 0), 7);
+    CHECK_EQI((int)cargs_fmt_table(vals, 4, CARGS_FMT_BYTES_IEC, 2, cells, sizeof cells - 1), 7);
+    memset(cells, 0, sizeof cells);
+    CHECK_EQI((int)cargs_fmt_table(vals, 4, CARGS_FMT_BYTES_IEC, 2, cells, sizeof cells), 7);
+    CHECK_STREQ(cells, "     5B");
+    CHECK_STREQ(cells + 8, "1.50KiB");
+    CHECK_STREQ(cells + 16, "  12MiB");
+    CHECK_STREQ(cells + 24, "1.00GiB");
+    CHECK_EQI((int)cargs_fmt_table(vals, 0, CARGS_FMT_COUNT, 1, cells, sizeof cells), 0);
+}
+
+static void write_file(const char *path, const char *data, size_t n) {
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        perror(path);
+        abort();
+    }
+    fwrite(data, 1, n, f);
+    fclose(f);
+}
+
+static void test_response_files(void) {
+    cargs_env env;
+    fill_env(&env);
+    const cargs_cmd *root;
+    build_root_basic(&root);
+    tstate             st = {0};
+    static uint64_t    mem[1024];
+    cargs_arena        arena;
+    static const char  a[] = "--jobs 3 @cargs_rsp_b.txt\n# 'two words' \"q\\\"x\" tail\\ end\n";
+    static const char  b[] = "-V";
+    cargs_arena_init(&arena, mem, sizeof mem);
+    write_file("cargs_rsp_a.txt", a, sizeof a - 1);
+    write_file("cargs_rsp_b.txt", b, sizeof b - 1);
+    write_file("cargs_rsp_loop.txt", "x @cargs_rsp_loop.txt", 21);
+    write_file("cargs_rsp_open.txt", "'never closed", 13);
+
+    /* off by default: "@file" is an ordinary positional */
+    const char *a1[] = {"t", "@cargs_rsp_a.txt"};
+    CHECK_EQI(run_vec(root, &env, &st, 2, a1), CARGS_OK);
+    CHECK_EQI(st.pos_argc, 1);
+    CHECK_STREQ(st.pos_argv[0], "@cargs_rsp_a.txt");
+
+    env.response_files = true;
+    env.arena          = &arena;
+    const char *a2[]   = {"t", "@cargs_rsp_a.txt", "last", "@"};
+    CHECK_EQI(run_vec(root, &env, &st, 4, a2), CARGS_OK);
+    CHECK_EQI(st.jobs, 3);
+    CHECK_EQI(st.verbose, 1);
+    CHECK_EQI(st.pos_argc, 6);
+    CHECK_STREQ(st.pos_argv[0], "#");
+    CHECK_STREQ(st.pos_argv[1], "two words");
+    CHECK_STREQ(st.pos_argv[2], "q\"x");
+    CHECK_STREQ(st.pos_argv[3], "tail end");
+    CHECK_STREQ(st.pos_argv[4], "last");
+    CHECK_STREQ(st.pos_argv[5], "@");
+    CHECK_EQI((int)arena.used, 0); /* rewound after dispatch */
+
+    /* a page-sized file ends without room for the final NUL in the mapping */
+    static char big[4096];
+    memset(big, ' ', sizeof big);
+    memcpy(big + sizeof big - 4, "-j42", 4);
+    write_file("cargs_rsp_big.txt", big, sizeof big);
+    const char *a3[] = {"t", "@cargs_rsp_big.txt"};
+    CHECK_EQI(run_vec(root, &env, &st, 2, a3), CARGS_OK);
+    CHECK_EQI(st.jobs, 42);
+
+    const char *a4[] = {"t", "@cargs_rsp_loop.txt"};
+    CHECK_EQI(run_vec(root, &env, &st, 2, a4), CARGS_ERR_RESPONSE);
+    const char *a5[] = {"t", "@cargs_rsp_open.txt"};
+    CHECK_EQI(run_vec(root, &env, &st, 2, a5), CARGS_ERR_RESPONSE);
+    const char *a6[] = {"t", "@cargs_rsp_missing.txt"};
+    CHECK_EQI(run_vec(root, &env, &st, 2, a6), CARGS_ERR_RESPONSE);
+
+    /* "--" ends expansion, in argv or in a file; NULL words are skipped */
+    write_file("cargs_rsp_dd.txt", "-V -- @cargs_rsp_b.txt", 22);
+    const char *a7[] = {"t", "--", "@cargs_rsp_b.txt"};
+    CHECK_EQI(run_vec(root, &env, &st, 3, a7), CARGS_OK);
+    CHECK(st.pos_argc == 1 && strcmp(st.pos_argv[0], "@cargs_rsp_b.txt") == 0);
+    const char *a8[] = {"t", "@cargs_rsp_dd.txt", "@cargs_rsp_b.txt"};
+    st.verbose       = 0;
+    CHECK_EQI(run_vec(root, &env, &st, 3, a8), CARGS_OK);
+    CHECK_EQI(st.verbose, 1);
+    CHECK(st.pos_argc == 2 && strcmp(st.pos_argv[0], "@cargs_rsp_b.txt") == 0);
+    const char *a9[] = {"t", "x", NULL, "@cargs_rsp_b.txt"};
+    st.verbose       = 0;
+    CHECK_EQI(run_vec(root, &env, &st, 4, a9), CARGS_OK);
+    CHECK(st.verbose == 0 && st.pos_argc == 1);
+
+    /* without an arena: a stack buffer, and page-sized files still map
+       (read into that buffer without mmap, where 4 KiB does not fit) */
+    env.arena = NULL;
+#ifdef CARGS__HAVE_MMAP
+    CHECK_EQI(run_vec(root, &env, &st, 2, a3), CARGS_OK);
+    CHECK_EQI(st.jobs, 42);
+#else
+    CHECK_EQI(run_vec(root, &env, &st, 2, a3), CARGS_ERR_RESPONSE);
+#endif
+    CHECK_EQI(run_vec(root, &env, &st, 4, a2), CARGS_OK);
+    CHECK_EQI(st.pos_argc, 6);
+    CHECK_EQI((int)arena.used, 0);
+    remove("cargs_rsp_dd.txt");
+
+    remove("cargs_rsp_a.txt");
+    remove("cargs_rsp_b.txt");
+    remove("cargs_rsp_loop.txt");
+    remove("cargs_rsp_open.txt");
+    remove("cargs_rsp_big.txt");
+    tstate_clear(&st);
+}
+
+typedef struct {
+    char   text[256];
+    size_t len;
+    int    writes;
+} sink_log;
+
+static void sink_write(void *ctx, const char *msg, size_t len) {
+    sink_log *l = (sink_log *)ctx;
+    size_t    k = len < sizeof l->text - 1 - l->len ? len : sizeof l->text - 1 - l->len;
+    memcpy(l->text + l->len, msg, k);
+    l->len += k;
+    l->text[l->len] = '\0';
+    l->writes++;
+}
+
+static struct {
+    int         jobs;
+    const char *name, *url;
+} cfgv;
+
+static void test_config_files(void) {
+    cargs_env env;
+    fill_env(&env);
+    static const cargs_opt root_opts[] = {
+        {"jobs", 'j', CARGS_ARG_REQUIRED, "N", "jobs", NULL, "CARGS_T_CJOBS", "1", 0, CARGS_GRP_NONE, CARGS_BIND(CARGS_BIND_INT, &cfgv.jobs)},
+        {"name", 0,   CARGS_ARG_REQUIRED, "S", "name", NULL, NULL,            NULL, 0, CARGS_GRP_NONE, CARGS_BIND(CARGS_BIND_STR, &cfgv.name)},
+    };
+    static const cargs_opt add_opts[] = {
+        {"url", 0, CARGS_ARG_REQUIRED, "U", "url", NULL, NULL, NULL, 0, CARGS_GRP_NONE, CARGS_BIND(CARGS_BIND_STR, &cfgv.url)},
+    };
+    static const char     *add_alias[] = {"a"};
+    static const cargs_cmd remote_subs[] = {
+        {.name = "add", .aliases = add_alias, .alias_count = 1, .opts = add_opts, .opt_count = 1, .run = run_remote_add},
+    };
+    static const cargs_cmd subs[] = {{.name = "remote", .subs = remote_subs, .sub_count = 1}};
+    static const cargs_cmd root   = {.opts = root_opts, .opt_count = 2, .subs = subs, .sub_count = 1, .run = run_root};
+    static const char      text[] = "\xef\xbb\xbf# defaults\njobs = 4\n  name = \"two words\"\r\n; remote\n"
+                                    "[remote a]\nurl=git@h:x\n[]\njobs\t= 5";
+    static uint64_t        storage[256];
+    cargs_arena            arena;
+    cargs_config           cfg;
+    tstate                 st = {0};
+    remove("cargs_cfg.snap");
+    write_file("cargs_cfg.ini", text, sizeof text - 1);
+    CHECK(cargs_config_size(&root) <= sizeof storage);
+    cargs_arena_init(&arena, storage, sizeof storage);
+
+    /* later duplicates win; each section's keys apply at its own level */
+    CHECK_EQI(cargs_config_load(&cfg, &env, &root, "cargs_cfg.ini", NULL, &arena), CARGS_OK);
+    CHECK_EQI((int)cfg.count, 3);
+    CHECK(!cfg.from_snapshot);
+    CHECK_STREQ(cargs_config_get(&cfg, &root_opts[0]), "5");
+    env.config       = &cfg;
+    const char *a1[] = {"t", "remote", "add"};
+    CHECK_EQI(run_vec(&root, &env, &st, 3, a1), CARGS_OK);
+    CHECK_EQI(cfgv.jobs, 5);
+    CHECK_STREQ(cfgv.name, "two words");
+    CHECK_STREQ(cfgv.url, "git@h:x");
+
+    /* config < env < argv */
+    static uint64_t      snapmem[64];
+    const char          *envp[] = {"CARGS_T_CJOBS=7", NULL};
+    const cargs_envsnap *snap   = cargs_envsnap_build(&root, envp, snapmem, sizeof snapmem);
+    env.envsnap                 = snap;
+    CHECK_EQI(run_vec(&root, &env, &st, 1, a1), CARGS_OK);
+    CHECK_EQI(cfgv.jobs, 7);
+    const char *a2[] = {"t", "-j", "9"};
+    CHECK_EQI(run_vec(&root, &env, &st, 3, a2), CARGS_OK);
+    CHECK_EQI(cfgv.jobs, 9);
+
+    /* a bad env value fails the dispatch like one on argv */
+    const char *envbad[] = {"CARGS_T_CJOBS=abc", NULL};
+    sink_log    log      = {{0}, 0, 0};
+    cargs_sink  sink     = {sink_write, &log};
+    env.err_sink         = &sink;
+    env.envsnap          = cargs_envsnap_build(&root, envbad, snapmem, sizeof snapmem);
+    CHECK_EQI(run_vec(&root, &env, &st, 3, a1), CARGS_ERR_BAD_FORMAT);
+    CHECK_STREQ(log.text, "Invalid value for '--jobs': 'abc'\n");
+    CHECK_EQI(cfgv.jobs, 9);
+    env.err_sink = NULL;
+    env.envsnap  = NULL;
+    cargs_config_close(&cfg);
+
+    /* sections and keys resolve through a compiled index as well */
+    static uint64_t ixmem[512];
+    env.index = cargs_compile(&root, ixmem, sizeof ixmem);
+    CHECK(env.index != NULL);
+    CHECK_EQI(cargs_config_load(&cfg, &env, &root, "cargs_cfg.ini", NULL, &arena), CARGS_OK);
+    CHECK_EQI((int)cfg.count, 3);
+    CHECK_STREQ(cargs_config_get(&cfg, &add_opts[0]), "git@h:x");
+    cargs_config_close(&cfg);
+    env.index = NULL;
+
+    /* the first load writes the snapshot, the second is served from it */
+    CHECK_EQI(cargs_config_load(&cfg, &env, &root, "cargs_cfg.ini", "cargs_cfg.snap", &arena), CARGS_OK);
+    CHECK(!cfg.from_snapshot);
+    cargs_config_close(&cfg);
+    CHECK_EQI(cargs_config_load(&cfg, &env, &root, "cargs_cfg.ini", "cargs_cfg.snap", &arena), CARGS_OK);
+    CHECK(cfg.from_snapshot);
+    CHECK_EQI((int)cfg.count, 3);
+    cfgv.url = NULL;
+    CHECK_EQI(run_vec(&root, &env, &st, 3, a1), CARGS_OK);
+    CHECK_EQI(cfgv.jobs, 5);
+    CHECK_STREQ(cfgv.name, "two words");
+    CHECK_STREQ(cfgv.url, "git@h:x");
+    cargs_config_close(&cfg);
+
+#ifdef CARGS__MTIME_NS
+    /* so does a same-size edit within the same second */
+    static char edit[sizeof text];
+    memcpy(edit, text, sizeof text);
+    edit[sizeof text - 2] = '6';
+    struct timespec t0, t1;
+    timespec_get(&t0, TIME_UTC);
+    do timespec_get(&t1, TIME_UTC); /* past the file system's tick */
+    while ((t1.tv_sec - t0.tv_sec) * 1000000000L + (t1.tv_nsec - t0.tv_nsec) < 20000000L);
+    write_file("cargs_cfg.ini", edit, sizeof edit - 1);
+    CHECK_EQI(cargs_config_load(&cfg, &env, &root, "cargs_cfg.ini", "cargs_cfg.snap", &arena), CARGS_OK);
+    CHECK(!cfg.from_snapshot);
+    CHECK_STREQ(cargs_config_get(&cfg, &root_opts[0]), "6");
+    cargs_config_close(&cfg);
+#endif
+
+    /* a source of another size invalidates it */
+    write_file("cargs_cfg.ini", "jobs = 12\n", 10);
+    CHECK_EQI(cargs_config_load(&cfg, &env, &root, "cargs_cfg.ini", "cargs_cfg.snap", &arena), CARGS_OK);
+    CHECK(!cfg.from_snapshot);
+    CHECK_EQI((int)cfg.count, 1);
+    CHECK_STREQ(cargs_config_get(&cfg, &root_opts[0]), "12");
+    CHECK(cargs_config_get(&cfg, &add_opts[0]) == NULL);
+    cargs_config_close(&cfg);
+
+    /* errors name the line; a missing file is not one */
+    const struct {
+        const char *text;
+        int         rc;
+    } bad[] = {
+        {"jobs = 1\nspeed = 2\n",   CARGS_ERR_UNKNOWN   },
+        {"[remote nope]\n",        CARGS_ERR_UNKNOWN   },
+        {"[remote]\nurl = x\n",    CARGS_ERR_UNKNOWN   },
+        {"jobs 4\n",               CARGS_ERR_BAD_FORMAT},
+        {"name = a b\n",           CARGS_ERR_BAD_FORMAT},
+        {"name = 'open\n",         CARGS_ERR_BAD_FORMAT},
+        {"[remote\n",              CARGS_ERR_BAD_FORMAT},
+    };
+    size_t used = arena.used;
+    for (size_t i = 0; i < sizeof bad / sizeof bad[0]; i++) {
+        write_file("cargs_cfg.ini", bad[i].text, strlen(bad[i].text));
+        CHECK_EQI(cargs_config_load(&cfg, &env, &root, "cargs_cfg.ini", NULL, &arena), bad[i].rc);
+        CHECK_EQI((int)cfg.count, 0);
+        CHECK(cfg.map == NULL);
+        CHECK(cfg.entries == NULL);
+    }
+    CHECK(arena.used == used);
+    remove("cargs_cfg.ini");
+    remove("cargs_cfg.snap");
+    CHECK_EQI(cargs_config_load(&cfg, &env, &root, "cargs_cfg.ini", NULL, &arena), 1);
+    cargs_arena_init(&arena, storage, 8);
+    CHECK_EQI(cargs_config_load(&cfg, &env, &root, "cargs_cfg.ini", NULL, &arena), CARGS_ERR_RESPONSE);
+    tstate_clear(&st);
+}
+
+typedef struct {
+    bool        dry;
+    int         verbose, jobs, mode;
+    uint64_t    max, limit, cache;
+    const char *out;
+} bound;
+
+static bound bnd;
+
+static int cb_after_jobs(const char *v, void *u) {
+    (void)v;
+    ((tstate *)u)->jobs = bnd.jobs * 10; /* cb sees the decoded value */
+    return CARGS_OK;
+}
+
+static void test_typed_bindings(void) {
+    cargs_env env;
+    fill_env(&env);
+    static const cargs_choice modes[] = {{"fast", 1}, {"safe", 2}, {NULL, 0}};
+    static const cargs_opt    opts[]  = {
+        {"dry-run", 'n', CARGS_ARG_OPTIONAL, NULL,   "dry",   NULL,          NULL,            NULL, 0, CARGS_GRP_NONE, CARGS_BIND(CARGS_BIND_FLAG, &bnd.dry)      },
+        {"verbose", 'V', CARGS_ARG_NONE,     NULL,   "more",  NULL,          NULL,            NULL, 0, CARGS_GRP_NONE, CARGS_BIND(CARGS_BIND_COUNT, &bnd.verbose) },
+        {"jobs",    'j', CARGS_ARG_REQUIRED, "N",    "jobs",  cb_after_jobs, NULL,            NULL, 0, CARGS_GRP_NONE, CARGS_BIND(CARGS_BIND_INT, &bnd.jobs)      },
+        {"max",     0,   CARGS_ARG_REQUIRED, "N",    "max",   NULL,          NULL,            NULL, 0, CARGS_GRP_NONE, CARGS_BIND(CARGS_BIND_U64, &bnd.max)       },
+        {"limit",   'l', CARGS_ARG_REQUIRED, "SZ",   "limit", NULL,          NULL,            NULL, 0, CARGS_GRP_NONE, CARGS_BIND(CARGS_BIND_SIZE_SI, &bnd.limit) },
+        {"cache",   0,   CARGS_ARG_REQUIRED, "SZ",   "cache", NULL,          "CARGS_T_CACHE", "1K", 0, CARGS_GRP_NONE, CARGS_BIND(CARGS_BIND_SIZE_IEC, &bnd.cache)},
+        {"out",     'o', CARGS_ARG_REQUIRED, "FILE", "out",   NULL,          NULL,            NULL, 0, CARGS_GRP_NONE, CARGS_BIND(CARGS_BIND_STR, &bnd.out)       },
+        {"mode",    'm', CARGS_ARG_REQUIRED, "M",    "mode",  NULL,          NULL,            NULL, 0, CARGS_GRP_NONE, CARGS_BIND_ENUM_TO(&bnd.mode, modes)       },
+    };
+    static const cargs_cmd root = {.opts = opts, .opt_count = sizeof(opts) / sizeof(opts[0]), .run = run_root};
+    tstate                 st   = {0};
+
+    const char *a1[] = {"t", "-n", "-VVV", "--jobs=0x10", "--max", "18446744073709551615", "-l1.5MB", "-o", "x.bin",
+                        "--mode=safe"};
+    CHECK_EQI(run_vec(&root, &env, &st, 10, a1), CARGS_OK);
+    CHECK(bnd.dry);
+    CHECK_EQI(bnd.verbose, 3);
+    CHECK_EQI(bnd.jobs, 16);
+    CHECK_EQI((int)st.jobs, 160);
+    CHECK(bnd.max == UINT64_MAX);
+    CHECK(bnd.limit == 1500000u);
+    CHECK(bnd.cache == 1024u); /* default through the binding */
+    CHECK_EQI(bnd.mode, 2);
+    CHECK(bnd.out != NULL);
+
+    const char *a2[] = {"t", "--dry-run=off", "--cache", "2MiB"};
+    CHECK_EQI(run_vec(&root, &env, &st, 4, a2), CARGS_OK);
+    CHECK(!bnd.dry);
+    CHECK(bnd.cache == 2u * 1024 * 1024);
+
+    /* decode failures are BAD_FORMAT and name the option */
+    const char *bad[][2] = {{"t", "--jobs=12x"}, {"t", "--max=-1"},     {"t", "-l16EiB"},
+                            {"t", "--mode=slow"}, {"t", "--dry-run=maybe"}};
+    for (size_t i = 0; i < sizeof bad / sizeof bad[0]; i++) CHECK_EQI(run_vec(&root, &env, &st, 2, bad[i]), CARGS_ERR_BAD_FORMAT);
+    tstate_clear(&st);
+}
+
+static void test_duration_bindings(void) {
+    cargs_env env;
+    fill_env(&env);
+    static uint64_t        timeout = 0, rate = 0;
+    static const cargs_opt opts[]  = {
+        {"timeout", 't', CARGS_ARG_REQUIRED, "DUR",  "t", NULL, NULL, "30s", 0, CARGS_GRP_NONE, CARGS_BIND(CARGS_BIND_DURATION, &timeout)},
+        {"rate",    0,   CARGS_ARG_REQUIRED, "RATE", "r", NULL, NULL, NULL,  0, CARGS_GRP_NONE, CARGS_BIND(CARGS_BIND_RATE, &rate)       },
+    };
+    static const cargs_cmd root = {.opts = opts, .opt_count = sizeof(opts) / sizeof(opts[0]), .run = run_root};
+    tstate                 st   = {0};
+
+    const char *a1[] = {"t", "--rate=2MiB/s"};
+    CHECK_EQI(run_vec(&root, &env, &st, 2, a1), CARGS_OK);
+    CHECK(timeout == 30000000000ull); /* default through the binding */
+    CHECK(rate == 2u * 1024 * 1024);
+    const char *a2[] = {"t", "-t1m30s"};
+    CHECK_EQI(run_vec(&root, &env, &st, 2, a2), CARGS_OK);
+    CHECK(timeout == 90000000000ull);
+
+    /* bad syntax and overflow are both BAD_FORMAT, with different wording */
+    sink_log   log  = {{0}, 0, 0};
+    cargs_sink sink = {sink_write, &log};
+    env.err_sink    = &sink;
+    const char *a3[] = {"t", "--timeout=99999999999h"};
+    CHECK_EQI(run_vec(&root, &env, &st, 2, a3), CARGS_ERR_BAD_FORMAT);
+    CHECK_STREQ(log.text, "Out-of-range value for '--timeout': '99999999999h'\n");
+    log.len          = 0;
+    const char *a4[] = {"t", "--rate=fast"};
+    CHECK_EQI(run_vec(&root, &env, &st, 2, a4), CARGS_ERR_BAD_FORMAT);
+    CHECK_STREQ(log.text, "Invalid value for '--rate': 'fast'\n");
+    cargs_event  elog[4];
+    cargs_events ev = {elog, 4, true, 0, 0, 0};
+    env.events      = &ev; /* deferred: validated the same way before anything runs */
+    log.len         = 0;
+    CHECK_EQI(run_vec(&root, &env, &st, 2, a3), CARGS_ERR_BAD_FORMAT);
+    CHECK_STREQ(log.text, "Out-of-range value for '--timeout': '99999999999h'\n");
+    tstate_clear(&st);
+}
+
+/* one handler for a whole table: records which option fired and the value */
+static struct {
+    int              n;
+    const cargs_opt *opt[8];
+    char             val[8][16];
+    size_t           len[8];
+} calls;
+
+static int on_call(const char *v, size_t len, const cargs_opt *o, void *u) {
+    (void)u;
+    if (calls.n >= 8) return CARGS_OK; /* log full: stop recording */
+    calls.opt[calls.n] = o;
+    calls.len[calls.n] = len;
+    snprintf(calls.val[calls.n], sizeof calls.val[0], "%.*s", (int)len, v ? v : "");
+    calls.n++;
+    return (v && strcmp(v, "bad") == 0) ? CARGS_ERR_BAD_FORMAT : CARGS_OK;
+}
+
+static void test_call_views(void) {
+    cargs_env env;
+    fill_env(&env);
+    static int             depth = 0;
+    static const cargs_opt opts[] = {
+        {"name",  'n', CARGS_ARG_REQUIRED, "S", "name",  NULL,   NULL, NULL, 0, CARGS_GRP_NONE, CARGS_CALL(on_call)},
+        {"level", 'L', CARGS_ARG_OPTIONAL, "N", "level", NULL,   NULL, "3",  0, CARGS_GRP_NONE, CARGS_CALL(on_call)},
+        {"depth", 0,   CARGS_ARG_REQUIRED, "N", "depth", cb_json, NULL, NULL, 0, CARGS_GRP_NONE,
+         {CARGS_BIND_INT, &depth, NULL, on_call, NULL}},
+        {"a-very-long-option-name-that-does-not-fit-in-any-fixed-size-name-buffer-whatsoever-0123456789", 0,
+         CARGS_ARG_REQUIRED, "V", "long", NULL, NULL, NULL, 0, CARGS_GRP_NONE, CARGS_CALL(on_call)},
+    };
+    static const cargs_cmd root = {.opts = opts, .opt_count = sizeof(opts) / sizeof(opts[0]), .run = run_root};
+    tstate                 st   = {0};
+
+    calls.n          = 0;
+    const char *a1[] = {"t", "--name=alpha", "-nbeta", "-L", "--depth", "7",
+                        "--a-very-long-option-name-that-does-not-fit-in-any-fixed-size-name-buffer-whatsoever-0123456789=x"};
+    CHECK_EQI(run_vec(&root, &env, &st, 7, a1), CARGS_OK);
+    CHECK_EQI(calls.n, 6);
+    CHECK(calls.opt[0] == &opts[1]); /* the default comes first */
+    CHECK_STREQ(calls.val[0], "3");
+    CHECK(calls.opt[1] == &opts[0] && calls.len[1] == 5);
+    CHECK_STREQ(calls.val[1], "alpha");
+    CHECK(calls.opt[2] == &opts[0] && calls.len[2] == 4);
+    CHECK(calls.opt[3] == &opts[1] && calls.len[3] == 0); /* no value */
+    CHECK(calls.opt[4] == &opts[2]);
+    CHECK_STREQ(calls.val[4], "7");
+    CHECK_EQI(depth, 7); /* bound, then cb, then call */
+    CHECK_EQI(st.json, 1);
+    CHECK(calls.opt[5] == &opts[3] && calls.len[5] == 1);
+
+    /* names are matched in place: no length cap, value split off at '=' */
+    const char *a2[] = {"t", "--name=bad"};
+    CHECK_EQI(run_vec(&root, &env, &st, 2, a2), CARGS_ERR_BAD_FORMAT);
+    sink_log   log  = {{0}, 0, 0};
+    cargs_sink sink = {sink_write, &log};
+    env.err_sink    = &sink;
+    const char *a3[] = {"t", "--zzzzzz=1"};
+    CHECK_EQI(run_vec(&root, &env, &st, 2, a3), CARGS_ERR_UNKNOWN);
+    CHECK_STREQ(log.text, "Unknown option: --zzzzzz\n");
+    const char *a4[] = {"t", "--helpx=1"};
+    CHECK_EQI(run_vec(&root, &env, &st, 2, a4), CARGS_ERR_UNKNOWN); /* not --help */
+    tstate_clear(&st);
+}
+
+/* deferred callbacks: how often, and with what, each one ran */
+static struct {
+    int jobs_calls, json_calls, jobs, level;
+} evs;
+
+static int cb_ev_jobs(const char *v, void *u) {
+    (void)u;
+    evs.jobs_calls++;
+    return cargs_read_int(v, &evs.jobs) ? CARGS_ERR_BAD_FORMAT : CARGS_OK;
+}
+
+static int cb_ev_json(const char *v, void *u) {
+    (void)v;
+    (void)u;
+    evs.json_calls++;
+    return CARGS_OK;
+}
+
+static void test_deferred_events(void) {
+    cargs_env env;
+    fill_env(&env);
+    static const cargs_opt opts[] = {
+        {"jobs",  'j', CARGS_ARG_REQUIRED, "N", "jobs",  cb_ev_jobs, "CARGS_T_EJOBS", "1", 0, CARGS_GRP_NONE, {0}                                   },
+        {"level", 'L', CARGS_ARG_NONE,     NULL, "more", NULL,       NULL,            "2", 0, CARGS_GRP_NONE, CARGS_BIND(CARGS_BIND_COUNT, &evs.level)},
+        {"name",  0,   CARGS_ARG_REQUIRED, "S", "name",  NULL,       NULL,            NULL, 0, CARGS_GRP_NONE, CARGS_BIND(CARGS_BIND_STR, &cfgv.name)  },
+        {"max",   0,   CARGS_ARG_REQUIRED, "N", "max",   NULL,       NULL,            NULL, 0, CARGS_GRP_NONE, CARGS_BIND(CARGS_BIND_INT, &cfgv.jobs)  },
+        {"json",  0,   CARGS_ARG_NONE,     NULL, "json", cb_ev_json, NULL,            NULL, 1, CARGS_GRP_XOR,  {0}                                   },
+        {"yaml",  0,   CARGS_ARG_NONE,     NULL, "yaml", cb_ev_json, NULL,            NULL, 1, CARGS_GRP_XOR,  {0}                                   },
+    };
+    static const cargs_pos pos[]  = {CARGS_POS("FILE", NULL)};
+    static const cargs_cmd root   = {.opts = opts, .opt_count = 6, .pos = pos, .pos_count = 1, .run = run_root};
+    static uint64_t        snapmem[64];
+    const char            *envp[] = {"CARGS_T_EJOBS=2", NULL};
+    env.envsnap                   = cargs_envsnap_build(&root, envp, snapmem, sizeof snapmem);
+    tstate       st               = {0};
+    cargs_event  log[16];
+    cargs_events ev = {log, 16, true, 0, 0, 0};
+
+    /* at once: the env value and every -j reach the callback */
+    const char *a1[] = {"t", "-j", "3", "-j4", "--jobs=5", "f"};
+    memset(&evs, 0, sizeof evs);
+    CHECK_EQI(run_vec(&root, &env, &st, 6, a1), CARGS_OK);
+    CHECK_EQI(evs.jobs_calls, 4);
+    CHECK_EQI(evs.jobs, 5);
+
+    /* deferred, last wins: one call; the log keeps where each entry came from */
+    env.events = &ev;
+    memset(&evs, 0, sizeof evs);
+    CHECK_EQI(run_vec(&root, &env, &st, 6, a1), CARGS_OK);
+    CHECK_EQI(evs.jobs_calls, 1);
+    CHECK_EQI(evs.jobs, 5);
+    CHECK_EQI(evs.level, 2); /* the COUNT default still applies */
+    CHECK_EQI((int)ev.count, 5);
+    CHECK_EQI(log[0].source, CARGS_SRC_ENV);
+    CHECK_STREQ(log[0].value, "2");
+    CHECK(!log[0].live);
+    CHECK_EQI(log[1].source, CARGS_SRC_DEFAULT);
+    CHECK(log[1].opt == &opts[1] && log[1].live);
+    CHECK(!log[2].live && !log[3].live && log[4].live);
+    CHECK_EQI(log[4].source, CARGS_SRC_ARGV);
+
+    /* a COUNT binding builds on its default; without last_wins each -j runs */
+    ev.last_wins     = false;
+    const char *a2[] = {"t", "-LL", "-j7", "-j8", "f"};
+    memset(&evs, 0, sizeof evs);
+    CHECK_EQI(run_vec(&root, &env, &st, 5, a2), CARGS_OK);
+    CHECK_EQI(evs.level, 4);
+    CHECK_EQI(evs.jobs_calls, 2);
+    CHECK_EQI(evs.jobs, 8);
+    ev.last_wins = true;
+
+    /* transactional: a group, positional or decode error, or --help, runs none */
+    const char *bad[][5] = {{"t", "-j3", "--json", "--yaml", "f"},
+                            {"t", "-j3", "--name", "x", NULL},
+                            {"t", "-j3", "--max=12x", "f", NULL},
+                            {"t", "-j3", "--name=y", "--help", NULL}};
+    const int   rcs[]    = {CARGS_ERR_GROUP, CARGS_ERR_POSITIONAL, CARGS_ERR_BAD_FORMAT, CARGS_OK};
+    const int   argcs[]  = {5, 4, 4, 4};
+    for (size_t k = 0; k < 4; k++) {
+        memset(&evs, 0, sizeof evs);
+        cfgv.name = NULL;
+        CHECK_EQI(run_vec(&root, &env, &st, argcs[k], bad[k]), rcs[k]);
+        CHECK_EQI(evs.jobs_calls + evs.json_calls + evs.level, 0);
+        CHECK(cfgv.name == NULL);
+    }
+
+    /* typed bindings collapse too; a full log fails the parse */
+    const char *a3[] = {"t", "--name", "a", "--name=b", "f"};
+    CHECK_EQI(run_vec(&root, &env, &st, 5, a3), CARGS_OK);
+    CHECK_STREQ(st.pos_argv[0], "f");
+    CHECK_EQI((int)ev.count, 4);
+    ev.cap = 3;
+    memset(&evs, 0, sizeof evs);
+    CHECK_EQI(run_vec(&root, &env, &st, 6, a1), CARGS_ERR_TOO_MANY);
+    CHECK_EQI(evs.jobs_calls, 0);
+    ev.cap = 16;
+
+    /* an env value its callback rejects fails the parse in both modes */
+    const char *envbad[] = {"CARGS_T_EJOBS=x", NULL};
+    env.envsnap          = cargs_envsnap_build(&root, envbad, snapmem, sizeof snapmem);
+    const char *a4[]     = {"t", "f"};
+    for (int k = 0; k < 2; k++) {
+        env.events = k ? &ev : NULL;
+        memset(&evs, 0, sizeof evs);
+        st.ran_root = 0;
+        CHECK_EQI(run_vec(&root, &env, &st, 2, a4), CARGS_ERR_BAD_FORMAT);
+        CHECK_EQI(evs.jobs_calls, 1);
+        CHECK_EQI(st.ran_root, 0);
+    }
+    tstate_clear(&st);
+}
+
+static size_t read_back(FILE *f, char *buf, size_t cap) {
+    rewind(f);
+    size_t n = fread(buf, 1, cap - 1, f);
+    buf[n]   = '\0';
+    fclose(f);
+    return n;
+}
+
+static void test_batch(void) {
+    cargs_env env;
+    fill_env(&env);
+    const cargs_cmd *root;
+    build_root_basic(&root);
+    static uint64_t storage[512];
+    env.index = cargs_compile(root, storage, sizeof storage);
+    CHECK(env.index != NULL);
+
+    enum { N = 600 };
+    static char      words[N][5][24];
+    static char     *argv[N][5];
+    static tstate    st[N];
+    static cargs_job jobs[N];
+    static sink_log  logs[N];
+    static cargs_sink sinks[N];
+    /* per-call fan-out on online CPUs and on 4 threads, then one pool of 4
+       workers reused across batches of 7 */
+    for (unsigned threads = 0; threads < 9; threads += 4) {
+        memset(st, 0, sizeof st);
+        memset(logs, 0, sizeof logs);
+        for (int i = 0; i < N; i++) {
+            int argc = 0;
+            snprintf(words[i][argc++], sizeof words[0][0], "t");
+            switch (i % 3) {
+                case 0:
+                    snprintf(words[i][argc++], sizeof words[0][0], "--jobs=%d", i);
+                    snprintf(words[i][argc++], sizeof words[0][0], "remote");
+                    snprintf(words[i][argc++], sizeof words[0][0], "rm");
+                    snprintf(words[i][argc++], sizeof words[0][0], "r%d", i);
+                    break;
+                case 1: snprintf(words[i][argc++], sizeof words[0][0], "--jsno"); break;
+                default:
+                    snprintf(words[i][argc++], sizeof words[0][0], "--json");
+                    snprintf(words[i][argc++], sizeof words[0][0], "--yaml");
+                    break;
+            }
+            for (int k = 0; k < argc; k++) argv[i][k] = words[i][k];
+            sinks[i]      = (cargs_sink){sink_write, &logs[i]};
+            jobs[i]       = (cargs_job){0};
+            jobs[i].argc  = argc;
+            jobs[i].argv  = argv[i];
+            jobs[i].user  = &st[i];
+            jobs[i].err   = &sinks[i];
+        }
+        if (threads < 8) {
+            CHECK_EQI((int)cargs_dispatch_batch(&env, root, jobs, N, threads), 2 * N / 3);
+        } else {
+            cargs_pool pool;
+            unsigned   nt = cargs_pool_start(&pool, 4);
+            CHECK(nt >= 1 && nt <= 4 && pool.threads == nt);
+            size_t failed = 0;
+            for (size_t i = 0; i < N; i += 7) failed += cargs_pool_dispatch(&pool, &env, root, jobs + i, N - i < 7 ? N - i : 7);
+            CHECK_EQI((int)failed, 2 * N / 3);
+            cargs_pool_stop(&pool);
+            CHECK_EQI((int)pool.threads, 0);
+        }
+        int bad = 0;
+        for (int i = 0; i < N; i++) {
+            switch (i % 3) {
+                case 0:
+                    bad += jobs[i].rc != CARGS_OK || st[i].jobs != i || !st[i].ran_remote_rm || logs[i].writes != 0;
+                    bad += st[i].pos_argc != 1 || strcmp(st[i].pos_argv[0], words[i][4]) != 0;
+                    break;
+                case 1:
+                    bad += jobs[i].rc != CARGS_ERR_UNKNOWN || jobs[i].error.arg != argv[i][1];
+                    bad += !jobs[i].error.suggestion || strcmp(jobs[i].error.suggestion, "json") != 0;
+                    bad += strcmp(logs[i].text, "Unknown option: --jsno (did you mean --json?)\n") != 0;
+                    break;
+                default:
+                    bad += jobs[i].rc != CARGS_ERR_GROUP || logs[i].writes != 1 || jobs[i].error.code != CARGS_OK;
+                    break;
+            }
+            tstate_clear(&st[i]);
+        }
+        CHECK_EQI(bad, 0);
+    }
+
+    /* edge cases: nothing to do, more threads than jobs */
+    CHECK_EQI((int)cargs_dispatch_batch(&env, root, jobs, 0, 4), 0);
+    CHECK_EQI((int)cargs_dispatch_batch(&env, root, jobs, 2, 64), 1);
+    tstate_clear(&st[0]);
+    cargs_pool idle;
+    CHECK(cargs_pool_start(&idle, 0) >= 1);
+    CHECK_EQI((int)cargs_pool_dispatch(&idle, &env, root, jobs, 0), 0);
+    cargs_pool_stop(&idle); /* workers that never got a batch */
+    CHECK_EQI((int)cargs_pool_dispatch(NULL, &env, root, jobs, 2), 1); /* no pool: the caller alone */
+    tstate_clear(&st[0]);
+    /* concurrent --help jobs: env->help_buf is not shared between them */
+    static char help_buf[64], page[2048], all[2048 * 16];
+    static char a0[] = "t", a1[] = "--help";
+    static char *hargv[] = {a0, a1, NULL};
+    FILE       *f      = tmpfile();
+    CHECK(f != NULL);
+    if (!f) return;
+    env.out          = f;
+    env.help_buf     = help_buf;
+    env.help_buf_cap = sizeof help_buf;
+    for (int i = 0; i < 16; i++) {
+        jobs[i]      = (cargs_job){0};
+        jobs[i].argc = 2;
+        jobs[i].argv = hargv;
+        jobs[i].user = &st[i];
+    }
+    CHECK_EQI((int)cargs_dispatch_batch(&env, root, jobs, 1, 1), 0);
+    size_t n = read_back(f, page, sizeof page);
+    CHECK(n > sizeof help_buf && n < sizeof page);
+    f = tmpfile();
+    CHECK(f != NULL);
+    if (!f) return;
+    env.out = f;
+    CHECK_EQI((int)cargs_dispatch_batch(&env, root, jobs, 16, 4), 0);
+    CHECK_EQI((int)read_back(f, all, sizeof all), (int)(16 * n));
+    int torn = 0;
+    for (int i = 0; i < 16; i++) torn += jobs[i].rc != CARGS_OK || memcmp(all + (size_t)i * n, page, n) != 0;
+    CHECK_EQI(torn, 0);
+}
+
+static void test_parse_line(void) {
+    cargs_env env;
+    fill_env(&env);
+    const cargs_cmd *root;
+    build_root_basic(&root);
+    static uint64_t storage[2048];
+    cargs_parser    p;
+    CHECK(cargs_parser_size(root) <= sizeof storage);
+    CHECK_EQI(cargs_parser_init(&p, &env, root, storage, sizeof storage), 0);
+    CHECK(p.env.index && p.env.index->root == root);
+    CHECK(p.env.envsnap != NULL);
+    CHECK(p.env.pres == &p.pres);
+    CHECK_EQI(cargs_parser_init(&p, &env, root, storage, 16), -1);
+    CHECK_EQI(cargs_parser_init(&p, &env, root, storage, sizeof storage), 0);
+
+    char          buf[128], *argv[8];
+    sink_log      log = {{0}, 0, 0};
+    cargs_sink    sink = {sink_write, &log};
+    cargs_scratch sc   = {buf, sizeof buf, argv, 8, &sink, NULL};
+    tstate        st   = {0};
+
+    static const char l1[] = "  -j 4 remote add origin \"git@x y\"\n";
+    CHECK_EQI(cargs_parse_line(&p, l1, sizeof l1 - 1, &sc, &st), CARGS_OK);
+    CHECK_EQI(st.jobs, 4);
+    CHECK_EQI(st.ran_remote_add, 1);
+    CHECK_EQI(st.pos_argc, 2);
+    CHECK_STREQ(st.pos_argv[0], "origin");
+    CHECK_STREQ(st.pos_argv[1], "git@x y");
+    CHECK_EQI(log.writes, 0);
+
+    /* errors go to this call's sink, not env->err; len bounds the line */
+    static const char l2[] = "--nope trailing-ignored";
+    CHECK_EQI(cargs_parse_line(&p, l2, 6, &sc, &st), CARGS_ERR_UNKNOWN);
+    CHECK_STREQ(log.text, "Unknown option: --nope\n");
+    CHECK_EQI(log.writes, 1);
+
+    CHECK_EQI(cargs_parse_line(&p, "'open", 5, &sc, &st), CARGS_ERR_BAD_FORMAT);
+    CHECK_EQI(log.writes, 2);
+    sc.argv_cap = 3;
+    CHECK_EQI(cargs_parse_line(&p, "a b c", 5, &sc, &st), CARGS_ERR_BAD_FORMAT);
+    sc.argv_cap = 8;
+    sc.cap      = 8;
+    CHECK_EQI(cargs_parse_line(&p, "-j 1 x y", 8, &sc, &st), CARGS_ERR_BAD_FORMAT);
+    CHECK_EQI(log.writes, 4);
+
+    /* empty line: root with no positionals */
+    sc.cap = sizeof buf;
+    CHECK_EQI(cargs_parse_line(&p, "", 0, &sc, &st), CARGS_OK);
+    CHECK_EQI(st.ran_root, 1);
+    tstate_clear(&st);
+
+    /* lines are untrusted: @file stays a literal word unless the parser opts
+       in, whatever env->response_files says */
+    static uint64_t   mem[1024];
+    cargs_arena       a;
+    static const char l3[] = "remote add origin @cargs_line.rsp";
+    write_file("cargs_line.rsp", "-j 7", 4);
+    cargs_arena_init(&a, mem, sizeof mem);
+    env.response_files = true;
+    env.arena          = &a;
+    CHECK_EQI(cargs_parser_init(&p, &env, root, storage, sizeof storage), 0);
+    CHECK(!p.response_files);
+    CHECK_EQI(cargs_parse_line(&p, l3, sizeof l3 - 1, &sc, &st), CARGS_OK);
+    CHECK_EQI(st.pos_argc, 2);
+    if (st.pos_argc == 2) CHECK_STREQ(st.pos_argv[1], "@cargs_line.rsp");
+    tstate_clear(&st);
+    p.response_files = true;
+    sc.arena         = &a;
+    CHECK_EQI(cargs_parse_line(&p, "@cargs_line.rsp", 15, &sc, &st), CARGS_OK);
+    CHECK_EQI(st.jobs, 7);
+    sc.arena = NULL;
+
+    /* the parser's own env->arena is shared, so it is never written */
+    sc.cap  = 8;
+    log.len = 0;
+    cargs_arena_init(&a, mem, sizeof mem);
+    CHECK_EQI(cargs_parse_line(&p, "-j 1 x y", 8, &sc, &st), CARGS_ERR_BAD_FORMAT);
+    CHECK_EQI((int)a.high, 0);
+    CHECK_STREQ(log.text, "Command line too long (8 bytes)\n");
+    remove("cargs_line.rsp");
+    tstate_clear(&st);
+}
+
+/* groups above 32, at-least-one groups and relations, reported by name */
+static void test_group_relations(void) {
+    static const cargs_opt opts[] = {
+        {"json",    0,   CARGS_ARG_NONE,     NULL,  "json",   cb_json,    NULL, NULL, 40, CARGS_GRP_XOR,  {0}},
+        {"yaml",    0,   CARGS_ARG_NONE,     NULL,  "yaml",   cb_yaml,    NULL, NULL, 40, CARGS_GRP_XOR,  {0}},
+        {"src",     0,   CARGS_ARG_REQUIRED, "DIR", "source", NULL,       NULL, NULL, 63, CARGS_GRP_ANY,  {0}},
+        {"url",     0,   CARGS_ARG_REQUIRED, "URL", "remote", NULL,       NULL, NULL, 63, CARGS_GRP_ANY,  {0}},
+        {"output",  'o', CARGS_ARG_REQUIRED, "F",   "output", NULL,       NULL, NULL, 0,  CARGS_GRP_NONE, {0}},
+        {"format",  0,   CARGS_ARG_REQUIRED, "F",   "format", NULL,       NULL, NULL, 0,  CARGS_GRP_NONE, {0}},
+        {"level",   0,   CARGS_ARG_REQUIRED, "N",   "level",  cb_jobs,    NULL, "1",  0,  CARGS_GRP_NONE, {0}},
+        {"cache",   0,   CARGS_ARG_NONE,     NULL,  "cache",  NULL,       NULL, NULL, 0,  CARGS_GRP_NONE, {0}},
+        {NULL,      'q', CARGS_ARG_NONE,     NULL,  "quiet",  NULL,       NULL, NULL, 0,  CARGS_GRP_NONE, {0}},
+        {"verbose", 'V', CARGS_ARG_NONE,     NULL,  "more",   cb_verbose, NULL, NULL, 0,  CARGS_GRP_NONE, {0}},
+    };
+    static const cargs_rel rels[] = {
+        {CARGS_REL_REQUIRES,  "output", "format"},
+        {CARGS_REL_REQUIRES,  "cache",  "level" }, /* satisfied by the default */
+        {CARGS_REL_CONFLICTS, "q",      "verbose"},
+    };
+    static const cargs_cmd root = {
+        .opts      = opts,
+        .opt_count = sizeof(opts) / sizeof(opts[0]),
+        .run       = run_root,
+        .rels      = rels,
+        .rel_count = sizeof(rels) / sizeof(rels[0]),
+    };
+    static uint64_t storage[2048];
+    cargs_env       env;
+    fill_env(&env);
+    sink_log   log  = {{0}, 0, 0};
+    cargs_sink sink = {sink_write, &log};
+    env.err_sink    = &sink;
+    tstate st       = {0};
+
+    for (int pass = 0; pass < 2; pass++) {
+        env.index = pass ? cargs_compile(&root, storage, sizeof storage) : NULL;
+        CHECK(!pass || env.index);
+        if (pass) CHECK(env.index->nodes[0].groups.xor_mask == 1ull << 40);
+        if (pass) CHECK(env.index->nodes[0].groups.any_mask == 1ull << 63);
+
+        const char *ok[] = {"t", "--src", "a", "--url=b", "--yaml", "--cache", "-o", "x", "--format", "y"};
+        CHECK_EQI(run_vec(&root, &env, &st, 10, ok), CARGS_OK);
+        CHECK_EQI(st.yaml, 1);
+
+        log.len          = 0;
+        const char *a1[] = {"t", "--json"};
+        CHECK_EQI(run_vec(&root, &env, &st, 2, a1), CARGS_ERR_GROUP);
+        CHECK_STREQ(log.text, "At least one of --src, --url is required\n");
+
+        log.len          = 0;
+        const char *a2[] = {"t", "--src", "a", "--json", "--yaml"};
+        CHECK_EQI(run_vec(&root, &env, &st, 5, a2), CARGS_ERR_GROUP);
+        CHECK_STREQ(log.text, "Options '--json' and '--yaml' are mutually exclusive\n");
+
+        log.len          = 0;
+        const char *a3[] = {"t", "--src", "a", "--json", "--json"};
+        CHECK_EQI(run_vec(&root, &env, &st, 5, a3), CARGS_ERR_GROUP);
+        CHECK_STREQ(log.text, "Option '--json' may be used only once\n");
+
+        log.len          = 0;
+        const char *a4[] = {"t", "--src", "a", "-o", "x"};
+        CHECK_EQI(run_vec(&root, &env, &st, 5, a4), CARGS_ERR_GROUP);
+        CHECK_STREQ(log.text, "Option '--output' requires '--format'\n");
+
+        log.len          = 0;
+        const char *a5[] = {"t", "--src", "a", "-qV"};
+        CHECK_EQI(run_vec(&root, &env, &st, 4, a5), CARGS_ERR_GROUP);
+        CHECK_STREQ(log.text, "Options '-q' and '--verbose' cannot be used together\n");
+        tstate_clear(&st);
+    }
+
+    /* required groups are reported before relations; exactly-one wording */
+    const cargs_cmd *req;
+    build_root_req_one(&req);
+    env.index        = NULL;
+    log.len          = 0;
+    const char *r1[] = {"t"};
+    CHECK_EQI(run_vec(req, &env, &st, 1, r1), CARGS_ERR_GROUP);
+    CHECK_STREQ(log.text, "Exactly one of --light, --dark is required\n");
+
+    /* relation endpoints must name options of the command */
+    static const cargs_rel  bad_rels[] = {{CARGS_REL_CONFLICTS, "json", "nope"}};
+    static const cargs_cmd  bad        = {
+        .opts      = opts,
+        .opt_count = sizeof(opts) / sizeof(opts[0]),
+        .rels      = bad_rels,
+        .rel_count = 1,
+    };
+    log.len = 0;
+    CHECK_EQI(run_vec(&bad, &env, &st, 1, r1), CARGS_ERR_BAD_FORMAT);
+    CHECK_STREQ(log.text, "Relation 'json' conflicts with 'nope': no option 'nope'\n");
+
+    /* long option lists come from the arena; names are never cut */
+    static char      gnames[10][48];
+    static cargs_opt gopts[10];
+    for (int k = 0; k < 10; k++) {
+        snprintf(gnames[k], sizeof gnames[k], "a-rather-long-option-name-%02d", k);
+        memset(&gopts[k], 0, sizeof gopts[k]);
+        gopts[k].long_name    = gnames[k];
+        gopts[k].group        = 1;
+        gopts[k].group_policy = CARGS_GRP_ANY;
+    }
+    cargs_cmd gcmd;
+    memset(&gcmd, 0, sizeof gcmd);
+    gcmd.opts      = gopts;
+    gcmd.opt_count = 10;
+    gcmd.run       = run_root;
+    cargs_arena ar;
+    cargs_arena_init(&ar, storage, sizeof storage);
+    env.arena = &ar;
+    log.len   = 0;
+    CHECK_EQI(run_vec(&gcmd, &env, &st, 1, r1), CARGS_ERR_GROUP);
+    CHECK(strncmp(log.text, "At least one of --a-rather-long-option-name-00, ", 48) == 0);
+    CHECK(ar.used == 0);
+    env.arena = NULL;
+    log.len   = 0;
+    CHECK_EQI(run_vec(&gcmd, &env, &st, 1, r1), CARGS_ERR_TOO_MANY);
+    CHECK_STREQ(log.text, "At least one of group 1 is required (its option list needs env->arena)\n");
+}
+
+/* applets from argv[0], unique-prefix matching and the sorted name table */
+static void test_multicall_and_prefix(void) {
+    static const char     *list_alias[] = {"ls"};
+    static const cargs_cmd remote_subs[] = {
+        {.name = "add",  .run = run_remote_add},
+        {.name = "show", .run = run_remote_rm },
+    };
+    static const cargs_cmd subs[] = {
+        {.name = "list", .aliases = list_alias, .alias_count = 1, .run = run_remote_add},
+        {.name = "log", .run = run_remote_rm},
+        {.name = "remote", .subs = remote_subs, .sub_count = 2},
+    };
+    static const cargs_cmd root = {.subs = subs, .sub_count = 3, .run = run_root};
+    static uint64_t        storage[2048];
+    cargs_env              env;
+    fill_env(&env);
+    sink_log   log  = {{0}, 0, 0};
+    cargs_sink sink = {sink_write, &log};
+    env.err_sink    = &sink;
+    tstate st       = {0};
+
+    for (int pass = 0; pass < 2; pass++) {
+        env.index      = pass ? cargs_compile(&root, storage, sizeof storage) : NULL;
+        env.sub_prefix = false;
+        if (pass) {
+            const cargs_index_node *nd = &env.index->nodes[0];
+            CHECK_EQI((int)nd->name_count, 4);
+            CHECK_STREQ(nd->names[0].name, "list");
+            CHECK_STREQ(nd->names[2].name, "ls");
+            CHECK_EQI((int)nd->names[2].sub, 0);
+            CHECK_STREQ(nd->names[3].name, "remote");
+        }
+
+        /* argv[0] selects the applet; otherwise the first word does */
+        const char *m1[] = {"/usr/bin/ls", "dir"};
+        CHECK_EQI(cargs_dispatch_multicall(&env, &root, 2, (char **)(void *)m1, &st), CARGS_OK);
+        CHECK_EQI(st.ran_remote_add, 1);
+        CHECK_EQI(st.pos_argc, 1);
+        CHECK_STREQ(st.pos_argv[0], "dir");
+        tstate_clear(&st);
+        st               = (tstate){0};
+        const char *m2[] = {"box", "log"};
+        CHECK_EQI(cargs_dispatch_multicall(&env, &root, 2, (char **)(void *)m2, &st), CARGS_OK);
+        CHECK_EQI(st.ran_remote_rm, 1);
+
+        /* prefixes are off by default: "rem" is a positional of the root */
+        st               = (tstate){0};
+        const char *p1[] = {"t", "rem"};
+        CHECK_EQI(run_vec(&root, &env, &st, 2, p1), CARGS_OK);
+        CHECK_EQI(st.ran_root, 1);
+        tstate_clear(&st);
+
+        env.sub_prefix = true;
+        st             = (tstate){0};
+        const char *p2[] = {"t", "rem", "sh"};
+        CHECK_EQI(run_vec(&root, &env, &st, 3, p2), CARGS_OK);
+        CHECK_EQI(st.ran_remote_rm, 1);
+        st               = (tstate){0};
+        const char *p3[] = {"t", "li", "x"};
+        CHECK_EQI(run_vec(&root, &env, &st, 3, p3), CARGS_OK);
+        CHECK_EQI(st.ran_remote_add, 1);
+        CHECK_STREQ(st.pos_argv[0], "x");
+        tstate_clear(&st);
+
+        /* "l" starts list, ls (same command) and log */
+        log.len          = 0;
+        const char *p4[] = {"t", "l"};
+        CHECK_EQI(run_vec(&root, &env, &st, 2, p4), CARGS_ERR_UNKNOWN);
+        CHECK_STREQ(log.text, "Ambiguous command 'l': list, log\n");
+
+        /* applets never match by prefix */
+        st               = (tstate){0};
+        const char *m3[] = {"/bin/lis", "log"};
+        CHECK_EQI(cargs_dispatch_multicall(&env, &root, 2, (char **)(void *)m3, &st), CARGS_OK);
+        CHECK_EQI(st.ran_remote_rm, 1);
+    }
+
+    /* lists past their 256-byte buffer: whole from the arena, an error without */
+    static char      lnames[12][40];
+    static cargs_cmd lsubs[12];
+    for (int k = 0; k < 12; k++) {
+        snprintf(lnames[k], sizeof lnames[k], "xsubcommand-with-a-long-name-%02d", k);
+        memset(&lsubs[k], 0, sizeof lsubs[k]);
+        lsubs[k].name = lnames[k];
+        lsubs[k].run  = run_remote_add;
+    }
+    cargs_cmd lroot;
+    memset(&lroot, 0, sizeof lroot);
+    lroot.subs      = lsubs;
+    lroot.sub_count = 12;
+    cargs_arena ar;
+    cargs_arena_init(&ar, storage, sizeof storage);
+    static char back[1024];
+    FILE       *f    = tmpfile();
+    CHECK(f != NULL);
+    if (!f) return;
+    env.index        = NULL;
+    env.err_sink     = NULL;
+    env.err          = f;
+    env.arena        = &ar;
+    const char *p5[] = {"t", "x"};
+    CHECK_EQI(run_vec(&lroot, &env, &st, 2, p5), CARGS_ERR_UNKNOWN);
+    read_back(f, back, sizeof back);
+    CHECK(strncmp(back, "Ambiguous command 'x': xsubcommand-with-a-long-name-00, ", 56) == 0);
+    CHECK(strstr(back, ", xsubcommand-with-a-long-name-11\n") != NULL);
+    CHECK(ar.used == 0);
+    env.err_sink = &sink;
+    env.arena    = NULL;
+    log.len      = 0;
+    CHECK_EQI(run_vec(&lroot, &env, &st, 2, p5), CARGS_ERR_TOO_MANY);
+    CHECK_STREQ(log.text, "Ambiguous command 'x' (the list of matches needs env->arena)\n");
+
+    /* applet names are matched in place, whatever their length */
+    static char longname[160];
+    memset(longname, 'a', sizeof longname - 1);
+    memcpy(longname + 8, "/", 1);
+    lsubs[3].name     = longname + 9;
+    const char *m4[]  = {longname, "y"};
+    st                = (tstate){0};
+    CHECK_EQI(cargs_dispatch_multicall(&env, &lroot, 2, (char **)(void *)m4, &st), CARGS_OK);
+    CHECK(st.ran_remote_add == 1 && st.pos_argc == 1);
+    tstate_clear(&st);
+}
+
+/* "did you mean" hints in the message and in env->error */
+static void test_suggestions(void) {
+    cargs_env env;
+    fill_env(&env);
+    const cargs_cmd *root;
+    build_root_basic(&root);
+    sink_log    log  = {{0}, 0, 0};
+    cargs_sink  sink = {sink_write, &log};
+    cargs_error err  = {0};
+    env.err_sink     = &sink;
+    env.error        = &err;
+    tstate st        = {0};
+
+    const char *a1[] = {"t", "--jsno"};
+    CHECK_EQI(run_vec(root, &env, &st, 2, a1), CARGS_ERR_UNKNOWN);
+    CHECK_STREQ(log.text, "Unknown option: --jsno (did you mean --json?)\n");
+    CHECK_EQI(err.code, CARGS_ERR_UNKNOWN);
+    CHECK_STREQ(err.suggestion, "json");
+    CHECK(!err.command);
+
+    log.len          = 0;
+    const char *a2[] = {"t", "--verbos=1"};
+    CHECK_EQI(run_vec(root, &env, &st, 2, a2), CARGS_ERR_UNKNOWN);
+    CHECK_STREQ(log.text, "Unknown option: --verbos (did you mean --verbose?)\n");
+
+    /* built-ins are candidates too; far-off words get no hint */
+    log.len          = 0;
+    const char *a3[] = {"t", "--hlep"};
+    CHECK_EQI(run_vec(root, &env, &st, 2, a3), CARGS_ERR_UNKNOWN);
+    CHECK_STREQ(err.suggestion, "help");
+    const char *a4[] = {"t", "--zzzzzz"};
+    CHECK_EQI(run_vec(root, &env, &st, 2, a4), CARGS_ERR_UNKNOWN);
+    CHECK(err.suggestion == NULL);
+
+    /* a near-miss subcommand word where no positionals are accepted */
+    log.len          = 0;
+    const char *a5[] = {"t", "remtoe", "add"};
+    CHECK_EQI(run_vec(root, &env, &st, 3, a5), CARGS_ERR_UNKNOWN);
+    CHECK_STREQ(log.text, "Unknown command: remtoe (did you mean remote?)\n");
+    CHECK(err.command);
+    char  w0[] = "t", w1[] = "remtoe";
+    char *av[] = {w0, w1};
+    CHECK_EQI(cargs_dispatch(&env, root, 2, av, &st), CARGS_ERR_UNKNOWN);
+    CHECK(err.arg == av[1]); /* points into argv */
+    const char *a6[] = {"t", "elsewhere"};
+    CHECK_EQI(run_vec(root, &env, &st, 2, a6), CARGS_OK);
+    CHECK_EQI(err.code, CARGS_OK);
+    tstate_clear(&st);
+
+    /* the budget bounds the candidates compared; negative disables hints */
+    env.suggest_budget = 1;
+    CHECK_EQI(run_vec(root, &env, &st, 2, a1), CARGS_ERR_UNKNOWN);
+    CHECK(err.suggestion == NULL);
+    env.suggest_budget = -1;
+    log.len            = 0;
+    CHECK_EQI(run_vec(root, &env, &st, 2, a1), CARGS_ERR_UNKNOWN);
+    CHECK_STREQ(log.text, "Unknown option: --jsno\n");
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+typedef struct {
+    size_t calls, seen, first_ok;
+    char   items[16][16];
+} batch_log;
+
+static int on_batch(size_t first, size_t n, char **items, void *user) {
+    batch_log *b = (batch_log *)user;
+    b->first_ok += first == b->seen;
+    for (size_t k = 0; k < n && b->seen < 16; k++, b->seen++) snprintf(b->items[b->seen], 16, "%s", items[k]);
+    b->calls++;
+    return CARGS_OK;
+}
+
+static int run_nop(int argc, char **argv, void *user) {
+    (void)argc, (void)argv, (void)user;
+    return CARGS_OK;
+}
+
+static void test_streaming_positionals(void) {
+    cargs_env env;
+    fill_env(&env);
+    static const cargs_pos pos[]  = {CARGS_POS_N("SRC", NULL, 1, CARGS_POS_INF), CARGS_POS("DST", NULL)};
+    static const cargs_pos pos3[] = {CARGS_POS_N("X", NULL, 1, 3)};
+    cargs_cmd              root   = {.pos = pos, .pos_count = 2, .run = run_nop, .pos_batch = on_batch};
+    char                   buf[12], *items[3];
+    cargs_stream           st  = {-1, '\0', buf, sizeof buf, items, 3};
+    batch_log              log = {0};
+    static const char      data[] = "alpha\0b\0\0charlie\0d\0e\0f\0last";
+    write_file("cargs_pos_nul.txt", data, sizeof data - 1);
+    write_file("cargs_pos_long.txt", "short\nwaytoolongitem\n", 21);
+    env.stream = &st;
+
+    /* unarmed stream: plain argv validation, naming the item left short */
+    char       a0[] = "t", a1[] = "dst";
+    char      *argv[] = {a0, a1};
+    sink_log   msgs   = {0};
+    cargs_sink sink   = {sink_write, &msgs};
+    env.err_sink      = &sink;
+    CHECK_EQI(cargs_dispatch(&env, &root, 2, argv, &log), CARGS_ERR_POSITIONAL);
+    CHECK_STREQ(msgs.text, "Missing required positional DST: need at least 2, got 1\n");
+
+    /* a stream without buffers is reported, not just refused */
+    st.fd    = 0;
+    st.items = NULL;
+    msgs.len = 0;
+    CHECK_EQI(cargs_dispatch(&env, &root, 2, argv, &log), CARGS_ERR_BAD_FORMAT);
+    CHECK_STREQ(msgs.text, "Positional stream needs buf (cap >= 2) and items (cap >= 1)\n");
+    CHECK_EQI((int)log.calls, 0);
+    st.items = items;
+
+    /* an empty stream: the streamed total names the missing item too */
+    write_file("cargs_pos_empty.txt", "", 0);
+    st.fd    = open("cargs_pos_empty.txt", O_RDONLY);
+    msgs.len = 0;
+    CHECK_EQI(cargs_dispatch(&env, &root, 2, argv, &log), CARGS_ERR_POSITIONAL);
+    close(st.fd);
+    CHECK_STREQ(msgs.text, "Missing required positional DST: need at least 2, got 1\n");
+    remove("cargs_pos_empty.txt");
+    memset(&log, 0, sizeof log);
+    env.err_sink = NULL;
+
+    st.fd = open("cargs_pos_nul.txt", O_RDONLY);
+    CHECK_EQI(cargs_dispatch(&env, &root, 2, argv, &log), CARGS_OK);
+    close(st.fd);
+    CHECK_EQI((int)log.seen, 8); /* argv item + 7 (empty one skipped) */
+    CHECK_EQI((int)log.first_ok, (int)log.calls);
+    CHECK(log.calls >= 4); /* batches of <= 3 through a 12-byte buffer */
+    CHECK_STREQ(log.items[0], "dst");
+    CHECK_STREQ(log.items[1], "alpha");
+    CHECK_STREQ(log.items[2], "b");
+    CHECK_STREQ(log.items[3], "charlie");
+    CHECK_STREQ(log.items[7], "last");
+
+    /* max is enforced before the batch that would overflow it */
+    memset(&log, 0, sizeof log);
+    root.pos       = pos3;
+    root.pos_count = 1;
+    st.fd          = open("cargs_pos_nul.txt", O_RDONLY);
+    CHECK_EQI(cargs_dispatch(&env, &root, 1, argv, &log), CARGS_ERR_TOO_MANY);
+    close(st.fd);
+    CHECK((int)log.seen <= 3);
+
+    /* newline mode; an item that cannot fit the buffer is an error */
+    root.pos       = pos;
+    root.pos_count = 2;
+    st.delim       = '\n';
+    st.fd          = open("cargs_pos_long.txt", O_RDONLY);
+    CHECK_EQI(cargs_dispatch(&env, &root, 2, argv, &log), CARGS_ERR_BAD_FORMAT);
+    close(st.fd);
+
+    remove("cargs_pos_nul.txt");
+    remove("cargs_pos_long.txt");
+}
+#endif
+
+static size_t emit_to(char *buf, size_t cap, void (*emit)(const cargs_env *, const cargs_cmd *, const char *, FILE *),
+                      const cargs_env *env, const cargs_cmd *root) {
+    FILE *f = tmpfile();
+    if (!f) return 0;
+    emit(env, root, "my-tool", f);
+    rewind(f);
+    size_t n = fread(buf, 1, cap - 1, f);
+    buf[n]   = '\0';
+    fclose(f);
+    return n;
+}
+
+static void test_completion_tables(void) {
+    cargs_env env;
+    fill_env(&env);
+    const cargs_cmd *root;
+    build_root_basic(&root);
+    static char out[8192];
+
+    /* scopes in preorder: root 0, remote 1, add 2, remove 3 */
+    CHECK(emit_to(out, sizeof out, cargs_emit_completion_bash, &env, root) > 0);
+    CHECK(strstr(out, "declare -gA _my_tool_next=(") != NULL);
+    CHECK(strstr(out, "[\"0/remote\"]=1\n") != NULL);
+    CHECK(strstr(out, "[\"1/add\"]=2\n") != NULL);
+    CHECK(strstr(out, "[\"1/rm\"]=3\n") != NULL); /* alias */
+    CHECK(strstr(out, "[\"0/--jobs\"]=+\n") != NULL);
+    CHECK(strstr(out, "[\"0/-j\"]=+\n") != NULL);
+    CHECK(strstr(out, "[\"0/--limit\"]") == NULL); /* optional value: not skipped */
+    CHECK(strstr(out, "[1]=\"--help -h add remove rm\"\n") != NULL);
+    CHECK(strstr(out, "[0]=\"--verbose -V --jobs -j --limit -l --json --yaml --help -h --version -v --author remote\"") !=
+          NULL);
+    CHECK(strstr(out, "complete -F _my-tool_complete my-tool\n") != NULL);
+
+    CHECK(emit_to(out, sizeof out, cargs_emit_completion_zsh, &env, root) > 0);
+    CHECK(strstr(out, "'1/rm' 3\n") != NULL);
+    CHECK(strstr(out, "  '--help -h add remove rm'\n") != NULL);
+    CHECK(strstr(out, "compdef _my-tool my-tool\n") != NULL);
+
+    CHECK(emit_to(out, sizeof out, cargs_emit_completion_fish, &env, root) > 0);
+    CHECK(strstr(out, "set -g __my_tool_n1_(string escape --style=var -- 'rm') 3\n") != NULL);
+    CHECK(strstr(out, "set -g __my_tool_c3 '--help' 'Show help' '-h' 'Show help'\n") != NULL);
+    CHECK(strstr(out, "complete -c my-tool -a '(__my-tool_complete)'\n") != NULL);
+}
+
+static size_t cached_to(char *buf, size_t cap, const cargs_env *env, const cargs_cmd *root, const cargs_blobs *blobs,
+                        cargs_blob_kind kind, int *rc) {
+    FILE *f = tmpfile();
+    if (!f) return 0;
+    *rc = cargs_emit_cached(env, root, "my-tool", f, blobs, kind);
+    rewind(f);
+    size_t n = fread(buf, 1, cap - 1, f);
+    buf[n]   = '\0';
+    fclose(f);
+    return n;
+}
+
+static void test_blobs(void) {
+    cargs_env env;
+    fill_env(&env);
+    const cargs_cmd *root;
+    build_root_basic(&root);
+    static char live[8192], out[65536];
+
+    /* the hash follows everything the emitters render */
+    uint64_t  h = cargs_tree_hash(&env, root, "my-tool");
+    cargs_cmd c = *root;
+    CHECK(cargs_tree_hash(&env, &c, "my-tool") == h);
+    c.desc = "Changed";
+    CHECK(cargs_tree_hash(&env, &c, "my-tool") != h);
+    c.desc = NULL;
+    CHECK(cargs_tree_hash(&env, &c, "my-tool") != cargs_tree_hash(&env, &c, "my-tool ")); /* prog */
+    cargs_env e2 = env;
+    e2.version   = "9.9";
+    CHECK(cargs_tree_hash(&e2, root, "my-tool") != h);
+    cargs_opt opts[8];
+    memcpy(opts, root->opts, root->opt_count * sizeof(cargs_opt));
+    c            = *root;
+    c.opts       = opts;
+    opts[1].help = "workers";
+    CHECK(cargs_tree_hash(&env, &c, "my-tool") != h);
+
+    /* matching hash: served verbatim; stale or missing: rendered live */
+    CHECK(emit_to(live, sizeof live, cargs_emit_completion_bash, &env, root) > 0);
+    cargs_blobs b  = {h, {"md", "man", "bash!", "zsh", "fish"}, {2, 3, 5, 3, 4}};
+    int         rc = -1;
+    CHECK_EQI((int)cached_to(out, sizeof out, &env, root, &b, CARGS_BLOB_BASH, &rc), 5);
+    CHECK_EQI(rc, 0);
+    CHECK_STREQ(out, "bash!");
+    b.tree_hash = h + 1;
+    cached_to(out, sizeof out, &env, root, &b, CARGS_BLOB_BASH, &rc);
+    CHECK_EQI(rc, 1);
+    CHECK_STREQ(out, live);
+    cached_to(out, sizeof out, &env, root, NULL, CARGS_BLOB_BASH, &rc);
+    CHECK_EQI(rc, 1);
+    CHECK_STREQ(out, live);
+
+    /* checked once, then served without hashing again */
+    CHECK(cargs_blobs_check(&env, root, "my-tool", &b) == NULL);
+    CHECK(cargs_blobs_check(&env, root, "my-tool", NULL) == NULL);
+    b.tree_hash = h;
+    CHECK(cargs_blobs_check(&env, root, "my-tool", &b) == &b);
+    FILE *f = tmpfile();
+    CHECK(f != NULL);
+    if (!f) return;
+    CHECK_EQI(cargs_emit_checked(&env, root, "my-tool", f, &b, CARGS_BLOB_ZSH), 0);
+    CHECK_EQI(cargs_emit_checked(&env, root, "my-tool", f, NULL, CARGS_BLOB_BASH), 1);
+    CHECK_EQI((int)read_back(f, out, sizeof out), (int)(3 + strlen(live)));
+    CHECK(strncmp(out, "zsh", 3) == 0 && strcmp(out + 3, live) == 0);
+
+    /* the generated header: hash line first, then byte arrays */
+    f = tmpfile();
+    CHECK(f != NULL);
+    if (!f) return;
+    CHECK_EQI(cargs_emit_blobs(&env, root, "my-tool", f, "my_blobs"), 0);
+    rewind(f);
+    size_t n = fread(out, 1, sizeof out - 1, f);
+    out[n]   = '\0';
+    fclose(f);
+    char want[64];
+    snprintf(want, sizeof want, "/* cargs blobs: tree 0x%016llx */\n", (unsigned long long)h);
+    CHECK(strncmp(out, want, strlen(want)) == 0);
+    CHECK(strstr(out, "static const char my_blobs_2[] = {\n    100,101,99,") != NULL); /* "dec" */
+    CHECK(strstr(out, "static const cargs_blobs my_blobs = {\n") != NULL);
+
+    /* the generator only rewrites a header built for another tree */
+    remove("cargs_blobs.h");
+    CHECK_EQI(cargs_write_blobs(&env, root, "my-tool", "cargs_blobs.h", "my_blobs"), 0);
+    CHECK_EQI(cargs_write_blobs(&env, root, "my-tool", "cargs_blobs.h", "my_blobs"), 1);
+    CHECK_EQI(cargs_write_blobs(&e2, root, "my-tool", "cargs_blobs.h", "my_blobs"), 0);
+    CHECK_EQI(cargs_write_blobs(&env, root, "my-tool", NULL, "my_blobs"), -1);
+    /* the temporary is per process, and renamed into place */
+    char tmp_name[64];
+    snprintf(tmp_name, sizeof tmp_name, "cargs_blobs.h.%lu.tmp", (unsigned long)getpid());
+    FILE *tmp = fopen(tmp_name, "r");
+    CHECK(tmp == NULL);
+    if (tmp) fclose(tmp);
+    /* another generator's temporary is left alone */
+    write_file("cargs_blobs.h.1.tmp", "busy", 4);
+    CHECK_EQI(cargs_write_blobs(&env, root, "my-tool", "cargs_blobs.h", "my_blobs"), 0);
+    tmp = fopen("cargs_blobs.h.1.tmp", "r");
+    CHECK(tmp != NULL && fgets(out, sizeof out, tmp) && strcmp(out, "busy") == 0);
+    if (tmp) fclose(tmp);
+    remove("cargs_blobs.h.1.tmp");
+    CHECK_EQI(cargs_write_blobs(&e2, root, "my-tool", "cargs_blobs.h", "my_blobs"), 0);
+    /* the header written last is complete and current */
+    f = fopen("cargs_blobs.h", "r");
+    CHECK(f != NULL);
+    if (f) {
+        snprintf(want, sizeof want, "/* cargs blobs: tree 0x%016llx */\n",
+                 (unsigned long long)cargs_tree_hash(&e2, root, "my-tool"));
+        CHECK(fgets(out, sizeof out, f) && strcmp(out, want) == 0);
+        fseek(f, -3, SEEK_END);
+        CHECK(fgets(out, sizeof out, f) && strcmp(out, "};\n") == 0);
+        fclose(f);
+    }
+    CHECK_EQI(cargs_write_blobs(&env, root, "my-tool", "no-such-dir/cargs_blobs.h", "my_blobs"), -1);
+    /* paths past the local buffer need env->arena */
+    static char long_path[600];
+    memset(long_path, 'x', sizeof long_path - 1);
+    CHECK_EQI(cargs_write_blobs(&env, root, "my-tool", long_path, "my_blobs"), -1);
+    remove("cargs_blobs.h");
+}
+
+static void test_json(void) {
+    cargs_env env;
+    fill_env(&env);
+    static int                color;
+    static const cargs_choice colors[] = {{"auto", 0}, {"never", 1}, {NULL, 0}};
+    static const char        *aliases[] = {"a"};
+    static const cargs_pos    pos[]     = {CARGS_POS("NAME", "Remote \"name\""), CARGS_POS_N("URL", NULL, 0, CARGS_POS_INF)};
+    static const cargs_opt    opts[]    = {
+        {"color", 'c', CARGS_ARG_REQUIRED, "WHEN", "Color\tmode", NULL, "T_COLOR", "auto", 2, CARGS_GRP_XOR, CARGS_BIND_ENUM_TO(&color, colors)},
+        {NULL,    'q', CARGS_ARG_NONE,     NULL,   NULL,          NULL, NULL,      NULL,   0, CARGS_GRP_NONE, {0}},
+    };
+    static const cargs_rel rels[] = {{CARGS_REL_CONFLICTS, "color", "q"}};
+    static const cargs_cmd subs[] = {{.name = "add", .desc = "Add\\remote", .aliases = aliases, .alias_count = 1,
+                                      .pos = pos, .pos_count = 2}};
+    cargs_cmd              root   = {.desc = "Tool", .opts = opts, .opt_count = 2, .subs = subs, .sub_count = 1,
+                                     .rels = rels, .rel_count = 1};
+    static char            out[4096], want[4096];
+
+    CHECK(emit_to(out, sizeof out, cargs_emit_json, &env, &root) > 0);
+    snprintf(want, sizeof want,
+             "{\"format\":\"cargs-tree\",\"version\":1,\"prog\":\"my-tool\",\"program_version\":\"v1\","
+             "\"tree_hash\":\"%016llx\",\"builtins\":{\"help\":true,\"version\":true,\"author\":true},"
+             "\"root\":{\"name\":null,\"desc\":\"Tool\",\"aliases\":[],\"options\":["
+             "{\"long\":\"color\",\"short\":\"c\",\"arg\":\"required\",\"metavar\":\"WHEN\",\"help\":\"Color\\tmode\","
+             "\"env\":\"T_COLOR\",\"default\":\"auto\",\"group\":2,\"policy\":\"xor\",\"type\":\"enum\","
+             "\"choices\":[\"auto\",\"never\"]},"
+             "{\"long\":null,\"short\":\"q\",\"arg\":\"none\",\"metavar\":null,\"help\":null,\"env\":null,"
+             "\"default\":null,\"group\":0,\"policy\":\"none\",\"type\":\"none\",\"choices\":[]}],"
+             "\"positionals\":[],\"relations\":[{\"kind\":\"conflicts\",\"opt\":\"color\",\"other\":\"q\"}],"
+             "\"commands\":[{\"name\":\"add\",\"desc\":\"Add\\\\remote\",\"aliases\":[\"a\"],\"options\":[],"
+             "\"positionals\":[{\"name\":\"NAME\",\"desc\":\"Remote \\\"name\\\"\",\"min\":1,\"max\":1},"
+             "{\"name\":\"URL\",\"desc\":null,\"min\":0,\"max\":null}],\"relations\":[],\"commands\":[]}]}}\n",
+             (unsigned long long)cargs_tree_hash(&env, &root, "my-tool"));
+    CHECK_STREQ(out, want);
+
+    /* built-ins follow what the parser would accept */
+    env.auto_version = false;
+    env.author       = NULL;
+    emit_to(out, sizeof out, cargs_emit_json, &env, &root);
+    CHECK(strstr(out, "\"builtins\":{\"help\":true,\"version\":false,\"author\":false}") != NULL);
+    emit_to(out, sizeof out, cargs_emit_json, NULL, NULL);
+    CHECK(strstr(out, "\"program_version\":null,") != NULL);
+    CHECK(strstr(out, "\"help\":false,") != NULL);
+    CHECK(strstr(out, "\"root\":null}\n") != NULL);
+
+    /* the hash clients cache against covers what only the JSON shows */
+    fill_env(&env);
+    uint64_t h = cargs_tree_hash(&env, &root, "my-tool");
+    root.rel_count = 0;
+    CHECK(cargs_tree_hash(&env, &root, "my-tool") != h);
+    root.rel_count = 1;
+    cargs_opt o2[2];
+    memcpy(o2, opts, sizeof o2);
+    root.opts = o2;
+    CHECK(cargs_tree_hash(&env, &root, "my-tool") == h);
+    o2[0].bind.choices = colors + 1;
+    CHECK(cargs_tree_hash(&env, &root, "my-tool") != h);
+    o2[0].bind = (cargs_bind)CARGS_BIND(CARGS_BIND_STR, NULL);
+    CHECK(cargs_tree_hash(&env, &root, "my-tool") != h);
+}
+
+/* grow hands out one spare block */
+static unsigned char arena_spare[4096];
+static int           arena_grows = 0;
+
+static void *arena_grow(void *ctx, size_t min, size_t *cap) {
+    (void)ctx;
+    if (arena_grows++ || min > sizeof arena_spare) return NULL;
+    *cap = sizeof arena_spare;
+    return arena_spare;
+}
+
+static void sink_len(void *ctx, const char *msg, size_t len) {
+    (void)msg;
+    *(size_t *)ctx = len;
+}
+
+static void test_arena(void) {
+    static uint64_t mem[8];
+    cargs_arena     a;
+    cargs_arena_init(&a, mem, sizeof mem);
+    CHECK(cargs_arena_alloc(&a, 40, 8) == (void *)mem);
+    cargs_arena_mark m = cargs_arena_save(&a);
+    CHECK(cargs_arena_alloc(&a, 100, 8) == NULL); /* no grow yet */
+    a.grow             = arena_grow;
+    unsigned char *big = (unsigned char *)cargs_arena_alloc(&a, 100, 8);
+    CHECK(big >= arena_spare && big < arena_spare + sizeof arena_spare);
+    CHECK_EQI(arena_grows, 1);
+    CHECK_EQI((int)a.high, 140);
+    CHECK(cargs_arena_alloc(&a, 8192, 8) == NULL);
+    cargs_arena_rewind(&a, m);
+    CHECK(a.base == (unsigned char *)mem && a.used == 40 && a.spent == 0);
+    CHECK_EQI((int)a.high, 140);
+
+    /* the tree builders take their storage from an arena */
+    const cargs_cmd *basic;
+    build_root_basic(&basic);
+    static uint64_t heap[4096];
+    cargs_arena     h;
+    cargs_arena_init(&h, heap, sizeof heap);
+    const cargs_index *ix = cargs_compile_arena(basic, &h);
+    CHECK(ix && ix->root == basic);
+    const char          *envp[] = {"COLUMNS=61", NULL};
+    const cargs_envsnap *snap   = cargs_envsnap_build_arena(basic, envp, &h);
+    CHECK_STREQ(cargs_envsnap_get(snap, "COLUMNS"), "61");
+    size_t built = h.used;
+    cargs_arena_init(&a, mem, sizeof mem);
+    CHECK(cargs_compile_arena(basic, &a) == NULL);
+    CHECK_EQI((int)a.used, 0);
+
+    /* a diagnostic over 512 bytes reaches the sink whole, in one write */
+    cargs_env env;
+    fill_env(&env);
+    size_t     got  = 0;
+    cargs_sink sink = {sink_len, &got};
+    env.err_sink    = &sink;
+    static char flag[700];
+    memset(flag, 'x', sizeof flag - 1);
+    memcpy(flag, "--", 2);
+    static char prog[] = "t";
+    char       *a1[]   = {prog, flag};
+    CHECK_EQI(cargs_dispatch(&env, basic, 2, a1, NULL), CARGS_ERR_UNKNOWN);
+    CHECK_EQI((int)got, 511);
+    env.arena = &h;
+    CHECK_EQI(cargs_dispatch(&env, basic, 2, a1, NULL), CARGS_ERR_UNKNOWN);
+    CHECK_EQI((int)got, (int)(strlen("Unknown option: \n") + sizeof flag - 1));
+    CHECK(h.used == built);
+
+    /* cargs_parse_line without buffers of its own */
+    static uint64_t storage[2048];
+    cargs_parser    p;
+    env.err_sink = NULL;
+    env.arena    = NULL;
+    CHECK_EQI(cargs_parser_init(&p, &env, basic, storage, sizeof storage), 0);
+    cargs_scratch sc = {NULL, 0, NULL, 0, NULL, &h};
+    tstate        st = {0};
+    CHECK_EQI(cargs_parse_line(&p, "-j 6 remote add o u", 19, &sc, &st), CARGS_OK);
+    CHECK_EQI(st.jobs, 6);
+    CHECK_EQI(st.ran_remote_add, 1);
+    CHECK(h.used == built);
+    sc.arena = NULL;
+    CHECK_EQI(cargs_parse_line(&p, "-j 6", 4, &sc, &st), CARGS_ERR_BAD_FORMAT);
+    tstate_clear(&st);
+
+    /* command paths deeper than 16 levels: help and docs name all of them */
+    static cargs_cmd lv[20];
+    static char      names[20][4];
+    for (int k = 19; k >= 0; k--) {
+        snprintf(names[k], sizeof names[k], "l%d", k);
+        memset(&lv[k], 0, sizeof lv[k]);
+        lv[k].name = names[k];
+        if (k < 19) {
+            lv[k].subs      = &lv[k + 1];
+            lv[k].sub_count = 1;
+        }
+    }
+    static cargs_cmd deep;
+    memset(&deep, 0, sizeof deep);
+    deep.subs      = lv;
+    deep.sub_count = 1;
+    static char *dv[21];
+    dv[0] = prog;
+    for (int k = 0; k < 20; k++) dv[k + 1] = names[k];
+    static char want[128], back[8192];
+    strcpy(want, "Usage: t");
+    for (int k = 0; k < 20; k++) strcat(strcat(want, " "), names[k]);
+    strcat(want, " [options]");
+
+    FILE *f = tmpfile();
+    CHECK(f != NULL);
+    if (!f) return;
+    env.out   = f;
+    env.arena = &h;
+    CHECK_EQI(cargs_dispatch(&env, &deep, 21, dv, NULL), CARGS_OK);
+    read_back(f, back, sizeof back);
+    CHECK(strncmp(back, want, strlen(want)) == 0);
+    CHECK(h.used == built);
+    f = tmpfile();
+    CHECK(f != NULL);
+    if (!f) return;
+    env.out   = f;
+    env.arena = NULL; /* no room for the path: an error, not a cut usage line */
+    CHECK_EQI(cargs_dispatch(&env, &deep, 21, dv, NULL), CARGS_ERR_TOO_MANY);
+    read_back(f, back, sizeof back);
+    CHECK(back[0] == '\0');
+    env.out = cargs_devnull();
+    CHECK_EQI(cargs_dispatch(&env, &deep, 17, dv, NULL), CARGS_OK); /* 16 levels fit */
+    CHECK(emit_to(back, sizeof back, cargs_emit_markdown, &env, &deep) > 0);
+    CHECK(strstr(back, "\n# my-tool l0 l1 l2 l3 l4 l5 l6 l7 l8 l9 l10 l11 l12 l13 l14 l15 l16 l17 l18 l19\n") != NULL);
+
+    /* a help page longer than the stack buffer still goes out whole */
+    static cargs_opt many[40];
+    static char      mnames[40][8];
+    for (int k = 0; k < 40; k++) {
+        snprintf(mnames[k], sizeof mnames[k], "opt%02d", k);
+        memset(&many[k], 0, sizeof many[k]);
+        many[k].long_name = mnames[k];
+        many[k].help      = "an option with some help text";
+    }
+    cargs_cmd wide;
+    memset(&wide, 0, sizeof wide);
+    wide.opts       = many;
+    wide.opt_count  = 40;
+    static char page[8192];
+    size_t      total = cargs_render_help(page, sizeof page, &env, &wide, "t", NULL, 0);
+    CHECK(total > 1024 && total < sizeof page);
+    f = tmpfile();
+    CHECK(f != NULL);
+    if (!f) return;
+    env.out   = f;
+    env.arena = &h;
+    cargs_print_help(&env, &wide, "t", NULL, 0);
+    CHECK_EQI(read_back(f, back, sizeof back), total);
+    CHECK_STREQ(back, page);
+    CHECK(h.used == built && h.high > built + total);
+}
+
+/* help for argv under the struct tree (pk NULL) or the packed one */
+static size_t help_of(const cargs_cmd *root, const cargs_packed *pk, const cargs_packed_fns *fns, bool fit,
+                      int argc, const char *argv[], char *buf, size_t cap) {
+    cargs_env env;
+    tstate    st = {0};
+    fill_env(&env);
+    env.help_fit = fit;
+    FILE *f = tmpfile();
+    if (!f) return 0;
+    env.out = f;
+    if (pk) run_packed(pk, fns, &env, &st, argc, argv);
+    else run_vec(root, &env, &st, argc, argv);
+    tstate_clear(&st);
+    return read_back(f, buf, cap);
+}
+
+static void test_packed(void) {
+    const cargs_cmd *root;
+    build_root_basic(&root);
+    static const cargs_cb   cbs[]  = {cb_verbose, cb_jobs, cb_limit_opt, cb_json, cb_yaml};
+    int (*const runs[])(int, char **, void *) = {run_root, run_remote_add, run_remote_rm};
+    cargs_packed_fns fns;
+    memset(&fns, 0, sizeof fns);
+    fns.cb        = cbs;
+    fns.cb_count  = 5;
+    fns.run       = runs;
+    fns.run_count = 3;
+
+    static uint64_t mem[1024];
+    cargs_arena     a;
+    cargs_arena_init(&a, mem, sizeof mem);
+    const cargs_packed *pk = cargs_pack(root, &fns, &a);
+    CHECK(pk != NULL);
+    if (!pk) return;
+    CHECK_EQI((int)pk->cmd_count, 4);
+    CHECK_EQI((int)pk->opt_count, 5);
+    CHECK_EQI((int)pk->alias_count, 1);
+    CHECK(pk->rels == NULL && pk->rel_count == 0);
+    CHECK(pk->tree_hash == cargs_tree_hash(NULL, root, NULL));
+    CHECK_STREQ(pk->pool + pk->cmds[pk->cmds[1].first_sub + 1].name, "remove");
+    CHECK(pk->cmds[0].name == CARGS_PK_NONE);
+
+    /* every handler must be in fns */
+    cargs_packed_fns part = fns;
+    part.cb_count         = 4;
+    size_t used           = a.used;
+    CHECK(cargs_pack(root, &part, &a) == NULL);
+    CHECK(cargs_pack(root, NULL, &a) == NULL);
+    CHECK(a.used == used);
+
+    /* same results as the struct tree */
+    cargs_env env;
+    fill_env(&env);
+    tstate      s1 = {0}, s2 = {0};
+    const char *a1[] = {"t", "-V", "--jobs=3", "--json", "remote", "rm", "origin"};
+    CHECK_EQI(run_vec(root, &env, &s1, 7, a1), CARGS_OK);
+    CHECK_EQI(run_packed(pk, &fns, &env, &s2, 7, a1), CARGS_OK);
+    CHECK(s2.verbose == 1 && s2.jobs == 3 && s2.json == 1 && s2.ran_remote_rm == 1);
+    CHECK(s1.verbose == s2.verbose && s1.jobs == s2.jobs && s1.pos_argc == s2.pos_argc);
+    tstate_clear(&s1);
+    tstate_clear(&s2);
+    const char *bad[][3] = {{"t", "remot", "x"}, {"t", "--json", "--yaml"}, {"t", "remote", "add"}};
+    for (size_t i = 0; i < sizeof bad / sizeof bad[0]; i++) {
+        int r1 = run_vec(root, &env, &s1, 3, bad[i]);
+        CHECK_EQI(run_packed(pk, &fns, &env, &s2, 3, bad[i]), r1);
+        CHECK(r1 < 0);
+    }
+    tstate_clear(&s1);
+    tstate_clear(&s2);
+
+    /* help pages match at every level, column width included */
+    static char h1[2048], h2[2048];
+    const char *hp[][3] = {{"t", "--help"}, {"t", "remote", "--help"}, {"t", "remote"}};
+    const int   hn[]    = {2, 3, 2};
+    for (size_t i = 0; i < 6; i++) {
+        bool fit = i >= 3;
+        help_of(root, NULL, NULL, fit, hn[i % 3], hp[i % 3], h1, sizeof h1);
+        help_of(root, pk, &fns, fit, hn[i % 3], hp[i % 3], h2, sizeof h2);
+        CHECK(h1[0] != '\0');
+        CHECK_STREQ(h2, h1);
+        if (i == 0) CHECK(strstr(h1, "  -j, --jobs N                   jobs\n") != NULL);
+        if (i == 3) CHECK(strstr(h1, "  -j, --jobs N       jobs\n") != NULL);
+    }
+
+    /* a level that does not fit the arena, and a damaged record */
+    static uint64_t tiny[4];
+    cargs_arena     t;
+    cargs_arena_init(&t, tiny, sizeof tiny);
+    env.arena = &t;
+    CHECK_EQI(run_packed(pk, &fns, &env, &s2, 7, a1), CARGS_ERR_TOO_MANY);
+    CHECK(t.used == 0);
+    env.arena = NULL;
+    cargs_packed_cmd cmds[4];
+    cargs_packed     broken = *pk;
+    memcpy(cmds, pk->cmds, sizeof cmds);
+    cmds[3].first_opt = 99; /* "remove" */
+    cmds[3].opt_count = 1;
+    broken.cmds       = cmds;
+    CHECK_EQI(run_packed(&broken, &fns, &env, &s2, 7, a1), CARGS_ERR_BAD_FORMAT);
+    tstate_clear(&s2);
+
+    /* the generated source */
+    static char src[8192];
+    FILE       *f = tmpfile();
+    CHECK(f != NULL);
+    if (!f) return;
+    CHECK_EQI(cargs_emit_packed(pk, f, "demo"), 0);
+    read_back(f, src, sizeof src);
+    CHECK(strncmp(src, "/* cargs packed tree 0x", 23) == 0);
+    CHECK(strstr(src, "static const cargs_packed_cmd demo_cmds[] = {\n"
+                      "    {.name = CARGS_PK_NONE, .desc = CARGS_PK_NONE, .first_opt = 0, .first_sub = 1,") != NULL);
+    CHECK(strstr(src, "static const uint32_t demo_aliases[] = {\n") != NULL);
+    CHECK(strstr(src, ", .short_name = 0, .arg = ") != NULL);
+    CHECK(strstr(src, "demo_rels") == NULL); /* empty tables are left out */
+    CHECK(strstr(src, "static const cargs_packed demo = {\n    .format = 2,\n    .tree_hash = 0x") != NULL);
+    CHECK(strstr(src, "ull,\n    .fn_counts = {5, 0, 3, 0, 0, 0, 0},\n") != NULL);
+    CHECK(strstr(src, "    .pool = demo_pool,\n") != NULL);
+    CHECK(strstr(src, "    .rels = NULL,\n    .rel_count = 0,\n};\n") != NULL);
+
+    /* a tree written for another record layout is refused */
+    broken        = *pk;
+    broken.format = CARGS_PACKED_FORMAT + 1;
+    CHECK_EQI(run_packed(&broken, &fns, &env, &s2, 1, a1), CARGS_ERR_BAD_FORMAT);
+
+    /* and so are tables that are not the generator's */
+    CHECK(pk->fn_counts[0] == 5 && pk->fn_counts[2] == 3 && pk->fn_counts[6] == 0);
+    sink_log   log  = {{0}, 0, 0};
+    cargs_sink sink = {sink_write, &log};
+    env.err_sink    = &sink;
+    part            = fns;
+    part.run_count  = 2;
+    CHECK_EQI(run_packed(pk, &part, &env, &s2, 1, a1), CARGS_ERR_BAD_FORMAT);
+    CHECK_STREQ(log.text, "Packed tree: fns->run has 2 entries, it was generated with 3 (regenerate it)\n");
+    CHECK_EQI(run_packed(pk, NULL, &env, &s2, 1, a1), CARGS_ERR_BAD_FORMAT);
+    env.err_sink = NULL;
+}
+
+/* value completers: a fixed list, and one that keeps going until told to stop */
+static int complete_remotes(const char *prefix, const cargs_opt *o, cargs_completion *c, void *u) {
+    (void)prefix;
+    (void)o;
+    ((tstate *)u)->mode++;
+    static const char *const names[] = {"origin", "upstream", "old\nmirror", "old-mirror"};
+    for (size_t i = 0; i < 4; i++)
+        if (cargs_complete_add(c, names[i])) break;
+    return CARGS_OK;
+}
+
+static int complete_flood(const char *prefix, const cargs_opt *o, cargs_completion *c, void *u) {
+    (void)prefix;
+    (void)o;
+    long *n = &((tstate *)u)->jobs;
+    while (cargs_complete_add(c, "x") == CARGS_OK) (*n)++;
+    return c->expired ? CARGS_OK : CARGS_ERR_BAD_FORMAT;
+}
+
+static size_t complete_of(const cargs_cmd *root, cargs_env *env, tstate *st, int argc, const char **argv, char *buf,
+                          size_t cap, int *rc) {
+    FILE *f  = tmpfile();
+    FILE *o  = env->out;
+    env->out = f;
+    if (!f) return 0;
+    *rc      = run_vec(root, env, st, argc, argv);
+    env->out = o;
+    return read_back(f, buf, cap);
+}
+
+static void test_complete(void) {
+    static int                color = -1;
+    static const char        *remote;
+    static const cargs_choice colors[] = {{"auto", 0}, {"always", 1}, {"never", 2}, {NULL, 0}};
+    static const cargs_opt    ropts[]  = {
+        {"color",   'c', CARGS_ARG_REQUIRED, "WHEN", "color", NULL,       NULL, NULL, 0, CARGS_GRP_NONE, CARGS_BIND_ENUM_TO(&color, colors)},
+        {"jobs",    'j', CARGS_ARG_REQUIRED, "N",    "jobs",  cb_jobs,    NULL, "4",  0, CARGS_GRP_NONE, {0}},
+        {"limit",   'l', CARGS_ARG_OPTIONAL, "N",    "limit", NULL,       NULL, NULL, 0, CARGS_GRP_NONE, {0}},
+        {"verbose", 'V', CARGS_ARG_NONE,     NULL,   "more",  cb_verbose, NULL, NULL, 0, CARGS_GRP_NONE, {0}},
+    };
+    static const cargs_opt popts[] = {
+        {"remote", 'r', CARGS_ARG_REQUIRED, "NAME", "remote", NULL, NULL, NULL, 0, CARGS_GRP_NONE,
+         {CARGS_BIND_STR, &remote, NULL, NULL, complete_remotes}},
+        {"flood", 0, CARGS_ARG_REQUIRED, "X", "flood", NULL, NULL, NULL, 0, CARGS_GRP_NONE, CARGS_COMPLETE(complete_flood)},
+    };
+    static const cargs_cmd subs[] = {{"push", "Push", popts, 2, NULL, 0, NULL, 0, NULL, 0, run_remote_add, NULL, NULL, 0}};
+    static const cargs_cmd root   = {NULL, "t", ropts, 4, subs, 1, NULL, 0, NULL, 0, run_root, NULL, NULL, 0};
+
+    cargs_env env;
+    fill_env(&env);
+    tstate      st = {0};
+    static char out[4096];
+    int         rc = 0;
+
+    /* off by default: just a positional */
+    tstate      s0   = {0};
+    const char *a0[] = {"t", "__complete", "--color", ""};
+    complete_of(&root, &env, &s0, 4, a0, out, sizeof out, &rc);
+    CHECK_EQI(rc, CARGS_OK);
+    CHECK(s0.ran_root == 1 && s0.pos_argc == 3 && out[0] == '\0');
+    tstate_clear(&s0);
+
+    env.complete = true;
+    struct {
+        int         argc;
+        const char *argv[8];
+        const char *want;
+    } cases[] = {
+        {4, {"t", "__complete", "--color", ""}, "auto\nalways\nnever\n"},
+        {4, {"t", "__complete", "-c", "a"}, "auto\nalways\n"},
+        {3, {"t", "__complete", "--color=n"}, "never\n"},
+        {5, {"t", "__complete", "push", "-r", "o"}, "origin\nold-mirror\n"},
+        {4, {"t", "__complete", "push", "--remote=up"}, "upstream\n"},
+        {6, {"t", "__complete", "-Vj", "2", "push", "--remote="}, "origin\nupstream\nold-mirror\n"},
+        {6, {"t", "__complete", "--jobs", "--color", "push", "-r"}, ""}, /* cur is -r itself */
+        {5, {"t", "__complete", "--limit", "push", "-c"}, ""},            /* push is --limit's value */
+        {5, {"t", "__complete", "-l5", "push", "-r"}, ""},
+        {4, {"t", "__complete", "-V", "pu"}, ""},                         /* not a value */
+        {6, {"t", "__complete", "push", "x", "-r", ""}, ""},              /* after a positional */
+        {5, {"t", "__complete", "--", "-c", ""}, ""},
+        {4, {"t", "__complete", "--jobs", ""}, ""},                       /* no completer */
+        {2, {"t", "__complete"}, ""},
+    };
+    for (size_t i = 0; i < sizeof cases / sizeof cases[0]; i++) {
+        complete_of(&root, &env, &st, cases[i].argc, cases[i].argv, out, sizeof out, &rc);
+        CHECK_EQI(rc, CARGS_OK);
+        CHECK_STREQ(out, cases[i].want);
+        /* nothing is delivered: no callbacks, bindings, defaults or run */
+        CHECK(st.verbose == 0 && st.jobs == 0 && st.ran_root == 0 && st.ran_remote_add == 0 && color == -1);
+    }
+    CHECK_EQI(st.mode, 3); /* the completer gets the dispatch's user */
+    CHECK(remote == NULL);
+
+    /* the budget stops a completer that would never finish */
+    env.complete_ms  = 1;
+    const char *a2[] = {"t", "__complete", "push", "--flood", ""};
+    FILE       *o    = env.out;
+    env.out          = cargs_devnull();
+    CHECK_EQI(run_vec(&root, &env, &st, 5, a2), CARGS_OK);
+    env.out = o;
+    CHECK(st.jobs > 0);
+    CHECK(cargs_complete_expired(NULL));
+
+    /* scripts ask only for the options that can answer */
+    static char sh[8192];
+    CHECK(emit_to(sh, sizeof sh, cargs_emit_completion_bash, &env, &root) > 0);
+    CHECK(strstr(sh, "[\"0/--color\"]='*'\n") != NULL);
+    CHECK(strstr(sh, "[\"0/--jobs\"]=+\n") != NULL);
+    CHECK(strstr(sh, "[\"1/-r\"]='*'\n") != NULL);
+    CHECK(strstr(sh, "\"${COMP_WORDS[0]}\" __complete \"${a[@]}\"") != NULL);
+    CHECK(emit_to(sh, sizeof sh, cargs_emit_completion_zsh, &env, &root) > 0);
+    CHECK(strstr(sh, "'1/--remote' '*'\n") != NULL);
+    CHECK(strstr(sh, "${words[1]} __complete \"${(@)words[2,CURRENT]}\"") != NULL);
+    CHECK(emit_to(sh, sizeof sh, cargs_emit_completion_fish, &env, &root) > 0);
+    CHECK(strstr(sh, "set -g __my_tool_n0_(string escape --style=var -- '-c') '*'\n") != NULL);
+    CHECK(strstr(sh, "$cmd __complete $tok $cur") != NULL);
+    uint64_t h = cargs_tree_hash(&env, &root, "t");
+    env.complete = false;
+    CHECK(emit_to(sh, sizeof sh, cargs_emit_completion_bash, &env, &root) > 0);
+    CHECK(strstr(sh, "'*'") == NULL && strstr(sh, "__complete") == NULL);
+    CHECK(cargs_tree_hash(&env, &root, "t") != h);
+
+    /* packed trees answer the same way */
+    static const cargs_cb            cbs[]  = {cb_jobs, cb_verbose};
+    static void *const               tgts[] = {&color, &remote};
+    static const cargs_choice *const chs[]  = {colors};
+    static const cargs_completer     cmps[] = {complete_remotes, complete_flood};
+    int (*const runs[])(int, char **, void *) = {run_root, run_remote_add};
+    cargs_packed_fns fns;
+    memset(&fns, 0, sizeof fns);
+    fns.cb             = cbs;
+    fns.cb_count       = 2;
+    fns.run            = runs;
+    fns.run_count      = 2;
+    fns.target         = tgts;
+    fns.target_count   = 2;
+    fns.choices        = chs;
+    fns.choices_count  = 1;
+    fns.complete       = cmps;
+    fns.complete_count = 1;
+    static uint64_t mem[512];
+    cargs_arena     a;
+    cargs_arena_init(&a, mem, sizeof mem);
+    CHECK(cargs_pack(&root, &fns, &a) == NULL); /* complete_flood is missing */
+    fns.complete_count     = 2;
+    const cargs_packed *pk = cargs_pack(&root, &fns, &a);
+    CHECK(pk != NULL);
+    if (!pk) return;
+    env.complete = true;
+    FILE *f      = tmpfile();
+    env.out      = f;
+    if (!f) return;
+    const char *a1[] = {"t", "__complete", "push", "-r", ""};
+    CHECK_EQI(run_packed(pk, &fns, &env, &st, 5, a1), CARGS_OK);
+    env.out = o;
+    read_back(f, out, sizeof out);
+    CHECK_STREQ(out, "origin\nupstream\nold-mirror\n");
+}
+
+/* untrusted input: each cap fails early with its own code */
+static void test_limits(void) {
+    cargs_env env;
+    fill_env(&env);
+    const cargs_cmd *root;
+    build_root_basic(&root);
+    cargs_limits lim;
+    memset(&lim, 0, sizeof lim);
+    env.limits = &lim;
+    tstate st  = {0};
+
+    const char *ok[] = {"t", "-VV", "-j", "2", "remote", "add", "o", "u"};
+    CHECK_EQI(run_vec(root, &env, &st, 8, ok), CARGS_OK); /* no caps set */
+    lim.max_argc = 7;
+    CHECK_EQI(run_vec(root, &env, &st, 8, ok), CARGS_ERR_LIMIT);
+    lim.max_argc  = 8;
+    lim.max_token = 5;
+    CHECK_EQI(run_vec(root, &env, &st, 8, ok), CARGS_ERR_LIMIT); /* "remote" */
+    lim.max_token = 6;
+    CHECK_EQI(run_vec(root, &env, &st, 8, ok), CARGS_OK);
+    lim.max_token = 0;
+
+    /* a long grouped token stops after max_shorts flags, with no callbacks */
+    static char flags[4096];
+    memset(flags, 'V', sizeof flags - 1);
+    flags[0]        = '-';
+    const char *g[] = {"t", flags};
+    lim.max_shorts  = 2;
+    st.verbose      = 0;
+    CHECK_EQI(run_vec(root, &env, &st, 2, g), CARGS_ERR_LIMIT);
+    CHECK_EQI(run_vec(root, &env, &st, 8, ok), CARGS_OK);
+    lim.max_shorts = 0;
+    lim.max_token  = 64;
+    st.verbose     = 0;
+    CHECK_EQI(run_vec(root, &env, &st, 2, g), CARGS_ERR_LIMIT);
+    CHECK_EQI(st.verbose, 0);
+    lim.max_token = 0;
+
+    /* callbacks: -V -V -j are three, run_remote_add the fourth */
+    lim.max_callbacks = 3;
+    st.ran_remote_add = 0;
+    CHECK_EQI(run_vec(root, &env, &st, 8, ok), CARGS_ERR_LIMIT);
+    CHECK_EQI(st.ran_remote_add, 0);
+    lim.max_callbacks = 4;
+    CHECK_EQI(run_vec(root, &env, &st, 8, ok), CARGS_OK);
+    CHECK_EQI(st.ran_remote_add, 1);
+    CHECK_EQI(run_vec(root, &env, &st, 8, ok), CARGS_OK); /* per dispatch */
+
+    /* defaults count, and the budget stops them too */
+    static const cargs_opt dopts[] = {
+        {"jobs",    'j', CARGS_ARG_REQUIRED, "N",  "jobs", cb_jobs,    NULL, "3", 0, CARGS_GRP_NONE, {0}},
+        {"verbose", 'V', CARGS_ARG_NONE,     NULL, "more", cb_verbose, NULL, "1", 0, CARGS_GRP_NONE, {0}},
+    };
+    static const cargs_cmd droot = {.opts = dopts, .opt_count = 2, .run = run_root};
+    const char            *d1[]  = {"t"};
+    lim.max_callbacks            = 2;
+    CHECK_EQI(run_vec(&droot, &env, &st, 1, d1), CARGS_ERR_LIMIT);
+    lim.max_callbacks = 3;
+    CHECK_EQI(run_vec(&droot, &env, &st, 1, d1), CARGS_OK);
+    lim.max_callbacks = 0;
+
+    /* subcommand depth */
+    lim.max_depth = 1;
+    CHECK_EQI(run_vec(root, &env, &st, 8, ok), CARGS_ERR_LIMIT);
+    lim.max_depth = 2;
+    CHECK_EQI(run_vec(root, &env, &st, 8, ok), CARGS_OK);
+    lim.max_depth = 0;
+
+    /* @files: argv is checked before any file is read, file words as they
+       are loaded */
+    sink_log   log  = {{0}, 0, 0};
+    cargs_sink sink = {sink_write, &log};
+    env.err_sink       = &sink;
+    env.response_files = true;
+    lim.max_argc       = 2;
+    const char *r1[]   = {"t", "-V", "@cargs_lim_none.txt"};
+    CHECK_EQI(run_vec(root, &env, &st, 3, r1), CARGS_ERR_LIMIT);
+    CHECK_STREQ(log.text, "Too many arguments: 3 (limit 2)\n");
+    write_file("cargs_lim.txt", "-V -V -V\n", 9);
+    const char *r2[] = {"t", "@cargs_lim.txt"};
+    log.len          = 0;
+    st.verbose       = 0;
+    CHECK_EQI(run_vec(root, &env, &st, 2, r2), CARGS_ERR_LIMIT);
+    CHECK_STREQ(log.text, "Too many arguments with 'cargs_lim.txt' (limit 2)\n");
+    CHECK_EQI(st.verbose, 0);
+    lim.max_argc  = 4;
+    lim.max_token = 14; /* "@cargs_lim.txt" */
+    CHECK_EQI(run_vec(root, &env, &st, 2, r2), CARGS_OK);
+    CHECK_EQI(st.verbose, 1);
+    write_file("cargs_lim.txt", "-V --verbose=far-too-long\n", 26);
+    log.len = 0;
+    CHECK_EQI(run_vec(root, &env, &st, 2, r2), CARGS_ERR_LIMIT);
+    CHECK_STREQ(log.text, "Argument in 'cargs_lim.txt' too long (limit 14 bytes)\n");
+    remove("cargs_lim.txt");
+    tstate_clear(&st);
+}
+
+#ifdef CARGS_ENABLE_STATS
+static void test_stats(void) {
+    cargs_env env;
+    fill_env(&env);
+    const cargs_cmd *root;
+    build_root_basic(&root);
+    cargs_stats stats = {0};
+    tstate      st    = {0};
+    env.stats         = &stats;
+
+    const char *a1[] = {"t", "-V", "--jobs=3", "--json", "remote", "rm", "origin"};
+    CHECK_EQI(run_vec(root, &env, &st, 7, a1), CARGS_OK);
+    tstate_clear(&st);
+    CHECK_EQI((int)stats.callbacks, 4); /* three options + run */
+    CHECK_EQI((int)stats.lookups, 6);   /* three options + three subcommand tries */
+    CHECK_EQI((int)stats.strcmps, 10);  /* jobs 2, json 4, remote 1, rm 3 (after add, remove) */
+    CHECK_EQI((int)stats.env_lookups, 0);
+    CHECK_EQI((int)stats.bytes_out, 0);
+    CHECK_EQI((int)stats.active_, 0); /* idle between calls */
+
+    /* the index replaces the scans: one comparison per long-name hit */
+    static uint64_t storage[512];
+    env.index        = cargs_compile(root, storage, sizeof(storage));
+    stats            = (cargs_stats){0};
+    const char *a2[] = {"t", "--jobs", "3", "--json"};
+    CHECK_EQI(run_vec(root, &env, &st, 4, a2), CARGS_OK);
+    CHECK_EQI((int)stats.lookups, 2);
+    CHECK_EQI((int)stats.strcmps, 2);
+    env.index = NULL;
+
+    /* help and emitters report the bytes they wrote */
+    FILE *f = tmpfile();
+    CHECK(f != NULL);
+    if (!f) return;
+    env.out          = f;
+    env.color        = true;
+    stats            = (cargs_stats){0};
+    const char *a3[] = {"t", "--help"};
+    CHECK_EQI(run_vec(root, &env, &st, 2, a3), CARGS_OK);
+    CHECK_EQI((long)stats.bytes_out, ftell(f));
+    CHECK(stats.env_lookups > 0); /* NO_COLOR */
+    const char *a4[] = {"t", "--version"};
+    CHECK_EQI(run_vec(root, &env, &st, 2, a4), CARGS_OK);
+    CHECK_EQI((long)stats.bytes_out, ftell(f));
+    cargs_emit_markdown(&env, root, "t", f);
+    cargs_emit_completion_fish(&env, root, "t", f);
+    CHECK_EQI((long)stats.bytes_out, ftell(f));
+    fclose(f);
+    env.out   = cargs_devnull();
+    env.color = false;
+
+#if defined(__unix__) || defined(__APPLE__)
+    /* emitters count what they write, so a pipe is measured too */
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+    FILE *p = fdopen(fds[1], "w");
+    FILE *r = fdopen(fds[0], "r");
+    CHECK(p != NULL && r != NULL);
+    if (p && r) {
+        static char piped[4096];
+        stats = (cargs_stats){0};
+        cargs_emit_markdown(&env, root, "t", p);
+        fclose(p);
+        size_t got = fread(piped, 1, sizeof piped, r);
+        CHECK(got > 0 && got < sizeof piped);
+        CHECK_EQI((int)stats.bytes_out, (int)got);
+    }
+    if (r) fclose(r);
+    else close(fds[0]);
+#endif
+
+    /* batch jobs run without stats */
+    cargs_job job;
+    memset(&job, 0, sizeof job);
+    char *jv[] = {dup_cstr("t"), dup_cstr("-V")};
+    job.argc   = 2;
+    job.argv   = jv;
+    job.user   = &st;
+    stats      = (cargs_stats){0};
+    CHECK_EQI((int)cargs_dispatch_batch(&env, root, &job, 1, 1), 0);
+    CHECK_EQI(job.rc, CARGS_OK);
+    CHECK(stats.callbacks == 0 && stats.lookups == 0);
+    free(jv[0]);
+    free(jv[1]);
+    tstate_clear(&st);
+}
+#else
+/* compiled out: env->stats is accepted and left untouched */
+static void test_stats(void) {
+    cargs_env env;
+    fill_env(&env);
+    const cargs_cmd *root;
+    build_root_basic(&root);
+    cargs_stats stats;
+    tstate      st = {0};
+    memset(&stats, 0xa5, sizeof stats);
+    cargs_stats before = stats;
+    env.stats          = &stats;
+    const char *a1[]   = {"t", "-V", "--jobs=3", "remote", "rm", "origin"};
+    CHECK_EQI(run_vec(root, &env, &st, 6, a1), CARGS_OK);
+    CHECK_EQI(st.ran_remote_rm, 1);
+    cargs_emit_markdown(&env, root, "t", cargs_devnull());
+    CHECK(memcmp(&stats, &before, sizeof stats) == 0);
+    tstate_clear(&st);
+}
+#endif
+
 int main(void) {
     test_required_forms();
     test_optional_forms();
@@ -510,6 +3002,37 @@ int main(void) {
     test_double_dash_and_positionals();
     test_subcommands_and_aliases();
     test_grouped_shorts();
+    test_compiled_index();
+    test_env_snapshot();
+    test_buffered_help();
+    test_presentation();
+    test_text_width();
+    test_strict_int_parsers();
+    test_exact_sizes();
+    test_durations_rates();
+    test_fmt_numbers();
+    test_response_files();
+    test_config_files();
+    test_parse_line();
+    test_arena();
+    test_packed();
+    test_complete();
+    test_limits();
+    test_group_relations();
+    test_multicall_and_prefix();
+    test_suggestions();
+    test_typed_bindings();
+    test_duration_bindings();
+    test_call_views();
+    test_deferred_events();
+    test_batch();
+    test_stats();
+    test_completion_tables();
+    test_blobs();
+    test_json();
+#if defined(__unix__) || defined(__APPLE__)
+    test_streaming_positionals();
+#endif
 
     if (failures) {
         fprintf(stderr, "\nFAILED %d/%d checks\n", failures, tests_run);
@@ -0,0 +1,149 @@
+// C++20 checks for c-args-parser.hpp: constexpr builders, validation and the
+// compile-time index.
+#include <cstdio>
+#include <cstring>
+
+#include "c-args-parser.hpp"
+
+static int tests_run = 0;
+static int failures  = 0;
+
+#define CHECK(cond)                                                           \
+    do {                                                                      \
+        tests_run++;                                                          \
+        if (!(cond)) {                                                        \
+            failures++;                                                       \
+            fprintf(stderr, "[FAIL] %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        }                                                                     \
+    } while (0)
+
+struct tstate {
+    int verbose = 0, jobs = 0, json = 0, ran_add = 0;
+};
+
+static int cb_verbose(const char *, void *u) {
+    static_cast<tstate *>(u)->verbose = 1;
+    return CARGS_OK;
+}
+static int cb_jobs(const char *v, void *u) {
+    return cargs_read_int(v, &static_cast<tstate *>(u)->jobs) ? CARGS_ERR_BAD_FORMAT : CARGS_OK;
+}
+static int cb_json(const char *, void *u) {
+    static_cast<tstate *>(u)->json = 1;
+    return CARGS_OK;
+}
+static int run_add(int, char **, void *u) {
+    static_cast<tstate *>(u)->ran_add = 1;
+    return CARGS_OK;
+}
+static int run_root(int, char **, void *) { return CARGS_OK; }
+static int on_call(const char *, std::size_t, const cargs_opt *, void *) { return CARGS_OK; }
+static int on_complete(const char *, const cargs_opt *, cargs_completion *, void *) { return CARGS_OK; }
+
+inline int                   level        = 0;
+inline int                   color        = 0;
+inline constexpr cargs_choice colors[]    = {{"auto", 0}, {"never", 1}, {nullptr, 0}};
+inline constexpr cargs_opt    root_opts[] = {
+    cargs::opt("verbose", 'V').help("Verbose").cb(cb_verbose).bind(CARGS_BIND_COUNT, &level),
+    cargs::opt("color").required("WHEN").bind_enum(&color, colors),
+    cargs::opt("jobs", 'j').required("N").help("Workers").cb(cb_jobs),
+    cargs::opt("json").help("JSON output").cb(cb_json).group(1, CARGS_GRP_XOR),
+    cargs::opt("yaml").help("YAML output").group(1, CARGS_GRP_XOR),
+};
+inline constexpr cargs_rel  root_rels[]  = {{CARGS_REL_CONFLICTS, "yaml", "color"}};
+inline constexpr cargs_pos  add_pos[]    = {CARGS_POS("NAME", "Remote name")};
+inline constexpr const char *add_alias[] = {"a"};
+inline constexpr cargs_cmd remote_subs[] = {
+    cargs::cmd("add", "Add").aliases(add_alias).pos(add_pos).run(run_add),
+    cargs::cmd("remove", "Remove"),
+};
+inline constexpr cargs_cmd root_subs[] = {cargs::cmd("remote", "Manage remotes").subs(remote_subs)};
+inline constexpr cargs_cmd root        = cargs::cmd(nullptr, "test").opts(root_opts).rels(root_rels).subs(root_subs).run(run_root);
+
+static_assert(cargs::validate(root));
+static_assert(cargs_opt(cargs::opt("name").required("S").call(on_call)).bind.call == on_call);
+static_assert(cargs_opt(cargs::opt("name").required("S").complete(on_complete)).bind.complete == on_complete);
+static_assert(cargs::compiled<root>::node_count == 4);
+static_assert(cargs::compiled<root>::index.root == &root);
+
+/* Invalid trees: these are not constant expressions (kept out of static_assert). */
+inline constexpr cargs_opt dup_short[] = {cargs::opt("a", 'x'), cargs::opt("b", 'x')};
+inline constexpr cargs_opt bad_group[] = {cargs::opt("a").group(64, CARGS_GRP_XOR)};
+inline constexpr cargs_opt mixed_pol[] = {
+    cargs::opt("a").group(2, CARGS_GRP_XOR),
+    cargs::opt("b").group(2, CARGS_GRP_REQ_ONE),
+};
+inline constexpr cargs_opt help_clash[] = {cargs::opt("host", 'h')};
+inline constexpr cargs_opt rel_opts[]   = {cargs::opt("a"), cargs::opt('b')};
+inline constexpr cargs_rel good_rel[]   = {{CARGS_REL_REQUIRES, "a", "b"}};
+inline constexpr cargs_rel bad_rel[]    = {{CARGS_REL_REQUIRES, "a", "nope"}};
+
+static bool runtime_validate(const cargs_cmd &c) { return cargs::validate(c); }
+
+int main() {
+    char a0[] = "t", a1[] = "--jobs=3", a2[] = "-VV", a3[] = "--color=never", a4[] = "remote", a5[] = "a",
+         a6[] = "origin";
+    char       *argv[] = {a0, a1, a2, a3, a4, a5, a6};
+    cargs_env   env{};
+    tstate      st{};
+    env.auto_help = true;
+    env.index     = &cargs::compiled<root>::index;
+
+    CHECK(cargs_dispatch(&env, &root, 7, argv, &st) == CARGS_OK);
+    CHECK(st.jobs == 3);
+    CHECK(st.verbose == 1);
+    CHECK(level == 2);
+    CHECK(color == 1);
+    CHECK(st.ran_add == 1);
+
+    /* constexpr tables match what cargs_compile() builds at runtime */
+    static uint64_t    storage[1024];
+    const cargs_index *rt = cargs_compile(&root, storage, sizeof(storage));
+    const cargs_index &ct = cargs::compiled<root>::index;
+    CHECK(rt && rt->node_count == ct.node_count);
+    for (std::size_t k = 0; rt && k < ct.node_count; k++) {
+        const cargs_index_node &r = rt->nodes[k], &c = ct.nodes[k];
+        CHECK(r.cmd == c.cmd);
+        CHECK(r.first_sub == c.first_sub);
+        CHECK(r.long_mask == c.long_mask);
+        CHECK(r.groups.xor_mask == c.groups.xor_mask);
+        CHECK(r.groups.req_mask == c.groups.req_mask);
+        CHECK(r.groups.any_mask == c.groups.any_mask);
+        CHECK(r.name_count == c.name_count);
+        for (uint32_t n = 0; n < r.name_count && n < c.name_count; n++)
+            CHECK(r.names[n].name == c.names[n].name && r.names[n].sub == c.names[n].sub);
+        CHECK(std::memcmp(r.shorts, c.shorts, 256 * sizeof(uint16_t)) == 0);
+        CHECK((r.longs == nullptr) == (c.longs == nullptr));
+        if (r.longs && c.longs) CHECK(std::memcmp(r.longs, c.longs, (r.long_mask + 1) * sizeof(uint32_t)) == 0);
+    }
+
+    /* the rules themselves, evaluated at runtime */
+    cargs_cmd bad{};
+    bad.opts      = dup_short;
+    bad.opt_count = 2;
+    CHECK(!runtime_validate(bad));
+    bad.opts      = bad_group;
+    bad.opt_count = 1;
+    CHECK(!runtime_validate(bad));
+    bad.opts      = mixed_pol;
+    bad.opt_count = 2;
+    CHECK(!runtime_validate(bad));
+    bad.opts      = help_clash;
+    bad.opt_count = 1;
+    CHECK(!runtime_validate(bad));
+    CHECK(cargs::validate(bad, cargs::checks{false, true, true}));
+    bad.opts      = rel_opts;
+    bad.opt_count = 2;
+    bad.rels      = good_rel;
+    bad.rel_count = 1;
+    CHECK(runtime_validate(bad));
+    bad.rels = bad_rel;
+    CHECK(!runtime_validate(bad));
+
+    if (failures) {
+        fprintf(stderr, "\nFAILED %d/%d checks\n", failures, tests_run);
+        return 1;
+    }
+    printf("ok — %d checks passed\n", tests_run);
+    return 0;
+}